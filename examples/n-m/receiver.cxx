@@ -1,5 +1,5 @@
 /********************************************************************************
- * Copyright (C) 2020-2023 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ * Copyright (C) 2020-2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
  *                                                                              *
  *              This software is distributed under the terms of the             *
  *              GNU Lesser General Public Licence (LGPL) version 3,             *
@@ -9,26 +9,18 @@
 #include "Header.h"
 
 #include <fairmq/Device.h>
+#include <fairmq/devices/TimeframeBuffer.h>
 #include <fairmq/runDevice.h>
 
-#include <string>
-#include <iomanip>
 #include <chrono>
+#include <cstdint>
+#include <memory>
 #include <string>
-#include <unordered_map>
-#include <unordered_set>
 
 using namespace std;
 using namespace example_n_m;
 namespace bpo = boost::program_options;
 
-struct TFBuffer
-{
-    fair::mq::Parts parts;
-    chrono::steady_clock::time_point start;
-    chrono::steady_clock::time_point end;
-};
-
 struct Receiver : fair::mq::Device
 {
     Receiver()
@@ -41,6 +33,9 @@ struct Receiver : fair::mq::Device
         fNumSenders = GetConfig()->GetValue<int>("num-senders");
         fBufferTimeoutInMs = GetConfig()->GetValue<int>("buffer-timeout");
         fMaxTimeframes = GetConfig()->GetValue<int>("max-timeframes");
+        fTimeframeCounter = 0;
+        fLastId = 1 << 16; // room for ids before the first one
+        fBuffer = make_unique<fair::mq::TimeframeBuffer>(1024, fNumSenders, chrono::milliseconds(fBufferTimeoutInMs));
     }
 
     bool HandleData(fair::mq::Parts& parts, int /* index */)
@@ -48,21 +43,23 @@ struct Receiver : fair::mq::Device
         Header& h = *(static_cast<Header*>(parts.At(0)->GetData()));
         // LOG(info) << "Received sub-time frame #" << h.id << " from Sender" << h.senderIndex;
 
-        if (fDiscardedSet.find(h.id) == fDiscardedSet.end()) {
-            if (fBuffer.find(h.id) == fBuffer.end()) {
-                // if this is the first part with this ID, save the receive time.
-                fBuffer[h.id].start = chrono::steady_clock::now();
-            }
-            // if the received ID has not previously been discarded, store the data part in the buffer
-            fBuffer[h.id].parts.AddPart(std::move(parts.At(1)));
-        } else {
-            // if received ID has been previously discarded.
-            LOG(debug) << "Received part from an already discarded timeframe with id " << h.id;
-        }
+        // the 16 bit id wraps around, continue the sequence from the last seen id
+        fLastId += static_cast<int16_t>(h.id - static_cast<uint16_t>(fLastId));
+
+        fair::mq::Parts data;
+        data.AddPart(std::move(parts.At(1)));
+        fair::mq::Parts frame;
+        auto onIncomplete = [&](uint64_t id, fair::mq::Parts&) {
+            LOG(debug) << "Timeframe #" << static_cast<uint16_t>(id) << " incomplete after " << fBufferTimeoutInMs << " milliseconds, discarding";
+        };
+
+        auto result = fBuffer->Add(fLastId, h.senderIndex, data, frame, onIncomplete);
+        fBuffer->Expire(onIncomplete);
 
-        if (fBuffer[h.id].parts.Size() == fNumSenders) {
+        if (result == fair::mq::TimeframeBuffer::Result::Late) {
+            LOG(debug) << "Received part from an already discarded timeframe with id " << h.id;
+        } else if (result == fair::mq::TimeframeBuffer::Result::Complete) {
             LOG(info) << "Successfully completed timeframe #" << h.id;
-            fBuffer.erase(h.id);
 
             if (fMaxTimeframes > 0 && ++fTimeframeCounter >= fMaxTimeframes) {
                 LOG(info) << "Reached configured maximum number of timeframes (" << fMaxTimeframes << "). Exiting RUNNING state.";
@@ -73,25 +70,16 @@ struct Receiver : fair::mq::Device
         return true;
     }
 
-    void DiscardIncompleteTimeframes()
+    void PostRun() override
     {
-        auto it = fBuffer.begin();
-        while (it != fBuffer.end()) {
-            if (chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - (it->second).start).count() > fBufferTimeoutInMs) {
-                LOG(debug) << "Timeframe #" << it->first << " incomplete after " << fBufferTimeoutInMs << " milliseconds, discarding";
-                fDiscardedSet.insert(it->first);
-                fBuffer.erase(it++);
-                LOG(debug) << "Number of discarded timeframes: " << fDiscardedSet.size();
-            } else {
-                // LOG(info) << "Timeframe #" << it->first << " within timeout, buffering...";
-                ++it;
-            }
-        }
+        const fair::mq::TimeframeStats& stats = fBuffer->GetStats();
+        LOG(info) << "Timeframes: " << stats.numComplete << " complete, " << stats.numIncomplete << " discarded, "
+                  << "mean build time " << stats.MeanBuildTimeNs() / 1000. << " us";
     }
 
   private:
-    unordered_map<uint16_t, TFBuffer> fBuffer;
-    unordered_set<uint16_t> fDiscardedSet;
+    unique_ptr<fair::mq::TimeframeBuffer> fBuffer;
+    uint64_t fLastId = 0;
 
     unsigned int fNumSenders = 0;
     int fBufferTimeoutInMs = 5000;
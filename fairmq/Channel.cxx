@@ -164,10 +164,25 @@ Channel& Channel::operator=(const Channel& chan)
     fAutoBind = chan.fAutoBind;
     fValid = false;
     fMultipart = chan.fMultipart;
+    fTxMetrics = {};
+    fRxMetrics = {};
 
     return *this;
 }
 
+void Channel::EnableMetrics([[maybe_unused]] metrics::Registry& registry)
+{
+#ifndef FAIRMQ_NO_CHANNEL_METRICS
+    for (auto [direction, transferMetrics] : {make_pair("tx", &fTxMetrics), make_pair("rx", &fRxMetrics)}) {
+        metrics::Labels labels{{"channel", fName}, {"direction", direction}};
+        transferMetrics->fTiming = &registry.GetTimingFlag();
+        transferMetrics->fBlockedNs = &registry.GetCounter("fairmq_channel_blocked_seconds_total", "Time spent in send/receive calls", labels, 1e-9);
+        transferMetrics->fTimeouts = &registry.GetCounter("fairmq_channel_timeouts_total", "Send/receive calls that timed out", labels);
+        transferMetrics->fDuration = &registry.GetHistogram("fairmq_channel_transfer_duration_seconds", "Duration of successful send/receive calls, including the time waiting for the queue/data", labels, 1e-9);
+    }
+#endif
+}
+
 bool Channel::Validate()
 try {
     stringstream ss;
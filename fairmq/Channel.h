@@ -10,9 +10,11 @@
 #define FAIR_MQ_CHANNEL_H
 
 #include <fairmq/Message.h>
+#include <fairmq/Metrics.h>
 #include <fairmq/Parts.h>
 #include <fairmq/Properties.h>
 #include <fairmq/Socket.h>
+#include <fairmq/Tracing.h>
 #include <fairmq/TransportFactory.h>
 #include <fairmq/TransportEnum.h>
 #include <fairmq/UnmanagedRegion.h>
@@ -22,6 +24,7 @@
 #include <ostream>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <utility>   // std::move
 #include <vector>
 
@@ -305,7 +308,7 @@ class Channel
         if constexpr (sizeof...(sndTimeoutMs) == 1) {
             t = {sndTimeoutMs...};
         }
-        return fSocket->Send(m, t);
+        return Transfer(fTxMetrics, tracing::Direction::tx, [&]() { return fSocket->Send(m, t); });
     }
 
     /// Receive message(s) from the socket queue.
@@ -329,13 +332,183 @@ class Channel
         if constexpr (sizeof...(rcvTimeoutMs) == 1) {
             t = {rcvTimeoutMs...};
         }
-        return fSocket->Receive(m, t);
+        return Transfer(fRxMetrics, tracing::Direction::rx, [&]() { return fSocket->Receive(m, t); });
     }
 
+    /// Receive a multipart message into a view, without creating a message per part (see PartsView).
+    /// Parts of the previous content of the view that have not been taken are released.
+    /// @param view view to receive into
+    /// @param rcvTimeoutMs receive timeout in ms.
+    /// -1 will wait forever (or until interrupt (e.g. via state change)),
+    /// 0 will not wait (return immediately if cannot receive).
+    /// If not provided, default timeout will be taken.
+    /// @return Number of bytes that have been received,
+    /// TransferCode::timeout if timed out,
+    /// TransferCode::error if there was an error,
+    /// TransferCode::interrupted if interrupted (e.g. by requested state change)
+    template<typename... Timeout>
+    int64_t Receive(PartsView& view, Timeout&&... rcvTimeoutMs)
+    {
+        static_assert(sizeof...(rcvTimeoutMs) <= 1, "Receive called with too many arguments");
+
+        int t = fRcvTimeoutMs;
+        if constexpr (sizeof...(rcvTimeoutMs) == 1) {
+            t = {rcvTimeoutMs...};
+        }
+        return Transfer(fRxMetrics, tracing::Direction::rx, [&]() { return fSocket->Receive(view, t); });
+    }
+
+    /// Send messages as a batch of independent single-part messages.
+    /// @param msgs messages to send
+    /// @param sndTimeoutMs send timeout in ms (for the first message of the batch).
+    /// -1 will wait forever (or until interrupt (e.g. via state change)),
+    /// 0 will not wait (return immediately if cannot send).
+    /// If not provided, default timeout will be taken.
+    /// @return Number of messages that have been queued (the first n of msgs),
+    /// TransferCode::timeout if timed out,
+    /// TransferCode::error if there was an error,
+    /// TransferCode::interrupted if interrupted (e.g. by requested state change)
+    template<typename... Timeout>
+    int64_t SendBatch(std::vector<MessagePtr>& msgs, Timeout&&... sndTimeoutMs)
+    {
+        static_assert(sizeof...(sndTimeoutMs) <= 1, "SendBatch called with too many arguments");
+
+        CheckSendCompatibility(msgs);
+        int t = fSndTimeoutMs;
+        if constexpr (sizeof...(sndTimeoutMs) == 1) {
+            t = {sndTimeoutMs...};
+        }
+        return Transfer(fTxMetrics, tracing::Direction::tx, [&]() { return fSocket->SendBatch(msgs, t); });
+    }
+
+    /// Receive a batch of independent single-part messages, appending them to msgs.
+    /// @param msgs received messages are appended here
+    /// @param maxMessages receive no further messages once this number is reached
+    /// @param rcvTimeoutMs receive timeout in ms (for the first message of the batch).
+    /// -1 will wait forever (or until interrupt (e.g. via state change)),
+    /// 0 will not wait (return immediately if cannot receive).
+    /// If not provided, default timeout will be taken.
+    /// @return Number of messages that have been received,
+    /// TransferCode::timeout if timed out,
+    /// TransferCode::error if there was an error,
+    /// TransferCode::interrupted if interrupted (e.g. by requested state change)
+    template<typename... Timeout>
+    int64_t ReceiveBatch(std::vector<MessagePtr>& msgs, std::size_t maxMessages, Timeout&&... rcvTimeoutMs)
+    {
+        static_assert(sizeof...(rcvTimeoutMs) <= 1, "ReceiveBatch called with too many arguments");
+
+        int t = fRcvTimeoutMs;
+        if constexpr (sizeof...(rcvTimeoutMs) == 1) {
+            t = {rcvTimeoutMs...};
+        }
+        return Transfer(fRxMetrics, tracing::Direction::rx, [&]() { return fSocket->ReceiveBatch(msgs, maxMessages, t); });
+    }
+
+    /// Send the same message(s) to several channels of one transport (e.g. all outputs of a device).
+    /// The last channel receives m itself, the others a copy (as by Message::Copy()), without copying the payload.
+    /// The shmem transport raises the reference counts once for all channels and encodes the metadata only once.
+    /// A channel that cannot take the message(s) within the timeout does not get them, the others are not affected.
+    /// @param channels destination channels
+    /// @param m reference to MessagePtr/Parts
+    /// @param sndTimeoutMs send timeout in ms (for each channel).
+    /// -1 will wait forever (or until interrupt (e.g. via state change)),
+    /// 0 will not wait (return immediately if cannot send).
+    /// If not provided, default timeout of the first channel will be taken.
+    /// @return Number of bytes that have been queued for each channel if all channels got the message(s),
+    /// otherwise the TransferCode of the first channel that did not:
+    /// TransferCode::timeout if timed out,
+    /// TransferCode::error if there was an error,
+    /// TransferCode::interrupted if interrupted (e.g. by requested state change)
+    template<typename M, typename... Timeout>
+    static std::enable_if_t<std::is_same_v<M, MessagePtr> || std::is_same_v<M, Parts>, int64_t>
+    SendToAll(const std::vector<Channel*>& channels, M& m, Timeout&&... sndTimeoutMs)
+    {
+        static_assert(sizeof...(sndTimeoutMs) <= 1, "SendToAll called with too many arguments");
+
+        if (channels.empty()) {
+            return 0;
+        }
+        Channel& first = *channels.front();
+        thread_local std::vector<Socket*> sockets;
+        sockets.clear();
+        for (auto channel : channels) {
+            if (channel->fTransportType != first.fTransportType) {
+                throw ChannelConfigurationError("SendToAll(): channel " + channel->GetName() + " does not use the transport of channel " + first.GetName());
+            }
+            sockets.push_back(channel->fSocket.get());
+        }
+
+        first.CheckSendCompatibility(m);
+        int t = first.fSndTimeoutMs;
+        if constexpr (sizeof...(sndTimeoutMs) == 1) {
+            t = {sndTimeoutMs...};
+        }
+        auto sendToAll = [&]() -> int64_t {
+            if constexpr (std::is_same_v<M, Parts>) {
+                return first.fSocket->SendToAll(sockets, m.fParts, t);
+            } else {
+                return first.fSocket->SendToAll(sockets, m, t);
+            }
+        };
+        return first.Transfer(first.fTxMetrics, tracing::Direction::tx, sendToAll);
+    }
+
+    /// Receive one message from this channel and send it on the output channel (within the send timeout of the output).
+    /// The receiving socket reuses its message objects, shmem channels of the same session pass the metadata on without creating messages.
+    /// Channels of different transports receive and send regular (converted) messages.
+    /// @param out channel to send the message on
+    /// @param multipart forward multipart messages (as received with Receive(Parts&)) or single-part messages
+    /// @param rcvTimeoutMs receive timeout in ms.
+    /// -1 will wait forever (or until interrupt (e.g. via state change)),
+    /// 0 will not wait (return immediately if cannot receive).
+    /// If not provided, default timeout will be taken.
+    /// The send uses the default send timeout of the output channel, a message that cannot be sent within it is dropped.
+    /// @return Number of bytes that have been forwarded,
+    /// TransferCode::timeout if timed out,
+    /// TransferCode::error if there was an error,
+    /// TransferCode::interrupted if interrupted (e.g. by requested state change)
+    template<typename... Timeout>
+    int64_t Forward(Channel& out, bool multipart, Timeout&&... rcvTimeoutMs)
+    {
+        static_assert(sizeof...(rcvTimeoutMs) <= 1, "Forward called with too many arguments");
+
+        int t = fRcvTimeoutMs;
+        if constexpr (sizeof...(rcvTimeoutMs) == 1) {
+            t = {rcvTimeoutMs...};
+        }
+        if (out.fTransportType == fTransportType) {
+            // the time blocked in forwarding counts as receive time of the input
+            return Transfer(fRxMetrics, tracing::Direction::forward, [&]() { return fSocket->Forward(*out.fSocket, multipart, t, out.fSndTimeoutMs); });
+        }
+
+        int64_t result = 0;
+        if (multipart) {
+            Parts parts;
+            result = Receive(parts, t);
+            if (result >= 0) {
+                result = out.Send(parts);
+            }
+        } else {
+            MessagePtr msg(NewMessage());
+            result = Receive(msg, t);
+            if (result >= 0) {
+                result = out.Send(msg);
+            }
+        }
+        return result;
+    }
+
+    /// Record the time spent in transfers, their durations and the timeouts of this channel in the given registry
+    /// (Device does this if the registry is enabled), while the timing of the registry is switched on.
+    /// Must be called before the channel is used for transfers. Does nothing if built with FAIRMQ_NO_CHANNEL_METRICS.
+    void EnableMetrics(metrics::Registry& registry);
+
     unsigned long GetBytesTx() const { return fSocket->GetBytesTx(); }
     unsigned long GetBytesRx() const { return fSocket->GetBytesRx(); }
     unsigned long GetMessagesTx() const { return fSocket->GetMessagesTx(); }
     unsigned long GetMessagesRx() const { return fSocket->GetMessagesRx(); }
+    unsigned long GetRetriesTx() const { return fSocket->GetRetriesTx(); }
+    unsigned long GetRetriesRx() const { return fSocket->GetRetriesRx(); }
 
     auto Transport() -> TransportFactory* { return fTransportFactory.get(); };
 
@@ -418,6 +591,26 @@ class Channel
 
     bool fMultipart;
 
+    metrics::TransferMetrics fTxMetrics;
+    metrics::TransferMetrics fRxMetrics;
+
+    /// runs a transfer of this channel with the enabled instrumentation (metrics, tracing)
+    template<typename F>
+    int64_t Transfer(const metrics::TransferMetrics& transferMetrics, tracing::Direction direction, F&& transfer)
+    {
+        if (tracing::IsEnabled()) {
+            tracing::BeginTransfer();
+            uint64_t const start = tracing::Now();
+            int64_t const result = transferMetrics ? transferMetrics.Measure(transfer) : transfer();
+            tracing::EndTransfer(fName, direction, start, result);
+            return result;
+        }
+        if (transferMetrics) {
+            return transferMetrics.Measure(transfer);
+        }
+        return transfer();
+    }
+
     void CheckSendCompatibility(MessagePtr& msg)
     {
         if (fTransportType != msg->GetType()) {
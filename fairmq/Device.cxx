@@ -15,13 +15,15 @@
 #include <boost/algorithm/string.hpp>   // join/split
 
 // std
-#include <algorithm>   // std::max, std::any_of
+#include <algorithm>   // std::max, std::any_of, std::remove_if
 #include <chrono>
+#include <exception>   // std::exception_ptr
 #include <iomanip>
 #include <list>
 #include <memory>   // std::make_unique
 #include <mutex>
 #include <thread>
+#include <unordered_map>
 
 namespace fair::mq {
 
@@ -36,6 +38,10 @@ constexpr int Device::DefaultInitTimeout;
 constexpr float Device::DefaultRate;
 constexpr const char* Device::DefaultSession;
 
+namespace {
+thread_local int tInputWorker = 0; // index of the input worker running on this thread, see Device::GetInputWorker()
+}
+
 struct StateSubscription
 {
     StateMachine& fStateMachine;
@@ -88,7 +94,7 @@ Device::Device(ProgOptions* config, tools::Version version)
     , fId(DefaultId)
     , fDefaultTransportType(DefaultTransportType)
     , fDataCallbacks(false)
-    , fMultitransportProceed(false)
+    , fInputProceed(false)
     , fVersion(version)
     , fRate(DefaultRate)
     , fInitializationTimeoutInS(DefaultInitTimeout)
@@ -163,6 +169,31 @@ void Device::InitWrapper()
         throw;
     }
 
+    fInputPolicy = InputPolicy();
+    fInputPolicy.rotate = fConfig->GetProperty<bool>("input-rotate", false);
+    fInputPolicy.drain = max(1U, fConfig->GetProperty<unsigned int>("input-drain", 1));
+    fInputPolicy.threads = fConfig->GetProperty<unsigned int>("input-threads", 0);
+    // <channel name>:<value> lists
+    auto parseChannelValues = [&](const string& key, unordered_map<string, unsigned int>& values) {
+        for (const auto& entry : fConfig->GetProperty<vector<string>>(key, vector<string>())) {
+            size_t pos = entry.rfind(':');
+            try {
+                if (pos == string::npos) {
+                    throw invalid_argument("missing ':'");
+                }
+                values[entry.substr(0, pos)] = stoul(entry.substr(pos + 1));
+            } catch (const exception& e) {
+                LOG(error) << "invalid " << key << " entry '" << entry << "', expected <channel name>:<value>";
+                throw;
+            }
+        }
+    };
+    parseChannelValues("input-weights", fInputPolicy.weights);
+    for (auto& weight : fInputPolicy.weights) {
+        weight.second = max(1U, weight.second);
+    }
+    parseChannelValues("input-groups", fInputPolicy.groups);
+
     unordered_map<string, int> infos = fConfig->GetChannelInfo();
     for (const auto& info : infos) {
         for (int i = 0; i < info.second; ++i) {
@@ -268,6 +299,8 @@ void Device::ConnectWrapper()
         LOG(warn) << "No channels created after finishing initialization";
     }
 
+    RegisterMetrics();
+
     Connect();
 
     if (!NewStatePending()) {
@@ -275,6 +308,42 @@ void Device::ConnectWrapper()
     }
 }
 
+void Device::RegisterMetrics()
+{
+    for (auto& channel : GetChannels()) {
+        for (auto& subChannel : channel.second) {
+            Channel* chan = &subChannel;
+            for (string direction : {"tx", "rx"}) {
+                metrics::Labels labels{{"channel", chan->GetName()}, {"direction", direction}};
+                bool tx = direction == "tx";
+                fMetrics.AddCallback(this, "fairmq_channel_bytes_total", "Bytes transferred by the channel", metrics::Type::Counter, labels,
+                    [chan, tx]() { return static_cast<double>(tx ? chan->GetBytesTx() : chan->GetBytesRx()); });
+                fMetrics.AddCallback(this, "fairmq_channel_messages_total", "Messages transferred by the channel (multipart messages count once)", metrics::Type::Counter, labels,
+                    [chan, tx]() { return static_cast<double>(tx ? chan->GetMessagesTx() : chan->GetMessagesRx()); });
+                fMetrics.AddCallback(this, "fairmq_channel_retries_total", "Socket timeout periods a blocking send/receive waited for the queue/data", metrics::Type::Counter, labels,
+                    [chan, tx]() { return static_cast<double>(tx ? chan->GetRetriesTx() : chan->GetRetriesRx()); });
+            }
+            if (fMetrics.IsEnabled()) {
+                chan->EnableMetrics(fMetrics);
+            }
+        }
+    }
+
+    lock_guard<mutex> lock(fTransportMtx);
+    for (auto& [transportType, transport] : fTransports) {
+        transport->RegisterMetrics(fMetrics);
+    }
+}
+
+void Device::UnregisterMetrics()
+{
+    fMetrics.RemoveCallbacks(this);
+    lock_guard<mutex> lock(fTransportMtx);
+    for (auto& [transportType, transport] : fTransports) {
+        fMetrics.RemoveCallbacks(transport.get());
+    }
+}
+
 void Device::AttachChannels(vector<Channel*>& chans)
 {
     auto itr = chans.begin();
@@ -448,16 +517,9 @@ void Device::HandleSingleChannelInput()
 
 void Device::HandleMultipleChannelInput()
 {
-    // check if more than one transport is used
-    fMultitransportInputs.clear();
+    fInputStats.clear();
     for (const auto& k : fInputChannelKeys) {
-        mq::Transport t = GetChannel(k, 0).fTransportType;
-        if (fMultitransportInputs.find(t) == fMultitransportInputs.end()) {
-            fMultitransportInputs.insert(pair<mq::Transport, vector<string>>(t, vector<string>()));
-            fMultitransportInputs.at(t).push_back(k);
-        } else {
-            fMultitransportInputs.at(t).push_back(k);
-        }
+        fInputStats[k].assign(GetChannels().at(k).size(), InputStats());
     }
 
     for (const auto& mi : fMsgInputs) {
@@ -472,91 +534,239 @@ void Device::HandleMultipleChannelInput()
         }
     }
 
-    // if more than one transport is used, handle poll of each in a separate thread
-    if (fMultitransportInputs.size() > 1) {
-        HandleMultipleTransportInput();
-    } else { // otherwise poll directly
-        bool proceed = true;
+    vector<vector<InputSlot>> groups(GroupInputSlots(MakeInputSlots(fInputChannelKeys)));
+    fInputProceed = true;
 
-        PollerPtr poller(GetChannel(fInputChannelKeys.at(0), 0).fTransportFactory->CreatePoller(GetChannels(), fInputChannelKeys));
-
-        while (!NewStatePending() && proceed) {
-            poller->Poll(200);
-
-            // check which inputs are ready and call their data handlers if they are.
-            for (const auto& ch : fInputChannelKeys) {
-                for (unsigned int i = 0; i < GetChannels().at(ch).size(); ++i) {
-                    if (poller->CheckInput(ch, i)) {
-                        if (GetChannel(ch, i).fMultipart) {
-                            proceed = HandleMultipartInput(ch, fMultipartInputs.at(ch), i);
-                        } else {
-                            proceed = HandleMsgInput(ch, fMsgInputs.at(ch), i);
-                        }
-
-                        if (!proceed) {
-                            break;
-                        }
+    if (groups.size() == 1) { // poll directly
+        tInputWorker = static_cast<int>(groups.front().front().fWorker);
+        tools::CallOnDestruction resetWorker([]() { tInputWorker = 0; });
+        PollInputs(groups.front(), 200, false);
+    } else {
+        // each group (transport or worker) is polled in a separate thread,
+        // without workers (multiple transports) the callbacks are still called one at a time
+        const bool serialize = fInputPolicy.threads == 0;
+        vector<thread> threads;
+        exception_ptr error;
+        mutex errorMtx;
+
+        for (auto& group : groups) {
+            threads.emplace_back([this, &error, &errorMtx, &slots = group, serialize]() {
+                tInputWorker = static_cast<int>(slots.front().fWorker);
+                try {
+                    PollInputs(slots, serialize ? 500 : 200, serialize);
+                } catch (...) {
+                    fInputProceed = false;
+                    lock_guard<mutex> lock(errorMtx);
+                    if (!error) {
+                        error = current_exception();
                     }
                 }
-                if (!proceed) {
-                    break;
-                }
-            }
+            });
+        }
+
+        for (thread& t : threads) {
+            t.join();
+        }
+
+        if (error) {
+            rethrow_exception(error);
+        }
+    }
+
+    LogInputStats();
+}
+
+void Device::LogPollerStats(const Poller& poller)
+{
+    if (poller.GetSpinTime().count() > 0) {
+        auto stats = poller.GetStats();
+        LOG(debug) << "Input poller (spin time " << poller.GetSpinTime().count() << " us): " << stats.numPolls << " polls, "
+                   << stats.numSpinWakeups << " spin wakeups, " << stats.numBlockWakeups << " block wakeups, " << stats.numTimeouts << " timeouts, "
+                   << "spin ratio " << stats.SpinRatio() << ", spin time " << stats.spinTimeNs / 1000000 << " ms";
+    }
+}
+
+int Device::GetInputWorker()
+{
+    return tInputWorker;
+}
+
+vector<Device::InputSlot> Device::MakeInputSlots(const vector<string>& channelKeys)
+{
+    vector<InputSlot> slots;
+    for (const auto& ch : channelKeys) {
+        auto weight = fInputPolicy.weights.find(ch);
+        unsigned int budget = fInputPolicy.drain * (weight == fInputPolicy.weights.end() ? 1 : weight->second);
+        auto msgInput = fMsgInputs.find(ch);
+        auto multipartInput = fMultipartInputs.find(ch);
+        for (unsigned int i = 0; i < GetChannels().at(ch).size(); ++i) {
+            slots.push_back(InputSlot{ch,
+                                      static_cast<int>(i),
+                                      &GetChannel(ch, i),
+                                      msgInput == fMsgInputs.end() ? nullptr : &msgInput->second,
+                                      multipartInput == fMultipartInputs.end() ? nullptr : &multipartInput->second,
+                                      max(1U, budget),
+                                      0,
+                                      &fInputStats.at(ch).at(i)});
         }
     }
+    return slots;
 }
 
-void Device::HandleMultipleTransportInput()
+vector<vector<Device::InputSlot>> Device::GroupInputSlots(vector<InputSlot> slots) const
 {
-    vector<thread> threads;
+    vector<vector<InputSlot>> groups;
+
+    if (fInputPolicy.threads == 0) {
+        // one group per transport, a poller handles the channels of one transport only
+        unordered_map<mq::Transport, size_t> transportGroups;
+        for (auto& slot : slots) {
+            auto it = transportGroups.emplace(slot.fChannel->fTransportType, groups.size()).first;
+            if (it->second == groups.size()) {
+                groups.emplace_back();
+            }
+            groups.at(it->second).push_back(slot);
+        }
+        return groups;
+    }
 
-    fMultitransportProceed = true;
+    // worker threads: sub-channels of channels with a configured group go to that worker, the others are distributed in turn
+    groups.resize(fInputPolicy.threads);
+    unsigned int next = 0;
+    for (auto& slot : slots) {
+        auto group = fInputPolicy.groups.find(slot.fChannelName);
+        if (group != fInputPolicy.groups.end()) {
+            slot.fWorker = group->second;
+        } else {
+            slot.fWorker = next++ % fInputPolicy.threads;
+        }
+        if (slot.fWorker >= fInputPolicy.threads) {
+            throw runtime_error(tools::ToString("input channel '", slot.fChannelName, "' is assigned to worker ", slot.fWorker, ", but there are only ", fInputPolicy.threads, " input workers"));
+        }
+        if (!groups.at(slot.fWorker).empty() && groups.at(slot.fWorker).front().fChannel->fTransportType != slot.fChannel->fTransportType) {
+            throw runtime_error(tools::ToString("input worker ", slot.fWorker, " would poll channels of different transports ('", groups.at(slot.fWorker).front().fChannelName, "', '", slot.fChannelName, "')"));
+        }
+        groups.at(slot.fWorker).push_back(slot);
+    }
+    groups.erase(remove_if(groups.begin(), groups.end(), [](const auto& group) { return group.empty(); }), groups.end());
+    return groups;
+}
 
-    for (const auto& i : fMultitransportInputs) {
-        threads.emplace_back(thread(&Device::PollForTransport, this, fTransports.at(i.first).get(), i.second));
+void Device::PollInputs(vector<InputSlot>& slots, int timeout, bool serialize)
+{
+    vector<Channel*> channels;
+    for (const auto& slot : slots) {
+        channels.push_back(slot.fChannel);
     }
+    PollerPtr poller(channels.front()->fTransportFactory->CreatePoller(channels));
+    size_t offset = 0;
 
-    for (thread& t : threads) {
-        t.join();
+    while (!NewStatePending() && fInputProceed) {
+        poller->Poll(timeout);
+        HandleReadyInputs(*poller, slots, offset, serialize);
     }
+    LogPollerStats(*poller);
 }
 
-void Device::PollForTransport(const TransportFactory* factory, const vector<string>& channelKeys)
+bool Device::HandleReadyInputs(Poller& poller, vector<InputSlot>& slots, size_t& offset, bool serialize)
 {
-    try {
-        PollerPtr poller(factory->CreatePoller(GetChannels(), channelKeys));
+    const auto wakeup = chrono::steady_clock::now();
+    const size_t start = offset;
+    if (fInputPolicy.rotate && ++offset >= slots.size()) {
+        offset = 0;
+    }
 
-        while (!NewStatePending() && fMultitransportProceed) {
-            poller->Poll(500);
+    for (size_t n = 0; n < slots.size(); ++n) {
+        const size_t index = (start + n) % slots.size();
+        InputSlot& slot = slots[index];
+        if (!poller.CheckInput(static_cast<int>(index))) {
+            continue;
+        }
+        ++slot.fStats->numWakeups;
 
-            for (const auto& ch : channelKeys) {
-                for (unsigned int i = 0; i < GetChannels().at(ch).size(); ++i) {
-                    if (poller->CheckInput(ch, i)) {
-                        lock_guard<mutex> lock(fMultitransportMutex);
+        // drain up to the budget of the sub-channel, only the first receive waits
+        for (unsigned int m = 0; m < slot.fBudget; ++m) {
+            unique_lock<mutex> lock(fInputMutex, defer_lock);
+            if (serialize) {
+                lock.lock();
+            }
+            if (!fInputProceed) {
+                return false;
+            }
 
-                        if (!fMultitransportProceed) {
-                            break;
-                        }
+            int result = HandleInput(slot, m == 0, wakeup);
+            if (result < 0) {
+                fInputProceed = false;
+                return false;
+            } else if (result == 0) {
+                break;
+            }
+        }
+    }
+    return true;
+}
 
-                        if (GetChannel(ch, i).fMultipart) {
-                            fMultitransportProceed = HandleMultipartInput(ch, fMultipartInputs.at(ch), i);
-                        } else {
-                            fMultitransportProceed = HandleMsgInput(ch, fMsgInputs.at(ch), i);
-                        }
+/// @return 1 if a message was handled, 0 if no message was available (not first), -1 to stop (callback returned false or transfer failed)
+int Device::HandleInput(InputSlot& slot, bool first, chrono::steady_clock::time_point wakeup)
+{
+    auto count = [&]() {
+        auto delay = static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - wakeup).count());
+        ++slot.fStats->numMessages;
+        slot.fStats->delayNs += delay;
+        slot.fStats->maxDelayNs = max(slot.fStats->maxDelayNs, delay);
+    };
+    auto failed = [&](int64_t result) {
+        return (!first && result == static_cast<int64_t>(TransferCode::timeout)) ? 0 : -1;
+    };
+
+    if (slot.fChannel->fMultipart) {
+        Parts input;
+        int64_t result = first ? slot.fChannel->Receive(input) : slot.fChannel->Receive(input, 0);
+        if (result < 0) {
+            return failed(result);
+        }
+        count();
+        return (*slot.fMultipartCallback)(input, slot.fIndex) ? 1 : -1;
+    } else {
+        unique_ptr<Message> input(slot.fChannel->fTransportFactory->CreateMessage());
+        int64_t result = first ? slot.fChannel->Receive(input) : slot.fChannel->Receive(input, 0);
+        if (result < 0) {
+            return failed(result);
+        }
+        count();
+        return (*slot.fMsgCallback)(input, slot.fIndex) ? 1 : -1;
+    }
+}
 
-                        if (!fMultitransportProceed) {
-                            break;
-                        }
-                    }
-                }
-                if (!fMultitransportProceed) {
-                    break;
-                }
+void Device::LogInputStats() const
+{
+    // summary over all input sub-channels, the least and the most delayed one show the (un)fairness of the input scheduling
+    const InputStats* minDelay = nullptr;
+    const InputStats* maxDelay = nullptr;
+    string minName, maxName;
+    uint64_t numMessages = 0;
+    for (const auto& [name, subChannels] : fInputStats) {
+        for (size_t i = 0; i < subChannels.size(); ++i) {
+            const InputStats& stats = subChannels[i];
+            numMessages += stats.numMessages;
+            if (stats.numMessages == 0) {
+                continue;
+            }
+            if (!minDelay || stats.MeanDelayNs() < minDelay->MeanDelayNs()) {
+                minDelay = &stats;
+                minName = tools::ToString(name, "[", i, "]");
+            }
+            if (!maxDelay || stats.MeanDelayNs() > maxDelay->MeanDelayNs()) {
+                maxDelay = &stats;
+                maxName = tools::ToString(name, "[", i, "]");
             }
         }
-    } catch (exception& e) {
-        LOG(error) << "fair::mq::Device::PollForTransport() failed: " << e.what() << ", going to ERROR state.";
-        throw runtime_error(tools::ToString("fair::mq::Device::PollForTransport() failed: ", e.what(), ", going to ERROR state."));
+    }
+    if (minDelay && maxDelay) {
+        LOG(debug) << "Input scheduling (rotate " << fInputPolicy.rotate << ", drain " << fInputPolicy.drain << "): " << numMessages << " messages, "
+                   << "mean queueing delay from " << minDelay->MeanDelayNs() / 1000. << " us (" << minName << ", " << minDelay->numMessages << " messages) "
+                   << "to " << maxDelay->MeanDelayNs() / 1000. << " us (" << maxName << ", " << maxDelay->numMessages << " messages), "
+                   << "max " << maxDelay->maxDelayNs / 1000. << " us";
     }
 }
 
@@ -730,6 +940,8 @@ void Device::ResetTaskWrapper()
 
 void Device::ResetWrapper()
 {
+    UnregisterMetrics();
+
     {
         lock_guard<mutex> lock(fTransportMtx);
         for (auto& [transportType, transport] : fTransports) {
@@ -30,6 +30,7 @@
 #include <atomic>
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>   // unique_ptr
 #include <mutex>
@@ -52,6 +53,28 @@ using InputMsgCallback = std::function<bool(MessagePtr&, int)>;
 
 using InputMultipartCallback = std::function<bool(Parts&, int)>;
 
+/// Order in which the OnData input handling serves the ready sub-channels after each poll
+/// (with more than one input sub-channel). The default serves every ready sub-channel once, in the order of the OnData() calls.
+struct InputPolicy
+{
+    bool rotate = false;    ///< start at the next sub-channel after each poll (round-robin), instead of always at the first
+    unsigned int drain = 1; ///< maximum number of messages handled per ready sub-channel and poll
+    std::unordered_map<std::string, unsigned int> weights; ///< per channel factor for drain (priority), default 1
+    unsigned int threads = 0; ///< number of input worker threads, which call the callbacks of their sub-channels concurrently (0: no workers)
+    std::unordered_map<std::string, unsigned int> groups; ///< per channel worker index, the sub-channels of other channels are distributed over the workers
+};
+
+/// Statistics of the OnData input handling of one sub-channel, to verify the fairness of the InputPolicy
+struct InputStats
+{
+    uint64_t numMessages = 0; ///< messages handed to the callback
+    uint64_t numWakeups = 0;  ///< polls after which the sub-channel had messages
+    uint64_t delayNs = 0;     ///< total queueing delay: time from the end of the poll to the reception of a message
+    uint64_t maxDelayNs = 0;  ///< maximum queueing delay
+
+    double MeanDelayNs() const { return numMessages > 0 ? static_cast<double>(delayNs) / static_cast<double>(numMessages) : 0.; }
+};
+
 class Device
 {
     friend class Channel;
@@ -153,6 +176,126 @@ class Device
         return GetChannel(channel, index).Receive(m, rcvTimeoutMs);
     }
 
+    /// Receive a multipart message on `chan` at index `i` into `view`, without creating a message per part
+    /// @param view view to receive into, parts of its previous content that have not been taken are released
+    /// @param chan channel name
+    /// @param i channel index
+    /// @return Number of received bytes,
+    /// TransferCode::timeout if timed out,
+    /// TransferCode::error if there was an error,
+    /// TransferCode::interrupted if interrupted (e.g. by requested state change)
+    int64_t Receive(PartsView& view, const std::string& channel, const int index = 0)
+    {
+        return GetChannel(channel, index).Receive(view);
+    }
+
+    /// Receive a multipart message on `chan` at index `i` into `view`, without creating a message per part
+    /// @param view view to receive into, parts of its previous content that have not been taken are released
+    /// @param chan channel name
+    /// @param i channel index
+    /// @param rcvTimeoutMs receive timeout in ms,
+    /// -1 will wait forever (or until interrupt (e.g. via state change),
+    /// 0 will not wait (return immediately if cannot receive)
+    /// @return Number of received bytes,
+    /// TransferCode::timeout if timed out,
+    /// TransferCode::error if there was an error,
+    /// TransferCode::interrupted if interrupted (e.g. by requested state change)
+    int64_t Receive(PartsView& view, const std::string& channel, const int index, int rcvTimeoutMs)
+    {
+        return GetChannel(channel, index).Receive(view, rcvTimeoutMs);
+    }
+
+    /// Send `msgs` as a batch of independent single-part messages on `chan` at index `i`
+    /// @param msgs messages to send
+    /// @param chan channel name
+    /// @param i channel index
+    /// @return Number of queued messages,
+    /// TransferCode::timeout if timed out,
+    /// TransferCode::error if there was an error,
+    /// TransferCode::interrupted if interrupted (e.g. by requested state change)
+    int64_t SendBatch(std::vector<MessagePtr>& msgs, const std::string& channel, const int index = 0)
+    {
+        return GetChannel(channel, index).SendBatch(msgs);
+    }
+
+    /// Send `msgs` as a batch of independent single-part messages on `chan` at index `i`
+    /// @param msgs messages to send
+    /// @param chan channel name
+    /// @param i channel index
+    /// @param sndTimeoutMs send timeout in ms (for the first message),
+    /// -1 will wait forever (or until interrupt (e.g. via state change)),
+    /// 0 will not wait (return immediately if cannot send)
+    /// @return Number of queued messages,
+    /// TransferCode::timeout if timed out,
+    /// TransferCode::error if there was an error,
+    /// TransferCode::interrupted if interrupted (e.g. by requested state change)
+    int64_t SendBatch(std::vector<MessagePtr>& msgs, const std::string& channel, const int index, int sndTimeoutMs)
+    {
+        return GetChannel(channel, index).SendBatch(msgs, sndTimeoutMs);
+    }
+
+    /// Receive up to `maxMessages` independent single-part messages on `chan` at index `i`, appending them to `msgs`
+    /// @param msgs received messages are appended here
+    /// @param maxMessages receive no further messages once this number is reached
+    /// @param chan channel name
+    /// @param i channel index
+    /// @return Number of received messages,
+    /// TransferCode::timeout if timed out,
+    /// TransferCode::error if there was an error,
+    /// TransferCode::interrupted if interrupted (e.g. by requested state change)
+    int64_t ReceiveBatch(std::vector<MessagePtr>& msgs, std::size_t maxMessages, const std::string& channel, const int index = 0)
+    {
+        return GetChannel(channel, index).ReceiveBatch(msgs, maxMessages);
+    }
+
+    /// Receive up to `maxMessages` independent single-part messages on `chan` at index `i`, appending them to `msgs`
+    /// @param msgs received messages are appended here
+    /// @param maxMessages receive no further messages once this number is reached
+    /// @param chan channel name
+    /// @param i channel index
+    /// @param rcvTimeoutMs receive timeout in ms (for the first message),
+    /// -1 will wait forever (or until interrupt (e.g. via state change),
+    /// 0 will not wait (return immediately if cannot receive)
+    /// @return Number of received messages,
+    /// TransferCode::timeout if timed out,
+    /// TransferCode::error if there was an error,
+    /// TransferCode::interrupted if interrupted (e.g. by requested state change)
+    int64_t ReceiveBatch(std::vector<MessagePtr>& msgs, std::size_t maxMessages, const std::string& channel, const int index, int rcvTimeoutMs)
+    {
+        return GetChannel(channel, index).ReceiveBatch(msgs, maxMessages, rcvTimeoutMs);
+    }
+
+    /// Send `m` to all sub-channels of the given channels, sharing the buffers instead of copying them (see Channel::SendToAll())
+    /// @param m reference to MessagePtr/Parts, the last sub-channel of the last channel receives it, the others a copy
+    /// @param channels channel names
+    /// @return Number of bytes queued for each sub-channel if all got the message(s),
+    /// otherwise the TransferCode of the first sub-channel that did not:
+    /// TransferCode::timeout if timed out,
+    /// TransferCode::error if there was an error,
+    /// TransferCode::interrupted if interrupted (e.g. by requested state change)
+    template<typename M>
+    int64_t SendToAll(M& m, const std::vector<std::string>& channels)
+    {
+        return Channel::SendToAll(GetSubChannels(channels), m);
+    }
+
+    /// Send `m` to all sub-channels of the given channels, sharing the buffers instead of copying them (see Channel::SendToAll())
+    /// @param m reference to MessagePtr/Parts, the last sub-channel of the last channel receives it, the others a copy
+    /// @param channels channel names
+    /// @param sndTimeoutMs send timeout in ms (for each sub-channel),
+    /// -1 will wait forever (or until interrupt (e.g. via state change)),
+    /// 0 will not wait (return immediately if cannot send)
+    /// @return Number of bytes queued for each sub-channel if all got the message(s),
+    /// otherwise the TransferCode of the first sub-channel that did not:
+    /// TransferCode::timeout if timed out,
+    /// TransferCode::error if there was an error,
+    /// TransferCode::interrupted if interrupted (e.g. by requested state change)
+    template<typename M>
+    int64_t SendToAll(M& m, const std::vector<std::string>& channels, int sndTimeoutMs)
+    {
+        return Channel::SendToAll(GetSubChannels(channels), m, sndTimeoutMs);
+    }
+
     /// @brief Getter for default transport factory
     auto Transport() const -> TransportFactory* { return fTransportFactory.get(); }
 
@@ -265,6 +408,10 @@ class Device
     /// Get pointer to the config
     ProgOptions* GetConfig() const { return fConfig; }
 
+    /// Metrics of the device: the device registers the statistics of its channels and transports, user code can add its own.
+    /// Exported by the metrics plugin (see fair::mq::metrics::Registry).
+    metrics::Registry& GetMetrics() { return fMetrics; }
+
     // overload to easily bind member functions
     template<typename T>
     void OnData(const std::string& channelName,
@@ -320,6 +467,28 @@ class Device
         }
     }
 
+    /// Set the scheduling of the OnData inputs (e.g. in InitTask()), overrides the --input-* options
+    void SetInputPolicy(const InputPolicy& policy) { fInputPolicy = policy; }
+    const InputPolicy& GetInputPolicy() const { return fInputPolicy; }
+
+    /// @brief Get the index of the input worker (InputPolicy::threads) that calls the current OnData callback
+    /// @return worker index, 0 without input workers
+    /// A channel must not be used by two threads at the same time: with input workers, every worker should send on its own
+    /// output sub-channel, e.g. Send(msg, "data-out", GetInputWorker()) with one sub-channel per worker.
+    static int GetInputWorker();
+
+    /// @brief Get the statistics of the OnData input handling of a sub-channel (after running, with more than one input sub-channel)
+    /// @param channelName channel name
+    /// @param index sub-channel
+    InputStats GetInputStats(const std::string& channelName, const int index = 0) const
+    {
+        auto it = fInputStats.find(channelName);
+        if (it == fInputStats.end() || index < 0 || static_cast<size_t>(index) >= it->second.size()) {
+            return InputStats();
+        }
+        return it->second.at(index);
+    }
+
     Channel& GetChannel(const std::string& channelName, const int index = 0)
     try {
         return GetChannels().at(channelName).at(index);
@@ -336,6 +505,20 @@ class Device
         throw;
     }
 
+    /// @brief Get all sub-channels of the given channels, e.g. as destinations of Channel::SendToAll()
+    /// @param channelNames channel names
+    /// @return pointers to the sub-channels, in order
+    std::vector<Channel*> GetSubChannels(const std::vector<std::string>& channelNames)
+    {
+        std::vector<Channel*> subChannels;
+        for (const auto& name : channelNames) {
+            for (size_t i = 0; i < GetNumSubChannels(name); ++i) {
+                subChannels.push_back(&GetChannel(name, i));
+            }
+        }
+        return subChannels;
+    }
+
     /// @brief Get numbers of connected peers for the given channel
     /// @param name channel name
     /// @param index sub-channel
@@ -644,32 +827,56 @@ class Device
     /// Shuts down the transports and the device
     void Exit() {}
 
+    /// Adds the statistics of the channels and transports to the metrics registry
+    void RegisterMetrics();
+    /// Removes what RegisterMetrics() added, before the channels and transports go away
+    void UnregisterMetrics();
+
     /// Attach (bind/connect) channels in the list
     void AttachChannels(std::vector<Channel*>& chans);
     bool AttachChannel(Channel& ch);
 
     void HandleSingleChannelInput();
     void HandleMultipleChannelInput();
-    void HandleMultipleTransportInput();
-    void PollForTransport(const TransportFactory* factory,
-                          const std::vector<std::string>& channelKeys);
+    static void LogPollerStats(const Poller& poller);
 
     bool HandleMsgInput(const std::string& chName, const InputMsgCallback& callback, int i);
     bool HandleMultipartInput(const std::string& chName,
                               const InputMultipartCallback& callback,
                               int i);
 
+    /// An input sub-channel of the OnData handling with more than one input sub-channel
+    struct InputSlot
+    {
+        std::string fChannelName;
+        int fIndex;
+        Channel* fChannel;
+        const InputMsgCallback* fMsgCallback;
+        const InputMultipartCallback* fMultipartCallback;
+        unsigned int fBudget; ///< messages per poll
+        unsigned int fWorker; ///< input worker (InputPolicy::threads)
+        InputStats* fStats;
+    };
+
+    std::vector<InputSlot> MakeInputSlots(const std::vector<std::string>& channelKeys);
+    std::vector<std::vector<InputSlot>> GroupInputSlots(std::vector<InputSlot> slots) const;
+    void PollInputs(std::vector<InputSlot>& slots, int timeout, bool serialize);
+    bool HandleReadyInputs(Poller& poller, std::vector<InputSlot>& slots, size_t& offset, bool serialize);
+    int HandleInput(InputSlot& slot, bool first, std::chrono::steady_clock::time_point wakeup);
+    void LogInputStats() const;
+
     std::vector<Channel*> fUninitializedBindingChannels;
     std::vector<Channel*> fUninitializedConnectingChannels;
 
     bool fDataCallbacks;
     std::unordered_map<std::string, InputMsgCallback> fMsgInputs;
     std::unordered_map<std::string, InputMultipartCallback> fMultipartInputs;
-    std::unordered_map<mq::Transport, std::vector<std::string>> fMultitransportInputs;
     std::unordered_map<std::string, std::pair<uint16_t, uint16_t>> fChannelRegistry;
     std::vector<std::string> fInputChannelKeys;
-    std::mutex fMultitransportMutex;
-    std::atomic<bool> fMultitransportProceed;
+    std::mutex fInputMutex; ///< serializes the callbacks of multiple input threads without workers (multiple transports)
+    std::atomic<bool> fInputProceed;
+    InputPolicy fInputPolicy;
+    std::unordered_map<std::string, std::vector<InputStats>> fInputStats;
 
     const tools::Version fVersion;
     float fRate;                  ///< Rate limiting for ConditionalRun
@@ -679,6 +886,8 @@ class Device
     StateQueue fStateQueue;
 
     std::mutex fTransportMtx;   ///< guards access to transports container
+
+    metrics::Registry fMetrics;
 };
 
 }   // namespace fair::mq
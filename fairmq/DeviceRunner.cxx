@@ -112,6 +112,8 @@ auto DeviceRunner::Run() -> int
 
     // Load builtin plugins last
     fPluginManager.LoadPlugin("s:control");
+    fPluginManager.LoadPlugin("s:metrics");
+    fPluginManager.LoadPlugin("s:trace");
 
     ////// CALL HOOK ///////
     fEvents.Emit<hooks::SetCustomCmdLineOptions>(*this);
@@ -0,0 +1,274 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include <fairmq/Metrics.h>
+#include <fairmq/tools/Strings.h>
+
+#include <algorithm> // std::remove_if
+#include <chrono>
+#include <cmath> // std::isfinite
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+namespace fair::mq::metrics
+{
+
+namespace
+{
+
+const char* TypeName(Type type)
+{
+    switch (type) {
+        case Type::Counter: return "counter";
+        case Type::Gauge: return "gauge";
+        case Type::Histogram: return "histogram";
+    }
+    return "untyped";
+}
+
+// label values in the Prometheus format and strings in JSON share the escaping of backslash, quote and newline
+string Escape(const string& str)
+{
+    string out;
+    out.reserve(str.size());
+    for (char c : str) {
+        if (c == '\\' || c == '"') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+string Number(double value)
+{
+    if (!std::isfinite(value)) {
+        return value != value ? "NaN" : (value > 0 ? "+Inf" : "-Inf");
+    }
+    ostringstream ss;
+    ss << setprecision(17) << value;
+    return ss.str();
+}
+
+// JSON has no representation for NaN/Inf
+string JsonNumber(double value)
+{
+    return std::isfinite(value) ? Number(value) : "null";
+}
+
+void WriteLabels(ostream& os, const Labels& labels, const string& extraName = "", const string& extraValue = "")
+{
+    if (labels.empty() && extraName.empty()) {
+        return;
+    }
+    os << '{';
+    bool first = true;
+    for (const auto& [name, value] : labels) {
+        os << (first ? "" : ",") << name << "=\"" << Escape(value) << '"';
+        first = false;
+    }
+    if (!extraName.empty()) {
+        os << (first ? "" : ",") << extraName << "=\"" << extraValue << '"';
+    }
+    os << '}';
+}
+
+bool ValidName(const string& name)
+{
+    if (name.empty() || (name[0] >= '0' && name[0] <= '9')) {
+        return false;
+    }
+    return all_of(name.begin(), name.end(), [](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == ':';
+    });
+}
+
+} // namespace
+
+Registry::Entry& Registry::GetEntry(const string& name, const string& help, Type type, const Labels& labels, double scale)
+{
+    if (!ValidName(name)) {
+        throw MetricsError(tools::ToString("invalid metric name '", name, "'"));
+    }
+    auto [it, inserted] = fFamilies.try_emplace(name, Family{help, type, {}});
+    Family& family = it->second;
+    if (family.fType != type) {
+        throw MetricsError(tools::ToString("metric '", name, "' exists as a ", TypeName(family.fType), ", requested as a ", TypeName(type)));
+    }
+    for (auto& entry : family.fEntries) {
+        if (entry.fLabels == labels) {
+            if (entry.fCallback) {
+                throw MetricsError(tools::ToString("metric '", name, "' with the given labels is provided by a callback"));
+            }
+            return entry;
+        }
+    }
+    Entry& entry = family.fEntries.emplace_back();
+    entry.fLabels = labels;
+    entry.fScale = scale;
+    return entry;
+}
+
+Counter& Registry::GetCounter(const string& name, const string& help, const Labels& labels, double scale)
+{
+    lock_guard<mutex> lock(fMtx);
+    Entry& entry = GetEntry(name, help, Type::Counter, labels, scale);
+    if (!entry.fCounter) {
+        entry.fCounter = make_unique<Counter>();
+    }
+    return *entry.fCounter;
+}
+
+Gauge& Registry::GetGauge(const string& name, const string& help, const Labels& labels, double scale)
+{
+    lock_guard<mutex> lock(fMtx);
+    Entry& entry = GetEntry(name, help, Type::Gauge, labels, scale);
+    if (!entry.fGauge) {
+        entry.fGauge = make_unique<Gauge>();
+    }
+    return *entry.fGauge;
+}
+
+Histogram& Registry::GetHistogram(const string& name, const string& help, const Labels& labels, double scale)
+{
+    lock_guard<mutex> lock(fMtx);
+    Entry& entry = GetEntry(name, help, Type::Histogram, labels, scale);
+    if (!entry.fHistogram) {
+        entry.fHistogram = make_unique<Histogram>();
+    }
+    return *entry.fHistogram;
+}
+
+void Registry::AddCallback(const void* owner, const string& name, const string& help, Type type, const Labels& labels, function<double()> callback)
+{
+    if (type == Type::Histogram) {
+        throw MetricsError(tools::ToString("metric '", name, "': histograms cannot be provided by a callback"));
+    }
+    lock_guard<mutex> lock(fMtx);
+    Entry& entry = GetEntry(name, help, type, labels, 1.);
+    if (entry.fCounter || entry.fGauge) {
+        throw MetricsError(tools::ToString("metric '", name, "' with the given labels exists already"));
+    }
+    entry.fOwner = owner;
+    entry.fCallback = std::move(callback);
+}
+
+void Registry::RemoveCallbacks(const void* owner)
+{
+    lock_guard<mutex> lock(fMtx);
+    for (auto it = fFamilies.begin(); it != fFamilies.end();) {
+        auto& entries = it->second.fEntries;
+        entries.erase(remove_if(entries.begin(), entries.end(), [owner](const Entry& e) { return e.fCallback && e.fOwner == owner; }), entries.end());
+        if (entries.empty()) {
+            it = fFamilies.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+size_t Registry::GetNumMetrics() const
+{
+    lock_guard<mutex> lock(fMtx);
+    size_t n = 0;
+    for (const auto& family : fFamilies) {
+        n += family.second.fEntries.size();
+    }
+    return n;
+}
+
+void Registry::WritePrometheus(ostream& os) const
+{
+    lock_guard<mutex> lock(fMtx);
+    for (const auto& [name, family] : fFamilies) {
+        os << "# HELP " << name << ' ' << family.fHelp << '\n';
+        os << "# TYPE " << name << ' ' << TypeName(family.fType) << '\n';
+        for (const auto& entry : family.fEntries) {
+            if (family.fType == Type::Histogram) {
+                Histogram::Snapshot s = entry.fHistogram->Get();
+                uint64_t cumulative = 0;
+                for (size_t i = 0; i < Histogram::kNumBuckets; ++i) {
+                    cumulative += s.fBuckets[i];
+                    os << name << "_bucket";
+                    WriteLabels(os, entry.fLabels, "le", Number(Histogram::BucketBound(i) * entry.fScale));
+                    os << ' ' << cumulative << '\n';
+                }
+                os << name << "_bucket";
+                WriteLabels(os, entry.fLabels, "le", "+Inf");
+                os << ' ' << s.fCount << '\n';
+                os << name << "_sum";
+                WriteLabels(os, entry.fLabels);
+                os << ' ' << Number(s.fSum * entry.fScale) << '\n';
+                os << name << "_count";
+                WriteLabels(os, entry.fLabels);
+                os << ' ' << s.fCount << '\n';
+                continue;
+            }
+            double value = 0.;
+            if (entry.fCallback) {
+                value = entry.fCallback();
+            } else if (entry.fCounter) {
+                value = entry.fCounter->Get() * entry.fScale;
+            } else {
+                value = entry.fGauge->Get() * entry.fScale;
+            }
+            os << name;
+            WriteLabels(os, entry.fLabels);
+            os << ' ' << Number(value) << '\n';
+        }
+    }
+}
+
+void Registry::WriteJson(ostream& os) const
+{
+    lock_guard<mutex> lock(fMtx);
+    auto const timestamp = chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+    os << "{\"timestamp_ms\": " << timestamp << ", \"metrics\": [";
+    bool first = true;
+    for (const auto& [name, family] : fFamilies) {
+        for (const auto& entry : family.fEntries) {
+            os << (first ? "\n" : ",\n") << "  {\"name\": \"" << name << "\", \"type\": \"" << TypeName(family.fType) << "\", \"labels\": {";
+            first = false;
+            bool firstLabel = true;
+            for (const auto& [label, value] : entry.fLabels) {
+                os << (firstLabel ? "" : ", ") << '"' << label << "\": \"" << Escape(value) << '"';
+                firstLabel = false;
+            }
+            os << "}, ";
+            if (family.fType == Type::Histogram) {
+                Histogram::Snapshot s = entry.fHistogram->Get();
+                os << "\"count\": " << s.fCount << ", \"sum\": " << JsonNumber(s.fSum * entry.fScale) << ", \"buckets\": [";
+                uint64_t cumulative = 0;
+                for (size_t i = 0; i < Histogram::kNumBuckets; ++i) {
+                    cumulative += s.fBuckets[i];
+                    os << (i == 0 ? "" : ", ") << "{\"le\": " << JsonNumber(Histogram::BucketBound(i) * entry.fScale) << ", \"count\": " << cumulative << "}";
+                }
+                os << "]}";
+                continue;
+            }
+            double value = 0.;
+            if (entry.fCallback) {
+                value = entry.fCallback();
+            } else if (entry.fCounter) {
+                value = entry.fCounter->Get() * entry.fScale;
+            } else {
+                value = entry.fGauge->Get() * entry.fScale;
+            }
+            os << "\"value\": " << JsonNumber(value) << "}";
+        }
+    }
+    os << (first ? "]}\n" : "\n]}\n");
+}
+
+} // namespace fair::mq::metrics
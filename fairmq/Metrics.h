@@ -0,0 +1,249 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef FAIR_MQ_METRICS_H
+#define FAIR_MQ_METRICS_H
+
+#include <fairmq/TransferCode.h>
+#include <fairmq/tools/Histogram.h>
+
+#include <algorithm> // std::min
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fair::mq::metrics
+{
+
+struct MetricsError : std::runtime_error { using std::runtime_error::runtime_error; };
+
+/// label name/value pairs of a metric
+using Labels = std::vector<std::pair<std::string, std::string>>;
+
+enum class Type { Counter, Gauge, Histogram };
+
+/// number of slots of the data path metrics, threads are spread over them
+constexpr std::size_t kNumShards = 16;
+
+/// slot of the calling thread, assigned round-robin on the first call of the thread
+inline std::size_t ShardIndex()
+{
+    static std::atomic<std::size_t> next{0};
+    thread_local std::size_t const index = next.fetch_add(1, std::memory_order_relaxed) % kNumShards;
+    return index;
+}
+
+/// Monotonic counter for the data path: every thread adds to its own cache line (one of kNumShards),
+/// so that concurrent updates do not contend. Reading sums up the slots, without locking.
+class Counter
+{
+  public:
+    void Add(uint64_t n = 1) { fShards[ShardIndex()].fValue.fetch_add(n, std::memory_order_relaxed); }
+
+    uint64_t Get() const
+    {
+        uint64_t sum = 0;
+        for (const auto& shard : fShards) {
+            sum += shard.fValue.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+  private:
+    struct alignas(64) Shard
+    {
+        std::atomic<uint64_t> fValue{0};
+    };
+    std::array<Shard, kNumShards> fShards;
+};
+
+/// Value that can go up and down (e.g. a queue depth)
+class alignas(64) Gauge
+{
+  public:
+    void Set(int64_t value) { fValue.store(value, std::memory_order_relaxed); }
+    void Add(int64_t n) { fValue.fetch_add(n, std::memory_order_relaxed); }
+    int64_t Get() const { return fValue.load(std::memory_order_relaxed); }
+
+  private:
+    std::atomic<int64_t> fValue{0};
+};
+
+/// Log-linear histogram of non-negative integer values (e.g. durations in ns) for the data path: two buckets per power of two,
+/// with the bounds 1, 2, 3, 4, 6, 8, 12, 16 ... 2^41 (~37 min in ns, relative bucket width <= 50%), and an overflow bucket.
+/// The buckets are those of tools::LatencyHistogram with 1 bit precision, shifted by one for the inclusive upper bounds of the export.
+/// Updates go to the cache lines of the calling thread, as for the Counter.
+/// For fine grained percentiles of a single thread see tools::LatencyHistogram.
+class Histogram
+{
+  public:
+    static constexpr std::size_t kNumBuckets = 82;
+    static constexpr unsigned int kPrecisionBits = 1;
+
+    void Observe(uint64_t value)
+    {
+        Shard& shard = fShards[ShardIndex()];
+        shard.fBuckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        shard.fSum.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    /// smallest bucket with value <= its bound, kNumBuckets for the overflow bucket
+    static std::size_t BucketIndex(uint64_t value)
+    {
+        if (value == 0) {
+            return 0;
+        }
+        return std::min(tools::LogLinearBucket(value - 1, kPrecisionBits), kNumBuckets);
+    }
+    static uint64_t BucketBound(std::size_t index) { return tools::LogLinearBucketMax(index, kPrecisionBits) + 1; }
+
+    struct Snapshot
+    {
+        std::array<uint64_t, kNumBuckets + 1> fBuckets{}; ///< not cumulative, the last one is the overflow bucket
+        uint64_t fCount = 0;
+        uint64_t fSum = 0;
+    };
+
+    Snapshot Get() const
+    {
+        Snapshot snapshot;
+        for (const auto& shard : fShards) {
+            for (std::size_t i = 0; i <= kNumBuckets; ++i) {
+                uint64_t n = shard.fBuckets[i].load(std::memory_order_relaxed);
+                snapshot.fBuckets[i] += n;
+                snapshot.fCount += n;
+            }
+            snapshot.fSum += shard.fSum.load(std::memory_order_relaxed);
+        }
+        return snapshot;
+    }
+
+  private:
+    struct alignas(64) Shard
+    {
+        std::array<std::atomic<uint64_t>, kNumBuckets + 1> fBuckets{};
+        std::atomic<uint64_t> fSum{0};
+    };
+    std::array<Shard, kNumShards> fShards;
+};
+
+/// Time spent in, durations and timeouts of the transfers in one direction of a channel, unset (and not measured) unless metrics are enabled.
+/// Built with FAIRMQ_NO_CHANNEL_METRICS it is never set and the checks in the data path compile away.
+struct TransferMetrics
+{
+    const std::atomic<bool>* fTiming = nullptr;
+    Counter* fBlockedNs = nullptr;
+    Counter* fTimeouts = nullptr;
+    Histogram* fDuration = nullptr;
+
+#ifdef FAIRMQ_NO_CHANNEL_METRICS
+    constexpr explicit operator bool() const { return false; }
+#else
+    explicit operator bool() const { return fTiming != nullptr; }
+#endif
+
+    /// calls transfer() (returning the result of a transfer or a TransferCode), recording its duration and timeouts if timing is switched on
+    template<typename F>
+    int64_t Measure(F&& transfer) const
+    {
+        if (!fTiming->load(std::memory_order_relaxed)) {
+            return transfer();
+        }
+        auto const start = std::chrono::steady_clock::now();
+        int64_t const result = transfer();
+        auto const ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        fBlockedNs->Add(ns);
+        if (result >= 0) {
+            fDuration->Observe(ns);
+        } else if (result == static_cast<int64_t>(TransferCode::timeout)) {
+            fTimeouts->Add();
+        }
+        return result;
+    }
+};
+
+/**
+ * @brief Named metrics of a device, exported by the metrics plugin (or any other reader)
+ *
+ * Metrics are identified by name and labels, the Get*() functions return the existing metric if it has been created before,
+ * which stays valid as long as the registry. Metrics that are already maintained elsewhere (e.g. the byte counts of the sockets)
+ * are added as callbacks, which are evaluated when the registry is read; they have to be removed (by their owner) before the
+ * data they read goes away.
+ *
+ * Creating metrics, adding and removing callbacks and writing the registry take a mutex. Updating the metrics does not,
+ * the data path only keeps the references to them.
+ */
+class Registry
+{
+  public:
+    /// @param scale factor applied to the value when exporting (e.g. 1e-9 for a counter of ns, exported in seconds)
+    Counter& GetCounter(const std::string& name, const std::string& help, const Labels& labels = {}, double scale = 1.);
+    Gauge& GetGauge(const std::string& name, const std::string& help, const Labels& labels = {}, double scale = 1.);
+    Histogram& GetHistogram(const std::string& name, const std::string& help, const Labels& labels = {}, double scale = 1.);
+
+    /// add a counter or gauge, whose value is returned by callback at export time
+    void AddCallback(const void* owner, const std::string& name, const std::string& help, Type type, const Labels& labels, std::function<double()> callback);
+    /// remove all callbacks of the given owner
+    void RemoveCallbacks(const void* owner);
+
+    /// instrument the data path (e.g. the channel transfers) when it is set up, to be set by exporters before the channels are initialized
+    void SetEnabled(bool enabled) { fEnabled = enabled; }
+    bool IsEnabled() const { return fEnabled; }
+
+    /// switch the timing of the instrumented data path on/off, also at runtime (e.g. from a property change)
+    void SetTimingEnabled(bool enabled) { fTiming.store(enabled, std::memory_order_relaxed); }
+    bool IsTimingEnabled() const { return fTiming.load(std::memory_order_relaxed); }
+    const std::atomic<bool>& GetTimingFlag() const { return fTiming; }
+
+    /// write all metrics in the Prometheus text exposition format (version 0.0.4)
+    void WritePrometheus(std::ostream& os) const;
+    /// write all metrics as a JSON object
+    void WriteJson(std::ostream& os) const;
+
+    std::size_t GetNumMetrics() const;
+
+  private:
+    struct Entry
+    {
+        Labels fLabels;
+        double fScale = 1.;
+        std::unique_ptr<Counter> fCounter;
+        std::unique_ptr<Gauge> fGauge;
+        std::unique_ptr<Histogram> fHistogram;
+        const void* fOwner = nullptr;
+        std::function<double()> fCallback;
+    };
+    struct Family
+    {
+        std::string fHelp;
+        Type fType;
+        std::vector<Entry> fEntries;
+    };
+
+    Entry& GetEntry(const std::string& name, const std::string& help, Type type, const Labels& labels, double scale);
+
+    mutable std::mutex fMtx;
+    std::map<std::string, Family> fFamilies;
+    std::atomic<bool> fEnabled{false};
+    std::atomic<bool> fTiming{false};
+};
+
+} // namespace fair::mq::metrics
+
+#endif /* FAIR_MQ_METRICS_H */
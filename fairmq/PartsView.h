@@ -0,0 +1,173 @@
+/********************************************************************************
+ * Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH       *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef FAIR_MQ_PARTSVIEW_H
+#define FAIR_MQ_PARTSVIEW_H
+
+#include <fairmq/Message.h>   // fair::mq::MessagePtr
+#include <fairmq/Parts.h>
+
+#include <cstddef>            // size_t
+#include <memory>             // std::unique_ptr
+#include <stdexcept>
+#include <string>
+#include <utility>            // std::move
+#include <vector>
+
+namespace fair::mq {
+
+struct PartsViewError : std::runtime_error { using std::runtime_error::runtime_error; };
+
+/// fair::mq::PartsView receives a multipart message as a contiguous array of lightweight handles (data pointer, size),
+/// without creating a Message per part. A part becomes a full Message only when it is taken out of the view with Take().
+/// Parts that are not taken are released with the next receive into the view, Clear() or destruction of the view.
+/// Depending on the transport the handles are backed by the received metadata only (shmem) or by regular messages.
+/// The view is meant to be reused for consecutive receives, which keeps its storage allocated.
+class PartsView
+{
+  public:
+    /// handle of a received part. The data stays valid as long as the part is in the view, or as long as the taken message lives.
+    struct Part
+    {
+        void* data;
+        size_t size;
+    };
+
+    using container = std::vector<Part>;
+    using size_type = container::size_type;
+    using const_iterator = container::const_iterator;
+
+    /// transport specific ownership of the received parts
+    struct Backend
+    {
+        Backend() = default;
+        Backend(const Backend&) = delete;
+        Backend(Backend&&) = delete;
+        Backend& operator=(const Backend&) = delete;
+        Backend& operator=(Backend&&) = delete;
+        virtual ~Backend() = default;
+
+        /// creates the message owning the given part
+        virtual MessagePtr Take(size_type index) = 0;
+        /// releases the given part, that has not been taken
+        virtual void Release(size_type index) = 0;
+        /// called after all parts have been taken or released
+        virtual void Clear() = 0;
+    };
+
+    /// fallback for transports without a dedicated view, the parts are backed by regular messages
+    struct MessageBackend : Backend
+    {
+        MessagePtr Take(size_type index) override { return std::move(fMessages[index]); }
+        void Release(size_type index) override { fMessages[index].reset(); }
+        void Clear() override { fMessages.clear(); }
+
+        Parts::container fMessages;
+    };
+
+    PartsView() = default;
+    PartsView(const PartsView&) = delete;
+    PartsView(PartsView&&) = default;
+    PartsView& operator=(const PartsView&) = delete;
+    PartsView& operator=(PartsView&& other) noexcept
+    {
+        Clear();
+        fParts = std::move(other.fParts);
+        fTaken = std::move(other.fTaken);
+        fBackend = std::move(other.fBackend);
+        return *this;
+    }
+    ~PartsView() { Clear(); }
+
+    size_type Size() const noexcept { return fParts.size(); }
+    bool Empty() const noexcept { return fParts.empty(); }
+
+    const Part& operator[](size_type index) const { return fParts[index]; }
+    const Part& At(size_type index) const { return fParts.at(index); }
+    bool IsTaken(size_type index) const { return fTaken.at(index) != 0; }
+
+    const_iterator begin() const noexcept { return fParts.begin(); }
+    const_iterator end() const noexcept { return fParts.end(); }
+    const_iterator cbegin() const noexcept { return fParts.cbegin(); }
+    const_iterator cend() const noexcept { return fParts.cend(); }
+
+    /// materializes the given part into a Message, that owns its buffer from now on. Each part can be taken once.
+    MessagePtr Take(size_type index)
+    {
+        if (index >= fParts.size()) {
+            throw PartsViewError("part index " + std::to_string(index) + " out of range, view has " + std::to_string(fParts.size()) + " parts");
+        }
+        if (fTaken[index]) {
+            throw PartsViewError("part " + std::to_string(index) + " has already been taken out of the view");
+        }
+        MessagePtr msg = fBackend->Take(index);
+        fTaken[index] = 1;
+        return msg;
+    }
+
+    /// materializes all parts that have not been taken yet, appending them to parts
+    void TakeAll(Parts& parts)
+    {
+        for (size_type i = 0; i < fParts.size(); ++i) {
+            if (!fTaken[i]) {
+                parts.AddPart(Take(i));
+            }
+        }
+    }
+
+    /// releases the parts that have not been taken and empties the view
+    void Clear()
+    {
+        if (fBackend) {
+            for (size_type i = 0; i < fParts.size(); ++i) {
+                if (!fTaken[i]) {
+                    fTaken[i] = 1;
+                    fBackend->Release(i);
+                }
+            }
+            fBackend->Clear();
+        }
+        fParts.clear();
+        fTaken.clear();
+    }
+
+    /// for transports: empties the view and returns its backend, replacing it if it is not of type B
+    template<typename B>
+    B& PrepareBackend()
+    {
+        Clear();
+        auto backend = dynamic_cast<B*>(fBackend.get());
+        if (!backend) {
+            fBackend = std::make_unique<B>();
+            backend = static_cast<B*>(fBackend.get());
+        }
+        return *backend;
+    }
+
+    /// for transports: adds the handle of the next part, after its ownership has been placed in the backend
+    void AddPart(void* data, size_t size)
+    {
+        fParts.push_back(Part{data, size});
+        fTaken.push_back(0);
+    }
+
+    void Reserve(size_type n)
+    {
+        fParts.reserve(n);
+        fTaken.reserve(n);
+    }
+
+  private:
+    container fParts;
+    std::vector<char> fTaken;
+    std::unique_ptr<Backend> fBackend;
+};
+
+}   // namespace fair::mq
+
+#endif /* FAIR_MQ_PARTSVIEW_H */
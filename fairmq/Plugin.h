@@ -92,6 +92,7 @@ class Plugin
     auto UnsubscribeFromDeviceStateChange() -> void { fPluginServices->UnsubscribeFromDeviceStateChange(fkName); }
 
     auto GetNumberOfConnectedPeers(const std::string& channelName, int index = 0) -> unsigned long { return fPluginServices->GetNumberOfConnectedPeers(channelName, index); }
+    auto GetMetrics() -> metrics::Registry& { return fPluginServices->GetMetrics(); }
 
     // device config API
     // see <fairmq/PluginServices.h> for docs
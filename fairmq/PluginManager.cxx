@@ -251,6 +251,20 @@ auto fair::mq::PluginManager::LoadPluginStatic(const string& pluginName) -> void
                 } catch (const boost::bad_optional_access&) {
                     /* just ignore, if no prog options are declared */
                 }
+            } else if ("metrics" == pluginName) {
+                try {
+                    fPluginProgOptions.insert(
+                        {pluginName, plugins::MetricsPluginProgramOptions().value()});
+                } catch (const boost::bad_optional_access&) {
+                    /* just ignore, if no prog options are declared */
+                }
+            } else if ("trace" == pluginName) {
+                try {
+                    fPluginProgOptions.insert(
+                        {pluginName, plugins::TracePluginProgramOptions().value()});
+                } catch (const boost::bad_optional_access&) {
+                    /* just ignore, if no prog options are declared */
+                }
             } else {
                 LoadSymbols(pluginName, dll::program_location());
             }
@@ -269,6 +283,10 @@ auto fair::mq::PluginManager::InstantiatePlugin(const string& pluginName) -> voi
             fPlugins[pluginName] = plugins::Make_control_Plugin(fPluginServices.get());
         } else if ("config" == pluginName) {
             fPlugins[pluginName] = plugins::Make_config_Plugin(fPluginServices.get());
+        } else if ("metrics" == pluginName) {
+            fPlugins[pluginName] = plugins::Make_metrics_Plugin(fPluginServices.get());
+        } else if ("trace" == pluginName) {
+            fPlugins[pluginName] = plugins::Make_trace_Plugin(fPluginServices.get());
         } else {
             fPlugins[pluginName] = fPluginFactories[pluginName](*fPluginServices);
         }
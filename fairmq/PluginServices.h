@@ -141,6 +141,9 @@ class PluginServices
     /// DO NOT USE, ONLY FOR TESTING, WILL BE REMOVED (and info made available via property api)
     auto GetNumberOfConnectedPeers(const std::string& channelName, int index = 0) -> unsigned long { return fDevice.GetNumberOfConnectedPeers(channelName, index); }
 
+    /// @brief Metrics registry of the device, see fair::mq::metrics::Registry
+    auto GetMetrics() -> metrics::Registry& { return fDevice.GetMetrics(); }
+
     // Config API
 
     /// @brief Checks a property with the given key exist in the configuration
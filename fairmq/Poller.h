@@ -9,12 +9,31 @@
 #ifndef FAIR_MQ_POLLER_H
 #define FAIR_MQ_POLLER_H
 
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <stdexcept>
 #include <string>
 
 namespace fair::mq {
 
+/// Poll() statistics, to tune the spin time of the busy-poll mode (CPU usage vs. latency)
+struct PollerStats
+{
+    uint64_t numPolls = 0;        ///< number of Poll() calls
+    uint64_t numSpinWakeups = 0;  ///< polls that found an event while spinning
+    uint64_t numBlockWakeups = 0; ///< polls that found an event after blocking
+    uint64_t numTimeouts = 0;     ///< polls that found no event
+    uint64_t spinTimeNs = 0;      ///< total time spent spinning
+
+    /// fraction of the events that were found while spinning
+    double SpinRatio() const
+    {
+        uint64_t numWakeups = numSpinWakeups + numBlockWakeups;
+        return numWakeups > 0 ? static_cast<double>(numSpinWakeups) / static_cast<double>(numWakeups) : 0.;
+    }
+};
+
 struct Poller
 {
     Poller() = default;
@@ -29,7 +48,32 @@ struct Poller
     virtual bool CheckInput(const std::string& channelKey, int index) = 0;
     virtual bool CheckOutput(const std::string& channelKey, int index) = 0;
 
+    /// Busy-poll mode: Poll() checks the readiness of the channels without blocking for up to the given time,
+    /// before it blocks for the rest of the timeout. 0 (default) blocks right away.
+    void SetSpinTime(std::chrono::microseconds spinTime) { fSpinTime = spinTime; }
+    std::chrono::microseconds GetSpinTime() const { return fSpinTime; }
+
+    PollerStats GetStats() const { return fStats; }
+    void ResetStats() { fStats = PollerStats(); }
+
     virtual ~Poller() = default;
+
+  protected:
+    std::chrono::microseconds fSpinTime{0};
+    PollerStats fStats;
+
+    /// for implementations: counts the outcome of a Poll() call
+    void CountPoll(bool ready, bool duringSpin)
+    {
+        ++fStats.numPolls;
+        if (!ready) {
+            ++fStats.numTimeouts;
+        } else if (duringSpin) {
+            ++fStats.numSpinWakeups;
+        } else {
+            ++fStats.numBlockWakeups;
+        }
+    }
 };
 
 using PollerPtr = std::unique_ptr<Poller>;
@@ -0,0 +1,277 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include <fairmq/Probes.h>
+#include <fairmq/tools/Strings.h>
+
+#include <array>
+#include <chrono>
+#include <cstdlib> // getenv
+#include <cstring> // std::memcmp, std::strlen
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <unistd.h> // getpid
+
+using namespace std;
+
+namespace fair::mq::probes
+{
+
+namespace
+{
+
+constexpr array<const char*, static_cast<size_t>(Probe::NumProbes)> kNames = {
+    "alloc_begin", "alloc_end", "bad_alloc_retry",
+    "dealloc_begin", "dealloc_end",
+    "refcount_inc", "refcount_dec",
+    "region_lookup_begin", "region_lookup_end", "region_cache_miss",
+    "meta_send", "meta_recv",
+    "region_ack_batch",
+    "send_begin", "send_end", "receive_begin", "receive_end",
+    "poll_begin", "poll_end"
+};
+
+// file format: | "FMQPROBE" | version (u32) | pid (u32) | number of probes (u32) | names (u8 length + chars) | events |
+constexpr char kFileMagic[8] = {'F', 'M', 'Q', 'P', 'R', 'O', 'B', 'E'};
+constexpr uint32_t kFileVersion = 1;
+
+constexpr size_t kRingSize = 65536;                        // events per thread between two writes
+constexpr auto kWriteInterval = chrono::milliseconds(10);
+
+/// single producer (the recording thread), single consumer (the writer, under gRingsMtx)
+struct Ring
+{
+    explicit Ring(uint32_t thread) : fThread(thread) {}
+
+    void Push(const Event& event)
+    {
+        uint64_t const head = fHead.load(memory_order_relaxed);
+        if (head - fTail.load(memory_order_acquire) == kRingSize) {
+            fDropped.fetch_add(1, memory_order_relaxed);
+            return;
+        }
+        fEvents[head % kRingSize] = event;
+        fHead.store(head + 1, memory_order_release);
+    }
+
+    void Drain(ostream& out)
+    {
+        uint64_t const tail = fTail.load(memory_order_relaxed);
+        uint64_t const head = fHead.load(memory_order_acquire);
+        // at most two contiguous pieces
+        for (uint64_t i = tail; i < head;) {
+            uint64_t const n = min(head - i, kRingSize - i % kRingSize);
+            out.write(reinterpret_cast<const char*>(&fEvents[i % kRingSize]), static_cast<streamsize>(n * sizeof(Event)));
+            i += n;
+        }
+        fTail.store(head, memory_order_release);
+    }
+
+    const uint32_t fThread;
+    array<Event, kRingSize> fEvents;
+    alignas(64) atomic<uint64_t> fHead{0};
+    alignas(64) atomic<uint64_t> fTail{0};
+    atomic<uint64_t> fDropped{0};
+};
+
+mutex gRingsMtx;
+vector<shared_ptr<Ring>> gRings; // rings of the threads that recorded events, removed by the writer after their thread is gone
+uint32_t gNumThreads = 0;
+uint64_t gDroppedGone = 0;
+
+mutex gRecorderMtx; // start/stop
+ofstream gOut;
+thread gWriter;
+atomic<bool> gStop{false};
+
+Ring& GetRing()
+{
+    thread_local shared_ptr<Ring> ring;
+    if (!ring) {
+        lock_guard<mutex> lock(gRingsMtx);
+        ring = make_shared<Ring>(gNumThreads++);
+        gRings.push_back(ring);
+    }
+    return *ring;
+}
+
+uint64_t Now()
+{
+    return static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void WriteEvents()
+{
+    lock_guard<mutex> lock(gRingsMtx);
+    for (auto it = gRings.begin(); it != gRings.end();) {
+        bool const gone = it->use_count() == 1; // only referenced here anymore, nothing is added after draining
+        (*it)->Drain(gOut);
+        if (gone) {
+            gDroppedGone += (*it)->fDropped;
+            it = gRings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    gOut.flush();
+}
+
+void WriteDropped()
+{
+    lock_guard<mutex> lock(gRingsMtx);
+    uint64_t dropped = gDroppedGone;
+    for (auto& ring : gRings) {
+        dropped += ring->fDropped.exchange(0);
+    }
+    gDroppedGone = 0;
+    if (dropped > 0) {
+        Event event{Now(), dropped, 0, kDropped, 0};
+        gOut.write(reinterpret_cast<const char*>(&event), sizeof(event));
+    }
+}
+
+template<typename T>
+void Read(istream& in, T& value)
+{
+    if (!in.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+        throw ProbesError("truncated probes recording");
+    }
+}
+
+/// starts the recorder for processes started with FAIRMQ_PROBES_FILE, stops it at exit
+struct AutoRecording
+{
+    AutoRecording()
+    {
+#ifdef FAIRMQ_PROBES
+        if (const char* file = getenv("FAIRMQ_PROBES_FILE"); file && *file) {
+            try {
+                StartRecording(file);
+            } catch (const ProbesError& e) {
+                cerr << "FAIRMQ_PROBES_FILE: " << e.what() << endl;
+            }
+        }
+#endif
+    }
+    ~AutoRecording() { StopRecording(); }
+} gAutoRecording;
+
+} // namespace
+
+const char* GetName(Probe probe)
+{
+    auto const i = static_cast<size_t>(probe);
+    return i < kNames.size() ? kNames[i] : "unknown";
+}
+
+void StartRecording(const string& file)
+{
+    lock_guard<mutex> lock(gRecorderMtx);
+    if (gWriter.joinable()) {
+        throw ProbesError("the probes recorder is already running");
+    }
+
+    string path = file;
+    if (auto pos = path.find("%p"); pos != string::npos) {
+        path.replace(pos, 2, to_string(getpid()));
+    }
+    gOut.open(path, ios::binary | ios::trunc);
+    if (!gOut) {
+        throw ProbesError(tools::ToString("cannot open '", path, "' for writing"));
+    }
+
+    gOut.write(kFileMagic, sizeof(kFileMagic));
+    uint32_t const header[] = {kFileVersion, static_cast<uint32_t>(getpid()), static_cast<uint32_t>(kNames.size())};
+    gOut.write(reinterpret_cast<const char*>(header), sizeof(header));
+    for (const char* name : kNames) {
+        auto const len = static_cast<uint8_t>(strlen(name));
+        gOut.put(static_cast<char>(len));
+        gOut.write(name, len);
+    }
+
+    gStop = false;
+    gWriter = thread([]() {
+        while (!gStop) {
+            this_thread::sleep_for(kWriteInterval);
+            WriteEvents();
+        }
+    });
+    detail::gRecording = true;
+}
+
+void StopRecording()
+{
+    lock_guard<mutex> lock(gRecorderMtx);
+    if (!gWriter.joinable()) {
+        return;
+    }
+    detail::gRecording = false;
+    gStop = true;
+    gWriter.join();
+    WriteEvents();
+    WriteDropped();
+    gOut.close();
+}
+
+bool IsRecording() { return detail::gRecording; }
+
+Recording ReadRecording(istream& in)
+{
+    char magic[sizeof(kFileMagic)];
+    if (!in.read(magic, sizeof(magic)) || memcmp(magic, kFileMagic, sizeof(magic)) != 0) {
+        throw ProbesError("not a probes recording");
+    }
+    uint32_t version = 0;
+    uint32_t pid = 0;
+    uint32_t numProbes = 0;
+    Read(in, version);
+    if (version != kFileVersion) {
+        throw ProbesError(tools::ToString("unsupported probes recording version ", version));
+    }
+    Read(in, pid);
+    Read(in, numProbes);
+
+    Recording recording;
+    recording.fPid = static_cast<int>(pid);
+    for (uint32_t i = 0; i < numProbes; ++i) {
+        uint8_t len = 0;
+        Read(in, len);
+        string name(len, '\0');
+        if (!in.read(name.data(), len)) {
+            throw ProbesError("truncated probes recording");
+        }
+        recording.fProbeNames.push_back(move(name));
+    }
+
+    Event event;
+    while (in.read(reinterpret_cast<char*>(&event), sizeof(event))) {
+        if (event.fProbe != kDropped && event.fProbe >= numProbes) {
+            throw ProbesError(tools::ToString("invalid probe ", event.fProbe, " in probes recording"));
+        }
+        recording.fEvents.push_back(event);
+    }
+    // a partially written last event (process killed while writing) is ignored
+    return recording;
+}
+
+namespace detail
+{
+
+void Record(Probe probe, uint64_t arg)
+{
+    Ring& ring = GetRing();
+    ring.Push(Event{Now(), arg, ring.fThread, static_cast<uint16_t>(probe), 0});
+}
+
+} // namespace detail
+
+} // namespace fair::mq::probes
@@ -0,0 +1,137 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef FAIR_MQ_PROBES_H
+#define FAIR_MQ_PROBES_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Tracepoints of the transport layer, compiled in with -DFAIRMQ_PROBES=ON (defines FAIRMQ_PROBES), no code otherwise.
+ *
+ * FAIRMQ_PROBE(name, arg) fires the probe `name` (one of Probe) with an integer argument:
+ *  - as a USDT probe `fairmq:name` (if <sys/sdt.h> was found at build time, FAIRMQ_HAVE_SDT), usable with
+ *    perf, bpftrace or SystemTap. A disabled USDT probe is a nop instruction.
+ *  - if the fallback recorder is running (StartRecording(), or the environment variable FAIRMQ_PROBES_FILE),
+ *    as an event in a lock-free buffer of the calling thread, written to the file by a background thread.
+ *    The fairmq-probes tool summarizes such files.
+ * FAIRMQ_PROBE_SCOPE(name, arg) fires name_begin and, when leaving the scope, name_end.
+ *
+ * Most probes are in header-only code, they end up in the binaries that include it (e.g. the device executables).
+ */
+namespace fair::mq::probes
+{
+
+enum class Probe : uint16_t
+{
+    alloc_begin,         ///< shmem::Manager::Allocate, arg: size
+    alloc_end,
+    bad_alloc_retry,     ///< segment full, arg: attempt
+    dealloc_begin,       ///< shmem::Message::Deallocate, arg: size
+    dealloc_end,
+    refcount_inc,        ///< references added to a shared buffer, arg: number
+    refcount_dec,        ///< reference released, arg: count before
+    region_lookup_begin, ///< shmem::Manager::GetRegionFromCache, arg: region id
+    region_lookup_end,
+    region_cache_miss,   ///< region not in the thread local cache, arg: region id
+    meta_send,           ///< shmem metadata message sent, arg: number of messages
+    meta_recv,           ///< shmem metadata message received, arg: number of messages
+    region_ack_batch,    ///< acks delivered to a region callback, arg: number
+    send_begin,          ///< shmem::Socket::Send, arg: number of messages
+    send_end,
+    receive_begin,       ///< shmem::Socket::Receive
+    receive_end,
+    poll_begin,          ///< Poller::Poll, arg: timeout
+    poll_end,
+    NumProbes
+};
+
+const char* GetName(Probe probe);
+
+/// as recorded by the fallback recorder
+struct Event
+{
+    uint64_t fTimeNs; ///< steady clock (CLOCK_MONOTONIC), comparable between processes of a host
+    uint64_t fArg;
+    uint32_t fThread; ///< sequential number of the thread within the process
+    uint16_t fProbe;  ///< index into Recording::fProbeNames, kDropped for the number of dropped events
+    uint16_t fReserved;
+};
+static_assert(sizeof(Event) == 24, "the event is part of the file format");
+
+constexpr uint16_t kDropped = 0xffff;
+
+struct ProbesError : std::runtime_error { using std::runtime_error::runtime_error; };
+
+/// start the fallback recorder, writing to the given file ("%p" is replaced by the process id), throws ProbesError
+void StartRecording(const std::string& file);
+/// stop the recorder and write the remaining events
+void StopRecording();
+bool IsRecording();
+
+/// content of a file written by the recorder
+struct Recording
+{
+    int fPid = 0;
+    std::vector<std::string> fProbeNames;
+    std::vector<Event> fEvents;
+};
+
+/// throws ProbesError if the content is not a recording
+Recording ReadRecording(std::istream& in);
+
+namespace detail
+{
+
+inline std::atomic<bool> gRecording{false};
+
+void Record(Probe probe, uint64_t arg);
+
+template<typename F>
+struct ProbeScope
+{
+    F fEnd;
+    ~ProbeScope() { fEnd(); }
+};
+template<typename F>
+ProbeScope(F) -> ProbeScope<F>;
+
+} // namespace detail
+
+} // namespace fair::mq::probes
+
+#ifdef FAIRMQ_PROBES
+#ifdef FAIRMQ_HAVE_SDT
+#include <sys/sdt.h>
+#define FAIRMQ_PROBE_USDT(name, arg) DTRACE_PROBE1(fairmq, name, arg)
+#else
+#define FAIRMQ_PROBE_USDT(name, arg) static_cast<void>(arg)
+#endif
+#define FAIRMQ_PROBE(name, arg)                                                                                   \
+    do {                                                                                                          \
+        uint64_t const fairmqProbeArg = static_cast<uint64_t>(arg);                                               \
+        FAIRMQ_PROBE_USDT(name, fairmqProbeArg);                                                                  \
+        if (::fair::mq::probes::detail::gRecording.load(std::memory_order_relaxed)) {                             \
+            ::fair::mq::probes::detail::Record(::fair::mq::probes::Probe::name, fairmqProbeArg);                  \
+        }                                                                                                         \
+    } while (false)
+#define FAIRMQ_PROBE_SCOPE(name, arg)                                                                             \
+    FAIRMQ_PROBE(name##_begin, arg);                                                                              \
+    ::fair::mq::probes::detail::ProbeScope fairmqProbeScope_##name{[&]() { FAIRMQ_PROBE(name##_end, arg); }}
+#else
+#define FAIRMQ_PROBE(name, arg) static_cast<void>(0)
+#define FAIRMQ_PROBE_SCOPE(name, arg) static_cast<void>(0)
+#endif
+
+#endif /* FAIR_MQ_PROBES_H */
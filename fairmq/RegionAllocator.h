@@ -0,0 +1,243 @@
+/********************************************************************************
+ * Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH       *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef FAIR_MQ_REGIONALLOCATOR_H
+#define FAIR_MQ_REGIONALLOCATOR_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef> // size_t
+#include <cstdint>
+#include <memory> // unique_ptr
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace fair::mq {
+
+struct RegionAllocatorError : std::runtime_error { using std::runtime_error::runtime_error; };
+
+/// what RegionAllocator::Allocate does when the region is full
+enum class RegionAllocationPolicy : int
+{
+    fail,  /// return nullptr immediately
+    spin,  /// busy-wait for acknowledgements (until the timeout)
+    block  /// sleep until acknowledgements arrive (until the timeout)
+};
+
+/// @brief Lock-free ring buffer allocator over the memory of an unmanaged region
+///
+/// Buffers are carved sequentially from the region (in units of the granularity) and are returned by Release(),
+/// in any order. The space of released buffers becomes available again once all buffers allocated before them are
+/// released as well. Allocate() can be called from any number of threads. Attached to a region via
+/// RegionConfig::allocator, buffers are released automatically when the transport acknowledges the message that was
+/// created from them (one message per buffer).
+class RegionAllocator
+{
+  public:
+    explicit RegionAllocator(size_t granularity = 256)
+        : fGranularity(granularity)
+    {
+        if (fGranularity == 0 || (fGranularity & (fGranularity - 1)) != 0) {
+            throw RegionAllocatorError("region allocator granularity must be a power of 2");
+        }
+    }
+
+    RegionAllocator(void* base, size_t size, size_t granularity = 256)
+        : RegionAllocator(granularity)
+    {
+        Init(base, size);
+    }
+
+    RegionAllocator(const RegionAllocator&) = delete;
+    RegionAllocator(RegionAllocator&&) = delete;
+    RegionAllocator& operator=(const RegionAllocator&) = delete;
+    RegionAllocator& operator=(RegionAllocator&&) = delete;
+
+    /// sets the managed memory, before any allocation
+    void Init(void* base, size_t size)
+    {
+        fBase = static_cast<char*>(base);
+        fNumGranules = size / fGranularity;
+        if (fNumGranules >= (1ULL << 31)) {
+            throw RegionAllocatorError("region too large for the allocator granularity");
+        }
+        fEntries = std::make_unique<std::atomic<uint32_t>[]>(fNumGranules);
+        for (size_t i = 0; i < fNumGranules; ++i) {
+            fEntries[i].store(0, std::memory_order_relaxed);
+        }
+        fHead.store(0, std::memory_order_relaxed);
+        fTail.store(0, std::memory_order_relaxed);
+    }
+
+    /// @brief allocate a buffer of the given size from the region
+    /// @param size buffer size
+    /// @param alignment alignment of the returned buffer (0: granularity)
+    /// @param policy what to do when the region is full
+    /// @param timeoutMs max. time to wait for space for the spin/block policies (-1: no timeout)
+    /// @return pointer to the buffer, nullptr if there was no space (in time) or the buffer can never fit
+    void* Allocate(size_t size, size_t alignment = 0, RegionAllocationPolicy policy = RegionAllocationPolicy::block, int timeoutMs = -1)
+    {
+        void* ptr = TryAllocate(size, alignment);
+        if (ptr || policy == RegionAllocationPolicy::fail || timeoutMs == 0 || NumGranules(size, alignment) > fNumGranules) {
+            return ptr;
+        }
+
+        auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        if (policy == RegionAllocationPolicy::spin) {
+            while (!ptr && (timeoutMs < 0 || std::chrono::steady_clock::now() < until)) {
+                std::this_thread::yield();
+                ptr = TryAllocate(size, alignment);
+            }
+            return ptr;
+        }
+
+        fNumWaiters.fetch_add(1, std::memory_order_seq_cst);
+        while (true) {
+            // a release after this point changes the generation, the wait below does not miss it
+            uint64_t gen = fReleaseGen.load(std::memory_order_seq_cst);
+            if ((ptr = TryAllocate(size, alignment))) {
+                break;
+            }
+            std::unique_lock<std::mutex> lock(fMtx);
+            auto released = [&]() { return fReleaseGen.load(std::memory_order_seq_cst) != gen; };
+            if (timeoutMs < 0) {
+                fSpaceCV.wait(lock, released);
+            } else if (!fSpaceCV.wait_until(lock, until, released)) {
+                break;
+            }
+        }
+        fNumWaiters.fetch_sub(1, std::memory_order_seq_cst);
+        return ptr;
+    }
+
+    /// allocate without waiting, returns nullptr if there is no space
+    void* TryAllocate(size_t size, size_t alignment = 0)
+    {
+        const uint64_t n = NumGranules(size, alignment);
+        if (n > fNumGranules) {
+            return nullptr;
+        }
+
+        uint64_t head = fHead.load(std::memory_order_relaxed);
+        uint64_t skip = 0;
+        while (true) {
+            uint64_t pos = head % fNumGranules;
+            skip = (pos + n > fNumGranules) ? fNumGranules - pos : 0; // does not fit before the end, wrap around
+            if (head + skip + n - fTail.load(std::memory_order_acquire) > fNumGranules) {
+                return nullptr; // full
+            }
+            if (fHead.compare_exchange_weak(head, head + skip + n, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+
+        const uint64_t start = (head + skip) % fNumGranules;
+        fEntries[start].store(static_cast<uint32_t>(n << 1), std::memory_order_release);
+        if (skip > 0) {
+            // the skipped space at the end is released right away
+            fEntries[head % fNumGranules].store(static_cast<uint32_t>(skip << 1) | 1U, std::memory_order_seq_cst);
+            Advance();
+        }
+
+        char* ptr = fBase + start * fGranularity;
+        if (alignment > 1) {
+            auto addr = reinterpret_cast<uintptr_t>(ptr);
+            ptr += (alignment - addr % alignment) % alignment;
+        }
+        return ptr;
+    }
+
+    /// release a buffer (or any address within it) returned by Allocate
+    void Release(void* ptr)
+    {
+        auto offset = static_cast<size_t>(static_cast<char*>(ptr) - fBase);
+        if (static_cast<char*>(ptr) < fBase || offset >= fNumGranules * fGranularity) {
+            throw RegionAllocatorError("released pointer does not belong to the region allocator");
+        }
+        // the entry of the first granule of a buffer is the only non-zero one within it
+        uint64_t index = offset / fGranularity;
+        while (index > 0 && fEntries[index].load(std::memory_order_acquire) == 0) {
+            --index;
+        }
+        fEntries[index].fetch_or(1U, std::memory_order_seq_cst);
+        Advance();
+    }
+
+    size_t GetCapacity() const { return fNumGranules * fGranularity; }
+    size_t GetGranularity() const { return fGranularity; }
+    /// space not occupied by buffers (or released buffers that are waiting for older ones)
+    size_t GetFreeSize() const
+    {
+        uint64_t tail = fTail.load(std::memory_order_acquire);
+        uint64_t head = fHead.load(std::memory_order_acquire);
+        return (fNumGranules - (head > tail ? head - tail : 0)) * fGranularity;
+    }
+
+  private:
+    const size_t fGranularity;
+    char* fBase = nullptr;
+    uint64_t fNumGranules = 0;
+    // per granule: (number of granules << 1) | released for the first granule of a buffer, 0 otherwise
+    std::unique_ptr<std::atomic<uint32_t>[]> fEntries;
+    std::atomic<uint64_t> fHead{0}; // in granules, monotonic
+    std::atomic<uint64_t> fTail{0};
+    std::atomic_flag fAdvancing = ATOMIC_FLAG_INIT;
+    std::atomic<int> fNumWaiters{0};
+    std::atomic<uint64_t> fReleaseGen{0};
+    std::mutex fMtx;
+    std::condition_variable fSpaceCV;
+
+    uint64_t NumGranules(size_t size, size_t alignment) const
+    {
+        // granules are aligned like the region base (at most to the granularity), reserve room for padding otherwise
+        bool padded = alignment > fGranularity || (alignment > 1 && reinterpret_cast<uintptr_t>(fBase) % alignment != 0);
+        size_t bytes = size + (padded ? alignment - 1 : 0);
+        return bytes == 0 ? 1 : (bytes + fGranularity - 1) / fGranularity;
+    }
+
+    // moves the tail over released buffers, by one thread at a time
+    void Advance()
+    {
+        bool advanced = false;
+        while (!fAdvancing.test_and_set(std::memory_order_seq_cst)) {
+            uint64_t tail = fTail.load(std::memory_order_relaxed);
+            const uint64_t head = fHead.load(std::memory_order_acquire);
+            while (tail < head) {
+                auto& entry = fEntries[tail % fNumGranules];
+                uint32_t value = entry.load(std::memory_order_acquire);
+                if ((value & 1U) == 0) {
+                    break; // in use, or allocation not completed yet
+                }
+                entry.store(0, std::memory_order_relaxed);
+                tail += value >> 1;
+                advanced = true;
+            }
+            fTail.store(tail, std::memory_order_release);
+            fAdvancing.clear(std::memory_order_seq_cst);
+
+            // a release that came in while the flag was held did not advance, check for it
+            if (tail >= fHead.load(std::memory_order_seq_cst) || (fEntries[tail % fNumGranules].load(std::memory_order_seq_cst) & 1U) == 0) {
+                break;
+            }
+        }
+
+        if (advanced) {
+            fReleaseGen.fetch_add(1, std::memory_order_seq_cst);
+        }
+        if (advanced && fNumWaiters.load(std::memory_order_seq_cst) > 0) {
+            { std::lock_guard<std::mutex> lock(fMtx); }
+            fSpaceCV.notify_all();
+        }
+    }
+};
+
+} // namespace fair::mq
+
+#endif /* FAIR_MQ_REGIONALLOCATOR_H */
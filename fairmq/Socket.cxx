@@ -0,0 +1,122 @@
+/********************************************************************************
+ * Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH       *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include <fairmq/Socket.h>
+#include <fairmq/TransportFactory.h>
+
+namespace fair::mq {
+
+int64_t Socket::SendBatch(std::vector<MessagePtr>& msgs, int timeout)
+{
+    int64_t numSent = 0;
+    for (auto& msg : msgs) {
+        int64_t result = Send(msg, numSent == 0 ? timeout : 0);
+        if (result < 0) {
+            return numSent == 0 ? result : numSent;
+        }
+        ++numSent;
+    }
+    return numSent;
+}
+
+int64_t Socket::ReceiveBatch(std::vector<MessagePtr>& msgs, std::size_t maxMessages, int timeout)
+{
+    int64_t numReceived = 0;
+    while (static_cast<std::size_t>(numReceived) < maxMessages) {
+        MessagePtr msg(GetTransport()->CreateMessage());
+        int64_t result = Receive(msg, numReceived == 0 ? timeout : 0);
+        if (result < 0) {
+            return numReceived == 0 ? result : numReceived;
+        }
+        msgs.push_back(std::move(msg));
+        ++numReceived;
+    }
+    return numReceived;
+}
+
+int64_t Socket::Receive(PartsView& view, int timeout)
+{
+    auto& backend = view.PrepareBackend<PartsView::MessageBackend>();
+    int64_t result = Receive(backend.fMessages, timeout);
+    if (result < 0) {
+        backend.Clear();
+        return result;
+    }
+    view.Reserve(backend.fMessages.size());
+    for (auto& msg : backend.fMessages) {
+        view.AddPart(msg->GetData(), msg->GetSize());
+    }
+    return result;
+}
+
+int64_t Socket::SendToAll(const std::vector<Socket*>& sockets, MessagePtr& msg, int timeout)
+{
+    int64_t result = 0;
+    int64_t failure = 0;
+    for (std::size_t i = 0; i < sockets.size(); ++i) {
+        if (i + 1 < sockets.size()) {
+            MessagePtr copy(GetTransport()->CreateMessage());
+            copy->Copy(*msg);
+            result = sockets[i]->Send(copy, timeout);
+        } else {
+            result = sockets[i]->Send(msg, timeout);
+        }
+        if (result < 0 && failure == 0) {
+            failure = result;
+        }
+    }
+    return failure < 0 ? failure : result;
+}
+
+int64_t Socket::SendToAll(const std::vector<Socket*>& sockets, Parts::container& msgVec, int timeout)
+{
+    int64_t result = 0;
+    int64_t failure = 0;
+    for (std::size_t i = 0; i < sockets.size(); ++i) {
+        if (i + 1 < sockets.size()) {
+            Parts::container copies;
+            copies.reserve(msgVec.size());
+            for (auto& msg : msgVec) {
+                copies.push_back(GetTransport()->CreateMessage());
+                copies.back()->Copy(*msg);
+            }
+            result = sockets[i]->Send(copies, timeout);
+        } else {
+            result = sockets[i]->Send(msgVec, timeout);
+        }
+        if (result < 0 && failure == 0) {
+            failure = result;
+        }
+    }
+    return failure < 0 ? failure : result;
+}
+
+int64_t Socket::Forward(Socket& destination, bool multipart, int timeout, int sndTimeout)
+{
+    if (multipart) {
+        fForwardParts.clear();
+        int64_t result = Receive(fForwardParts, timeout);
+        if (result < 0) {
+            return result;
+        }
+        return destination.Send(fForwardParts, sndTimeout);
+    }
+
+    if (!fForwardMsg) {
+        fForwardMsg = GetTransport()->CreateMessage();
+    } else {
+        fForwardMsg->Rebuild();
+    }
+    int64_t result = Receive(fForwardMsg, timeout);
+    if (result < 0) {
+        return result;
+    }
+    return destination.Send(fForwardMsg, sndTimeout);
+}
+
+} // namespace fair::mq
@@ -11,7 +11,11 @@
 
 #include <fairmq/Message.h>
 #include <fairmq/Parts.h>
+#include <fairmq/PartsView.h>
+#include <fairmq/TransferCode.h>
 
+#include <cstddef> // size_t
+#include <cstdint>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -22,14 +26,6 @@ namespace fair::mq {
 
 class TransportFactory;
 
-enum class TransferCode : int
-{
-    success = 0,
-    error = -1,
-    timeout = -2,
-    interrupted = -3
-};
-
 template <typename T>
 struct is_transferrable : std::disjunction<std::is_same<T, MessagePtr>,
                                            std::is_same<T, std::vector<MessagePtr>>,
@@ -56,6 +52,36 @@ struct Socket
     virtual int64_t Receive(Parts::container & msgVec, int timeout = -1) = 0;
     virtual int64_t Send(Parts& parts, int timeout = -1) { return Send(parts.fParts, timeout); }
     virtual int64_t Receive(Parts& parts, int timeout = -1) { return Receive(parts.fParts, timeout); }
+    /// Receive a multipart message into a view, replacing its previous content (see PartsView).
+    /// Transports without a dedicated view implementation receive regular messages behind the view.
+    virtual int64_t Receive(PartsView& view, int timeout = -1);
+
+    /// Send the given messages as independent single-part messages (as opposed to Send(Parts::container&), which sends one multipart message).
+    /// Only the first message waits for the given timeout, the rest are sent if possible without waiting.
+    /// @return number of sent messages (the first n of msgs), or TransferCode if none could be sent
+    virtual int64_t SendBatch(std::vector<MessagePtr>& msgs, int timeout = -1);
+    /// Receive up to maxMessages independent single-part messages, appending them to msgs.
+    /// Waits for the given timeout only for the first message, then takes what is available without waiting.
+    /// Messages of a coalesced batch beyond maxMessages are kept for the next receive calls (of any kind) on the socket.
+    /// @return number of received messages, or TransferCode if none could be received
+    virtual int64_t ReceiveBatch(std::vector<MessagePtr>& msgs, std::size_t maxMessages, int timeout = -1);
+
+    /// Send the same message to all given sockets (of the transport of this socket, which is one of them), as by Send() on each of them.
+    /// The last socket receives msg itself, the others a copy of it (Message::Copy()). Where possible, transports share the
+    /// encoded message among all destinations instead of creating a copy per destination, which this default implementation does.
+    /// A destination that cannot take the message within the timeout does not get it, without affecting the other destinations.
+    /// @return number of bytes queued for each destination if all got the message, otherwise the TransferCode of the first destination that did not
+    virtual int64_t SendToAll(const std::vector<Socket*>& sockets, MessagePtr& msg, int timeout = -1);
+    /// Send the same multipart message to all given sockets, see SendToAll(const std::vector<Socket*>&, MessagePtr&, int).
+    virtual int64_t SendToAll(const std::vector<Socket*>& sockets, Parts::container& msgVec, int timeout = -1);
+
+    /// Receive one message (multipart or single-part, as given) from this socket and send it on the destination socket.
+    /// The message and part containers are reused across calls.
+    /// Transports may hand the received data on without creating message objects for it, if both sockets allow it.
+    /// @param timeout for the receive, the message is not consumed if none arrives within it
+    /// @param sndTimeout for the send to the destination
+    /// @return number of forwarded bytes, or TransferCode. If the send fails (or times out) the received message is dropped.
+    virtual int64_t Forward(Socket& destination, bool multipart, int timeout = -1, int sndTimeout = -1);
 
     [[deprecated("Use Socket::~Socket() instead.")]]
     virtual void Close() = 0;
@@ -82,6 +108,9 @@ struct Socket
     virtual unsigned long GetBytesRx() const = 0;
     virtual unsigned long GetMessagesTx() const = 0;
     virtual unsigned long GetMessagesRx() const = 0;
+    /// number of times a blocking send/receive had to wait for another socket timeout period (e.g. because of a full queue or no data)
+    virtual unsigned long GetRetriesTx() const { return 0; }
+    virtual unsigned long GetRetriesRx() const { return 0; }
 
     virtual unsigned long GetNumberOfConnectedPeers() const = 0;
 
@@ -92,6 +121,8 @@ struct Socket
 
   private:
     TransportFactory* fTransport{nullptr};
+    MessagePtr fForwardMsg;         // reused by Forward() for single-part messages
+    Parts::container fForwardParts; // reused by Forward() for multipart messages
 };
 
 using SocketPtr = std::unique_ptr<Socket>;
@@ -0,0 +1,235 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include <fairmq/Tracing.h>
+
+#include <algorithm> // std::min, std::max
+#include <array>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace fair::mq::tracing
+{
+
+namespace
+{
+
+constexpr size_t kRingSize = 2048; // spans per thread between two Collect() calls
+
+/// single producer (the recording thread), single consumer (Collect, under gRingsMtx)
+struct Ring
+{
+    explicit Ring(uint32_t thread) : fThread(thread) {}
+
+    void Push(const Span& span)
+    {
+        uint64_t const head = fHead.load(memory_order_relaxed);
+        if (head - fTail.load(memory_order_acquire) == kRingSize) {
+            fDropped.fetch_add(1, memory_order_relaxed);
+            return;
+        }
+        fSpans[head % kRingSize] = span;
+        fHead.store(head + 1, memory_order_release);
+    }
+
+    size_t Drain(const function<void(const Span&)>& callback)
+    {
+        uint64_t const tail = fTail.load(memory_order_relaxed);
+        uint64_t const head = fHead.load(memory_order_acquire);
+        for (uint64_t i = tail; i < head; ++i) {
+            callback(fSpans[i % kRingSize]);
+        }
+        fTail.store(head, memory_order_release);
+        return head - tail;
+    }
+
+    const uint32_t fThread;
+    array<Span, kRingSize> fSpans;
+    alignas(64) atomic<uint64_t> fHead{0};
+    alignas(64) atomic<uint64_t> fTail{0};
+    atomic<uint64_t> fDropped{0};
+};
+
+mutex gRingsMtx;
+vector<shared_ptr<Ring>> gRings; // rings of the threads that recorded spans, removed by Collect() after their thread is gone
+uint32_t gNumThreads = 0;
+uint64_t gDroppedGone = 0; // dropped spans of removed rings
+
+atomic<uint64_t> gThreshold{0}; // sample if a random 64 bit value is below, max = always
+atomic<double> gSampleRate{0.};
+
+struct ThreadState
+{
+    ThreadState()
+    {
+        random_device rd;
+        fRng = (static_cast<uint64_t>(rd()) << 32) ^ rd() ^ hash<thread::id>()(this_thread::get_id());
+        if (fRng == 0) {
+            fRng = 0x9e3779b97f4a7c15;
+        }
+    }
+
+    uint64_t Random() // xorshift64*
+    {
+        fRng ^= fRng >> 12;
+        fRng ^= fRng << 25;
+        fRng ^= fRng >> 27;
+        return fRng * 0x2545f4914f6cdd1d;
+    }
+
+    Ring& GetRing()
+    {
+        if (!fRing) {
+            lock_guard<mutex> lock(gRingsMtx);
+            fRing = make_shared<Ring>(gNumThreads++);
+            gRings.push_back(fRing);
+        }
+        return *fRing;
+    }
+
+    uint64_t fRng;
+    Context fCurrent;
+    Context fLast; ///< context of the last transfer, if traced
+    shared_ptr<Ring> fRing;
+};
+
+ThreadState& State()
+{
+    thread_local ThreadState state;
+    return state;
+}
+
+} // namespace
+
+void Enable(double sampleRate)
+{
+    SetSampleRate(sampleRate);
+    detail::gEnabled = true;
+}
+
+void Disable()
+{
+    detail::gEnabled = false;
+}
+
+void SetSampleRate(double sampleRate)
+{
+    sampleRate = max(0., min(sampleRate, 1.));
+    gSampleRate = sampleRate;
+    if (sampleRate >= 1.) {
+        gThreshold = numeric_limits<uint64_t>::max();
+    } else {
+        gThreshold = static_cast<uint64_t>(sampleRate * 18446744073709551616.); // * 2^64
+    }
+}
+
+double GetSampleRate() { return gSampleRate; }
+
+uint64_t Now()
+{
+    return static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count());
+}
+
+bool Outgoing(Context& ctx)
+{
+    ThreadState& state = State();
+    if (state.fCurrent.fTraceId != 0) {
+        ctx = state.fCurrent;
+        ++ctx.fHop;
+    } else {
+        uint64_t const threshold = gThreshold.load(memory_order_relaxed);
+        if (threshold == 0 || (threshold != numeric_limits<uint64_t>::max() && state.Random() >= threshold)) {
+            return false;
+        }
+        ctx = Context();
+        ctx.fTraceId = state.Random() | 1;
+        ctx.fOriginNs = Now();
+    }
+    ctx.fSentNs = Now();
+    state.fLast = ctx;
+    return true;
+}
+
+void Incoming(const Context& ctx)
+{
+    ThreadState& state = State();
+    state.fCurrent = ctx;
+    state.fLast = ctx;
+}
+
+void BeginTransfer()
+{
+    State().fLast.fTraceId = 0;
+}
+
+void EndTransfer(const string& channel, Direction direction, uint64_t startNs, int64_t result)
+{
+    ThreadState& state = State();
+    if (result < 0) {
+        return;
+    }
+    if (state.fLast.fTraceId == 0) {
+        if (direction != Direction::tx) {
+            state.fCurrent = Context(); // what is sent next does not belong to the previous trace anymore
+        }
+        return;
+    }
+
+    Span span;
+    span.fContext = state.fLast;
+    span.fStartNs = startNs;
+    span.fEndNs = Now();
+    span.fBytes = result;
+    span.fDirection = direction;
+    Ring& ring = state.GetRing();
+    span.fThread = ring.fThread;
+    channel.copy(span.fChannel, sizeof(span.fChannel) - 1);
+    ring.Push(span);
+    state.fLast.fTraceId = 0;
+}
+
+Context GetCurrentContext() { return State().fCurrent; }
+
+void ClearCurrentContext() { State().fCurrent = Context(); }
+
+size_t Collect(const function<void(const Span&)>& callback)
+{
+    lock_guard<mutex> lock(gRingsMtx);
+    size_t n = 0;
+    for (auto it = gRings.begin(); it != gRings.end();) {
+        // only referenced here anymore: the thread is gone, nothing is added after draining
+        bool const gone = it->use_count() == 1;
+        n += (*it)->Drain(callback);
+        if (gone) {
+            gDroppedGone += (*it)->fDropped;
+            it = gRings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return n;
+}
+
+uint64_t GetNumDropped()
+{
+    lock_guard<mutex> lock(gRingsMtx);
+    uint64_t n = gDroppedGone;
+    for (auto& ring : gRings) {
+        n += ring->fDropped;
+    }
+    return n;
+}
+
+} // namespace fair::mq::tracing
@@ -0,0 +1,104 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef FAIR_MQ_TRACING_H
+#define FAIR_MQ_TRACING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/**
+ * Message tracing: a sampled message carries a small trace context from hop to hop, each traced Send/Receive of a Channel
+ * records a span into a buffer of the calling thread, which a reader (e.g. the trace plugin) drains.
+ *
+ * Propagation is per thread: a traced message received on a thread makes its context the current one of the thread,
+ * the messages sent afterwards by the thread continue that trace (one hop further), until a message without trace is received.
+ * Threads that have no current context (e.g. the origin of the data) start a new trace with the configured sample rate.
+ *
+ * On the wire the context is a WireContext:
+ *  - shmem: appended to the metadata message, after the MetaHeader(s) (i.e. in the padding of --shm-metadata-msg-size, if large enough),
+ *  - zeromq: an extra frame in front of the message (multipart messages get one frame in front of the parts).
+ * Receivers recognize it by kMagic, with tracing disabled they still remove it. Batches, rings and pub/sub are not traced.
+ */
+namespace fair::mq::tracing
+{
+
+struct Context
+{
+    uint64_t fTraceId = 0;  ///< 0 = not traced
+    uint64_t fOriginNs = 0; ///< time the trace was started (ns since epoch)
+    uint64_t fSentNs = 0;   ///< time the message was sent by the previous hop (ns since epoch)
+    uint32_t fHop = 0;      ///< number of sends since the origin, 0 for the first one
+    uint32_t fReserved = 0;
+};
+
+constexpr uint64_t kMagic = 0x43415254'5f514d46; // "FMQ_TRAC" in little endian
+
+struct WireContext
+{
+    uint64_t fMagic = kMagic;
+    Context fContext;
+};
+static_assert(sizeof(WireContext) == 40, "the trace context is part of the wire format");
+
+/// forward: receive and send in one call (Channel::Forward), the span has the context of the sent message
+enum class Direction : uint8_t { tx, rx, forward };
+
+struct Span
+{
+    Context fContext;
+    uint64_t fStartNs = 0;
+    uint64_t fEndNs = 0;
+    int64_t fBytes = 0;
+    uint32_t fThread = 0; ///< sequential number of the recording thread
+    Direction fDirection = Direction::tx;
+    char fChannel[43] = {}; ///< name of the channel, truncated
+};
+
+namespace detail
+{
+inline std::atomic<bool> gEnabled{false};
+} // namespace detail
+
+/// cheap check for the data path, everything else is only called when tracing is enabled
+inline bool IsEnabled() { return detail::gEnabled.load(std::memory_order_relaxed); }
+
+/// start tracing, sampleRate (0..1) is the fraction of messages that start a new trace
+void Enable(double sampleRate);
+void Disable();
+void SetSampleRate(double sampleRate);
+double GetSampleRate();
+
+/// time in ns since epoch (system clock, to compare the timestamps of different hosts)
+uint64_t Now();
+
+/// for the transports: whether a message sent now is traced, and with which context (to be put on the wire)
+bool Outgoing(Context& ctx);
+/// for the transports: a traced message has been received
+void Incoming(const Context& ctx);
+
+/// for Channel: around a transfer, records a span if the transfer carried a trace context
+void BeginTransfer();
+void EndTransfer(const std::string& channel, Direction direction, uint64_t startNs, int64_t result);
+
+/// context of the current thread (fTraceId == 0 if none)
+Context GetCurrentContext();
+/// forget the context of the current thread, the next send starts a new (sampled) trace
+void ClearCurrentContext();
+
+/// hand all recorded spans (of all threads) to the callback and remove them, returns their number
+std::size_t Collect(const std::function<void(const Span&)>& callback);
+/// spans that were dropped because the buffer of a thread was full
+uint64_t GetNumDropped();
+
+} // namespace fair::mq::tracing
+
+#endif /* FAIR_MQ_TRACING_H */
@@ -0,0 +1,24 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef FAIR_MQ_TRANSFERCODE_H
+#define FAIR_MQ_TRANSFERCODE_H
+
+namespace fair::mq {
+
+enum class TransferCode : int
+{
+    success = 0,
+    error = -1,
+    timeout = -2,
+    interrupted = -3
+};
+
+} // namespace fair::mq
+
+#endif // FAIR_MQ_TRANSFERCODE_H
@@ -26,6 +26,7 @@ namespace fair::mq {
 
 class Channel;
 class ProgOptions;
+namespace metrics { class Registry; }
 
 class TransportFactory
 {
@@ -177,6 +178,9 @@ class TransportFactory
     virtual void Resume() = 0;
     virtual void Reset() = 0;
 
+    /// Add the statistics of the transport (e.g. memory usage) to the registry, as callbacks owned by the transport (this)
+    virtual void RegisterMetrics(metrics::Registry& /* registry */) {}
+
     virtual ~TransportFactory() = default;
 
     static auto CreateTransportFactory(const std::string& type,
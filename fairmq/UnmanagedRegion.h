@@ -9,6 +9,7 @@
 #ifndef FAIR_MQ_UNMANAGEDREGION_H
 #define FAIR_MQ_UNMANAGEDREGION_H
 
+#include <fairmq/RegionAllocator.h>
 #include <fairmq/TransportEnum.h>
 
 #include <cstddef>   // size_t
@@ -19,11 +20,13 @@
 #include <optional>     // std::optional
 #include <ostream>
 #include <string>
+#include <utility>      // std::move
 #include <vector>
 
 namespace fair::mq {
 
 class TransportFactory;
+struct RegionConfig;
 
 enum class RegionEvent : int
 {
@@ -75,6 +78,17 @@ using RegionCallback = std::function<void(void*, size_t, void*)>;
 using RegionBulkCallback = std::function<void(const std::vector<RegionBlock>&)>;
 using RegionEventCallback = std::function<void(RegionInfo)>;
 
+/// acknowledgement statistics of a region: number of acknowledged blocks and latencies (ns) from the release
+/// of a block to the call of the region callback
+struct RegionAckStats
+{
+    uint64_t count = 0;
+    uint64_t p50 = 0;
+    uint64_t p90 = 0;
+    uint64_t p99 = 0;
+    uint64_t max = 0;
+};
+
 struct UnmanagedRegion
 {
     UnmanagedRegion() = default;
@@ -92,15 +106,47 @@ struct UnmanagedRegion
     virtual uint16_t GetId() const = 0;
     virtual void SetLinger(uint32_t linger) = 0;
     virtual uint32_t GetLinger() const = 0;
+    /// acknowledgement latency statistics, if collected by the transport
+    virtual RegionAckStats GetAckStats() const { return {}; }
 
     virtual Transport GetType() const = 0;
     TransportFactory* GetTransport() { return fTransport; }
     void SetTransport(TransportFactory* transport) { fTransport = transport; }
 
+    /// @brief Allocate a buffer from the region (requires RegionConfig::allocator)
+    /// @param size buffer size
+    /// @param alignment alignment of the buffer (0: allocator granularity)
+    /// @param policy what to do when the region is full: fail, spin or block until acknowledgements free space
+    /// @param timeoutMs max. time to wait for space (-1: no timeout)
+    /// @return pointer to the buffer, nullptr if no space was available (in time). Send it as one message, it is
+    /// released automatically when the message is acknowledged, before the region callback is called for it.
+    void* Allocate(size_t size, size_t alignment = 0, RegionAllocationPolicy policy = RegionAllocationPolicy::block, int timeoutMs = -1)
+    {
+        return Allocator().Allocate(size, alignment, policy, timeoutMs);
+    }
+    /// @brief Release a buffer from Allocate that is not going to be sent
+    void Deallocate(void* ptr) { Allocator().Release(ptr); }
+    bool HasAllocator() const { return fAllocator != nullptr; }
+    RegionAllocator* GetAllocator() const { return fAllocator.get(); }
+
     virtual ~UnmanagedRegion() = default;
 
+    /// For the transports: creates a region with create(callback, bulkCallback), with an allocator attached if
+    /// requested by the config. The allocator is replenished by a bulk callback that wraps the user callbacks.
+    template<typename Create>
+    static std::unique_ptr<UnmanagedRegion> CreateWithAllocator(const RegionConfig& cfg, RegionCallback callback, RegionBulkCallback bulkCallback, Create&& create);
+
   private:
     TransportFactory* fTransport{nullptr};
+    std::unique_ptr<RegionAllocator> fAllocator; // destroyed after the transport region has stopped delivering acks
+
+    RegionAllocator& Allocator() const
+    {
+        if (!fAllocator) {
+            throw RegionAllocatorError("region has no allocator, enable it with RegionConfig::allocator");
+        }
+        return *fAllocator;
+    }
 };
 
 using UnmanagedRegionPtr = std::unique_ptr<UnmanagedRegion>;
@@ -138,8 +184,42 @@ struct RegionConfig
     std::string path = ""; /// file path, if the region is backed by a file
     std::optional<uint16_t> id = std::nullopt; /// region id
     uint32_t linger = 100; /// delay in ms before region destruction to collect outstanding events
+    uint32_t ackMaxDelay = 50; /// max. time in us that acknowledgements are held back to be delivered in bulk (0: deliver immediately)
+    uint32_t ackBatchSize = 256; /// number of pending acknowledgements that are delivered without further delay
+    bool allocator = false; /// attach a buffer allocator to the region (UnmanagedRegion::Allocate), replenished by the acknowledgements
+    size_t allocatorGranularity = 256; /// allocation unit of the allocator (power of 2), it keeps 4 bytes of bookkeeping per unit
 };
 
+template<typename Create>
+std::unique_ptr<UnmanagedRegion> UnmanagedRegion::CreateWithAllocator(const RegionConfig& cfg, RegionCallback callback, RegionBulkCallback bulkCallback, Create&& create)
+{
+    if (!cfg.allocator) {
+        return create(std::move(callback), std::move(bulkCallback));
+    }
+
+    auto allocator = std::make_unique<RegionAllocator>(cfg.allocatorGranularity);
+    RegionAllocator* alloc = allocator.get();
+    // the buffers are free again once the user callbacks see their acknowledgement (they can be reused right away,
+    // the user callbacks must not touch their content)
+    RegionBulkCallback wrapped = [alloc, callback = std::move(callback), bulkCallback = std::move(bulkCallback)](const std::vector<RegionBlock>& blocks) {
+        for (const auto& block : blocks) {
+            alloc->Release(block.ptr);
+        }
+        if (bulkCallback) {
+            bulkCallback(blocks);
+        } else if (callback) {
+            for (const auto& block : blocks) {
+                callback(block.ptr, block.size, block.hint);
+            }
+        }
+    };
+
+    std::unique_ptr<UnmanagedRegion> region = create(nullptr, std::move(wrapped));
+    allocator->Init(region->GetData(), region->GetSize());
+    region->fAllocator = std::move(allocator);
+    return region;
+}
+
 }   // namespace fair::mq
 
 using FairMQRegionEvent [[deprecated("Use fair::mq::RegionEvent")]] = fair::mq::RegionEvent;
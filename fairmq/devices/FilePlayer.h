@@ -0,0 +1,210 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef FAIR_MQ_FILEPLAYER_H
+#define FAIR_MQ_FILEPLAYER_H
+
+#include <fairmq/Device.h>
+#include <fairmq/UnmanagedRegion.h>
+#include <fairmq/devices/Recording.h>
+#include <fairmq/tools/RateLimit.h>
+#include <fairmq/tools/Strings.h>
+
+#include <fairlogger/Logger.h>
+
+#include <algorithm> // std::min
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring> // std::memcpy
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fair::mq
+{
+
+/// Replays a recording (written by the Sink with --out-format recording) on the output channel.
+/// The recording is copied once into an unmanaged region of the output transport, every frame is then sent zero-copy
+/// from the region (with --copy every part is copied into a new message instead).
+/// Replay modes (--replay):
+///  - original: with the time differences of the recording, scaled by --speed (default).
+///  - rate: at a fixed --rate of frames per second.
+///  - max: as fast as the output takes the frames.
+/// The recording is played --loops times (0 - endlessly).
+class FilePlayer : public Device
+{
+  protected:
+    enum class Replay { Original, Rate, Max };
+
+    std::string fInFilename;
+    std::string fOutChannelName;
+    Replay fReplay = Replay::Original;
+    float fRate = 0;
+    double fSpeed = 1.;
+    uint64_t fLoops = 1;
+    uint64_t fMaxIterations = 0;
+    uint64_t fNumSent = 0;
+    uint64_t fBytesSent = 0;
+    bool fCopy = false;
+    std::unique_ptr<RecordingReader> fReader;
+    UnmanagedRegionPtr fRegion;
+    std::atomic<int64_t> fNumUnacked{0};
+
+    void InitTask() override
+    {
+        fInFilename = fConfig->GetProperty<std::string>("in-filename");
+        fOutChannelName = fConfig->GetProperty<std::string>("out-channel");
+        fRate = fConfig->GetProperty<float>("rate");
+        fSpeed = fConfig->GetProperty<float>("speed");
+        fLoops = fConfig->GetProperty<uint64_t>("loops");
+        fMaxIterations = fConfig->GetProperty<uint64_t>("max-iterations");
+        fCopy = fConfig->GetProperty<bool>("copy");
+
+        std::string replay = fConfig->GetProperty<std::string>("replay");
+        if (replay == "original") {
+            fReplay = Replay::Original;
+        } else if (replay == "rate") {
+            fReplay = Replay::Rate;
+        } else if (replay == "max") {
+            fReplay = Replay::Max;
+        } else {
+            throw std::runtime_error(tools::ToString("unknown replay mode '", replay, "', expected original/rate/max"));
+        }
+        if (fReplay == Replay::Original && fSpeed <= 0.) {
+            throw std::runtime_error("--speed must be > 0");
+        }
+
+        fReader = std::make_unique<RecordingReader>(fInFilename);
+        LOG(info) << "Opened recording '" << fInFilename << "': " << fReader->GetNumFrames() << " frames, " << fReader->GetSize() << " bytes"
+                  << (fReader->IsIndexed() ? "" : " (no index, the frames were found by scanning the file)");
+
+        if (!fCopy) {
+            RegionConfig cfg;
+            cfg.path = fConfig->GetProperty<std::string>("region-path");
+            fRegion = NewUnmanagedRegionFor(fOutChannelName, 0, fReader->GetSize(),
+                [this](const std::vector<RegionBlock>& blocks) { fNumUnacked -= blocks.size(); },
+                cfg);
+            std::memcpy(fRegion->GetData(), fReader->GetData(), fReader->GetSize());
+        }
+    }
+
+    void Run() override
+    {
+        Channel& dataOutChannel = GetChannel(fOutChannelName, 0);
+        const std::size_t numFrames = fReader->GetNumFrames();
+        if (numFrames == 0) {
+            LOG(warn) << "Recording '" << fInFilename << "' contains no frames";
+            return;
+        }
+
+        fNumSent = 0;
+        fBytesSent = 0;
+        tools::RateLimiter rateLimiter(fReplay == Replay::Rate ? fRate : 0);
+        const uint64_t firstTimestamp = fReader->GetFrame(0).timestampNs;
+        auto tStart = std::chrono::steady_clock::now();
+        bool done = false;
+
+        for (uint64_t loop = 0; !done && (fLoops == 0 || loop < fLoops); ++loop) {
+            auto loopStart = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < numFrames; ++i) {
+                RecordingReader::Frame frame = fReader->GetFrame(i);
+                if (fReplay == Replay::Original) {
+                    auto offset = std::chrono::nanoseconds(static_cast<int64_t>((frame.timestampNs - firstTimestamp) / fSpeed));
+                    WaitUntil(loopStart + offset);
+                }
+                if (NewStatePending()) {
+                    done = true;
+                    break;
+                }
+
+                if (SendFrame(dataOutChannel, frame) < 0) {
+                    done = true;
+                    break;
+                }
+                if (fMaxIterations > 0 && fNumSent >= fMaxIterations) {
+                    LOG(info) << "Configured maximum number of iterations reached.";
+                    done = true;
+                    break;
+                }
+                if (fReplay == Replay::Rate) {
+                    rateLimiter.maybe_sleep();
+                }
+            }
+        }
+
+        auto sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - tStart).count();
+        LOG(info) << "Sent " << fNumSent << " frames (" << fBytesSent << " bytes) in " << sec * 1000. << "ms ("
+                  << fNumSent / sec << " frames/s, " << fBytesSent / sec / (1000. * 1000.) << " MB/s)";
+
+        // the region must outlive the messages sent from it
+        while (fNumUnacked > 0 && !NewStatePending()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        if (fNumUnacked > 0) {
+            LOG(warn) << "Leaving RUNNING state with " << fNumUnacked << " messages not acknowledged by the transport";
+        }
+    }
+
+    /// wait until the given time, but return early on a pending state change
+    void WaitUntil(std::chrono::steady_clock::time_point due)
+    {
+        while (!NewStatePending()) {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= due) {
+                return;
+            }
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(due - now, std::chrono::milliseconds(100)));
+        }
+    }
+
+    MessagePtr MakePart(Channel& channel, uint64_t offset, uint64_t size)
+    {
+        if (fCopy || size == 0) {
+            MessagePtr msg(channel.NewMessage(size));
+            std::memcpy(msg->GetData(), fReader->GetData() + offset, size);
+            return msg;
+        }
+        ++fNumUnacked;
+        return channel.NewMessage(fRegion, static_cast<char*>(fRegion->GetData()) + offset, size);
+    }
+
+    int64_t SendFrame(Channel& channel, const RecordingReader::Frame& frame)
+    {
+        int64_t result = 0;
+        if (frame.numParts == 1) {
+            MessagePtr msg(MakePart(channel, frame.offset, frame.sizes[0]));
+            result = channel.Send(msg);
+        } else {
+            Parts parts;
+            uint64_t offset = frame.offset;
+            for (uint32_t p = 0; p < frame.numParts; ++p) {
+                parts.AddPart(MakePart(channel, offset, frame.sizes[p]));
+                offset += frame.sizes[p];
+            }
+            result = channel.Send(parts);
+        }
+        if (result >= 0) {
+            ++fNumSent;
+            fBytesSent += static_cast<uint64_t>(result);
+        }
+        return result;
+    }
+
+    void ResetTask() override
+    {
+        fRegion.reset();
+        fReader.reset();
+    }
+};
+
+} // namespace fair::mq
+
+#endif /* FAIR_MQ_FILEPLAYER_H */
@@ -0,0 +1,373 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef FAIR_MQ_FILEWRITER_H
+#define FAIR_MQ_FILEWRITER_H
+
+#include <fairmq/Message.h>
+#include <fairmq/Parts.h>
+#include <fairmq/tools/Strings.h>
+
+#include <algorithm> // std::min, std::max
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring> // std::strerror
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility> // std::move
+#include <vector>
+
+#include <climits> // IOV_MAX
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace fair::mq {
+
+struct FileWriterError : std::runtime_error { using std::runtime_error::runtime_error; };
+
+/// Statistics of a FileWriter
+struct FileWriterStats
+{
+    uint64_t bytesWritten = 0;
+    uint64_t numWrites = 0;        ///< pwritev() calls
+    uint64_t numParts = 0;         ///< message parts written
+    uint64_t numFiles = 0;         ///< files opened
+    uint64_t numSyncs = 0;         ///< fdatasync() calls
+    uint64_t numStalls = 0;        ///< Push() calls that had to wait for a full queue
+    uint64_t maxQueuedBytes = 0;   ///< maximum queue depth in bytes
+    uint64_t maxQueuedParts = 0;   ///< maximum queue depth in parts
+    uint64_t writeTimeNs = 0;      ///< time spent in pwritev() and fdatasync()
+
+    /// write throughput while writing, in bytes/s
+    double WriteThroughput() const { return writeTimeNs > 0 ? bytesWritten * 1e9 / writeTimeNs : 0.; }
+};
+
+/// @brief Writes message buffers to a file on a dedicated thread
+///
+/// The pushed messages are queued (bounded by a number of bytes, Push() blocks while the queue is full) and written
+/// by the writer thread with pwritev(), gathering up to a batch of parts into one call. The messages (and with them
+/// e.g. shared memory buffers) are released only after they were written. Optionally the output is rotated to a new
+/// file after a given size or time (the files are named <path>.<index> then), and synced with fdatasync() after a
+/// given number of bytes and when a file is closed.
+/// An error on the writer thread stops it, the error is rethrown by every following Push() and by Close().
+class FileWriter
+{
+  public:
+    struct Config
+    {
+        std::string path;
+        std::size_t queueSize = 256 * 1024 * 1024; ///< maximum bytes in the queue (a single larger message is accepted)
+        std::size_t batch = 1024;                  ///< maximum number of parts per write (capped to IOV_MAX)
+        uint64_t rotateSize = 0;                   ///< start a new file after this many bytes (0 - never)
+        std::chrono::milliseconds rotateInterval{0}; ///< start a new file after this time (0 - never)
+        uint64_t syncBytes = 0;                    ///< fdatasync() after this many bytes and when closing a file (0 - never)
+    };
+
+    explicit FileWriter(Config config)
+        : fConfig(std::move(config))
+        , fBatch(std::max<std::size_t>(1, std::min<std::size_t>(fConfig.batch, IOV_MAX)))
+    {
+        Open(); // fail early if the file cannot be created
+        fThread = std::thread(&FileWriter::WriteLoop, this);
+    }
+
+    FileWriter(const FileWriter&) = delete;
+    FileWriter& operator=(const FileWriter&) = delete;
+
+    ~FileWriter()
+    {
+        try {
+            Close();
+        } catch (const std::exception&) {
+            // the error was already reported by a previous call, or nobody is left to handle it
+        }
+    }
+
+    /// queue a message for writing, blocks while the queue is full
+    void Push(MessagePtr msg)
+    {
+        std::unique_lock<std::mutex> lock(fMtx);
+        WaitForSpace(lock, msg->GetSize());
+        Enqueue(std::move(msg));
+        lock.unlock();
+        fDataAvailable.notify_one();
+    }
+
+    /// queue all parts of a multipart message for writing (in order), blocks while the queue is full
+    void Push(Parts& parts)
+    {
+        std::size_t size = 0;
+        for (const auto& part : parts) {
+            size += part->GetSize();
+        }
+        std::unique_lock<std::mutex> lock(fMtx);
+        WaitForSpace(lock, size);
+        for (auto& part : parts) {
+            Enqueue(std::move(part));
+        }
+        lock.unlock();
+        parts.fParts.clear();
+        fDataAvailable.notify_one();
+    }
+
+    /// write the remaining queue, close the file and stop the writer thread
+    void Close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(fMtx);
+            fClosing = true;
+        }
+        fDataAvailable.notify_one();
+        if (fThread.joinable()) {
+            fThread.join();
+        }
+        std::lock_guard<std::mutex> lock(fMtx);
+        ThrowOnError();
+    }
+
+    /// current statistics (written by the writer thread, a snapshot)
+    FileWriterStats GetStats() const
+    {
+        std::lock_guard<std::mutex> lock(fMtx);
+        return fStats;
+    }
+
+    /// name of the file currently written
+    std::string GetFileName() const
+    {
+        std::lock_guard<std::mutex> lock(fMtx);
+        return fFileName;
+    }
+
+  private:
+    void WaitForSpace(std::unique_lock<std::mutex>& lock, std::size_t size)
+    {
+        ThrowOnError();
+        if (fQueuedBytes > 0 && fQueuedBytes + size > fConfig.queueSize) {
+            ++fStats.numStalls;
+            fSpaceAvailable.wait(lock, [&]() { return fQueuedBytes == 0 || fQueuedBytes + size <= fConfig.queueSize || fError; });
+            ThrowOnError();
+        }
+        if (fClosing) {
+            throw FileWriterError("FileWriter: push after close");
+        }
+    }
+
+    void Enqueue(MessagePtr msg)
+    {
+        fQueuedBytes += msg->GetSize();
+        fQueue.push_back(std::move(msg));
+        fStats.maxQueuedBytes = std::max<uint64_t>(fStats.maxQueuedBytes, fQueuedBytes);
+        fStats.maxQueuedParts = std::max<uint64_t>(fStats.maxQueuedParts, fQueue.size());
+    }
+
+    void ThrowOnError()
+    {
+        if (fError) {
+            std::rethrow_exception(fError);
+        }
+    }
+
+    void Open()
+    {
+        std::string name = (fConfig.rotateSize > 0 || fConfig.rotateInterval.count() > 0)
+                               ? tools::ToString(fConfig.path, ".", fFileIndex)
+                               : fConfig.path;
+        int fd = ::open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw FileWriterError(tools::ToString("FileWriter: could not open '", name, "': ", std::strerror(errno)));
+        }
+        ++fFileIndex;
+        fFd = fd;
+        fFileBytes = 0;
+        fUnsyncedBytes = 0;
+        fFileStart = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(fMtx);
+        fFileName = name;
+        ++fStats.numFiles;
+    }
+
+    void CloseFile()
+    {
+        if (fFd < 0) {
+            return;
+        }
+        if (fConfig.syncBytes > 0 && fUnsyncedBytes > 0) {
+            Sync();
+        }
+        int fd = fFd;
+        fFd = -1;
+        if (::close(fd) != 0) {
+            throw FileWriterError(tools::ToString("FileWriter: could not close '", fFileName, "': ", std::strerror(errno)));
+        }
+    }
+
+    /// the file (with the pending bytes) reached the rotation size or age
+    bool RotationDue(std::size_t pendingBytes) const
+    {
+        if (fFileBytes + pendingBytes == 0) {
+            return false;
+        }
+        return (fConfig.rotateSize > 0 && fFileBytes + pendingBytes >= fConfig.rotateSize)
+            || (fConfig.rotateInterval.count() > 0 && std::chrono::steady_clock::now() - fFileStart >= fConfig.rotateInterval);
+    }
+
+    void WriteLoop()
+    {
+        std::vector<MessagePtr> msgs;
+        std::vector<iovec> iov;
+        iov.reserve(fBatch);
+
+        try {
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(fMtx);
+                    fDataAvailable.wait(lock, [&]() { return !fQueue.empty() || fClosing; });
+                    if (fQueue.empty()) {
+                        break;
+                    }
+                    msgs.swap(fQueue);
+                }
+
+                std::size_t batchBytes = 0;
+                std::size_t begin = 0;
+                for (std::size_t i = 0; i < msgs.size(); ++i) {
+                    std::size_t size = msgs[i]->GetSize();
+                    if (RotationDue(batchBytes)) {
+                        Write(iov, batchBytes, msgs, begin, i);
+                        begin = i;
+                        batchBytes = 0;
+                        CloseFile();
+                        Open();
+                    }
+                    if (size > 0) {
+                        iov.push_back({msgs[i]->GetData(), size});
+                        batchBytes += size;
+                    }
+                    if (iov.size() == fBatch) {
+                        Write(iov, batchBytes, msgs, begin, i + 1);
+                        begin = i + 1;
+                        batchBytes = 0;
+                    }
+                }
+                Write(iov, batchBytes, msgs, begin, msgs.size());
+                msgs.clear();
+            }
+            CloseFile();
+        } catch (...) {
+            if (fFd >= 0) {
+                ::close(fFd);
+                fFd = -1;
+            }
+            std::lock_guard<std::mutex> lock(fMtx);
+            fError = std::current_exception();
+            fQueue.clear();
+            fQueuedBytes = 0;
+        }
+        fSpaceAvailable.notify_all();
+    }
+
+    /// write the gathered buffers of msgs[begin, end) and release these messages
+    void Write(std::vector<iovec>& iov, std::size_t bytes, std::vector<MessagePtr>& msgs, std::size_t begin, std::size_t end)
+    {
+        auto start = std::chrono::steady_clock::now();
+        uint64_t numWrites = 0;
+        std::size_t first = 0;
+        while (first < iov.size()) {
+            ssize_t written = ::pwritev(fFd, iov.data() + first, static_cast<int>(iov.size() - first), static_cast<off_t>(fFileBytes));
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw FileWriterError(tools::ToString("FileWriter: failed writing to '", fFileName, "': ", std::strerror(errno)));
+            }
+            ++numWrites;
+            fFileBytes += static_cast<uint64_t>(written);
+            // skip the completely written buffers, adjust a partially written one
+            auto remaining = static_cast<std::size_t>(written);
+            while (first < iov.size() && remaining >= iov[first].iov_len) {
+                remaining -= iov[first].iov_len;
+                ++first;
+            }
+            if (remaining > 0) {
+                iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + remaining;
+                iov[first].iov_len -= remaining;
+            }
+        }
+        iov.clear();
+
+        auto ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        fUnsyncedBytes += bytes;
+        if (fConfig.syncBytes > 0 && fUnsyncedBytes >= fConfig.syncBytes) {
+            Sync();
+        }
+
+        std::size_t releasedBytes = 0;
+        for (std::size_t i = begin; i < end; ++i) {
+            releasedBytes += msgs[i]->GetSize();
+            msgs[i].reset();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(fMtx);
+            fStats.bytesWritten += bytes;
+            fStats.numWrites += numWrites;
+            fStats.numParts += end - begin;
+            fStats.writeTimeNs += ns;
+            fQueuedBytes -= releasedBytes;
+        }
+        fSpaceAvailable.notify_all();
+    }
+
+    void Sync()
+    {
+        auto start = std::chrono::steady_clock::now();
+        if (::fdatasync(fFd) != 0) {
+            throw FileWriterError(tools::ToString("FileWriter: fdatasync failed for '", fFileName, "': ", std::strerror(errno)));
+        }
+        fUnsyncedBytes = 0;
+        auto ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        std::lock_guard<std::mutex> lock(fMtx);
+        ++fStats.numSyncs;
+        fStats.writeTimeNs += ns;
+    }
+
+    Config fConfig;
+    std::size_t fBatch;
+
+    // writer thread only
+    int fFd = -1;
+    uint64_t fFileIndex = 0;
+    uint64_t fFileBytes = 0;
+    uint64_t fUnsyncedBytes = 0;
+    std::chrono::steady_clock::time_point fFileStart;
+
+    // shared, guarded by fMtx
+    mutable std::mutex fMtx;
+    std::condition_variable fDataAvailable;
+    std::condition_variable fSpaceAvailable;
+    std::vector<MessagePtr> fQueue;
+    std::size_t fQueuedBytes = 0;
+    bool fClosing = false;
+    std::exception_ptr fError;
+    std::string fFileName;
+    FileWriterStats fStats;
+
+    std::thread fThread;
+};
+
+} // namespace fair::mq
+
+#endif /* FAIR_MQ_FILEWRITER_H */
@@ -1,5 +1,5 @@
 /********************************************************************************
- * Copyright (C) 2014-2023 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ * Copyright (C) 2014-2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
  *                                                                              *
  *              This software is distributed under the terms of the             *
  *              GNU Lesser General Public Licence (LGPL) version 3,             *
@@ -13,16 +13,21 @@
 #include <fairmq/Device.h>
 
 #include <fairlogger/Logger.h>
+
+#include <algorithm> // std::max
 #include <string>
 #include <vector>
 
 namespace fair::mq
 {
 
+/// Forwards the messages of all input sub-channels to the output channel.
+/// Every ready input is drained of up to --drain messages per poll, the messages are passed on with Channel::Forward().
 class Merger : public Device
 {
   protected:
     bool fMultipart = true;
+    int fDrain = 16;
     std::string fInChannelName{"data-in"};
     std::string fOutChannelName{"data-out"};
 
@@ -31,6 +36,7 @@ class Merger : public Device
         fMultipart = fConfig->GetProperty<bool>("multipart");
         fInChannelName = fConfig->GetProperty<std::string>("in-channel");
         fOutChannelName = fConfig->GetProperty<std::string>("out-channel");
+        fDrain = std::max(1, fConfig->GetProperty<int>("drain", 16));
     }
 
     void RegisterChannelEndpoints() override
@@ -51,49 +57,30 @@ class Merger : public Device
             chans.push_back(&chan);
         }
 
+        Channel& out = GetChannel(fOutChannelName, 0);
         PollerPtr poller(NewPoller(chans));
 
-        if (fMultipart) {
-            while (!NewStatePending()) {
-                poller->Poll(100);
-
-                // Loop over the data input channels.
-                for (int i = 0; i < numInputs; ++i) {
-                    // Check if the channel has data ready to be received.
-                    if (poller->CheckInput(i)) {
-                        Parts payload;
-
-                        if (Receive(payload, fInChannelName, i) >= 0) {
-                            if (Send(payload, fOutChannelName) < 0) {
-                                LOG(debug) << "Transfer interrupted";
-                                break;
-                            }
-                        } else {
-                            LOG(debug) << "Transfer interrupted";
-                            break;
-                        }
-                    }
+        while (!NewStatePending()) {
+            poller->Poll(100);
+
+            // Loop over the data input channels.
+            for (int i = 0; i < numInputs; ++i) {
+                // Check if the channel has data ready to be received.
+                if (!poller->CheckInput(i)) {
+                    continue;
                 }
-            }
-        } else {
-            while (!NewStatePending()) {
-                poller->Poll(100);
-
-                // Loop over the data input channels.
-                for (int i = 0; i < numInputs; ++i) {
-                    // Check if the channel has data ready to be received.
-                    if (poller->CheckInput(i)) {
-                        MessagePtr payload(fTransportFactory->CreateMessage());
-
-                        if (Receive(payload, fInChannelName, i) >= 0) {
-                            if (Send(payload, fOutChannelName) < 0) {
-                                LOG(debug) << "Transfer interrupted";
-                                break;
-                            }
-                        } else {
-                            LOG(debug) << "Transfer interrupted";
-                            break;
-                        }
+                // Take what the input has queued (up to fDrain messages) without polling again.
+                for (int n = 0; n < fDrain; ++n) {
+                    int64_t result = chans[i]->Forward(out, fMultipart, 0);
+                    if (result == static_cast<int64_t>(TransferCode::timeout)) {
+                        break;
+                    } else if (result == static_cast<int64_t>(TransferCode::interrupted)) {
+                        LOG(debug) << "Transfer interrupted";
+                        return;
+                    } else if (result < 0) {
+                        // the message is lost, the other inputs continue
+                        LOG(error) << "Failed forwarding from " << chans[i]->GetName() << " to " << out.GetName();
+                        break;
                     }
                 }
             }
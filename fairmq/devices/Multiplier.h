@@ -11,6 +11,7 @@
 
 #include <fairmq/Device.h>
 
+#include <algorithm> // std::all_of
 #include <string>
 #include <vector>
 
@@ -24,6 +25,8 @@ class Multiplier : public Device
     int fNumOutputs = 0;
     std::string fInChannelName;
     std::vector<std::string> fOutChannelNames;
+    std::vector<Channel*> fOutputs; // all sub-channels of the output channels
+    bool fSendToAll = true;         // outputs share transport and send timeout, sent with one Channel::SendToAll()
 
     void InitTask() override
     {
@@ -31,6 +34,14 @@ class Multiplier : public Device
         fInChannelName = fConfig->GetProperty<std::string>("in-channel");
         fOutChannelNames = fConfig->GetProperty<std::vector<std::string>>("out-channel");
         fNumOutputs = GetNumSubChannels(fOutChannelNames.at(0));
+        fOutputs = GetSubChannels(fOutChannelNames);
+        fSendToAll = std::all_of(fOutputs.begin(), fOutputs.end(), [&](const Channel* output) {
+            return output->GetTransportType() == fOutputs.front()->GetTransportType()
+                && output->GetSndTimeout() == fOutputs.front()->GetSndTimeout();
+        });
+        if (!fSendToAll) {
+            LOG(debug) << "Output channels differ in transport or send timeout, sending to each of them separately.";
+        }
 
         if (fMultipart) {
             OnData(fInChannelName, &Multiplier::HandleMultipartData);
@@ -39,64 +50,40 @@ class Multiplier : public Device
         }
     }
 
-
+    // the outputs share the buffers of the payload, the last one takes over the payload itself
     bool HandleSingleData(std::unique_ptr<Message>& payload, int)
     {
-        for (unsigned int i = 0; i < fOutChannelNames.size() - 1; ++i) { // all except last channel
-            for (unsigned int j = 0; j < GetNumSubChannels(fOutChannelNames.at(i)); ++j) { // all subChannels in a channel
-                MessagePtr msgCopy(fTransportFactory->CreateMessage());
-                msgCopy->Copy(*payload);
-
-                Send(msgCopy, fOutChannelNames.at(i), j);
-            }
+        if (fSendToAll) {
+            Channel::SendToAll(fOutputs, payload);
+            return true;
         }
 
-        unsigned int lastChannelSize = GetNumSubChannels(fOutChannelNames.back());
-
-        for (unsigned int i = 0; i < lastChannelSize - 1; ++i) { // iterate over all except last subChannels of the last channel
+        for (size_t i = 0; i < fOutputs.size() - 1; ++i) { // all except the last output, with their own send timeout
             MessagePtr msgCopy(fTransportFactory->CreateMessage());
             msgCopy->Copy(*payload);
-
-            Send(msgCopy, fOutChannelNames.back(), i);
+            fOutputs[i]->Send(msgCopy);
         }
-
-        Send(payload, fOutChannelNames.back(), lastChannelSize - 1); // send final message to last subChannel of last channel
-
+        fOutputs.back()->Send(payload);
         return true;
     }
 
     bool HandleMultipartData(Parts& payload, int)
     {
-        for (unsigned int i = 0; i < fOutChannelNames.size() - 1; ++i) { // all except last channel
-            for (unsigned int j = 0; j < GetNumSubChannels(fOutChannelNames.at(i)); ++j) { // all subChannels in a channel
-                Parts parts;
-
-                for (unsigned int k = 0; k < payload.Size(); ++k) {
-                    MessagePtr msgCopy(fTransportFactory->CreateMessage());
-                    msgCopy->Copy(*(payload.At(k)));
-                    parts.AddPart(std::move(msgCopy));
-                }
-
-                Send(parts, fOutChannelNames.at(i), j);
-            }
+        if (fSendToAll) {
+            Channel::SendToAll(fOutputs, payload);
+            return true;
         }
 
-        unsigned int lastChannelSize = GetNumSubChannels(fOutChannelNames.back());
-
-        for (unsigned int i = 0; i < lastChannelSize - 1; ++i) { // iterate over all except last subChannels of the last channel
+        for (size_t i = 0; i < fOutputs.size() - 1; ++i) { // all except the last output, with their own send timeout
             Parts parts;
-
-            for (unsigned int k = 0; k < payload.Size(); ++k) {
+            for (auto& part : payload) {
                 MessagePtr msgCopy(fTransportFactory->CreateMessage());
-                msgCopy->Copy(*(payload.At(k)));
+                msgCopy->Copy(*part);
                 parts.AddPart(std::move(msgCopy));
             }
-
-            Send(parts, fOutChannelNames.back(), i);
+            fOutputs[i]->Send(parts);
         }
-
-        Send(payload, fOutChannelNames.back(), lastChannelSize - 1); // send final message to last subChannel of last channel
-
+        fOutputs.back()->Send(payload);
         return true;
     }
 };
@@ -1,5 +1,5 @@
 /********************************************************************************
- * Copyright (C) 2014-2021 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ * Copyright (C) 2014-2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
  *                                                                              *
  *              This software is distributed under the terms of the             *
  *              GNU Lesser General Public Licence (LGPL) version 3,             *
@@ -16,6 +16,7 @@
 namespace fair::mq
 {
 
+/// Forwards every message of the input channel to the output channel, see Channel::Forward()
 class Proxy : public Device
 {
   protected:
@@ -32,31 +33,13 @@ class Proxy : public Device
 
     void Run() override
     {
-        if (fMultipart) {
-            while (!NewStatePending()) {
-                Parts payload;
-                if (Receive(payload, fInChannelName) >= 0) {
-                    if (Send(payload, fOutChannelName) < 0) {
-                        LOG(debug) << "Transfer interrupted";
-                        break;
-                    }
-                } else {
-                    LOG(debug) << "Transfer interrupted";
-                    break;
-                }
-            }
-        } else {
-            while (!NewStatePending()) {
-                MessagePtr payload(fTransportFactory->CreateMessage());
-                if (Receive(payload, fInChannelName) >= 0) {
-                    if (Send(payload, fOutChannelName) < 0) {
-                        LOG(debug) << "Transfer interrupted";
-                        break;
-                    }
-                } else {
-                    LOG(debug) << "Transfer interrupted";
-                    break;
-                }
+        Channel& in = GetChannel(fInChannelName, 0);
+        Channel& out = GetChannel(fOutChannelName, 0);
+
+        while (!NewStatePending()) {
+            if (in.Forward(out, fMultipart) < 0) {
+                LOG(debug) << "Transfer interrupted";
+                break;
             }
         }
     }
@@ -0,0 +1,307 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef FAIR_MQ_RECORDING_H
+#define FAIR_MQ_RECORDING_H
+
+#include <fairmq/Message.h>
+#include <fairmq/Parts.h>
+#include <fairmq/tools/Strings.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring> // std::memcpy, std::memcmp, std::strerror
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// Recording format, as written by the Sink (--out-format recording) and replayed by the FilePlayer.
+/// All integers are in host byte order, frames and the index start at 8 byte boundaries:
+///
+///   RecordingFileHeader
+///   frame*       [padding] RecordingFrameHeader, uint64_t size[numParts], the data of the parts (not padded)
+///   index        [padding] uint64_t frameOffset[numFrames]
+///   RecordingTrailer
+///
+/// A recording without (valid) index and trailer, e.g. of a process that did not shut down properly, is still
+/// readable: the frames are then found by scanning the file, up to the last complete frame.
+
+namespace fair::mq {
+
+struct RecordingError : std::runtime_error { using std::runtime_error::runtime_error; };
+
+struct RecordingFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+};
+
+struct RecordingFrameHeader
+{
+    uint64_t timestampNs; ///< receive time, relative to the start of the recording
+    uint32_t numParts;
+    uint32_t reserved;
+};
+
+struct RecordingTrailer
+{
+    uint64_t numFrames;
+    uint64_t indexOffset;
+    char magic[8];
+};
+
+constexpr char kRecordingMagic[8] = {'F', 'M', 'Q', 'R', 'E', 'C', '\0', '\0'};
+constexpr char kRecordingIndexMagic[8] = {'F', 'M', 'Q', 'I', 'D', 'X', '\0', '\0'};
+constexpr uint32_t kRecordingVersion = 1;
+
+/// @brief Produces the metadata of a recording, while the caller writes it and the message data in order
+///
+/// FileHeader(), then for every frame FrameHeader() followed by the data of its parts, then Index().
+class RecordingEncoder
+{
+  public:
+    static constexpr std::size_t FileHeaderSize() { return sizeof(RecordingFileHeader); }
+
+    /// write the file header to out (FileHeaderSize() bytes)
+    void FileHeader(char* out)
+    {
+        RecordingFileHeader header{};
+        std::memcpy(header.magic, kRecordingMagic, sizeof(header.magic));
+        header.version = kRecordingVersion;
+        std::memcpy(out, &header, sizeof(header));
+        fOffset = sizeof(header);
+        fIndex.clear();
+    }
+
+    /// size of the frame header (including padding) for a frame of numParts parts
+    std::size_t FrameHeaderSize(std::size_t numParts) const
+    {
+        return Padding() + sizeof(RecordingFrameHeader) + numParts * sizeof(uint64_t);
+    }
+
+    /// write the header of a frame with the given parts to out (FrameHeaderSize(parts.Size()) bytes)
+    void FrameHeader(char* out, uint64_t timestampNs, const Parts& parts)
+    {
+        char* sizes = BeginFrame(out, timestampNs, parts.Size());
+        uint64_t dataSize = 0;
+        for (const auto& part : parts) {
+            uint64_t size = part->GetSize();
+            std::memcpy(sizes, &size, sizeof(size));
+            sizes += sizeof(size);
+            dataSize += size;
+        }
+        fOffset += dataSize;
+    }
+
+    /// write the header of a single part frame to out (FrameHeaderSize(1) bytes)
+    void FrameHeader(char* out, uint64_t timestampNs, const Message& msg)
+    {
+        char* sizes = BeginFrame(out, timestampNs, 1);
+        uint64_t size = msg.GetSize();
+        std::memcpy(sizes, &size, sizeof(size));
+        fOffset += size;
+    }
+
+    /// size of the index and trailer (including padding)
+    std::size_t IndexSize() const
+    {
+        return Padding() + fIndex.size() * sizeof(uint64_t) + sizeof(RecordingTrailer);
+    }
+
+    /// write the index and the trailer to out (IndexSize() bytes)
+    void Index(char* out)
+    {
+        std::size_t padding = Padding();
+        std::memset(out, 0, padding);
+        RecordingTrailer trailer{};
+        trailer.numFrames = fIndex.size();
+        trailer.indexOffset = fOffset + padding;
+        std::memcpy(trailer.magic, kRecordingIndexMagic, sizeof(trailer.magic));
+        std::memcpy(out + padding, fIndex.data(), fIndex.size() * sizeof(uint64_t));
+        std::memcpy(out + padding + fIndex.size() * sizeof(uint64_t), &trailer, sizeof(trailer));
+        fOffset += IndexSize();
+    }
+
+    std::size_t GetNumFrames() const { return fIndex.size(); }
+
+  private:
+    std::size_t Padding() const { return (8 - fOffset % 8) % 8; }
+
+    char* BeginFrame(char* out, uint64_t timestampNs, std::size_t numParts)
+    {
+        std::size_t padding = Padding();
+        std::memset(out, 0, padding);
+        fIndex.push_back(fOffset + padding);
+        RecordingFrameHeader header{};
+        header.timestampNs = timestampNs;
+        header.numParts = static_cast<uint32_t>(numParts);
+        std::memcpy(out + padding, &header, sizeof(header));
+        fOffset += FrameHeaderSize(numParts);
+        return out + padding + sizeof(header);
+    }
+
+    uint64_t fOffset = 0;
+    std::vector<uint64_t> fIndex;
+};
+
+/// @brief Read-only, memory mapped access to the frames of a recording
+class RecordingReader
+{
+  public:
+    struct Frame
+    {
+        uint64_t timestampNs;
+        uint32_t numParts;
+        const uint64_t* sizes; ///< size of every part
+        const char* data;      ///< data of the first part, the others follow without gaps
+        uint64_t offset;       ///< offset of the data in the file
+    };
+
+    explicit RecordingReader(const std::string& path)
+        : fPath(path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw RecordingError(tools::ToString("could not open recording '", path, "': ", std::strerror(errno)));
+        }
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(RecordingFileHeader))) {
+            ::close(fd);
+            throw RecordingError(tools::ToString("'", path, "' is not a recording (too small)"));
+        }
+        fSize = static_cast<std::size_t>(st.st_size);
+        void* data = ::mmap(nullptr, fSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            throw RecordingError(tools::ToString("could not map recording '", path, "': ", std::strerror(errno)));
+        }
+        fData = static_cast<const char*>(data);
+
+        try {
+            RecordingFileHeader header;
+            std::memcpy(&header, fData, sizeof(header));
+            if (std::memcmp(header.magic, kRecordingMagic, sizeof(header.magic)) != 0) {
+                throw RecordingError(tools::ToString("'", path, "' is not a recording"));
+            }
+            if (header.version != kRecordingVersion) {
+                throw RecordingError(tools::ToString("unsupported version ", header.version, " of recording '", path, "'"));
+            }
+            if (!ReadIndex()) {
+                ScanFrames();
+            }
+        } catch (...) {
+            ::munmap(const_cast<char*>(fData), fSize);
+            throw;
+        }
+    }
+
+    RecordingReader(const RecordingReader&) = delete;
+    RecordingReader& operator=(const RecordingReader&) = delete;
+
+    ~RecordingReader() { ::munmap(const_cast<char*>(fData), fSize); }
+
+    std::size_t GetNumFrames() const { return fOffsets.size(); }
+
+    Frame GetFrame(std::size_t i) const
+    {
+        const char* p = fData + fOffsets.at(i);
+        RecordingFrameHeader header;
+        std::memcpy(&header, p, sizeof(header));
+        const char* sizes = p + sizeof(header);
+        const char* data = sizes + header.numParts * sizeof(uint64_t);
+        return {header.timestampNs, header.numParts, reinterpret_cast<const uint64_t*>(sizes), data, static_cast<uint64_t>(data - fData)};
+    }
+
+    /// the mapped file
+    const char* GetData() const { return fData; }
+    std::size_t GetSize() const { return fSize; }
+    const std::string& GetPath() const { return fPath; }
+
+    /// false if the file had no valid index and the frames were found by scanning it
+    bool IsIndexed() const { return fIndexed; }
+
+  private:
+    /// size of the frame at offset, 0 if it is not complete within the file
+    uint64_t FrameSize(uint64_t offset) const
+    {
+        if (offset % 8 != 0 || offset > fSize || fSize - offset < sizeof(RecordingFrameHeader)) {
+            return 0;
+        }
+        RecordingFrameHeader header;
+        std::memcpy(&header, fData + offset, sizeof(header));
+        uint64_t size = sizeof(header) + uint64_t(header.numParts) * sizeof(uint64_t);
+        if (header.numParts == 0 || fSize - offset < size) {
+            return 0;
+        }
+        for (uint32_t i = 0; i < header.numParts; ++i) {
+            uint64_t partSize;
+            std::memcpy(&partSize, fData + offset + sizeof(header) + i * sizeof(uint64_t), sizeof(partSize));
+            if (partSize > fSize - offset - size) {
+                return 0;
+            }
+            size += partSize;
+        }
+        return size;
+    }
+
+    bool ReadIndex()
+    {
+        if (fSize < sizeof(RecordingFileHeader) + sizeof(RecordingTrailer)) {
+            return false;
+        }
+        RecordingTrailer trailer;
+        std::memcpy(&trailer, fData + fSize - sizeof(trailer), sizeof(trailer));
+        uint64_t indexEnd = fSize - sizeof(trailer);
+        if (std::memcmp(trailer.magic, kRecordingIndexMagic, sizeof(trailer.magic)) != 0
+            || trailer.indexOffset > indexEnd
+            || (indexEnd - trailer.indexOffset) / sizeof(uint64_t) != trailer.numFrames) {
+            return false;
+        }
+        fOffsets.resize(trailer.numFrames);
+        std::memcpy(fOffsets.data(), fData + trailer.indexOffset, trailer.numFrames * sizeof(uint64_t));
+        for (uint64_t offset : fOffsets) {
+            if (offset >= trailer.indexOffset || FrameSize(offset) == 0) {
+                fOffsets.clear();
+                return false;
+            }
+        }
+        fIndexed = true;
+        return true;
+    }
+
+    void ScanFrames()
+    {
+        uint64_t offset = sizeof(RecordingFileHeader);
+        while (true) {
+            uint64_t size = FrameSize(offset);
+            if (size == 0) {
+                break;
+            }
+            fOffsets.push_back(offset);
+            offset += size;
+            offset += (8 - offset % 8) % 8;
+        }
+    }
+
+    std::string fPath;
+    const char* fData = nullptr;
+    std::size_t fSize = 0;
+    std::vector<uint64_t> fOffsets;
+    bool fIndexed = false;
+};
+
+} // namespace fair::mq
+
+#endif /* FAIR_MQ_RECORDING_H */
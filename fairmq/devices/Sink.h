@@ -1,5 +1,5 @@
 /********************************************************************************
- * Copyright (C) 2014-2021 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
+ * Copyright (C) 2014-2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH  *
  *                                                                              *
  *              This software is distributed under the terms of the             *
  *              GNU Lesser General Public Licence (LGPL) version 3,             *
@@ -10,17 +10,30 @@
 #define FAIR_MQ_SINK_H
 
 #include <fairmq/Device.h>
+#include <fairmq/devices/FileWriter.h>
+#include <fairmq/devices/Recording.h>
 #include <fairmq/tools/Strings.h>
 
 #include <chrono>
 #include <fairlogger/Logger.h>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <stdexcept>
+#include <vector>
 
 namespace fair::mq
 {
 
+/// Receives messages on the input channel and discards them, optionally writing their buffers to a file.
+/// File writers (--file-writer):
+///  - stream: std::fstream on the run thread (default).
+///  - async: a FileWriter thread, which gathers the parts into pwritev() calls. Received buffers are released after
+///    they were written, the receive loop blocks only while --write-queue-size bytes are waiting to be written.
+///    The output can be rotated (--rotate-size, --rotate-interval) and synced (--sync-bytes).
+/// Output formats (--out-format):
+///  - raw: the message buffers only (default).
+///  - recording: the messages with their part sizes and receive times, replayable with the FilePlayer (see Recording.h).
 class Sink : public Device
 {
   protected:
@@ -32,6 +45,12 @@ class Sink : public Device
     std::string fInChannelName;
     std::string fOutFilename;
     std::fstream fOutputFile;
+    bool fAsyncWriter = false;
+    FileWriter::Config fWriterConfig;
+    std::unique_ptr<FileWriter> fWriter;
+    bool fRecording = false;
+    RecordingEncoder fEncoder;
+    std::vector<char> fMetadataBuffer;
 
     void InitTask() override
     {
@@ -41,6 +60,27 @@ class Sink : public Device
         fInChannelName = fConfig->GetProperty<std::string>("in-channel");
         fOutFilename   = fConfig->GetProperty<std::string>("out-filename");
 
+        std::string writer = fConfig->GetProperty<std::string>("file-writer", "stream");
+        if (writer != "stream" && writer != "async") {
+            throw std::runtime_error(tools::ToString("unknown file writer '", writer, "', expected stream/async"));
+        }
+        fAsyncWriter = writer == "async";
+        fWriterConfig.path = fOutFilename;
+        fWriterConfig.queueSize = fConfig->GetProperty<size_t>("write-queue-size", fWriterConfig.queueSize);
+        fWriterConfig.batch = fConfig->GetProperty<size_t>("write-batch", fWriterConfig.batch);
+        fWriterConfig.rotateSize = fConfig->GetProperty<uint64_t>("rotate-size", 0);
+        fWriterConfig.rotateInterval = std::chrono::seconds(fConfig->GetProperty<int>("rotate-interval", 0));
+        fWriterConfig.syncBytes = fConfig->GetProperty<uint64_t>("sync-bytes", 0);
+
+        std::string format = fConfig->GetProperty<std::string>("out-format", "raw");
+        if (format != "raw" && format != "recording") {
+            throw std::runtime_error(tools::ToString("unknown output format '", format, "', expected raw/recording"));
+        }
+        fRecording = format == "recording";
+        if (fRecording && (fWriterConfig.rotateSize > 0 || fWriterConfig.rotateInterval.count() > 0)) {
+            throw std::runtime_error("the recording format does not support file rotation");
+        }
+
         fBytesWritten = 0;
     }
 
@@ -60,10 +100,17 @@ class Sink : public Device
                 LOG(debug) << "ATTENTION: --max-file-size is 0 - output file will continue to grow until sink is stopped";
             }
 
-            fOutputFile.open(fOutFilename, std::ios::out | std::ios::binary);
-            if (!fOutputFile) {
-                LOG(error) << "Could not open '" << fOutFilename;
-                throw std::runtime_error(fair::mq::tools::ToString("Could not open '", fOutFilename));
+            if (fAsyncWriter) {
+                fWriter = std::make_unique<FileWriter>(fWriterConfig);
+            } else {
+                fOutputFile.open(fOutFilename, std::ios::out | std::ios::binary);
+                if (!fOutputFile) {
+                    LOG(error) << "Could not open '" << fOutFilename;
+                    throw std::runtime_error(fair::mq::tools::ToString("Could not open '", fOutFilename));
+                }
+            }
+            if (fRecording) {
+                WriteMetadata(dataInChannel, RecordingEncoder::FileHeaderSize(), [&](char* out) { fEncoder.FileHeader(out); });
             }
         }
 
@@ -73,7 +120,16 @@ class Sink : public Device
                 if (dataInChannel.Receive(parts) < 0) {
                     continue;
                 }
-                if (fOutputFile.is_open()) {
+                if (fRecording && (fWriter || fOutputFile.is_open())) {
+                    uint64_t timestamp = Timestamp(tStart);
+                    WriteMetadata(dataInChannel, fEncoder.FrameHeaderSize(parts.Size()), [&](char* out) { fEncoder.FrameHeader(out, timestamp, parts); });
+                }
+                if (fWriter) {
+                    for (const auto& part : parts) {
+                        fBytesWritten += part->GetSize();
+                    }
+                    fWriter->Push(parts);
+                } else if (fOutputFile.is_open()) {
                     for (const auto& part : parts) {
                         WriteToFile(static_cast<const char*>(part->GetData()), part->GetSize());
                     }
@@ -83,7 +139,14 @@ class Sink : public Device
                 if (dataInChannel.Receive(msg) < 0) {
                     continue;
                 }
-                if (fOutputFile.is_open()) {
+                if (fRecording && (fWriter || fOutputFile.is_open())) {
+                    uint64_t timestamp = Timestamp(tStart);
+                    WriteMetadata(dataInChannel, fEncoder.FrameHeaderSize(1), [&](char* out) { fEncoder.FrameHeader(out, timestamp, *msg); });
+                }
+                if (fWriter) {
+                    fBytesWritten += msg->GetSize();
+                    fWriter->Push(std::move(msg));
+                } else if (fOutputFile.is_open()) {
                     WriteToFile(static_cast<const char*>(msg->GetData()), msg->GetSize());
                 }
             }
@@ -101,10 +164,17 @@ class Sink : public Device
             fNumIterations++;
         }
 
+        if (fRecording && (fWriter || fOutputFile.is_open())) {
+            WriteMetadata(dataInChannel, fEncoder.IndexSize(), [&](char* out) { fEncoder.Index(out); });
+            LOG(info) << "Recorded " << fEncoder.GetNumFrames() << " frames";
+        }
         if (fOutputFile.is_open()) {
             fOutputFile.flush();
             fOutputFile.close();
         }
+        if (fWriter) {
+            CloseWriter();
+        }
 
         auto tEnd = std::chrono::high_resolution_clock::now();
         auto ms = std::chrono::duration<double, std::milli>(tEnd - tStart).count();
@@ -118,6 +188,43 @@ class Sink : public Device
         LOG(info) << "Leaving RUNNING state.";
     }
 
+    static uint64_t Timestamp(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    /// write size bytes of recording metadata, produced by encode(char* out), to the output file
+    template<typename Encode>
+    void WriteMetadata(Channel& channel, size_t size, Encode&& encode)
+    {
+        if (fWriter) {
+            MessagePtr msg(channel.NewMessage(size));
+            encode(static_cast<char*>(msg->GetData()));
+            fBytesWritten += size;
+            fWriter->Push(std::move(msg));
+        } else {
+            fMetadataBuffer.resize(size);
+            encode(fMetadataBuffer.data());
+            WriteToFile(fMetadataBuffer.data(), size);
+        }
+    }
+
+    void CloseWriter()
+    {
+        std::unique_ptr<FileWriter> writer(std::move(fWriter));
+        writer->Close();
+        const FileWriterStats stats = writer->GetStats();
+        LOG(info) << "File writer: " << stats.numParts << " parts in " << stats.numWrites << " writes to " << stats.numFiles << " file(s), "
+                  << stats.numSyncs << " syncs, " << (stats.WriteThroughput() / (1000. * 1000.)) << " MB/s while writing, "
+                  << "max queue depth " << stats.maxQueuedBytes << " bytes / " << stats.maxQueuedParts << " parts, "
+                  << stats.numStalls << " stalls on a full queue";
+    }
+
+    void ResetTask() override
+    {
+        fWriter.reset();
+    }
+
     void WriteToFile(const char* ptr, size_t size)
     {
         fOutputFile.write(ptr, size);
@@ -11,19 +11,48 @@
 
 #include <fairmq/Device.h>
 
+#include <algorithm> // std::max
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace fair::mq
 {
 
+/// Distributes the data of one input channel over the sub-channels of an output channel.
+/// Dispatch modes (--dispatch):
+///  - round-robin: every output in turn, waiting for a busy output to take the data (default).
+///  - ready: the next output (in turn) that can take the data without waiting, a busy output is skipped.
+///  - credit: the output with the fewest messages in flight. Sub-channel i of the credit channel returns
+///    credits for output i (one per message, or the number given as uint32_t in the message),
+///    an output with --credits messages in flight gets no more data until it returns credits.
 class Splitter : public Device
 {
   protected:
+    enum class Dispatch { RoundRobin, Ready, Credit };
+
+    struct OutputStats
+    {
+        uint64_t fDispatched = 0; // messages sent to the output
+        uint64_t fBusy = 0; // times the output was skipped because it could not take the data
+        int64_t fInFlight = 0; // messages not yet acknowledged by a credit (credit mode)
+        int64_t fMaxInFlight = 0;
+    };
+
     bool fMultipart = true;
     int fNumOutputs = 0;
     int fDirection = 0;
+    Dispatch fDispatch = Dispatch::RoundRobin;
+    int fCredits = 0;
     std::string fInChannelName;
     std::string fOutChannelName;
+    std::string fCreditChannelName;
+    std::vector<Channel*> fOutputs;
+    std::vector<Channel*> fCreditInputs;
+    std::vector<OutputStats> fStats;
+    PollerPtr fPoller; // waits for a ready output (ready mode) or for credits (credit mode)
 
     void InitTask() override
     {
@@ -32,6 +61,29 @@ class Splitter : public Device
         fOutChannelName = fConfig->GetProperty<std::string>("out-channel");
         fNumOutputs = GetNumSubChannels(fOutChannelName);
         fDirection = 0;
+        fOutputs = GetSubChannels({fOutChannelName});
+        fStats.assign(fNumOutputs, OutputStats());
+        fCreditInputs.clear();
+        fPoller.reset();
+
+        std::string dispatch = fConfig->GetProperty<std::string>("dispatch", "round-robin");
+        if (dispatch == "round-robin") {
+            fDispatch = Dispatch::RoundRobin;
+        } else if (dispatch == "ready") {
+            fDispatch = Dispatch::Ready;
+            fPoller = NewPoller(fOutputs);
+        } else if (dispatch == "credit") {
+            fDispatch = Dispatch::Credit;
+            fCredits = fConfig->GetProperty<int>("credits", 8);
+            fCreditChannelName = fConfig->GetProperty<std::string>("credit-channel", "credits");
+            fCreditInputs = GetSubChannels({fCreditChannelName});
+            if (static_cast<int>(fCreditInputs.size()) != fNumOutputs || fCredits < 1) {
+                throw std::runtime_error(tools::ToString("credit dispatch needs one sub-channel of '", fCreditChannelName, "' per output (", fNumOutputs, "), and --credits > 0"));
+            }
+            fPoller = NewPoller(fCreditInputs);
+        } else {
+            throw std::runtime_error(tools::ToString("unknown dispatch mode '", dispatch, "', expected round-robin/ready/credit"));
+        }
 
         if (fMultipart) {
             OnData(fInChannelName, &Splitter::HandleData<Parts>);
@@ -43,14 +95,110 @@ class Splitter : public Device
     template<typename T>
     bool HandleData(T& payload, int)
     {
-        Send(payload, fOutChannelName, fDirection);
-
-        if (++fDirection >= fNumOutputs) {
-            fDirection = 0;
+        switch (fDispatch) {
+            case Dispatch::RoundRobin:
+                if (Send(payload, fOutChannelName, fDirection) >= 0) {
+                    ++fStats[fDirection].fDispatched;
+                }
+                Advance(fDirection);
+                break;
+            case Dispatch::Ready:
+                SendToReady(payload);
+                break;
+            case Dispatch::Credit:
+                SendWithCredit(payload);
+                break;
         }
 
         return true;
     }
+
+    template<typename T>
+    void SendToReady(T& payload)
+    {
+        while (!NewStatePending()) {
+            for (int i = 0; i < fNumOutputs; ++i) {
+                int out = (fDirection + i) % fNumOutputs;
+                int64_t result = fOutputs[out]->Send(payload, 0);
+                if (result >= 0) {
+                    ++fStats[out].fDispatched;
+                    fDirection = out;
+                    Advance(fDirection);
+                    return;
+                } else if (result != static_cast<int64_t>(TransferCode::timeout)) {
+                    return;
+                }
+                ++fStats[out].fBusy;
+            }
+            fPoller->Poll(100);
+        }
+    }
+
+    template<typename T>
+    void SendWithCredit(T& payload)
+    {
+        while (!NewStatePending()) {
+            ReceiveCredits();
+            int out = -1;
+            for (int i = 0; i < fNumOutputs; ++i) {
+                int candidate = (fDirection + i) % fNumOutputs;
+                if (fStats[candidate].fInFlight >= fCredits) {
+                    ++fStats[candidate].fBusy;
+                } else if (out < 0 || fStats[candidate].fInFlight < fStats[out].fInFlight) {
+                    out = candidate;
+                }
+            }
+            if (out >= 0) {
+                if (fOutputs[out]->Send(payload) >= 0) {
+                    OutputStats& stats = fStats[out];
+                    ++stats.fDispatched;
+                    stats.fMaxInFlight = std::max(stats.fMaxInFlight, ++stats.fInFlight);
+                }
+                fDirection = out;
+                Advance(fDirection);
+                return;
+            }
+            fPoller->Poll(100);
+        }
+    }
+
+    void ReceiveCredits()
+    {
+        for (int i = 0; i < fNumOutputs; ++i) {
+            while (true) {
+                MessagePtr msg(fCreditInputs[i]->NewMessage());
+                if (fCreditInputs[i]->Receive(msg, 0) < 0) {
+                    break;
+                }
+                uint32_t credits = 1;
+                if (msg->GetSize() >= sizeof(credits)) {
+                    std::memcpy(&credits, msg->GetData(), sizeof(credits));
+                }
+                fStats[i].fInFlight = std::max<int64_t>(0, fStats[i].fInFlight - credits);
+            }
+        }
+    }
+
+    void Advance(int& direction) const
+    {
+        if (++direction >= fNumOutputs) {
+            direction = 0;
+        }
+    }
+
+    void PostRun() override
+    {
+        uint64_t total = 0;
+        for (const auto& stats : fStats) {
+            total += stats.fDispatched;
+        }
+        for (int i = 0; i < fNumOutputs; ++i) {
+            const OutputStats& stats = fStats[i];
+            LOG(info) << "Output " << fOutChannelName << "[" << i << "]: dispatched " << stats.fDispatched
+                      << " (" << (total ? 100. * stats.fDispatched / total : 0.) << "%), busy " << stats.fBusy
+                      << (fDispatch == Dispatch::Credit ? tools::ToString(", in flight ", stats.fInFlight, " (max ", stats.fMaxInFlight, ")") : "");
+        }
+    }
 };
 
 } // namespace fair::mq
@@ -0,0 +1,284 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef FAIR_MQ_TIMEFRAMEBUFFER_H
+#define FAIR_MQ_TIMEFRAMEBUFFER_H
+
+#include <fairmq/Parts.h>
+
+#include <algorithm> // std::max, std::move
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator> // std::make_move_iterator
+#include <stdexcept>
+#include <vector>
+
+namespace fair::mq {
+
+struct TimeframeBufferError : std::runtime_error { using std::runtime_error::runtime_error; };
+
+/// Statistics of a TimeframeBuffer
+struct TimeframeStats
+{
+    uint64_t numComplete = 0;   ///< time frames completed by all senders
+    uint64_t numIncomplete = 0; ///< time frames released incomplete (timed out, or evicted by a newer time frame)
+    uint64_t numLate = 0;       ///< sub time frames of time frames that were already released (or are older than the capacity)
+    uint64_t numDuplicate = 0;  ///< sub time frames of a sender that already contributed to the time frame
+    uint64_t buildTimeNs = 0;   ///< total time from the first to the last sub time frame of the complete time frames
+    uint64_t maxBuildTimeNs = 0;
+
+    /// fraction of the released time frames that were complete
+    double CompletenessRatio() const
+    {
+        uint64_t total = numComplete + numIncomplete;
+        return total > 0 ? static_cast<double>(numComplete) / static_cast<double>(total) : 0.;
+    }
+    double MeanBuildTimeNs() const { return numComplete > 0 ? static_cast<double>(buildTimeNs) / static_cast<double>(numComplete) : 0.; }
+};
+
+/// @brief Assembles time frames (events) from the sub time frames of a fixed number of senders
+///
+/// A time frame is identified by a (monotonically increasing) id, every sender contributes one sub time frame (one or
+/// more message parts) to it. In-flight time frames live in a fixed number of slots (id modulo capacity), with a
+/// bitmap of the senders that contributed. Timeouts are tracked by a timer wheel, so that neither adding nor expiring
+/// scans the in-flight time frames. The memory is bounded by the capacity: a time frame that needs the slot of an
+/// older one evicts it (released as incomplete), sub time frames for released time frames are rejected as late.
+/// The message parts are moved, never copied. Not thread-safe.
+class TimeframeBuffer
+{
+  public:
+    enum class Result
+    {
+        Added,     ///< the sub time frame was added, the time frame is not complete yet
+        Complete,  ///< the sub time frame completed the time frame, which was moved into the output parts
+        Late,      ///< the time frame was already released, the parts were not taken
+        Duplicate, ///< the sender already contributed to the time frame, the parts were not taken
+    };
+
+    using clock = std::chrono::steady_clock;
+
+    /// @param capacity maximum number of time frames in flight
+    /// @param numSenders number of senders (sub time frames) per time frame
+    /// @param timeout time after the first sub time frame after which an incomplete time frame is released
+    TimeframeBuffer(std::size_t capacity, unsigned int numSenders, std::chrono::milliseconds timeout)
+        : fNumSenders(numSenders)
+        , fBitmapWords((numSenders + 63) / 64)
+        , fTick(std::max<clock::duration>(std::chrono::milliseconds(1), timeout / (kWheelSize - 2)))
+        , fTimeout(timeout)
+        , fSlots(capacity)
+        , fBitmaps(capacity * fBitmapWords, 0)
+        , fWheel(kWheelSize, kNone)
+        , fLastTick(TickOf(clock::now()))
+    {
+        if (capacity == 0 || numSenders == 0) {
+            throw TimeframeBufferError("TimeframeBuffer: capacity and number of senders must be > 0");
+        }
+        for (auto& slot : fSlots) {
+            slot.senders.resize(numSenders);
+        }
+    }
+
+    TimeframeBuffer(const TimeframeBuffer&) = delete;
+    TimeframeBuffer& operator=(const TimeframeBuffer&) = delete;
+
+    /// @brief Add the sub time frame of a sender
+    /// @param id time frame id
+    /// @param sender sender index (< number of senders)
+    /// @param parts parts of the sub time frame, moved into the buffer unless the result is Late/Duplicate
+    /// @param frame receives the parts of all senders (in sender order) if the result is Complete (replacing its content)
+    /// @param onIncomplete called with (id, parts) for an incomplete time frame evicted by this one
+    template<typename OnIncomplete>
+    Result Add(uint64_t id, unsigned int sender, Parts& parts, Parts& frame, OnIncomplete&& onIncomplete)
+    {
+        if (sender >= fNumSenders) {
+            throw TimeframeBufferError("TimeframeBuffer: sender index out of range");
+        }
+
+        std::size_t index = id % fSlots.size();
+        Slot& slot = fSlots[index];
+        if (slot.state != State::Free && slot.id != id) {
+            if (id < slot.id) {
+                ++fStats.numLate;
+                return Result::Late;
+            }
+            if (slot.state == State::Building) {
+                Release(index, onIncomplete);
+            }
+            slot.state = State::Free;
+        } else if (slot.state == State::Released) {
+            ++fStats.numLate;
+            return Result::Late;
+        }
+
+        if (slot.state == State::Free) {
+            Start(index, id);
+        }
+
+        uint64_t& word = fBitmaps[index * fBitmapWords + sender / 64];
+        const uint64_t bit = uint64_t(1) << (sender % 64);
+        if (word & bit) {
+            ++fStats.numDuplicate;
+            return Result::Duplicate;
+        }
+        word |= bit;
+        auto& stored = slot.senders[sender];
+        stored.insert(stored.end(), std::make_move_iterator(parts.fParts.begin()), std::make_move_iterator(parts.fParts.end()));
+        parts.fParts.clear();
+
+        if (++slot.numContributed < fNumSenders) {
+            return Result::Added;
+        }
+
+        auto buildTime = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - slot.start).count());
+        ++fStats.numComplete;
+        fStats.buildTimeNs += buildTime;
+        fStats.maxBuildTimeNs = std::max(fStats.maxBuildTimeNs, buildTime);
+        Collect(index, frame);
+        return Result::Complete;
+    }
+
+    Result Add(uint64_t id, unsigned int sender, Parts& parts, Parts& frame)
+    {
+        return Add(id, sender, parts, frame, [](uint64_t, Parts&) {});
+    }
+
+    /// @brief Release the incomplete time frames whose timeout expired
+    /// @param onIncomplete called with (id, parts) for every released time frame (the parts are discarded afterwards)
+    /// @param now current time
+    /// @return number of released time frames
+    template<typename OnIncomplete>
+    std::size_t Expire(OnIncomplete&& onIncomplete, clock::time_point now = clock::now())
+    {
+        std::size_t numExpired = 0;
+        int64_t nowTick = TickOf(now);
+        // visit the buckets of the ticks since the last call, after a gap of a full round every bucket once
+        int64_t tick = std::max(fLastTick + 1, nowTick - static_cast<int64_t>(kWheelSize) + 1);
+        for (; tick <= nowTick; ++tick) {
+            int32_t index = fWheel[static_cast<std::size_t>(tick) % kWheelSize];
+            while (index != kNone) {
+                int32_t next = fSlots[static_cast<std::size_t>(index)].next;
+                if (fSlots[static_cast<std::size_t>(index)].deadlineTick <= nowTick) {
+                    Release(static_cast<std::size_t>(index), onIncomplete);
+                    ++numExpired;
+                }
+                index = next;
+            }
+        }
+        fLastTick = std::max(fLastTick, nowTick);
+        return numExpired;
+    }
+
+    std::size_t Expire(clock::time_point now = clock::now())
+    {
+        return Expire([](uint64_t, Parts&) {}, now);
+    }
+
+    /// number of time frames in flight
+    std::size_t Size() const { return fNumBuilding; }
+    std::size_t Capacity() const { return fSlots.size(); }
+    unsigned int GetNumSenders() const { return fNumSenders; }
+    const TimeframeStats& GetStats() const { return fStats; }
+    void ResetStats() { fStats = TimeframeStats(); }
+
+  private:
+    static constexpr std::size_t kWheelSize = 64;
+    static constexpr int32_t kNone = -1;
+
+    enum class State : uint8_t { Free, Building, Released };
+
+    struct Slot
+    {
+        uint64_t id = 0;
+        State state = State::Free;
+        unsigned int numContributed = 0;
+        clock::time_point start;
+        int64_t deadlineTick = 0;
+        int32_t prev = kNone; // timer wheel bucket list
+        int32_t next = kNone;
+        std::vector<Parts::container> senders; // parts per sender, the storage is reused
+    };
+
+    int64_t TickOf(clock::time_point t) const { return t.time_since_epoch() / fTick; }
+
+    void Start(std::size_t index, uint64_t id)
+    {
+        Slot& slot = fSlots[index];
+        slot.id = id;
+        slot.state = State::Building;
+        slot.numContributed = 0;
+        slot.start = clock::now();
+        // round up, so that a time frame lives at least for the timeout
+        slot.deadlineTick = TickOf(slot.start + fTimeout) + 1;
+        std::fill_n(fBitmaps.begin() + static_cast<std::ptrdiff_t>(index * fBitmapWords), fBitmapWords, 0);
+
+        int32_t& head = fWheel[static_cast<std::size_t>(slot.deadlineTick) % kWheelSize];
+        slot.prev = kNone;
+        slot.next = head;
+        if (head != kNone) {
+            fSlots[static_cast<std::size_t>(head)].prev = static_cast<int32_t>(index);
+        }
+        head = static_cast<int32_t>(index);
+        ++fNumBuilding;
+    }
+
+    /// remove the slot from its timer wheel bucket and mark it released
+    void Finish(std::size_t index)
+    {
+        Slot& slot = fSlots[index];
+        if (slot.prev != kNone) {
+            fSlots[static_cast<std::size_t>(slot.prev)].next = slot.next;
+        } else {
+            fWheel[static_cast<std::size_t>(slot.deadlineTick) % kWheelSize] = slot.next;
+        }
+        if (slot.next != kNone) {
+            fSlots[static_cast<std::size_t>(slot.next)].prev = slot.prev;
+        }
+        slot.prev = kNone;
+        slot.next = kNone;
+        slot.state = State::Released;
+        --fNumBuilding;
+    }
+
+    void Collect(std::size_t index, Parts& frame)
+    {
+        Slot& slot = fSlots[index];
+        Finish(index);
+        frame.fParts.clear();
+        for (auto& parts : slot.senders) {
+            frame.fParts.insert(frame.fParts.end(), std::make_move_iterator(parts.begin()), std::make_move_iterator(parts.end()));
+            parts.clear();
+        }
+    }
+
+    template<typename OnIncomplete>
+    void Release(std::size_t index, OnIncomplete& onIncomplete)
+    {
+        ++fStats.numIncomplete;
+        fIncomplete.fParts.clear();
+        Collect(index, fIncomplete);
+        onIncomplete(fSlots[index].id, fIncomplete);
+        fIncomplete.fParts.clear();
+    }
+
+    unsigned int fNumSenders;
+    std::size_t fBitmapWords;
+    clock::duration fTick;
+    clock::duration fTimeout;
+    std::vector<Slot> fSlots;
+    std::vector<uint64_t> fBitmaps; // fBitmapWords per slot
+    std::vector<int32_t> fWheel;    // heads of the bucket lists
+    int64_t fLastTick;
+    std::size_t fNumBuilding = 0;
+    Parts fIncomplete;
+    TimeframeStats fStats;
+};
+
+} // namespace fair::mq
+
+#endif /* FAIR_MQ_TIMEFRAMEBUFFER_H */
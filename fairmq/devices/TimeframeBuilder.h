@@ -0,0 +1,141 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef FAIR_MQ_TIMEFRAMEBUILDER_H
+#define FAIR_MQ_TIMEFRAMEBUILDER_H
+
+#include <fairmq/Device.h>
+#include <fairmq/Poller.h>
+#include <fairmq/devices/TimeframeBuffer.h>
+
+#include <fairlogger/Logger.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fair::mq
+{
+
+/// Header at the beginning of the first part of every sub time frame received by the TimeframeBuilder
+struct SubTimeframeHeader
+{
+    uint64_t id;     ///< time frame id
+    uint32_t sender; ///< sender index, 0 <= sender < number of senders
+};
+
+/// Receives sub time frames (multipart messages, starting with a SubTimeframeHeader) from a number of senders on the
+/// sub-channels of the input channel and sends every complete time frame as one multipart message with the parts of
+/// all senders, in sender order. Incomplete time frames are discarded (or sent) after a timeout.
+class TimeframeBuilder : public Device
+{
+  protected:
+    std::string fInChannelName{"data-in"};
+    std::string fOutChannelName{"data-out"};
+    bool fForwardIncomplete = false;
+    uint64_t fMaxTimeframes = 0;
+    uint64_t fNumSent = 0;
+    std::unique_ptr<TimeframeBuffer> fBuffer;
+
+    void InitTask() override
+    {
+        fInChannelName = fConfig->GetProperty<std::string>("in-channel");
+        fOutChannelName = fConfig->GetProperty<std::string>("out-channel");
+        fForwardIncomplete = fConfig->GetProperty<bool>("forward-incomplete");
+        fMaxTimeframes = fConfig->GetProperty<uint64_t>("max-timeframes");
+        fBuffer = std::make_unique<TimeframeBuffer>(fConfig->GetProperty<size_t>("capacity"),
+                                                    fConfig->GetProperty<unsigned int>("num-senders"),
+                                                    std::chrono::milliseconds(fConfig->GetProperty<int>("buffer-timeout")));
+        fNumSent = 0;
+    }
+
+    void RegisterChannelEndpoints() override
+    {
+        RegisterChannelEndpoint(fInChannelName, 1, 10000);
+        RegisterChannelEndpoint(fOutChannelName, 1, 1);
+
+        PrintRegisteredChannels();
+    }
+
+    /// Extract the time frame id and the sender index of a sub time frame, override for other header formats
+    virtual bool Identify(const Parts& parts, uint64_t& id, unsigned int& sender)
+    {
+        if (parts.Size() == 0 || parts.At(0)->GetSize() < sizeof(SubTimeframeHeader)) {
+            return false;
+        }
+        const auto* header = static_cast<const SubTimeframeHeader*>(parts.At(0)->GetData());
+        id = header->id;
+        sender = header->sender;
+        return sender < fBuffer->GetNumSenders();
+    }
+
+    void Run() override
+    {
+        int numInputs = GetNumSubChannels(fInChannelName);
+        PollerPtr poller(NewPoller(GetSubChannels({fInChannelName})));
+        Parts frame;
+        auto onIncomplete = [&](uint64_t id, Parts& parts) {
+            LOG(debug) << "Time frame #" << id << " incomplete (" << parts.Size() << " parts), " << (fForwardIncomplete ? "sending" : "discarding");
+            if (fForwardIncomplete) {
+                Forward(parts);
+            }
+        };
+
+        while (!NewStatePending()) {
+            poller->Poll(10);
+
+            for (int i = 0; i < numInputs; ++i) {
+                if (!poller->CheckInput(i)) {
+                    continue;
+                }
+                Parts parts;
+                if (Receive(parts, fInChannelName, i) < 0) {
+                    continue;
+                }
+                uint64_t id = 0;
+                unsigned int sender = 0;
+                if (!Identify(parts, id, sender)) {
+                    LOG(warn) << "Received a sub time frame without a valid header on " << fInChannelName << "[" << i << "], discarding";
+                    continue;
+                }
+                if (fBuffer->Add(id, sender, parts, frame, onIncomplete) == TimeframeBuffer::Result::Complete) {
+                    Forward(frame);
+                }
+            }
+
+            fBuffer->Expire(onIncomplete);
+
+            if (fMaxTimeframes > 0 && fNumSent >= fMaxTimeframes) {
+                LOG(info) << "Reached configured maximum number of time frames (" << fMaxTimeframes << "). Exiting RUNNING state.";
+                break;
+            }
+        }
+    }
+
+    void Forward(Parts& frame)
+    {
+        if (Send(frame, fOutChannelName) >= 0) {
+            ++fNumSent;
+        }
+    }
+
+    void PostRun() override
+    {
+        const TimeframeStats& stats = fBuffer->GetStats();
+        LOG(info) << "Time frames: " << stats.numComplete << " complete, " << stats.numIncomplete << " incomplete (completeness " << stats.CompletenessRatio() * 100. << "%), "
+                  << stats.numLate << " late and " << stats.numDuplicate << " duplicate sub time frames, "
+                  << "build time mean " << stats.MeanBuildTimeNs() / 1000. << " us, max " << stats.maxBuildTimeNs / 1000. << " us, "
+                  << fBuffer->Size() << " in flight";
+    }
+};
+
+} // namespace fair::mq
+
+#endif /* FAIR_MQ_TIMEFRAMEBUILDER_H */
@@ -0,0 +1,31 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include <fairmq/devices/FilePlayer.h>
+#include <fairmq/runDevice.h>
+
+namespace bpo = boost::program_options;
+
+void addCustomOptions(bpo::options_description& options)
+{
+    options.add_options()
+        ("in-filename", bpo::value<std::string>()->required(), "Recording to replay (written by fairmq-sink --out-format recording)")
+        ("out-channel", bpo::value<std::string>()->default_value("data"), "Name of the output channel")
+        ("replay", bpo::value<std::string>()->default_value("original"), "Replay timing: original (as recorded) / rate (--rate frames per second) / max (as fast as possible)")
+        ("speed", bpo::value<float>()->default_value(1.), "Speed-up of the original timing (replay original)")
+        ("rate", bpo::value<float>()->default_value(0.), "Frames per second (replay rate)")
+        ("loops", bpo::value<uint64_t>()->default_value(1), "Number of times the recording is replayed (0 - endlessly)")
+        ("max-iterations", bpo::value<uint64_t>()->default_value(0), "Maximum number of frames to send (0 - unlimited)")
+        ("copy", bpo::value<bool>()->default_value(false), "Copy every part into a new message instead of sending it from an unmanaged region")
+        ("region-path", bpo::value<std::string>()->default_value(""), "Path prefix of the file backing the unmanaged region (empty - not file backed)");
+}
+
+std::unique_ptr<fair::mq::Device> getDevice(fair::mq::ProgOptions& /*config*/)
+{
+    return std::make_unique<fair::mq::FilePlayer>();
+}
@@ -18,7 +18,14 @@ void addCustomOptions(bpo::options_description& options)
         ("out-filename", bpo::value<std::string>()->default_value(""), "Write incoming message buffers to the specified file")
         ("max-file-size", bpo::value<uint64_t>()->default_value(2000000000), "Maximum file size for the file output (0 - unlimited)")
         ("max-iterations", bpo::value<uint64_t>()->default_value(0), "Number of run iterations (0 - infinite)")
-        ("multipart", bpo::value<bool>()->default_value(false), "Handle multipart payloads");
+        ("multipart", bpo::value<bool>()->default_value(false), "Handle multipart payloads")
+        ("out-format", bpo::value<std::string>()->default_value("raw"), "Format of the file output: raw (buffers only) / recording (replayable with fairmq-fileplayer)")
+        ("file-writer", bpo::value<std::string>()->default_value("stream"), "File writer: stream (on the run thread) / async (vectored writes on a writer thread)")
+        ("write-queue-size", bpo::value<size_t>()->default_value(256 * 1024 * 1024), "Maximum bytes waiting to be written (async writer)")
+        ("write-batch", bpo::value<size_t>()->default_value(1024), "Maximum number of buffers per write call (async writer)")
+        ("rotate-size", bpo::value<uint64_t>()->default_value(0), "Start a new file <out-filename>.<index> after this many bytes (async writer, 0 - never)")
+        ("rotate-interval", bpo::value<int>()->default_value(0), "Start a new file <out-filename>.<index> after this many seconds (async writer, 0 - never)")
+        ("sync-bytes", bpo::value<uint64_t>()->default_value(0), "fdatasync() after this many bytes and when closing a file (async writer, 0 - never)");
 }
 
 std::unique_ptr<fair::mq::Device> getDevice(fair::mq::ProgOptions& /*config*/)
@@ -16,7 +16,10 @@ void addCustomOptions(bpo::options_description& options)
     options.add_options()
         ("in-channel", bpo::value<std::string>()->default_value("data-in"), "Name of the input channel")
         ("out-channel", bpo::value<std::string>()->default_value("data-out"), "Name of the output channel")
-        ("multipart", bpo::value<bool>()->default_value(true), "Handle multipart payloads");
+        ("multipart", bpo::value<bool>()->default_value(true), "Handle multipart payloads")
+        ("dispatch", bpo::value<std::string>()->default_value("round-robin"), "Output selection: round-robin/ready (skip busy outputs)/credit (fewest messages in flight)")
+        ("credit-channel", bpo::value<std::string>()->default_value("credits"), "Name of the channel returning credits, one sub-channel per output (credit dispatch)")
+        ("credits", bpo::value<int>()->default_value(8), "Maximum number of messages in flight per output (credit dispatch)");
 }
 
 std::unique_ptr<fair::mq::Device> getDevice(fair::mq::ProgOptions& /*config*/)
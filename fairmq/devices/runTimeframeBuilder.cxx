@@ -0,0 +1,29 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include <fairmq/devices/TimeframeBuilder.h>
+#include <fairmq/runDevice.h>
+
+namespace bpo = boost::program_options;
+
+void addCustomOptions(bpo::options_description& options)
+{
+    options.add_options()
+        ("in-channel", bpo::value<std::string>()->default_value("data-in"), "Name of the input channel")
+        ("out-channel", bpo::value<std::string>()->default_value("data-out"), "Name of the output channel")
+        ("num-senders", bpo::value<unsigned int>()->required(), "Number of senders (sub time frames) per time frame")
+        ("capacity", bpo::value<size_t>()->default_value(1024), "Maximum number of time frames in flight")
+        ("buffer-timeout", bpo::value<int>()->default_value(1000), "Time (in ms) after the first sub time frame after which an incomplete time frame is released")
+        ("forward-incomplete", bpo::value<bool>()->default_value(false), "Send incomplete time frames instead of discarding them")
+        ("max-timeframes", bpo::value<uint64_t>()->default_value(0), "Maximum number of time frames to send (0 - unlimited)");
+}
+
+std::unique_ptr<fair::mq::Device> getDevice(fair::mq::ProgOptions& /*config*/)
+{
+    return std::make_unique<fair::mq::TimeframeBuilder>();
+}
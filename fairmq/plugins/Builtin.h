@@ -10,3 +10,5 @@
 
 #include <fairmq/plugins/config/Config.h>
 #include <fairmq/plugins/control/Control.h>
+#include <fairmq/plugins/metrics/Metrics.h>
+#include <fairmq/plugins/trace/Trace.h>
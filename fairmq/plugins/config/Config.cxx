@@ -65,7 +65,7 @@ Plugin::ProgOptions ConfigPluginProgramOptions()
         ("init-timeout",                  po::value<int           >()->default_value(120),               "Timeout for the initialization in seconds (when expecting dynamic initialization).")
         ("print-channels",                po::value<bool          >()->implicit_value(true),             "Print registered channel endpoints in a machine-readable format (<channel name>:<min num subchannels>:<max num subchannels>)")
         ("shm-segment-size",              po::value<size_t        >()->default_value(2ULL << 30),        "Shared memory: size of the shared memory segment (in bytes).")
-        ("shm-allocation",                po::value<string        >()->default_value("rbtree_best_fit"), "Shared memory allocation algorithm: rbtree_best_fit/simple_seq_fit.")
+        ("shm-allocation",                po::value<string        >()->default_value("rbtree_best_fit"), "Shared memory allocation algorithm: rbtree_best_fit/simple_seq_fit/segregated_slab.")
         ("shm-segment-id",                po::value<uint16_t      >()->default_value(0),                 "EXPERIMENTAL: Shared memory segment id for message creation.")
         ("shmid",                         po::value<uint64_t      >(),                                   "EXPERIMENTAL: Fixed shmid to use instead of deriving it from the session name.")
         ("shm-mlock-segment",             po::value<bool          >()->default_value(false),             "Shared memory: mlock the shared memory segment after initialization (opened or created).")
@@ -74,10 +74,23 @@ Plugin::ProgOptions ConfigPluginProgramOptions()
         ("shm-zero-segment-on-creation",  po::value<bool          >()->default_value(false),             "Shared memory: zero the shared memory segment memory only once when created.")
         ("shm-throw-bad-alloc",           po::value<bool          >()->default_value(true),              "Shared memory: throw fair::mq::MessageBadAlloc if cannot allocate a message (retry if false).")
         ("shm-metadata-msg-size",         po::value<std::size_t   >()->default_value(0),                 "Shared memory: size of the zmq metadata message (values smaller than minimum are clamped to the minimum).")
+        ("shm-alloc-cache",               po::value<bool          >()->default_value(false),             "Shared memory: keep per-thread caches of size-classed free chunks in front of the segment allocator.")
+        ("shm-alloc-cache-max-size",      po::value<std::size_t   >()->default_value(65536),             "Shared memory: largest chunk (message size + header) served by the allocation cache (in bytes).")
+        ("shm-alloc-cache-capacity",      po::value<std::size_t   >()->default_value(64),                "Shared memory: maximum number of chunks per size class and thread in the allocation cache. A quarter of it is the refill/flush batch size.")
+        ("shm-ring",                      po::value<bool          >()->default_value(false),             "Shared memory: exchange metadata of push/pull/pair channels with a single ipc/inproc endpoint via a ring buffer in shared memory instead of ZeroMQ. Must be enabled on all peers.")
+        ("shm-ring-capacity",             po::value<std::size_t   >()->default_value(1024),              "Shared memory: number of slots (message parts) of the metadata ring buffers (rounded up to a power of 2).")
+        ("shm-ring-spin",                 po::value<unsigned int  >()->default_value(4000),              "Shared memory: maximum number of busy-wait iterations on a metadata ring before sleeping (adapted at runtime).")
+        ("shm-pub-policy",                po::value<string        >()->default_value("drop"),            "Shared memory: handling of pub channel subscribers at their high-water mark (sndBufSize): drop (the subscriber misses the message)/block (wait for the subscriber within the send timeout).")
         ("bad-alloc-max-attempts",        po::value<int           >(),                                   "Maximum number of allocation attempts before throwing fair::mq::MessageBadAlloc. -1 is infinite. There is always at least one attempt, so 0 has safe effect as 1.")
         ("bad-alloc-attempt-interval",    po::value<int           >()->default_value(50),                "Interval between attempts if cannot allocate a message (in ms).")
         ("shm-monitor",                   po::value<bool          >()->default_value(false),             "Shared memory: run monitor daemon.")
         ("shm-no-cleanup",                po::value<bool          >()->default_value(false),             "Shared memory: do not cleanup the memory when last device leaves.")
+        ("poll-spin",                     po::value<unsigned int  >()->default_value(0),                 "Busy-poll: time (in us) for which pollers check the channels without blocking before they block (0: block right away).")
+        ("input-rotate",                  po::value<bool          >()->default_value(false),             "OnData input handling: start at the next input sub-channel after each poll (round-robin) instead of always at the first.")
+        ("input-drain",                   po::value<unsigned int  >()->default_value(1),                 "OnData input handling: maximum number of messages handled per ready input sub-channel and poll.")
+        ("input-weights",                 po::value<vector<string>>()->multitoken()->composing(),        "OnData input handling: per channel factors for input-drain (priority), as <channel name>:<weight>.")
+        ("input-threads",                 po::value<unsigned int  >()->default_value(0),                 "OnData input handling: number of worker threads that poll the input sub-channels and call their callbacks concurrently (0: no workers).")
+        ("input-groups",                  po::value<vector<string>>()->multitoken()->composing(),        "OnData input handling: assignment of channels to input workers, as <channel name>:<worker index> (others are distributed over the workers).")
         ("rate",                          po::value<float         >()->default_value(0.),                "Rate for conditional run loop (Hz).")
         ("session",                       po::value<string        >()->default_value("default"),         "Session name.")
         ("config-key",                    po::value<string        >(),                                   "Use provided value instead of device id for fetching the configuration from JSON file.")
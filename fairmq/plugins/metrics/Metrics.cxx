@@ -0,0 +1,284 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include "Metrics.h"
+
+#include <fairmq/tools/Strings.h>
+
+#include <cerrno>
+#include <cstdio> // std::rename
+#include <cstring> // strerror
+#include <fstream>
+#include <sstream>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace fair::mq::plugins
+{
+
+namespace
+{
+
+auto SendAll(int fd, const string& data) -> void
+{
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        sent += static_cast<size_t>(n);
+    }
+}
+
+auto Response(const string& status, const string& contentType, const string& body) -> string
+{
+    return tools::ToString("HTTP/1.1 ", status, "\r\n",
+                           "Content-Type: ", contentType, "\r\n",
+                           "Content-Length: ", body.size(), "\r\n",
+                           "Connection: close\r\n\r\n",
+                           body);
+}
+
+} // namespace
+
+Metrics::Metrics(const string& name, Plugin::Version version, const string& maintainer, const string& homepage, PluginServices* pluginServices)
+    : Plugin(name, version, maintainer, homepage, pluginServices)
+    , fFile(GetProperty<string>("metrics-file", ""))
+    , fInterval(max(GetProperty<int>("metrics-interval", 10), 1))
+    , fStop(false)
+{
+    try {
+        auto http = GetProperty<string>("metrics-http", "");
+        auto socketPath = GetProperty<string>("metrics-socket", "");
+        if (!http.empty()) {
+            Listen(http);
+        }
+        if (!socketPath.empty()) {
+            ListenUnix(socketPath);
+        }
+    } catch (...) {
+        for (int fd : fListeners) {
+            ::close(fd);
+        }
+        throw;
+    }
+
+    if (fListeners.empty() && fFile.empty()) {
+        LOG(debug) << "Metrics plugin: no exporter configured";
+        return;
+    }
+
+    GetMetrics().SetEnabled(true);
+    GetMetrics().SetTimingEnabled(GetProperty<bool>("metrics-timing", true));
+    SubscribeToPropertyChange<bool>([&](const string& key, bool value) {
+        if (key == "metrics-timing") {
+            LOG(debug) << "Metrics plugin: " << (value ? "enabling" : "disabling") << " channel timing";
+            GetMetrics().SetTimingEnabled(value);
+        }
+    });
+    fThread = thread(&Metrics::Serve, this);
+}
+
+auto Metrics::Listen(const string& http) -> void
+{
+    string host;
+    string port = http;
+    if (auto pos = http.rfind(':'); pos != string::npos) {
+        host = http.substr(0, pos);
+        port = http.substr(pos + 1);
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    try {
+        addr.sin_port = htons(static_cast<uint16_t>(stoi(port)));
+    } catch (const exception&) {
+        throw ExporterError(tools::ToString("metrics-http: invalid port in '", http, "', expected [host:]port"));
+    }
+    if (!host.empty() && host != "*" && inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+        throw ExporterError(tools::ToString("metrics-http: invalid IPv4 address in '", http, "'"));
+    }
+
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw ExporterError(tools::ToString("metrics-http: socket() failed: ", strerror(errno)));
+    }
+    int one = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, 16) != 0) {
+        int err = errno;
+        ::close(fd);
+        throw ExporterError(tools::ToString("metrics-http: cannot listen on '", http, "': ", strerror(err)));
+    }
+    fListeners.push_back(fd);
+    LOG(info) << "Metrics plugin: serving /metrics on http://" << (host.empty() ? "*" : host) << ":" << port;
+}
+
+auto Metrics::ListenUnix(const string& path) -> void
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw ExporterError(tools::ToString("metrics-socket: path too long: '", path, "'"));
+    }
+    path.copy(addr.sun_path, path.size());
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw ExporterError(tools::ToString("metrics-socket: socket() failed: ", strerror(errno)));
+    }
+    ::unlink(path.c_str()); // stale socket of a previous run
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, 16) != 0) {
+        int err = errno;
+        ::close(fd);
+        throw ExporterError(tools::ToString("metrics-socket: cannot listen on '", path, "': ", strerror(err)));
+    }
+    fListeners.push_back(fd);
+    fSocketPath = path;
+    LOG(info) << "Metrics plugin: serving /metrics on unix socket " << path;
+}
+
+auto Metrics::Serve() -> void
+{
+    vector<pollfd> fds;
+    for (int fd : fListeners) {
+        fds.push_back(pollfd{fd, POLLIN, 0});
+    }
+    auto nextWrite = chrono::steady_clock::now() + fInterval;
+
+    while (!fStop) {
+        if (!fds.empty()) {
+            if (::poll(fds.data(), fds.size(), 100) > 0) {
+                for (auto& pfd : fds) {
+                    if (pfd.revents & POLLIN) {
+                        int conn = ::accept4(pfd.fd, nullptr, nullptr, SOCK_CLOEXEC);
+                        if (conn >= 0) {
+                            HandleConnection(conn);
+                            ::close(conn);
+                        }
+                    }
+                    pfd.revents = 0;
+                }
+            }
+        } else {
+            this_thread::sleep_for(chrono::milliseconds(100));
+        }
+
+        if (!fFile.empty() && chrono::steady_clock::now() >= nextWrite) {
+            WriteFile();
+            nextWrite += fInterval;
+        }
+    }
+}
+
+auto Metrics::HandleConnection(int fd) -> void
+{
+    // a slow or silent client must not block the exporter for long
+    timeval timeout{1, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    string request;
+    char buf[1024];
+    while (request.find("\r\n\r\n") == string::npos && request.size() < 8192) {
+        ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        request.append(buf, static_cast<size_t>(n));
+    }
+
+    istringstream line(request.substr(0, request.find("\r\n")));
+    string method;
+    string target;
+    line >> method >> target;
+    target = target.substr(0, target.find('?'));
+
+    if (method != "GET") {
+        SendAll(fd, Response("405 Method Not Allowed", "text/plain", "only GET is supported\n"));
+    } else if (target == "/metrics") {
+        ostringstream body;
+        GetMetrics().WritePrometheus(body);
+        SendAll(fd, Response("200 OK", "text/plain; version=0.0.4; charset=utf-8", body.str()));
+    } else if (target == "/metrics.json") {
+        ostringstream body;
+        GetMetrics().WriteJson(body);
+        SendAll(fd, Response("200 OK", "application/json", body.str()));
+    } else {
+        SendAll(fd, Response("404 Not Found", "text/plain", "see /metrics or /metrics.json\n"));
+    }
+}
+
+auto Metrics::WriteFile() -> void
+{
+    // write to a temporary file and rename it, so that readers never see a partial dump
+    string tmp = fFile + ".tmp";
+    {
+        ofstream out(tmp, ios::trunc);
+        if (!out) {
+            LOG(warn) << "Metrics plugin: cannot open " << tmp << " for writing";
+            return;
+        }
+        GetMetrics().WriteJson(out);
+        if (!out) {
+            LOG(warn) << "Metrics plugin: failed writing " << tmp;
+            return;
+        }
+    }
+    if (std::rename(tmp.c_str(), fFile.c_str()) != 0) {
+        LOG(warn) << "Metrics plugin: cannot rename " << tmp << " to " << fFile << ": " << strerror(errno);
+    }
+}
+
+auto MetricsPluginProgramOptions() -> Plugin::ProgOptions
+{
+    namespace po = boost::program_options;
+    auto pluginOptions = po::options_description{"Metrics (builtin) Plugin"};
+    pluginOptions.add_options()
+        ("metrics-http",     po::value<string>()->default_value(""),   "Serve the metrics over HTTP on [host:]port (/metrics in the Prometheus text format, /metrics.json).")
+        ("metrics-socket",   po::value<string>()->default_value(""),   "Serve the metrics over HTTP on the given Unix socket path (e.g. curl --unix-socket <path> http://localhost/metrics).")
+        ("metrics-file",     po::value<string>()->default_value(""),   "Periodically write the metrics as JSON into the given file.")
+        ("metrics-interval", po::value<int   >()->default_value(10),   "Interval in seconds for --metrics-file.")
+        ("metrics-timing",   po::value<bool  >()->default_value(true), "Measure the time spent in, the durations and the timeouts of channel transfers (only if an exporter is configured). Can be changed at runtime via the property.");
+    return pluginOptions;
+}
+
+Metrics::~Metrics()
+{
+    if (fThread.joinable()) {
+        UnsubscribeFromPropertyChange<bool>();
+        fStop = true;
+        fThread.join();
+    }
+    for (int fd : fListeners) {
+        ::close(fd);
+    }
+    if (!fSocketPath.empty()) {
+        ::unlink(fSocketPath.c_str());
+    }
+    if (!fFile.empty()) {
+        WriteFile();
+    }
+}
+
+} // namespace fair::mq::plugins
@@ -0,0 +1,71 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef FAIR_MQ_PLUGINS_METRICS
+#define FAIR_MQ_PLUGINS_METRICS
+
+#include <fairmq/Plugin.h>
+#include <fairmq/Version.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fair::mq::plugins
+{
+
+/// Exports the metrics registry of the device (see fair::mq::metrics::Registry):
+///  - over HTTP on a TCP port (--metrics-http) and/or a Unix socket (--metrics-socket),
+///    /metrics in the Prometheus text format, /metrics.json as JSON,
+///  - as JSON into a file (--metrics-file), every --metrics-interval seconds and when the device shuts down.
+/// Without any of these options the plugin does nothing.
+class Metrics : public Plugin
+{
+  public:
+    struct ExporterError : std::runtime_error { using std::runtime_error::runtime_error; };
+
+    Metrics(const std::string& name, Plugin::Version version, const std::string& maintainer, const std::string& homepage, PluginServices* pluginServices);
+    Metrics(const Metrics&) = delete;
+    Metrics(Metrics&&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+    Metrics& operator=(Metrics&&) = delete;
+
+    ~Metrics() override;
+
+  private:
+    auto Listen(const std::string& http) -> void;
+    auto ListenUnix(const std::string& path) -> void;
+    auto Serve() -> void;
+    auto HandleConnection(int fd) -> void;
+    auto WriteFile() -> void;
+
+    std::vector<int> fListeners;
+    std::string fSocketPath;
+    std::string fFile;
+    std::chrono::seconds fInterval;
+    std::atomic<bool> fStop;
+    std::thread fThread;
+}; /* class Metrics */
+
+auto MetricsPluginProgramOptions() -> Plugin::ProgOptions;
+
+REGISTER_FAIRMQ_PLUGIN(
+    Metrics,   // Class name
+    metrics,   // Plugin name
+    (Plugin::Version{FAIRMQ_VERSION_MAJOR, FAIRMQ_VERSION_MINOR, FAIRMQ_VERSION_PATCH}),
+    "FairRootGroup <fairroot@gsi.de>",
+    "https://github.com/FairRootGroup/FairMQ",
+    MetricsPluginProgramOptions
+)
+
+} // namespace fair::mq::plugins
+
+#endif /* FAIR_MQ_PLUGINS_METRICS */
@@ -0,0 +1,160 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include "Trace.h"
+
+#include <fairmq/tools/Strings.h>
+
+#include <iomanip>
+#include <sstream>
+
+#include <unistd.h> // getpid
+
+using namespace std;
+
+namespace fair::mq::plugins
+{
+
+namespace
+{
+
+struct Micros
+{
+    uint64_t fNs;
+};
+
+ostream& operator<<(ostream& os, Micros t)
+{
+    return os << t.fNs / 1000 << '.' << setw(3) << setfill('0') << t.fNs % 1000 << setfill(' ');
+}
+
+string FlowId(uint64_t traceId, uint32_t hop)
+{
+    ostringstream ss;
+    ss << "0x" << hex << traceId << '.' << dec << hop;
+    return ss.str();
+}
+
+} // namespace
+
+Trace::Trace(const string& name, Plugin::Version version, const string& maintainer, const string& homepage, PluginServices* pluginServices)
+    : Plugin(name, version, maintainer, homepage, pluginServices)
+    , fFile(GetProperty<string>("trace-file", ""))
+    , fInterval(max(GetProperty<int>("trace-interval", 1000), 10))
+    , fPid(static_cast<int>(getpid()))
+    , fFirstEvent(true)
+    , fStop(false)
+{
+    if (fFile.empty()) {
+        return;
+    }
+
+    fOut.open(fFile, ios::trunc);
+    if (!fOut) {
+        throw TraceError(tools::ToString("trace-file: cannot open '", fFile, "' for writing"));
+    }
+    fOut << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+    fOut << "{\"ph\": \"M\", \"name\": \"process_name\", \"pid\": " << fPid << ", \"tid\": 0, \"args\": {\"name\": \"" << GetProperty<string>("id", "") << "\"}}";
+    fFirstEvent = false;
+
+    auto const sampleRate = GetProperty<double>("trace-sample-rate", 0.001);
+    tracing::Enable(sampleRate);
+    LOG(info) << "Trace plugin: tracing " << sampleRate * 100 << "% of the messages started here, writing to " << fFile;
+
+    SubscribeToPropertyChange<double>([&](const string& key, double value) {
+        if (key == "trace-sample-rate") {
+            LOG(debug) << "Trace plugin: sample rate " << value;
+            tracing::SetSampleRate(value);
+        }
+    });
+    fThread = thread(&Trace::Run, this);
+}
+
+auto Trace::Run() -> void
+{
+    while (!fStop) {
+        auto const next = chrono::steady_clock::now() + fInterval;
+        while (!fStop && chrono::steady_clock::now() < next) {
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        Flush();
+    }
+}
+
+auto Trace::Flush() -> void
+{
+    tracing::Collect([this](const tracing::Span& span) { WriteSpan(span); });
+    fOut.flush();
+}
+
+auto Trace::BeginEvent(const char* phase, const char* name, const tracing::Span& span, uint64_t tsNs) -> void
+{
+    fOut << (fFirstEvent ? "" : ",\n") << "{\"ph\": \"" << phase << "\", \"cat\": \"fairmq\", \"name\": \"" << name
+         << "\", \"pid\": " << fPid << ", \"tid\": " << span.fThread << ", \"ts\": " << Micros{tsNs};
+    fFirstEvent = false;
+}
+
+auto Trace::WriteSpan(const tracing::Span& span) -> void
+{
+    const tracing::Context& ctx = span.fContext;
+    const char* what = span.fDirection == tracing::Direction::tx ? "send" : (span.fDirection == tracing::Direction::rx ? "receive" : "forward");
+    string name = tools::ToString(span.fChannel, " ", what);
+    uint64_t const dur = span.fEndNs > span.fStartNs ? span.fEndNs - span.fStartNs : 0;
+
+    BeginEvent("X", name.c_str(), span, span.fStartNs);
+    fOut << ", \"dur\": " << Micros{dur} << ", \"args\": {\"trace_id\": \"0x" << hex << ctx.fTraceId << dec << "\", \"hop\": " << ctx.fHop
+         << ", \"bytes\": " << span.fBytes;
+    if (span.fDirection != tracing::Direction::tx && span.fEndNs > ctx.fOriginNs) {
+        fOut << ", \"since_origin_us\": " << Micros{span.fEndNs - ctx.fOriginNs};
+    }
+    if (span.fDirection == tracing::Direction::rx && span.fEndNs > ctx.fSentNs) {
+        fOut << ", \"since_sent_us\": " << Micros{span.fEndNs - ctx.fSentNs};
+    }
+    fOut << "}}";
+
+    // flow arrows from the send of a hop to its receive, the ids are unique per trace and hop
+    if (span.fDirection == tracing::Direction::rx || (span.fDirection == tracing::Direction::forward && ctx.fHop > 0)) {
+        uint32_t const hop = span.fDirection == tracing::Direction::forward ? ctx.fHop - 1 : ctx.fHop;
+        BeginEvent("f", "message", span, span.fStartNs);
+        fOut << ", \"bp\": \"e\", \"id\": \"" << FlowId(ctx.fTraceId, hop) << "\"}";
+    }
+    if (span.fDirection != tracing::Direction::rx) {
+        BeginEvent("s", "message", span, span.fStartNs);
+        fOut << ", \"id\": \"" << FlowId(ctx.fTraceId, ctx.fHop) << "\"}";
+    }
+}
+
+auto TracePluginProgramOptions() -> Plugin::ProgOptions
+{
+    namespace po = boost::program_options;
+    auto pluginOptions = po::options_description{"Trace (builtin) Plugin"};
+    pluginOptions.add_options()
+        ("trace-file",        po::value<string>()->default_value(""),    "Enable message tracing and write the spans to the given file (Chrome trace event format).")
+        ("trace-sample-rate", po::value<double>()->default_value(0.001), "Fraction of the messages that start a new trace (0..1), messages received with a trace pass it on regardless. Can be changed at runtime via the property.")
+        ("trace-interval",    po::value<int   >()->default_value(1000),  "Interval in ms for writing the recorded spans to --trace-file.");
+    return pluginOptions;
+}
+
+Trace::~Trace()
+{
+    if (!fThread.joinable()) {
+        return;
+    }
+    UnsubscribeFromPropertyChange<double>();
+    tracing::Disable();
+    fStop = true;
+    fThread.join();
+    Flush();
+    fOut << "\n]}\n";
+    fOut.close();
+    if (auto const dropped = tracing::GetNumDropped(); dropped > 0) {
+        LOG(warn) << "Trace plugin: " << dropped << " spans were dropped, consider a lower sample rate or a shorter interval";
+    }
+}
+
+} // namespace fair::mq::plugins
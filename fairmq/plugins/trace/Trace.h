@@ -0,0 +1,70 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef FAIR_MQ_PLUGINS_TRACE
+#define FAIR_MQ_PLUGINS_TRACE
+
+#include <fairmq/Plugin.h>
+#include <fairmq/Tracing.h>
+#include <fairmq/Version.h>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace fair::mq::plugins
+{
+
+/// Enables message tracing (see fair::mq::tracing) with --trace-file and writes the spans recorded by the device
+/// into that file in the Chrome trace event format (JSON, viewable with Perfetto or chrome://tracing).
+/// The sample rate (--trace-sample-rate) can be changed at runtime via the property.
+class Trace : public Plugin
+{
+  public:
+    struct TraceError : std::runtime_error { using std::runtime_error::runtime_error; };
+
+    Trace(const std::string& name, Plugin::Version version, const std::string& maintainer, const std::string& homepage, PluginServices* pluginServices);
+    Trace(const Trace&) = delete;
+    Trace(Trace&&) = delete;
+    Trace& operator=(const Trace&) = delete;
+    Trace& operator=(Trace&&) = delete;
+
+    ~Trace() override;
+
+  private:
+    auto Run() -> void;
+    auto Flush() -> void;
+    auto WriteSpan(const tracing::Span& span) -> void;
+    auto BeginEvent(const char* phase, const char* name, const tracing::Span& span, uint64_t tsNs) -> void;
+
+    std::ofstream fOut;
+    std::string fFile;
+    std::chrono::milliseconds fInterval;
+    int fPid;
+    bool fFirstEvent;
+    std::atomic<bool> fStop;
+    std::thread fThread;
+}; /* class Trace */
+
+auto TracePluginProgramOptions() -> Plugin::ProgOptions;
+
+REGISTER_FAIRMQ_PLUGIN(
+    Trace,   // Class name
+    trace,   // Plugin name
+    (Plugin::Version{FAIRMQ_VERSION_MAJOR, FAIRMQ_VERSION_MINOR, FAIRMQ_VERSION_PATCH}),
+    "FairRootGroup <fairroot@gsi.de>",
+    "https://github.com/FairRootGroup/FairMQ",
+    TracePluginProgramOptions
+)
+
+} // namespace fair::mq::plugins
+
+#endif /* FAIR_MQ_PLUGINS_TRACE */
@@ -0,0 +1,269 @@
+/********************************************************************************
+ * Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH       *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+#ifndef FAIR_MQ_SHMEM_ACKRING_H_
+#define FAIR_MQ_SHMEM_ACKRING_H_
+
+#include "Common.h"
+#include "Futex.h"
+
+#include <boost/interprocess/offset_ptr.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <new> // placement new
+
+namespace fair::mq::shmem
+{
+
+// Acknowledgement queue of an unmanaged region, placed in its own small segment and shared by all processes
+// that release region blocks (producers) and the region owner (single consumer).
+// Producers push lock-free (D. Vyukov's bounded MPMC queue). The consumer sleeps on a futex word and announces
+// how many pending acks it waits for, producers wake it only once that many are queued.
+// Ack latencies (release to delivery) are kept in a log-linear histogram readable by other processes.
+class AckRing
+{
+  public:
+    struct Slot
+    {
+        std::atomic<uint64_t> fSeq;
+        RegionBlock fBlock;
+        uint64_t fReleaseTime; // steady clock, ns
+    };
+
+    static constexpr uint32_t kNumSubBuckets = 8;
+    static constexpr uint32_t kNumBuckets = 64 * kNumSubBuckets;
+
+    AckRing(Slot* slots, uint32_t capacity)
+        : fSlots(slots)
+        , fCapacity(capacity)
+        , fMask(capacity - 1)
+        , fPadding0()
+        , fEnqueuePos(0)
+        , fPadding1()
+        , fDequeuePos(0)
+        , fPadding2()
+        , fDataSeq(0)
+        , fWaitThreshold(0)
+        , fPadding3()
+        , fSpaceSeq(0)
+        , fSpaceWaiters(0)
+        , fPadding4()
+        , fReceiverActive(false)
+        , fNumAcks(0)
+        , fMaxLatency(0)
+        , fLatencies()
+    {
+        for (uint32_t i = 0; i < fCapacity; ++i) {
+            Slot* slot = ::new (static_cast<void*>(&slots[i])) Slot();
+            slot->fSeq.store(i, std::memory_order_relaxed);
+        }
+        for (auto& bucket : fLatencies) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    AckRing(const AckRing&) = delete;
+    AckRing(AckRing&&) = delete;
+    AckRing& operator=(const AckRing&) = delete;
+    AckRing& operator=(AckRing&&) = delete;
+
+    uint32_t Capacity() const { return fCapacity; }
+
+    /// number of queued acks (approximate while producers are active)
+    uint64_t Size() const
+    {
+        uint64_t enq = fEnqueuePos.load(std::memory_order_acquire);
+        uint64_t deq = fDequeuePos.load(std::memory_order_acquire);
+        return enq > deq ? enq - deq : 0;
+    }
+
+    /// set by the region owner while it consumes acks, releases of blocks are not queued otherwise
+    void SetReceiverActive(bool active) { fReceiverActive.store(active, std::memory_order_seq_cst); }
+    bool ReceiverActive() const { return fReceiverActive.load(std::memory_order_acquire); }
+
+    bool TryPush(const RegionBlock& block, uint64_t releaseTime)
+    {
+        uint64_t pos = fEnqueuePos.load(std::memory_order_relaxed);
+        Slot* slot = nullptr;
+        while (true) {
+            slot = &SlotAt(pos);
+            int64_t diff = static_cast<int64_t>(slot->fSeq.load(std::memory_order_acquire) - pos);
+            if (diff == 0) {
+                if (fEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // full
+            } else {
+                pos = fEnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->fBlock = block;
+        slot->fReleaseTime = releaseTime;
+        slot->fSeq.store(pos + 1, std::memory_order_release);
+
+        fDataSeq.fetch_add(1, std::memory_order_seq_cst);
+        uint32_t threshold = fWaitThreshold.load(std::memory_order_seq_cst);
+        if (threshold > 0 && Size() >= threshold) {
+            FutexWake(fDataSeq);
+        }
+        return true;
+    }
+
+    /// release time of the oldest queued ack, 0 if empty. Consumer side only.
+    uint64_t OldestReleaseTime() const
+    {
+        uint64_t pos = fDequeuePos.load(std::memory_order_relaxed);
+        const Slot& slot = SlotAt(pos);
+        if (slot.fSeq.load(std::memory_order_acquire) != pos + 1) {
+            return 0;
+        }
+        return slot.fReleaseTime;
+    }
+
+    /// dequeues up to max acks, calling consume(const RegionBlock&, uint64_t releaseTime) for each. Consumer side only.
+    template<typename F>
+    uint32_t Pop(F&& consume, uint32_t max)
+    {
+        uint64_t pos = fDequeuePos.load(std::memory_order_relaxed);
+        uint32_t n = 0;
+        for (; n < max; ++n) {
+            Slot& slot = SlotAt(pos + n);
+            if (slot.fSeq.load(std::memory_order_acquire) != pos + n + 1) {
+                break;
+            }
+            consume(static_cast<const RegionBlock&>(slot.fBlock), slot.fReleaseTime);
+            slot.fSeq.store(pos + n + fCapacity, std::memory_order_release);
+        }
+        if (n > 0) {
+            fDequeuePos.store(pos + n, std::memory_order_release);
+            fSpaceSeq.fetch_add(1, std::memory_order_seq_cst);
+            if (fSpaceWaiters.load(std::memory_order_seq_cst) > 0) {
+                FutexWake(fSpaceSeq);
+            }
+        }
+        return n;
+    }
+
+    /// consumer: sleeps until at least threshold acks are queued, timeoutNs passed (negative: no timeout),
+    /// interrupted() returns true or WakeReceiver() is called
+    template<typename Pred>
+    void WaitForAcks(uint32_t threshold, int64_t timeoutNs, Pred interrupted)
+    {
+        uint32_t current = fDataSeq.load(std::memory_order_seq_cst);
+        fWaitThreshold.store(threshold, std::memory_order_seq_cst);
+        if (Size() < threshold && !interrupted()) {
+            FutexWait(fDataSeq, current, timeoutNs);
+        }
+        fWaitThreshold.store(0, std::memory_order_seq_cst);
+    }
+
+    void WakeReceiver()
+    {
+        fDataSeq.fetch_add(1, std::memory_order_seq_cst);
+        FutexWake(fDataSeq);
+    }
+
+    /// producer: sleeps until there is space or timeoutNs passed
+    void WaitForSpace(int64_t timeoutNs)
+    {
+        uint32_t current = fSpaceSeq.load(std::memory_order_seq_cst);
+        fSpaceWaiters.fetch_add(1, std::memory_order_seq_cst);
+        if (Size() >= fCapacity) {
+            FutexWait(fSpaceSeq, current, timeoutNs);
+        }
+        fSpaceWaiters.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    /// records an ack latency. Consumer side only.
+    void RecordLatency(uint64_t ns)
+    {
+        fLatencies[BucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+        fNumAcks.fetch_add(1, std::memory_order_relaxed);
+        if (ns > fMaxLatency.load(std::memory_order_relaxed)) {
+            fMaxLatency.store(ns, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t NumAcks() const { return fNumAcks.load(std::memory_order_relaxed); }
+    uint64_t MaxLatency() const { return fMaxLatency.load(std::memory_order_relaxed); }
+
+    /// latency (ns) below which the fraction q of the recorded acks lies (upper edge of the histogram bucket)
+    uint64_t LatencyPercentile(double q) const
+    {
+        uint64_t total = 0;
+        for (const auto& bucket : fLatencies) {
+            total += bucket.load(std::memory_order_relaxed);
+        }
+        if (total == 0) {
+            return 0;
+        }
+        auto rank = static_cast<uint64_t>(q * static_cast<double>(total));
+        uint64_t count = 0;
+        for (uint32_t i = 0; i < kNumBuckets; ++i) {
+            count += fLatencies[i].load(std::memory_order_relaxed);
+            if (count > rank) {
+                uint64_t upper = BucketUpperEdge(i);
+                uint64_t max = MaxLatency();
+                return upper < max ? upper : max;
+            }
+        }
+        return MaxLatency();
+    }
+
+  private:
+    boost::interprocess::offset_ptr<Slot> fSlots;
+    const uint32_t fCapacity;
+    const uint64_t fMask;
+
+    // producer and consumer sides on separate cache lines (padded, the segment does not honour alignas)
+    char fPadding0[64];
+    std::atomic<uint64_t> fEnqueuePos;
+    char fPadding1[56];
+    std::atomic<uint64_t> fDequeuePos;
+    char fPadding2[56];
+    std::atomic<uint32_t> fDataSeq;
+    std::atomic<uint32_t> fWaitThreshold;
+    char fPadding3[56];
+    std::atomic<uint32_t> fSpaceSeq;
+    std::atomic<uint32_t> fSpaceWaiters;
+    char fPadding4[56];
+
+    std::atomic<bool> fReceiverActive;
+    std::atomic<uint64_t> fNumAcks;
+    std::atomic<uint64_t> fMaxLatency;
+    std::atomic<uint64_t> fLatencies[kNumBuckets];
+
+    Slot& SlotAt(uint64_t pos) const { return fSlots[pos & fMask]; }
+
+    // log-linear: values below kNumSubBuckets map directly, above that each power of two is split into kNumSubBuckets
+    static uint32_t BucketIndex(uint64_t v)
+    {
+        if (v < kNumSubBuckets) {
+            return static_cast<uint32_t>(v);
+        }
+        uint32_t msb = 63 - static_cast<uint32_t>(__builtin_clzll(v));
+        uint32_t sub = static_cast<uint32_t>(v >> (msb - 3)) & (kNumSubBuckets - 1);
+        return (msb - 2) * kNumSubBuckets + sub;
+    }
+
+    static uint64_t BucketUpperEdge(uint32_t index)
+    {
+        if (index < kNumSubBuckets) {
+            return index;
+        }
+        uint32_t msb = index / kNumSubBuckets + 2;
+        uint64_t sub = index % kNumSubBuckets;
+        return ((kNumSubBuckets + sub + 1) << (msb - 3)) - 1;
+    }
+};
+
+} // namespace fair::mq::shmem
+
+#endif /* FAIR_MQ_SHMEM_ACKRING_H_ */
@@ -27,6 +27,7 @@
 
 #include <sys/types.h>
 
+#include <fairmq/shmem/SegregatedSlabAlgorithm.h>
 #include <fairmq/tools/Strings.h>
 
 namespace fair::mq::shmem
@@ -44,6 +45,9 @@ using RBTreeBestFitSegment = boost::interprocess::basic_managed_shared_memory<ch
     boost::interprocess::rbtree_best_fit<boost::interprocess::mutex_family, boost::interprocess::offset_ptr<void>>,
     boost::interprocess::null_index>;
     // boost::interprocess::iset_index>;
+using SegregatedSlabSegment = boost::interprocess::basic_managed_shared_memory<char,
+    SegregatedSlabAlgorithm<boost::interprocess::mutex_family, boost::interprocess::offset_ptr<void>>,
+    boost::interprocess::null_index>;
 
 inline std::string MakeShmName(const std::string& shmId, const std::string& type) {
     return std::string("fmq_" + shmId + "_" + type);
@@ -61,6 +65,7 @@ struct RefCount
 
     uint16_t Get() { return count.load(); }
     uint16_t Increment() { return count.fetch_add(1); }
+    uint16_t Increment(uint16_t n) { return count.fetch_add(n); }
     uint16_t Decrement() { return count.fetch_sub(1); }
 
     std::atomic<uint16_t> count;
@@ -127,6 +132,7 @@ struct ShmHeader
 
     static uint16_t RefCount(char* ptr) { return RefCountPtr(ptr).load(); }
     static uint16_t IncrementRefCount(char* ptr) { return RefCountPtr(ptr).fetch_add(1); }
+    static uint16_t IncrementRefCount(char* ptr, uint16_t n) { return RefCountPtr(ptr).fetch_add(n); }
     static uint16_t DecrementRefCount(char* ptr) { return RefCountPtr(ptr).fetch_sub(1); }
 
     static size_t FullSize(size_t size, size_t alignment)
@@ -169,7 +175,8 @@ struct MetaHeader
 enum class AllocationAlgorithm : int
 {
     rbtree_best_fit,
-    simple_seq_fit
+    simple_seq_fit,
+    segregated_slab
 };
 
 struct RegionInfo
@@ -255,6 +262,27 @@ struct RegionCounter
     std::atomic<uint16_t> fCount;
 };
 
+// counters of the per-thread allocation caches (shm-alloc-cache), summed over all users of a managed segment
+struct AllocCacheStats
+{
+    AllocCacheStats()
+        : fHits(0)
+        , fMisses(0)
+        , fRefills(0)
+        , fFlushes(0)
+        , fCachedBytes(0)
+    {}
+
+    std::atomic<uint64_t> fHits; // allocations served from a thread cache
+    std::atomic<uint64_t> fMisses; // allocations that found the thread cache empty
+    std::atomic<uint64_t> fRefills; // batch allocations from the segment
+    std::atomic<uint64_t> fFlushes; // batch deallocations to the segment
+    std::atomic<int64_t> fCachedBytes; // bytes currently held in thread caches
+};
+
+using Uint16AllocCacheStatsPairAlloc = boost::interprocess::allocator<std::pair<const uint16_t, AllocCacheStats>, SegmentManager>;
+using Uint16AllocCacheStatsHashMap = boost::unordered_map<uint16_t, AllocCacheStats, boost::hash<uint16_t>, std::equal_to<uint16_t>, Uint16AllocCacheStatsPairAlloc>;
+
 #ifdef FAIRMQ_DEBUG_MODE
 struct MsgCounter
 {
@@ -0,0 +1,67 @@
+/********************************************************************************
+ * Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH       *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+#ifndef FAIR_MQ_SHMEM_FUTEX_H_
+#define FAIR_MQ_SHMEM_FUTEX_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits> // INT_MAX
+#include <ctime>
+#endif
+
+// Blocking primitives for 32 bit words placed in shared memory (used by the rings in the management/region segments).
+// The futexes are not FUTEX_PRIVATE_FLAG, the words are shared between processes.
+
+namespace fair::mq::shmem
+{
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain 32 bit integer");
+
+inline void CpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+/// sleeps while word == expected, for at most timeoutNs (negative: no timeout). May return spuriously.
+inline void FutexWait(std::atomic<uint32_t>& word, uint32_t expected, int64_t timeoutNs)
+{
+#ifdef __linux__
+    timespec ts{ static_cast<time_t>(timeoutNs / 1000000000), static_cast<long>(timeoutNs % 1000000000) };
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, timeoutNs < 0 ? nullptr : &ts, nullptr, 0); // NOLINT
+#else
+    auto until = std::chrono::steady_clock::now() + std::chrono::nanoseconds(timeoutNs < 0 ? INT64_MAX / 2 : timeoutNs);
+    while (word.load() == expected && std::chrono::steady_clock::now() < until) {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+#endif
+}
+
+/// wakes all waiters of word
+inline void FutexWake(std::atomic<uint32_t>& word)
+{
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0); // NOLINT
+#else
+    (void)word;
+#endif
+}
+
+} // namespace fair::mq::shmem
+
+#endif /* FAIR_MQ_SHMEM_FUTEX_H_ */
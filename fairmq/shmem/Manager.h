@@ -10,16 +10,17 @@
 #define FAIR_MQ_SHMEM_MANAGER_H_
 
 #include "Common.h"
+#include "MetaRing.h"
 #include "Monitor.h"
 #include "UnmanagedRegion.h"
 #include <fairmq/Message.h>
+#include <fairmq/Probes.h>
 #include <fairmq/ProgOptions.h>
 #include <fairmq/tools/Strings.h>
 #include <fairmq/Transports.h>
 
 #include <fairlogger/Logger.h>
 
-#include <boost/interprocess/ipc/message_queue.hpp>
 #include <boost/interprocess/managed_shared_memory.hpp>
 #include <boost/interprocess/sync/interprocess_condition.hpp>
 #include <boost/interprocess/sync/interprocess_mutex.hpp>
@@ -79,6 +80,17 @@ class Manager
         , fBadAllocAttemptIntervalInMs(config ? config->GetProperty<int>("bad-alloc-attempt-interval", 50) : 50)
         , fNoCleanup(config ? config->GetProperty<bool>("shm-no-cleanup", false) : false)
         , fMetadataMsgSize(config ? config->GetProperty<std::size_t>("shm-metadata-msg-size", 0) : 0)
+        , fInstanceId(++fInstanceCounter)
+        , fAllocCacheEnabled(config ? config->GetProperty<bool>("shm-alloc-cache", false) : false)
+        , fAllocCacheMaxSize(config ? config->GetProperty<std::size_t>("shm-alloc-cache-max-size", 65536) : 65536)
+        , fAllocCacheCapacity(config ? config->GetProperty<std::size_t>("shm-alloc-cache-capacity", 64) : 64)
+        , fAllocCacheBatch(std::max<std::size_t>(1, fAllocCacheCapacity / 4))
+        , fAllocCacheNumClasses(0)
+        , fAllocCacheStats(nullptr)
+        , fMetaRingEnabled(config ? config->GetProperty<bool>("shm-ring", false) : false)
+        , fMetaRingCapacity(config ? config->GetProperty<std::size_t>("shm-ring-capacity", 1024) : 1024)
+        , fMetaRingSpin(config ? config->GetProperty<unsigned int>("shm-ring-spin", 4000) : 4000)
+        , fBlockingPub(false)
     {
         using namespace boost::interprocess;
 
@@ -96,6 +108,31 @@ class Manager
             // otherwise leave fBadAllocMaxAttempts at 1 (the original default, set in the initializer list)
         }
 
+        if (config) {
+            const std::string pubPolicy = config->GetProperty<std::string>("shm-pub-policy", "drop");
+            if (pubPolicy == "block") {
+                fBlockingPub = true;
+            } else if (pubPolicy != "drop") {
+                LOG(warn) << "Unknown shm-pub-policy '" << pubPolicy << "', using 'drop'.";
+            }
+        }
+
+        if (fAllocCacheEnabled) {
+            while (fAllocCacheNumClasses < 64 && AllocCacheClassSize(fAllocCacheNumClasses) <= fAllocCacheMaxSize) {
+                ++fAllocCacheNumClasses;
+            }
+            if (fAllocCacheNumClasses == 0 || fAllocCacheCapacity == 0) {
+                LOG(warn) << "shm-alloc-cache-max-size (" << fAllocCacheMaxSize << ") is below the smallest size class (" << kAllocCacheMinChunkSize
+                          << ") or shm-alloc-cache-capacity is 0, disabling the allocation cache.";
+                fAllocCacheEnabled = false;
+            } else {
+                // sizes between the largest class and a max size that is not a power of two are not cached
+                fAllocCacheMaxSize = AllocCacheClassSize(fAllocCacheNumClasses - 1);
+                LOG(debug) << "Per-thread allocation cache enabled: " << fAllocCacheNumClasses << " size classes up to " << AllocCacheClassSize(fAllocCacheNumClasses - 1)
+                           << " bytes, " << fAllocCacheCapacity << " chunks per class, refill batch: " << fAllocCacheBatch;
+            }
+        }
+
         bool mlockSegment = false;
         bool mlockSegmentOnCreation = false;
         bool zeroSegment = false;
@@ -168,6 +205,9 @@ class Manager
                     } else if (allocationAlgorithm == "simple_seq_fit") {
                         fSegments.emplace(fSegmentId, SimpleSeqFitSegment(open_or_create, segmentName.c_str(), size));
                         fShmSegments->emplace(fSegmentId, AllocationAlgorithm::simple_seq_fit);
+                    } else if (allocationAlgorithm == "segregated_slab") {
+                        fSegments.emplace(fSegmentId, SegregatedSlabSegment(open_or_create, segmentName.c_str(), size));
+                        fShmSegments->emplace(fSegmentId, AllocationAlgorithm::segregated_slab);
                     }
                     if (mlockSegmentOnCreation) {
                         MlockSegment(fSegmentId);
@@ -184,6 +224,12 @@ class Manager
                             LOG(warn) << "Allocation algorithm of the opened segment is rbtree_best_fit, but requested is " << allocationAlgorithm << ". Ignoring requested setting.";
                             allocationAlgorithm = "rbtree_best_fit";
                         }
+                    } else if (it->second.fAllocationAlgorithm == AllocationAlgorithm::segregated_slab) {
+                        fSegments.emplace(fSegmentId, SegregatedSlabSegment(open_or_create, segmentName.c_str(), size));
+                        if (allocationAlgorithm != "segregated_slab") {
+                            LOG(warn) << "Allocation algorithm of the opened segment is segregated_slab, but requested is " << allocationAlgorithm << ". Ignoring requested setting.";
+                            allocationAlgorithm = "segregated_slab";
+                        }
                     } else {
                         fSegments.emplace(fSegmentId, SimpleSeqFitSegment(open_or_create, segmentName.c_str(), size));
                         if (allocationAlgorithm != "simple_seq_fit") {
@@ -196,6 +242,7 @@ class Manager
                     << ". Size: " << std::visit([](auto& s) { return s.get_size(); }, fSegments.at(fSegmentId)) << " bytes."
                     << " Available: " << std::visit([](auto& s) { return s.get_free_memory(); }, fSegments.at(fSegmentId)) << " bytes."
                     << " Allocation algorithm: " << allocationAlgorithm;
+                fOwnSegment = &fSegments.at(fSegmentId); // elements of the map are not moved, the segment stays while the manager exists
             } catch (interprocess_exception& bie) {
                 LOG(error) << "Failed to create/open shared memory segment '" << "fmq_" << fShmId << "_m_" << fSegmentId << "': " << bie.what();
                 throw TransportError(tools::ToString("Failed to create/open shared memory segment '", "fmq_", fShmId, "_m_", fSegmentId, "': ", bie.what()));
@@ -212,6 +259,11 @@ class Manager
                 (fEventCounter->fCount)++;
             }
 
+            if (fAllocCacheEnabled) {
+                // boost::unordered_map nodes are stable, the entry can be updated without holding the lock
+                fAllocCacheStats = &((*fManagementSegment.find_or_construct<Uint16AllocCacheStatsHashMap>(unique_instance)(fShmVoidAlloc))[fSegmentId]);
+            }
+
 #ifdef FAIRMQ_DEBUG_MODE
             fMsgDebug = fManagementSegment.find_or_construct<Uint16MsgDebugMapHashMap>(unique_instance)(fShmVoidAlloc);
             fShmMsgCounters = fManagementSegment.find_or_construct<Uint16MsgCounterHashMap>(unique_instance)(fShmVoidAlloc);
@@ -284,6 +336,7 @@ class Manager
     void Resume() { fInterrupted.store(false); }
     void Reset()
     {
+        DrainAllocCaches(false);
 #ifdef FAIRMQ_DEBUG_MODE
         auto diff = fMsgCounterNew.load() - fMsgCounterDelete.load();
         if (diff != 0) {
@@ -372,6 +425,7 @@ class Manager
 
     UnmanagedRegion* GetRegionFromCache(uint16_t id)
     {
+        FAIRMQ_PROBE_SCOPE(region_lookup, id);
         // NOTE: gcc optimizations. Prevent loading tls addresses many times in the fast path
         const auto &lTlCache = fTlRegionCache;
         const auto &lTlCacheVec = lTlCache.fRegionsTLCache;
@@ -385,6 +439,7 @@ class Manager
         }
 
         // slow path: check invalidation
+        FAIRMQ_PROBE(region_cache_miss, id);
         if (lTlCacheGen != fRegionsGen) {
             fTlRegionCache.fRegionsTLCache.clear();
         }
@@ -648,6 +703,8 @@ class Manager
 
                 if (segmentInfo.fAllocationAlgorithm == AllocationAlgorithm::rbtree_best_fit) {
                     fSegments.emplace(id, RBTreeBestFitSegment(open_only, MakeShmName(fShmId, "m", id).c_str()));
+                } else if (segmentInfo.fAllocationAlgorithm == AllocationAlgorithm::segregated_slab) {
+                    fSegments.emplace(id, SegregatedSlabSegment(open_only, MakeShmName(fShmId, "m", id).c_str()));
                 } else {
                     fSegments.emplace(id, SimpleSeqFitSegment(open_only, MakeShmName(fShmId, "m", id).c_str()));
                 }
@@ -670,12 +727,21 @@ class Manager
 
     char* Allocate(size_t size, size_t alignment = 0)
     {
+        FAIRMQ_PROBE_SCOPE(alloc, size);
         alignment = std::max(alignment, alignof(std::max_align_t));
 
         char* ptr = nullptr;
         int numAttempts = 0;
         size_t fullSize = ShmHeader::FullSize(size, alignment);
 
+        if (fAllocCacheEnabled && fullSize <= fAllocCacheMaxSize) {
+            // nullptr if the cache could not be refilled, the regular path below then retries/throws as configured
+            ptr = AllocateFromCache(fullSize);
+            if (ptr) {
+                ShmHeader::Construct(ptr, alignment);
+            }
+        }
+
         while (!ptr) {
             try {
                 size_t segmentSize = std::visit([](auto& s) { return s.get_size(); }, fSegments.at(fSegmentId));
@@ -692,6 +758,8 @@ class Manager
                         ", alignment: ", (alignment != 0) ? std::to_string(alignment) : "default",
                         ", free memory: ", std::visit([](auto& s) { return s.get_free_memory(); }, fSegments.at(fSegmentId))));
                 }
+                ++fNumBadAllocRetries;
+                FAIRMQ_PROBE(bad_alloc_retry, numAttempts);
                 if (numAttempts == 1 && fBadAllocMaxAttempts > 1) {
                     LOG(warn) << tools::ToString("shmem: could not create a message of size ", size,
                         ", alignment: ", (alignment != 0) ? std::to_string(alignment) : "default",
@@ -708,18 +776,18 @@ class Manager
                     continue;
                 }
             }
+        }
 #ifdef FAIRMQ_DEBUG_MODE
-            boost::interprocess::scoped_lock<boost::interprocess::interprocess_mutex> lock(*fShmMtx);
-            IncrementShmMsgCounter(fSegmentId);
-            if (fMsgDebug->count(fSegmentId) == 0) {
-                fMsgDebug->emplace(fSegmentId, fShmVoidAlloc);
-            }
-            fMsgDebug->at(fSegmentId).emplace(
-                static_cast<size_t>(GetHandleFromAddress(ShmHeader::UserPtr(ptr), fSegmentId)),
-                MsgDebug(getpid(), size, std::chrono::system_clock::now().time_since_epoch().count())
-            );
-#endif
+        boost::interprocess::scoped_lock<boost::interprocess::interprocess_mutex> lock(*fShmMtx);
+        IncrementShmMsgCounter(fSegmentId);
+        if (fMsgDebug->count(fSegmentId) == 0) {
+            fMsgDebug->emplace(fSegmentId, fShmVoidAlloc);
         }
+        fMsgDebug->at(fSegmentId).emplace(
+            static_cast<size_t>(GetHandleFromAddress(ShmHeader::UserPtr(ptr), fSegmentId)),
+            MsgDebug(getpid(), size, std::chrono::system_clock::now().time_since_epoch().count())
+        );
+#endif
 
         return ptr;
     }
@@ -737,6 +805,9 @@ class Manager
         }
 #endif
         ShmHeader::Destruct(ptr);
+        if (fAllocCacheEnabled && segmentId == fSegmentId && DeallocateToCache(ptr)) {
+            return;
+        }
         std::visit([ptr](auto& s) { s.deallocate(ptr); }, fSegments.at(segmentId));
     }
 
@@ -746,6 +817,11 @@ class Manager
     }
 
     uint16_t GetSegmentId() const { return fSegmentId; }
+    /// size and free memory of the segment for new messages, can be called from any thread
+    std::size_t GetSegmentSize() const { return std::visit([](auto& s) { return s.get_size(); }, *fOwnSegment); }
+    std::size_t GetSegmentFreeMemory() const { return std::visit([](auto& s) { return s.get_free_memory(); }, *fOwnSegment); }
+    /// number of failed allocations that have been retried (see bad-alloc-max-attempts)
+    uint64_t GetNumBadAllocRetries() const { return fNumBadAllocRetries; }
 
     void CleanupIfLast()
     {
@@ -776,9 +852,48 @@ class Manager
 
     auto GetMetadataMsgSize() const noexcept { return fMetadataMsgSize; }
 
+    bool MetaRingEnabled() const noexcept { return fMetaRingEnabled; }
+    unsigned int GetMetaRingSpin() const noexcept { return fMetaRingSpin; }
+    bool BlockingPub() const noexcept { return fBlockingPub; }
+
+    /// Finds or creates the metadata ring with the given name in the management segment
+    MetaRing* AttachMetaRing(const std::string& name)
+    {
+        using namespace boost::interprocess;
+        scoped_lock<interprocess_mutex> lock(*fShmMtx);
+
+        MetaRing* ring = fManagementSegment.find<MetaRing>(name.c_str()).first;
+        if (!ring) {
+            const uint32_t capacity = MetaRing::RoundCapacity(static_cast<uint32_t>(std::min<std::size_t>(fMetaRingCapacity, 1U << 30)));
+            auto slots = static_cast<MetaRing::Slot*>(fManagementSegment.allocate(capacity * sizeof(MetaRing::Slot)));
+            ring = fManagementSegment.construct<MetaRing>(name.c_str())(slots, capacity);
+            LOG(debug) << "Created metadata ring '" << name << "' with capacity " << capacity;
+        }
+        ++(ring->NumAttached());
+        return ring;
+    }
+
+    /// Detaches from the metadata ring, destroying it if this was the last user.
+    /// Returns the metadata of the messages that were still queued in a destroyed ring.
+    std::vector<MetaHeader> DetachMetaRing(const std::string& name, MetaRing* ring)
+    {
+        using namespace boost::interprocess;
+        std::vector<MetaHeader> undelivered;
+        scoped_lock<interprocess_mutex> lock(*fShmMtx);
+
+        if (--(ring->NumAttached()) == 0) {
+            while (ring->TryPop([&](const MetaHeader& meta) { undelivered.push_back(meta); }) > 0) {}
+            fManagementSegment.deallocate(ring->Slots());
+            fManagementSegment.destroy<MetaRing>(name.c_str());
+            LOG(debug) << "Destroyed metadata ring '" << name << "'";
+        }
+        return undelivered;
+    }
+
     ~Manager()
     {
         fRegionsGen += 1; // signal TL cache invalidation
+        DrainAllocCaches(true);
         UnsubscribeFromRegionEvents();
 
         StopHeartbeats();
@@ -787,10 +902,201 @@ class Manager
     }
 
   private:
+    // Per-thread cache of managed segment chunks, grouped in power-of-two size classes.
+    // Chunks are taken from the segment in batches and returned on overflow, Reset() and destruction.
+    struct AllocationCache
+    {
+        explicit AllocationCache(size_t numClasses)
+            : fChunks(numClasses)
+        {}
+
+        std::mutex fMtx; // taken by the owning thread, contended only when the Manager drains the cache
+        std::vector<std::vector<char*>> fChunks; // free chunks per size class
+        int64_t fCachedBytes = 0;
+        int64_t fPublishedCachedBytes = 0;
+        uint64_t fHits = 0; // not yet published to the shared AllocCacheStats
+        uint64_t fMisses = 0;
+        uint64_t fRefills = 0;
+        uint64_t fFlushes = 0;
+        unsigned int fOpsSincePublish = 0;
+        std::atomic<bool> fClosed = false; // owning Manager is gone
+    };
+
+    static constexpr size_t kAllocCacheMinChunkSize = 64;
+    static constexpr unsigned int kAllocCachePublishInterval = 1024;
+
+    static size_t AllocCacheClassSize(size_t sizeClass) { return kAllocCacheMinChunkSize << sizeClass; }
+
+    AllocationCache& GetAllocCache()
+    {
+        auto& tlCache = fTlAllocCache;
+        if (tlCache.fLastManagerId == fInstanceId) {
+            return *tlCache.fLast;
+        }
+
+        auto it = tlCache.fCaches.find(fInstanceId);
+        if (it == tlCache.fCaches.end()) {
+            // forget the caches of destroyed managers, they have been drained already
+            for (auto c = tlCache.fCaches.begin(); c != tlCache.fCaches.end();) {
+                c = c->second->fClosed ? tlCache.fCaches.erase(c) : std::next(c);
+            }
+            auto cache = std::make_shared<AllocationCache>(fAllocCacheNumClasses);
+            {
+                std::lock_guard<std::mutex> lock(fAllocCachesMtx);
+                fAllocCaches.push_back(cache);
+            }
+            it = tlCache.fCaches.emplace(fInstanceId, std::move(cache)).first;
+        }
+        tlCache.fLastManagerId = fInstanceId;
+        tlCache.fLast = it->second.get();
+        return *tlCache.fLast;
+    }
+
+    char* AllocateFromCache(size_t fullSize)
+    {
+        size_t sizeClass = 0;
+        while (AllocCacheClassSize(sizeClass) < fullSize) {
+            ++sizeClass;
+        }
+
+        AllocationCache& cache = GetAllocCache();
+        std::lock_guard<std::mutex> lock(cache.fMtx);
+        auto& chunks = cache.fChunks[sizeClass];
+
+        if (chunks.empty()) {
+            ++cache.fMisses;
+            RefillAllocCache(cache, sizeClass);
+            if (chunks.empty()) {
+                return nullptr;
+            }
+        } else {
+            ++cache.fHits;
+            if (++cache.fOpsSincePublish >= kAllocCachePublishInterval) {
+                PublishAllocCacheStats(cache);
+            }
+        }
+
+        char* ptr = chunks.back();
+        chunks.pop_back();
+        cache.fCachedBytes -= AllocCacheClassSize(sizeClass);
+        return ptr;
+    }
+
+    bool DeallocateToCache(char* ptr)
+    {
+        // the real chunk size determines the class, so buffers allocated by other processes or shrunk in place are handled too
+        const size_t chunkSize = std::visit([ptr](auto& s) { return s.get_segment_manager()->size(ptr); }, fSegments.at(fSegmentId));
+        if (chunkSize < kAllocCacheMinChunkSize) {
+            return false;
+        }
+        size_t sizeClass = 0;
+        while (sizeClass + 1 < fAllocCacheNumClasses && AllocCacheClassSize(sizeClass + 1) <= chunkSize) {
+            ++sizeClass;
+        }
+        // do not cache chunks that would waste more than a quarter of their size in the class
+        if (chunkSize - AllocCacheClassSize(sizeClass) > AllocCacheClassSize(sizeClass) / 4) {
+            return false;
+        }
+
+        AllocationCache& cache = GetAllocCache();
+        std::lock_guard<std::mutex> lock(cache.fMtx);
+        auto& chunks = cache.fChunks[sizeClass];
+
+        if (chunks.size() >= fAllocCacheCapacity) {
+            FlushAllocCache(cache, sizeClass, fAllocCacheBatch);
+        }
+        chunks.push_back(ptr);
+        cache.fCachedBytes += AllocCacheClassSize(sizeClass);
+        return true;
+    }
+
+    // expects cache.fMtx to be held
+    void RefillAllocCache(AllocationCache& cache, size_t sizeClass)
+    {
+        auto& chunks = cache.fChunks[sizeClass];
+        const size_t classSize = AllocCacheClassSize(sizeClass);
+        std::visit([&](auto& s) {
+            typename std::decay_t<decltype(s)>::multiallocation_chain chain;
+            // single pass over the segment mutex for the whole batch; leaves the chain empty on failure
+            s.allocate_many(std::nothrow, classSize, fAllocCacheBatch, chain);
+            while (!chain.empty()) {
+                chunks.push_back(static_cast<char*>(boost::interprocess::ipcdetail::to_raw_pointer(chain.pop_front())));
+            }
+        }, fSegments.at(fSegmentId));
+
+        if (!chunks.empty()) {
+            cache.fCachedBytes += chunks.size() * classSize;
+            ++cache.fRefills;
+        }
+        PublishAllocCacheStats(cache);
+    }
+
+    // expects cache.fMtx to be held
+    void FlushAllocCache(AllocationCache& cache, size_t sizeClass, size_t num)
+    {
+        auto& chunks = cache.fChunks[sizeClass];
+        num = std::min(num, chunks.size());
+        if (num == 0) {
+            return;
+        }
+        std::visit([&](auto& s) {
+            typename std::decay_t<decltype(s)>::multiallocation_chain chain;
+            for (auto it = chunks.end() - num; it != chunks.end(); ++it) {
+                chain.push_back(*it);
+            }
+            s.deallocate_many(chain);
+        }, fSegments.at(fSegmentId));
+        chunks.resize(chunks.size() - num);
+
+        cache.fCachedBytes -= num * AllocCacheClassSize(sizeClass);
+        ++cache.fFlushes;
+        PublishAllocCacheStats(cache);
+    }
+
+    // expects cache.fMtx to be held
+    void PublishAllocCacheStats(AllocationCache& cache)
+    {
+        fAllocCacheStats->fHits.fetch_add(cache.fHits, std::memory_order_relaxed);
+        fAllocCacheStats->fMisses.fetch_add(cache.fMisses, std::memory_order_relaxed);
+        fAllocCacheStats->fRefills.fetch_add(cache.fRefills, std::memory_order_relaxed);
+        fAllocCacheStats->fFlushes.fetch_add(cache.fFlushes, std::memory_order_relaxed);
+        fAllocCacheStats->fCachedBytes.fetch_add(cache.fCachedBytes - cache.fPublishedCachedBytes, std::memory_order_relaxed);
+        cache.fHits = 0;
+        cache.fMisses = 0;
+        cache.fRefills = 0;
+        cache.fFlushes = 0;
+        cache.fPublishedCachedBytes = cache.fCachedBytes;
+        cache.fOpsSincePublish = 0;
+    }
+
+    /// Returns the chunks of all thread caches to the segment. If close is true, the caches are not used afterwards.
+    void DrainAllocCaches(bool close)
+    {
+        if (!fAllocCacheEnabled) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(fAllocCachesMtx);
+        for (auto& cache : fAllocCaches) {
+            std::lock_guard<std::mutex> cacheLock(cache->fMtx);
+            for (size_t sizeClass = 0; sizeClass < cache->fChunks.size(); ++sizeClass) {
+                FlushAllocCache(*cache, sizeClass, cache->fChunks[sizeClass].size());
+            }
+            PublishAllocCacheStats(*cache);
+            if (close) {
+                cache->fClosed = true;
+            }
+        }
+        if (close) {
+            fAllocCaches.clear();
+            fTlAllocCache.fLastManagerId = 0;
+            fTlAllocCache.fLast = nullptr;
+        }
+    }
+
     uint64_t fShmId64;
     std::string fShmId;
     uint16_t fSegmentId;
-    std::unordered_map<uint16_t, std::variant<RBTreeBestFitSegment, SimpleSeqFitSegment>> fSegments; // TODO: refactor to use Segment class
+    std::unordered_map<uint16_t, std::variant<RBTreeBestFitSegment, SimpleSeqFitSegment, SegregatedSlabSegment>> fSegments; // TODO: refactor to use Segment class
     boost::interprocess::managed_shared_memory fManagementSegment; // TODO: refactor to use ManagementSegment class
     VoidAlloc fShmVoidAlloc;
     boost::interprocess::interprocess_mutex* fShmMtx;
@@ -831,9 +1137,32 @@ class Manager
 
     int fBadAllocMaxAttempts;
     int fBadAllocAttemptIntervalInMs;
+    std::atomic<uint64_t> fNumBadAllocRetries{0};
+    const decltype(fSegments)::mapped_type* fOwnSegment = nullptr;
     bool fNoCleanup;
 
     std::size_t fMetadataMsgSize;
+
+    inline static std::atomic<uint64_t> fInstanceCounter = 0;
+    const uint64_t fInstanceId; // distinguishes Managers in the thread local allocation caches
+    bool fAllocCacheEnabled;
+    std::size_t fAllocCacheMaxSize;
+    std::size_t fAllocCacheCapacity;
+    std::size_t fAllocCacheBatch;
+    std::size_t fAllocCacheNumClasses;
+    AllocCacheStats* fAllocCacheStats;
+    std::mutex fAllocCachesMtx;
+    std::vector<std::shared_ptr<AllocationCache>> fAllocCaches; // caches of all threads that used this Manager
+    inline static thread_local struct ManagerTLAllocCache {
+        uint64_t fLastManagerId;
+        AllocationCache* fLast;
+        std::unordered_map<uint64_t, std::shared_ptr<AllocationCache>> fCaches; // key: Manager instance id
+    } fTlAllocCache;
+
+    bool fMetaRingEnabled;
+    std::size_t fMetaRingCapacity;
+    unsigned int fMetaRingSpin;
+    bool fBlockingPub;
 };
 
 } // namespace fair::mq::shmem
@@ -13,8 +13,10 @@
 #include "UnmanagedRegion.h"
 #include "UnmanagedRegionImpl.h"
 #include <fairmq/Message.h>
+#include <fairmq/Probes.h>
 #include <fairmq/UnmanagedRegion.h>
 #include <fairmq/Transports.h>
+#include <fairmq/tools/ObjectPool.h>
 
 #include <fairlogger/Logger.h>
 
@@ -275,39 +277,8 @@ class Message final : public fair::mq::Message
         }
 
         // increment ref count
-        if (otherMsg.fManaged) { // msg in managed segment
-            fManager.GetSegment(otherMsg.fSegmentId);
-            ShmHeader::IncrementRefCount(fManager.GetAddressFromHandle(otherMsg.fHandle, otherMsg.fSegmentId));
-        } else { // msg in unmanaged region
-            fRegionPtr = fManager.GetRegionFromCache(otherMsg.fRegionId);
-            if (!fRegionPtr) {
-                throw TransportError(tools::ToString("Cannot get unmanaged region with id ", otherMsg.fRegionId));
-            }
-            if (fRegionPtr->fRcSegmentSize > 0) {
-                if (otherMsg.fShared < 0) {
-                    // UR msg not yet shared, create the reference counting object with count 2
-                    try {
-                        otherMsg.fShared = fRegionPtr->HandleFromAddress(&(fRegionPtr->MakeRefCount(2)));
-                    } catch (boost::interprocess::bad_alloc& ba) {
-                        throw RefCountBadAlloc(tools::ToString("Insufficient space in the reference count segment ", otherMsg.fRegionId, ", original exception: bad_alloc: ", ba.what()));
-                    }
-                } else {
-                    fRegionPtr->GetRefCountAddressFromHandle(otherMsg.fShared)->Increment();
-                }
-            } else { // if RefCount segment size is 0, store the ref count in the managed segment
-                if (otherMsg.fShared < 0) { // if UR msg is not yet shared
-                    char* ptr = fManager.Allocate(2, 0);
-                    // point the fShared in the unmanaged region message to the refCount holder
-                    otherMsg.fShared = fManager.GetHandleFromAddress(ptr, fSegmentId);
-                    // the message needs to be able to locate in which segment the refCount is stored
-                    otherMsg.fSegmentId = fSegmentId;
-                    ShmHeader::IncrementRefCount(ptr);
-                } else { // if the UR msg is already shared
-                    fManager.GetSegment(otherMsg.fSegmentId);
-                    ShmHeader::IncrementRefCount(fManager.GetAddressFromHandle(otherMsg.fShared, otherMsg.fSegmentId));
-                }
-            }
-        }
+        otherMsg.AddReferences(1);
+        fRegionPtr = otherMsg.fRegionPtr;
 
         // copy meta data
         fSize = otherMsg.fSize;
@@ -321,6 +292,10 @@ class Message final : public fair::mq::Message
 
     ~Message() override { CloseMessage(); }
 
+    // message objects are recycled via per-thread free lists instead of the heap
+    static void* operator new(size_t size) { return tools::ObjectPool<Message>::Allocate(size); }
+    static void operator delete(void* ptr, size_t size) { tools::ObjectPool<Message>::Deallocate(ptr, size); }
+
   private:
     Manager& fManager;
     mutable UnmanagedRegion* fRegionPtr = nullptr;
@@ -345,6 +320,54 @@ class Message final : public fair::mq::Message
         fManaged = meta.fManaged;
     }
 
+    /// takes n additional references to the buffer at once (a single atomic increment)
+    void AddReferences(uint16_t n) const
+    {
+        FAIRMQ_PROBE(refcount_inc, n);
+        if (fManaged) { // msg in managed segment
+            fManager.GetSegment(fSegmentId);
+            ShmHeader::IncrementRefCount(fManager.GetAddressFromHandle(fHandle, fSegmentId), n);
+        } else { // msg in unmanaged region
+            fRegionPtr = fManager.GetRegionFromCache(fRegionId);
+            if (!fRegionPtr) {
+                throw TransportError(tools::ToString("Cannot get unmanaged region with id ", fRegionId));
+            }
+            if (fRegionPtr->fRcSegmentSize > 0) {
+                if (fShared < 0) {
+                    // UR msg not yet shared, create the reference counting object
+                    try {
+                        fShared = fRegionPtr->HandleFromAddress(&(fRegionPtr->MakeRefCount(1 + n)));
+                    } catch (boost::interprocess::bad_alloc& ba) {
+                        throw RefCountBadAlloc(tools::ToString("Insufficient space in the reference count segment ", fRegionId, ", original exception: bad_alloc: ", ba.what()));
+                    }
+                } else {
+                    fRegionPtr->GetRefCountAddressFromHandle(fShared)->Increment(n);
+                }
+            } else { // if RefCount segment size is 0, store the ref count in the managed segment
+                if (fShared < 0) { // if UR msg is not yet shared
+                    char* ptr = fManager.Allocate(2, 0);
+                    // point the fShared in the unmanaged region message to the refCount holder
+                    fShared = fManager.GetHandleFromAddress(ptr, fManager.GetSegmentId());
+                    // the message needs to be able to locate in which segment the refCount is stored
+                    fSegmentId = fManager.GetSegmentId();
+                    ShmHeader::IncrementRefCount(ptr, n);
+                } else { // if the UR msg is already shared
+                    fManager.GetSegment(fSegmentId);
+                    ShmHeader::IncrementRefCount(fManager.GetAddressFromHandle(fShared, fSegmentId), n);
+                }
+            }
+        }
+    }
+
+    /// takes n additional references to the buffer, which are owned by the receivers of the returned metadata
+    MetaHeader Share(uint16_t n = 1) const
+    {
+        if (fHandle >= 0 && n > 0) {
+            AddReferences(n);
+        }
+        return MetaHeader{ fSize, fHint, fHandle, fShared, fRegionId, fSegmentId, fManaged };
+    }
+
     char* InitializeChunk(const size_t size, size_t alignment = 0)
     {
         if (size == 0) {
@@ -360,10 +383,12 @@ class Message final : public fair::mq::Message
 
     void Deallocate()
     {
+        FAIRMQ_PROBE_SCOPE(dealloc, fSize);
         if (fHandle >= 0 && !fQueued) {
             if (fManaged) { // managed segment
                 fManager.GetSegment(fSegmentId);
                 uint16_t refCount = ShmHeader::DecrementRefCount(fManager.GetAddressFromHandle(fHandle, fSegmentId));
+                FAIRMQ_PROBE(refcount_dec, refCount);
                 if (refCount == 1) {
                     fManager.Deallocate(fHandle, fSegmentId);
                 }
@@ -375,6 +400,7 @@ class Message final : public fair::mq::Message
                     }
                     if (fRegionPtr->fRcSegmentSize > 0) {
                         uint16_t refCount = fRegionPtr->GetRefCountAddressFromHandle(fShared)->Decrement();
+                        FAIRMQ_PROBE(refcount_dec, refCount);
                         if (refCount == 1) {
                             fRegionPtr->RemoveRefCount(*(fRegionPtr->GetRefCountAddressFromHandle(fShared)));
                             ReleaseUnmanagedRegionBlock();
@@ -384,6 +410,7 @@ class Message final : public fair::mq::Message
                         fManager.GetSegment(fSegmentId);
                         // release unmanaged region block if ref count is one
                         uint16_t refCount = ShmHeader::DecrementRefCount(fManager.GetAddressFromHandle(fShared, fSegmentId));
+                        FAIRMQ_PROBE(refcount_dec, refCount);
                         if (refCount == 1) {
                             fManager.Deallocate(fShared, fSegmentId);
                             ReleaseUnmanagedRegionBlock();
@@ -0,0 +1,240 @@
+/********************************************************************************
+ * Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH       *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+#ifndef FAIR_MQ_SHMEM_METARING_H_
+#define FAIR_MQ_SHMEM_METARING_H_
+
+#include "Common.h"
+#include "Futex.h"
+
+#include <boost/interprocess/offset_ptr.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <new> // placement new
+
+namespace fair::mq::shmem
+{
+
+// Bounded multi-producer/multi-consumer queue of MetaHeaders, placed in the management segment and shared by the
+// sockets of one endpoint. Slots carry a sequence number (D. Vyukov's bounded MPMC queue), a multipart message
+// occupies consecutive slots and is enqueued/dequeued as a whole.
+// Waiting sides sleep on a futex word that is bumped by the other side, but only if somebody announced to wait.
+class MetaRing
+{
+  public:
+    struct Slot
+    {
+        std::atomic<uint64_t> fSeq;
+        std::atomic<uint32_t> fNumParts; // number of parts starting at this slot, 0 for continuation slots
+        MetaHeader fMeta;
+    };
+
+    MetaRing(Slot* slots, uint32_t capacity)
+        : fSlots(slots)
+        , fCapacity(capacity)
+        , fMask(capacity - 1)
+        , fPadding0()
+        , fEnqueuePos(0)
+        , fPadding1()
+        , fDequeuePos(0)
+        , fPadding2()
+        , fDataSeq(0)
+        , fDataWaiters(0)
+        , fPadding3()
+        , fSpaceSeq(0)
+        , fSpaceWaiters(0)
+        , fPadding4()
+        , fNumAttached(0)
+    {
+        for (uint32_t i = 0; i < fCapacity; ++i) {
+            Slot* slot = ::new (static_cast<void*>(&slots[i])) Slot();
+            slot->fSeq.store(i, std::memory_order_relaxed);
+            slot->fNumParts.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    MetaRing(const MetaRing&) = delete;
+    MetaRing(MetaRing&&) = delete;
+    MetaRing& operator=(const MetaRing&) = delete;
+    MetaRing& operator=(MetaRing&&) = delete;
+
+    /// rounds the requested capacity up to a power of two
+    static uint32_t RoundCapacity(uint32_t capacity)
+    {
+        uint32_t c = 2;
+        while (c < capacity && c < (1U << 30)) {
+            c <<= 1;
+        }
+        return c;
+    }
+
+    uint32_t Capacity() const { return fCapacity; }
+    Slot* Slots() const { return fSlots.get(); }
+    int& NumAttached() { return fNumAttached; }
+
+    /// enqueues all n metas, or none if there is not enough space
+    bool TryPush(const MetaHeader* metas, uint32_t n)
+    {
+        uint64_t pos = fEnqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            int64_t diff = 0;
+            for (uint32_t i = 0; i < n; ++i) {
+                diff = static_cast<int64_t>(SlotAt(pos + i).fSeq.load(std::memory_order_acquire) - (pos + i));
+                if (diff != 0) {
+                    break;
+                }
+            }
+            if (diff == 0) {
+                if (fEnqueuePos.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // full
+            } else {
+                pos = fEnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        for (uint32_t i = 0; i < n; ++i) {
+            Slot& slot = SlotAt(pos + i);
+            slot.fMeta = metas[i];
+            slot.fNumParts.store(i == 0 ? n : 0, std::memory_order_relaxed);
+        }
+        // publish the continuation slots first, the head slot makes the message visible to consumers
+        for (uint32_t i = n; i-- > 0;) {
+            SlotAt(pos + i).fSeq.store(pos + i + 1, std::memory_order_release);
+        }
+
+        Notify(fDataSeq, fDataWaiters);
+        return true;
+    }
+
+    /// dequeues one (multipart) message, calling consume(const MetaHeader&) for each of its parts.
+    /// Returns the number of parts, 0 if empty. Messages with more than maxParts parts are left in the ring and -1 is returned.
+    template<typename F>
+    int64_t TryPop(F&& consume, uint32_t maxParts = UINT32_MAX)
+    {
+        uint64_t pos = fDequeuePos.load(std::memory_order_relaxed);
+        uint32_t n = 0;
+        while (true) {
+            Slot& head = SlotAt(pos);
+            int64_t diff = static_cast<int64_t>(head.fSeq.load(std::memory_order_acquire) - (pos + 1));
+            if (diff < 0) {
+                return 0; // empty
+            } else if (diff > 0) {
+                pos = fDequeuePos.load(std::memory_order_relaxed);
+                continue;
+            }
+            n = head.fNumParts.load(std::memory_order_relaxed);
+            if (n == 0 || n > fCapacity) {
+                pos = fDequeuePos.load(std::memory_order_relaxed); // raced with another consumer
+                continue;
+            }
+            if (n > maxParts) {
+                return -1;
+            }
+            if (fDequeuePos.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+
+        // continuation slots are published before the head slot, so they are complete at this point
+        for (uint32_t i = 0; i < n; ++i) {
+            Slot& slot = SlotAt(pos + i);
+            consume(static_cast<const MetaHeader&>(slot.fMeta));
+            slot.fSeq.store(pos + i + fCapacity, std::memory_order_release);
+        }
+
+        Notify(fSpaceSeq, fSpaceWaiters);
+        return n;
+    }
+
+    bool HasData() const
+    {
+        uint64_t pos = fDequeuePos.load(std::memory_order_relaxed);
+        return SlotAt(pos).fSeq.load(std::memory_order_acquire) == pos + 1;
+    }
+
+    bool HasSpace(uint32_t n = 1) const
+    {
+        uint64_t pos = fEnqueuePos.load(std::memory_order_relaxed);
+        for (uint32_t i = 0; i < n; ++i) {
+            if (SlotAt(pos + i).fSeq.load(std::memory_order_acquire) != pos + i) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// spins up to spinCount iterations, then sleeps up to timeoutMs for data to arrive.
+    /// Returns true if the wait ended during the spin phase.
+    bool WaitForData(unsigned int spinCount, int timeoutMs)
+    {
+        return Wait([this] { return HasData(); }, fDataSeq, fDataWaiters, spinCount, timeoutMs);
+    }
+
+    /// spins up to spinCount iterations, then sleeps up to timeoutMs for space for n parts.
+    /// Returns true if the wait ended during the spin phase.
+    bool WaitForSpace(uint32_t n, unsigned int spinCount, int timeoutMs)
+    {
+        return Wait([this, n] { return HasSpace(n); }, fSpaceSeq, fSpaceWaiters, spinCount, timeoutMs);
+    }
+
+  private:
+    boost::interprocess::offset_ptr<Slot> fSlots;
+    const uint32_t fCapacity;
+    const uint64_t fMask;
+
+    // producer and consumer sides on separate cache lines (padded, the segment does not honour alignas)
+    char fPadding0[64];
+    std::atomic<uint64_t> fEnqueuePos;
+    char fPadding1[56];
+    std::atomic<uint64_t> fDequeuePos;
+    char fPadding2[56];
+    std::atomic<uint32_t> fDataSeq;
+    std::atomic<uint32_t> fDataWaiters;
+    char fPadding3[56];
+    std::atomic<uint32_t> fSpaceSeq;
+    std::atomic<uint32_t> fSpaceWaiters;
+    char fPadding4[56];
+
+    int fNumAttached; // protected by the management segment mutex
+
+    Slot& SlotAt(uint64_t pos) const { return fSlots[pos & fMask]; }
+
+    static void Notify(std::atomic<uint32_t>& seq, std::atomic<uint32_t>& waiters)
+    {
+        seq.fetch_add(1, std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_seq_cst) > 0) {
+            FutexWake(seq);
+        }
+    }
+
+    template<typename Pred>
+    static bool Wait(Pred ready, std::atomic<uint32_t>& seq, std::atomic<uint32_t>& waiters, unsigned int spinCount, int timeoutMs)
+    {
+        for (unsigned int i = 0; i < spinCount; ++i) {
+            if (ready()) {
+                return true;
+            }
+            CpuRelax();
+        }
+
+        uint32_t current = seq.load(std::memory_order_seq_cst);
+        waiters.fetch_add(1, std::memory_order_seq_cst);
+        if (!ready()) {
+            FutexWait(seq, current, timeoutMs < 0 ? -1 : timeoutMs * 1000000LL);
+        }
+        waiters.fetch_sub(1, std::memory_order_seq_cst);
+        return false;
+    }
+};
+
+} // namespace fair::mq::shmem
+
+#endif /* FAIR_MQ_SHMEM_METARING_H_ */
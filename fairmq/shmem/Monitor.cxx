@@ -22,14 +22,18 @@
 #include <boost/interprocess/sync/named_condition.hpp>
 #include <boost/interprocess/ipc/message_queue.hpp>
 
+#include <algorithm> // max, min, sort
+#include <climits> // CHAR_BIT
 #include <csignal>
 #include <cstdio>
+#include <cstring> // memcpy
 #include <iostream>
 #include <iomanip>
 #include <chrono>
 #include <ctime>
 #include <iomanip>
 #include <sstream>
+#include <type_traits>
 #include <variant>
 
 #include <poll.h>
@@ -185,7 +189,7 @@ bool Monitor::PrintShm(const ShmId& shmId)
         VoidAlloc allocInstance(managementSegment.get_segment_manager());
 
         Uint16SegmentInfoHashMap* shmSegments = managementSegment.find<Uint16SegmentInfoHashMap>(unique_instance).first;
-        std::unordered_map<uint16_t, std::variant<RBTreeBestFitSegment, SimpleSeqFitSegment>> segments;
+        std::unordered_map<uint16_t, std::variant<RBTreeBestFitSegment, SimpleSeqFitSegment, SegregatedSlabSegment>> segments;
 
         Uint16RegionInfoHashMap* shmRegions = managementSegment.find<Uint16RegionInfoHashMap>(unique_instance).first;
 
@@ -201,6 +205,8 @@ bool Monitor::PrintShm(const ShmId& shmId)
         for (const auto& s : *shmSegments) {
             if (s.second.fAllocationAlgorithm == AllocationAlgorithm::rbtree_best_fit) {
                 segments.emplace(s.first, RBTreeBestFitSegment(open_read_only, MakeShmName(shmId.shmId, "m", s.first).c_str()));
+            } else if (s.second.fAllocationAlgorithm == AllocationAlgorithm::segregated_slab) {
+                segments.emplace(s.first, SegregatedSlabSegment(open_read_only, MakeShmName(shmId.shmId, "m", s.first).c_str()));
             } else {
                 segments.emplace(s.first, SimpleSeqFitSegment(open_read_only, MakeShmName(shmId.shmId, "m", s.first).c_str()));
             }
@@ -222,6 +228,7 @@ bool Monitor::PrintShm(const ShmId& shmId)
 #ifdef FAIRMQ_DEBUG_MODE
         Uint16MsgCounterHashMap* msgCounters = managementSegment.find<Uint16MsgCounterHashMap>(unique_instance).first;
 #endif
+        Uint16AllocCacheStatsHashMap* allocCacheStats = managementSegment.find<Uint16AllocCacheStatsHashMap>(unique_instance).first;
 
         stringstream ss;
         size_t mfree = managementSegment.get_free_memory();
@@ -257,8 +264,19 @@ bool Monitor::PrintShm(const ShmId& shmId)
                << ": total: " << total
                << ", msgs: " << msgCount
                << ", free: " << free
-               << ", used: " << used
-               << "\n";
+               << ", used: " << used;
+
+            if (allocCacheStats) {
+                auto it = allocCacheStats->find(s.first);
+                if (it != allocCacheStats->end()) {
+                    ss << ", alloc cache: hits: " << it->second.fHits.load()
+                       << ", misses: " << it->second.fMisses.load()
+                       << ", refills: " << it->second.fRefills.load()
+                       << ", flushes: " << it->second.fFlushes.load()
+                       << ", cached: " << it->second.fCachedBytes.load();
+                }
+            }
+            ss << "\n";
         }
 
         ss << "   [m]: "
@@ -281,12 +299,16 @@ bool Monitor::PrintShm(const ShmId& shmId)
                     ss << ", rcCountSegment: not found";
                 }
 
-                // try {
-                //     boost::interprocess::message_queue q(open_only, std::string("fmq_" + std::string(shmId) + "_rgq_" + to_string(id)).c_str());
-                //     ss << ", ack queue: " << q.get_num_msg() << " messages";
-                // } catch (bie&) {
-                //     ss << ", ack queue: not found";
-                // }
+                try {
+                    managed_shared_memory ackSegment(open_read_only, MakeShmName(shmId.shmId, "rgq", id).c_str());
+                    AckRing* ackRing = ackSegment.find_no_lock<AckRing>(unique_instance).first;
+                    if (ackRing) {
+                        ss << ", ack queue: " << ackRing->Size() << " pending, " << ackRing->NumAcks() << " delivered"
+                           << ", latency (ns) p50: " << ackRing->LatencyPercentile(0.5) << ", p99: " << ackRing->LatencyPercentile(0.99);
+                    }
+                } catch (bie&) {
+                    ss << ", ack queue: not found";
+                }
             }
         }
         LOGV(info, user1) << ss.str();
@@ -525,6 +547,9 @@ unsigned long Monitor::GetFreeMemory(const ShmId& shmId, uint16_t segmentId)
             if (it->second.fAllocationAlgorithm == AllocationAlgorithm::rbtree_best_fit) {
                 RBTreeBestFitSegment segment(open_read_only, MakeShmName(shmId.shmId, "m", segmentId).c_str());
                 return segment.get_free_memory();
+            } else if (it->second.fAllocationAlgorithm == AllocationAlgorithm::segregated_slab) {
+                SegregatedSlabSegment segment(open_read_only, MakeShmName(shmId.shmId, "m", segmentId).c_str());
+                return segment.get_free_memory();
             } else {
                 SimpleSeqFitSegment segment(open_read_only, MakeShmName(shmId.shmId, "m", segmentId).c_str());
                 return segment.get_free_memory();
@@ -544,6 +569,235 @@ unsigned long Monitor::GetFreeMemory(const SessionId& sessionId, uint16_t segmen
     return GetFreeMemory(shmId, segmentId);
 }
 
+AllocCacheInfo Monitor::GetAllocCacheInfo(const ShmId& shmId, uint16_t segmentId)
+{
+    using namespace boost::interprocess;
+    try {
+        bipc::managed_shared_memory managementSegment(bipc::open_read_only, MakeShmName(shmId.shmId, "mng").c_str());
+        Uint16AllocCacheStatsHashMap* allocCacheStats = managementSegment.find<Uint16AllocCacheStatsHashMap>(unique_instance).first;
+
+        if (allocCacheStats) {
+            auto it = allocCacheStats->find(segmentId);
+            if (it != allocCacheStats->end()) {
+                AllocCacheInfo info;
+                info.fHits = it->second.fHits.load();
+                info.fMisses = it->second.fMisses.load();
+                info.fRefills = it->second.fRefills.load();
+                info.fFlushes = it->second.fFlushes.load();
+                info.fCachedBytes = it->second.fCachedBytes.load();
+                return info;
+            }
+        }
+        LOG(error) << "No allocation cache statistics found for segment id '" << segmentId << "'";
+        throw MonitorError(tools::ToString("No allocation cache statistics found for segment id '", segmentId, "'"));
+    } catch (bie&) {
+        LOG(error) << "Could not find management segment for shmid '" << shmId.shmId << "'";
+        throw MonitorError(tools::ToString("Could not find management segment for shmid '", shmId.shmId, "'"));
+    }
+}
+
+AllocCacheInfo Monitor::GetAllocCacheInfo(const SessionId& sessionId, uint16_t segmentId)
+{
+    ShmId shmId{makeShmIdStr(sessionId.sessionId)};
+    return GetAllocCacheInfo(shmId, segmentId);
+}
+
+namespace
+{
+
+using RBTreeBestFit = bipc::rbtree_best_fit<bipc::mutex_family, bipc::offset_ptr<void>>;
+
+// Block header of rbtree_best_fit (its SizeHolder, which is private), sizes in units of RBTreeBestFit::Alignment.
+// The layout is verified on the first and the end block before walking.
+struct BlockHeader
+{
+    RBTreeBestFit::size_type fPrevSize;
+    RBTreeBestFit::size_type fSize : sizeof(RBTreeBestFit::size_type) * CHAR_BIT - 2;
+    RBTreeBestFit::size_type fPrevAllocated : 1;
+    RBTreeBestFit::size_type fAllocated : 1;
+};
+
+size_t Bucket(uint64_t size)
+{
+    return min<size_t>(63 - __builtin_clzll(size | 1), FragmentationInfo::kNumBuckets - 1);
+}
+
+// Walks all blocks of the segment from the first to the end block, without the segment mutex: returns false if the
+// blocks did not line up, because they were changed by an allocation/deallocation during the walk.
+// The first block follows the algorithm object (of size algoSize) and the rest of the segment manager (extraHdrBytes).
+bool WalkBlocks(const RBTreeBestFit& algo, size_t algoSize, size_t extraHdrBytes, FragmentationInfo& info)
+{
+    constexpr size_t kAlignment = RBTreeBestFit::Alignment;
+    const char* const base = reinterpret_cast<const char*>(&algo);
+    const char* const segmentEnd = base + algo.get_size();
+    const auto firstOffset = reinterpret_cast<uintptr_t>(base) + algoSize + extraHdrBytes;
+    const char* const first = base + ((firstOffset + kAlignment - 1) / kAlignment * kAlignment - reinterpret_cast<uintptr_t>(base));
+
+    // the first block stores the distance to the end block in its fPrevSize
+    BlockHeader firstBlock;
+    memcpy(&firstBlock, first, sizeof(BlockHeader));
+    const char* const end = first + firstBlock.fPrevSize * kAlignment;
+    if (!firstBlock.fPrevAllocated || end <= first || end + sizeof(BlockHeader) > segmentEnd) {
+        throw Monitor::MonitorError("unexpected layout of the segment allocator, cannot analyze it");
+    }
+    BlockHeader endBlock;
+    memcpy(&endBlock, end, sizeof(BlockHeader));
+    if (!endBlock.fAllocated || endBlock.fSize != firstBlock.fPrevSize) {
+        throw Monitor::MonitorError("unexpected layout of the segment allocator, cannot analyze it");
+    }
+
+    FragmentationInfo result;
+    result.fSize = algo.get_size();
+    for (const char* ptr = first; ptr != end;) {
+        BlockHeader block;
+        memcpy(&block, ptr, sizeof(BlockHeader));
+        const uint64_t size = static_cast<uint64_t>(block.fSize) * kAlignment;
+        if (size == 0 || size > static_cast<uint64_t>(end - ptr)) {
+            return false;
+        }
+        size_t bucket = Bucket(size);
+        if (block.fAllocated) {
+            ++result.fNumUsedBlocks;
+            result.fUsedBytes += size;
+            ++result.fUsedBlocks[bucket];
+        } else {
+            ++result.fNumFreeBlocks;
+            result.fFreeBytes += size;
+            ++result.fFreeBlocks[bucket];
+            result.fFreeBlockBytes[bucket] += size;
+            result.fLargestFreeBlock = max(result.fLargestFreeBlock, size);
+        }
+        ptr += size;
+    }
+
+    if (result.fLargestFreeBlock > RBTreeBestFit::PayloadPerAllocation + ShmHeader::FullSize(0, alignof(max_align_t))) {
+        result.fLargestMessage = result.fLargestFreeBlock - RBTreeBestFit::PayloadPerAllocation - ShmHeader::FullSize(0, alignof(max_align_t));
+    }
+    result.fFragmentation = result.fFreeBytes > 0 ? 1. - static_cast<double>(result.fLargestFreeBlock) / static_cast<double>(result.fFreeBytes) : 0.;
+    info = result;
+    return true;
+}
+
+template<typename SegmentType>
+FragmentationInfo AnalyzeSegment(const SegmentType& segment)
+{
+    using SegmentManager = typename SegmentType::segment_manager;
+    using Algorithm = typename SegmentManager::memory_algorithm;
+    // what the segment manager reserves behind the algorithm object, see segment_manager::priv_get_reserved_bytes()
+    constexpr size_t extraHdrBytes = sizeof(SegmentManager) - sizeof(bipc::segment_manager_base<Algorithm>);
+
+    // the segment manager derives privately from the algorithm, the C-style cast is the conversion to that base
+    const Algorithm& algo = *(const Algorithm*)(segment.get_segment_manager()); // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+    const RBTreeBestFit& rbtree = algo;
+
+    FragmentationInfo info;
+    info.fConsistent = false;
+    for (int attempt = 0; attempt < 10 && !info.fConsistent; ++attempt) {
+        info.fConsistent = WalkBlocks(rbtree, sizeof(Algorithm), extraHdrBytes, info);
+    }
+    if constexpr (!std::is_same_v<Algorithm, RBTreeBestFit>) {
+        const size_t free = algo.get_free_memory();
+        const size_t rbtreeFree = rbtree.get_free_memory();
+        info.fSlabFreeBytes = free > rbtreeFree ? free - rbtreeFree : 0;
+    }
+    return info;
+}
+
+} // namespace
+
+FragmentationInfo Monitor::GetFragmentationInfo(const ShmId& shmId, uint16_t segmentId)
+{
+    using namespace boost::interprocess;
+    AllocationAlgorithm algorithm;
+    try {
+        bipc::managed_shared_memory managementSegment(bipc::open_read_only, MakeShmName(shmId.shmId, "mng").c_str());
+        Uint16SegmentInfoHashMap* shmSegments = managementSegment.find<Uint16SegmentInfoHashMap>(unique_instance).first;
+        if (!shmSegments) {
+            throw MonitorError("Found management segment, but could not locate segment info");
+        }
+        auto it = shmSegments->find(segmentId);
+        if (it == shmSegments->end()) {
+            throw MonitorError(tools::ToString("Could not find segment id '", segmentId, "'"));
+        }
+        algorithm = it->second.fAllocationAlgorithm;
+    } catch (bie&) {
+        throw MonitorError(tools::ToString("Could not find management segment for shmid '", shmId.shmId, "'"));
+    }
+
+    try {
+        if (algorithm == AllocationAlgorithm::rbtree_best_fit) {
+            return AnalyzeSegment(RBTreeBestFitSegment(open_read_only, MakeShmName(shmId.shmId, "m", segmentId).c_str()));
+        } else if (algorithm == AllocationAlgorithm::segregated_slab) {
+            return AnalyzeSegment(SegregatedSlabSegment(open_read_only, MakeShmName(shmId.shmId, "m", segmentId).c_str()));
+        }
+    } catch (bie&) {
+        throw MonitorError(tools::ToString("Could not open segment '", segmentId, "' of shmid '", shmId.shmId, "'"));
+    }
+    throw MonitorError("The fragmentation analysis supports only the rbtree_best_fit and segregated_slab allocation algorithms");
+}
+
+FragmentationInfo Monitor::GetFragmentationInfo(const SessionId& sessionId, uint16_t segmentId)
+{
+    ShmId shmId{makeShmIdStr(sessionId.sessionId)};
+    return GetFragmentationInfo(shmId, segmentId);
+}
+
+bool Monitor::PrintFragmentation(const ShmId& shmId)
+{
+    using namespace boost::interprocess;
+
+    std::vector<uint16_t> segmentIds;
+    try {
+        managed_shared_memory managementSegment(open_read_only, MakeShmName(shmId.shmId, "mng").c_str());
+        Uint16SegmentInfoHashMap* shmSegments = managementSegment.find<Uint16SegmentInfoHashMap>(unique_instance).first;
+        if (!shmSegments) {
+            LOG(error) << "Found management segment, but cannot locate segment info, something went wrong...";
+            return false;
+        }
+        for (const auto& s : *shmSegments) {
+            segmentIds.push_back(s.first);
+        }
+    } catch (bie&) {
+        return false;
+    }
+    sort(segmentIds.begin(), segmentIds.end());
+
+    stringstream ss;
+    ss << "shm id: " << shmId.shmId << ", fragmentation of the managed segments:";
+    for (auto id : segmentIds) {
+        ss << "\n   [" << id << "]: ";
+        FragmentationInfo info;
+        try {
+            info = GetFragmentationInfo(shmId, id);
+        } catch (MonitorError& e) {
+            ss << e.what();
+            continue;
+        }
+
+        ss << "total: " << info.fSize
+           << ", free: " << info.fFreeBytes << " in " << info.fNumFreeBlocks << " blocks"
+           << ", largest free block: " << info.fLargestFreeBlock
+           << " (largest message: " << info.fLargestMessage << ")"
+           << ", fragmentation: " << fixed << setprecision(3) << info.fFragmentation
+           << ", used: " << info.fUsedBytes << " in " << info.fNumUsedBlocks << " blocks";
+        if (info.fSlabFreeBytes > 0) {
+            ss << ", free in slabs: " << info.fSlabFreeBytes;
+        }
+        if (!info.fConsistent) {
+            ss << " (approximate, the segment kept changing during the analysis)";
+        }
+        ss << "\n      " << setw(14) << "block size >=" << setw(14) << "free blocks" << setw(16) << "free bytes" << setw(14) << "used blocks";
+        for (size_t i = 0; i < FragmentationInfo::kNumBuckets; ++i) {
+            if (info.fFreeBlocks[i] > 0 || info.fUsedBlocks[i] > 0) {
+                ss << "\n      " << setw(14) << (uint64_t(1) << i) << setw(14) << info.fFreeBlocks[i] << setw(16) << info.fFreeBlockBytes[i] << setw(14) << info.fUsedBlocks[i];
+            }
+        }
+    }
+    LOGV(info, user1) << ss.str();
+
+    return true;
+}
+
 bool Monitor::SegmentIsPresent(const ShmId& shmId, uint16_t segmentId)
 {
     using namespace boost::interprocess;
@@ -561,6 +815,8 @@ bool Monitor::SegmentIsPresent(const ShmId& shmId, uint16_t segmentId)
             try {
                 if (it->second.fAllocationAlgorithm == AllocationAlgorithm::rbtree_best_fit) {
                     RBTreeBestFitSegment segment(open_read_only, MakeShmName(shmId.shmId, "m", segmentId).c_str());
+                } else if (it->second.fAllocationAlgorithm == AllocationAlgorithm::segregated_slab) {
+                    SegregatedSlabSegment segment(open_read_only, MakeShmName(shmId.shmId, "m", segmentId).c_str());
                 } else {
                     SimpleSeqFitSegment segment(open_read_only, MakeShmName(shmId.shmId, "m", segmentId).c_str());
                 }
@@ -687,7 +943,7 @@ std::vector<std::pair<std::string, bool>> Monitor::Cleanup(const ShmId& shmIdT,
                 } else {
                     result.emplace_back(Remove<bipc::shared_memory_object>(MakeShmName(shmId, "rg", id), verbose));
                 }
-                result.emplace_back(Remove<bipc::message_queue>(MakeShmName(shmId, "rgq", id), verbose));
+                result.emplace_back(Remove<bipc::shared_memory_object>(MakeShmName(shmId, "rgq", id), verbose));
                 result.emplace_back(Remove<bipc::shared_memory_object>(MakeShmName(shmId, "rrc", id), verbose));
             }
         }
@@ -766,6 +1022,11 @@ void Monitor::ResetContent(const ShmId& shmIdT, bool verbose /* = true */)
                         void* ptr = segment.get_segment_manager();
                         size_t size = segment.get_segment_manager()->get_size();
                         new(ptr) segment_manager<char, rbtree_best_fit<mutex_family, offset_ptr<void>>, null_index>(size);
+                    } else if (info.fAllocationAlgorithm == AllocationAlgorithm::segregated_slab) {
+                        SegregatedSlabSegment segment(open_only, MakeShmName(shmId, "m", id).c_str());
+                        void* ptr = segment.get_segment_manager();
+                        size_t size = segment.get_segment_manager()->get_size();
+                        new(ptr) segment_manager<char, SegregatedSlabAlgorithm<mutex_family, offset_ptr<void>>, null_index>(size);
                     } else {
                         SimpleSeqFitSegment segment(open_only, MakeShmName(shmId, "m", id).c_str());
                         void* ptr = segment.get_segment_manager();
@@ -789,7 +1050,7 @@ void Monitor::ResetContent(const ShmId& shmIdT, bool verbose /* = true */)
         if (shmRegions) {
             for (const auto& region : *shmRegions) {
                 uint16_t id = region.first;
-                Remove<bipc::message_queue>(MakeShmName(shmId, "rgq", id), verbose);
+                Remove<bipc::shared_memory_object>(MakeShmName(shmId, "rgq", id), verbose);
                 Remove<bipc::shared_memory_object>(MakeShmName(shmId, "rrc", id), verbose);
             }
         }
@@ -834,6 +1095,8 @@ void Monitor::ResetContent(const ShmId& shmIdT, const std::vector<SegmentConfig>
             Segment::Register(shmId, s.id, AllocationAlgorithm::rbtree_best_fit);
         } else if (s.allocationAlgorithm == "simple_seq_fit") {
             Segment::Register(shmId, s.id, AllocationAlgorithm::simple_seq_fit);
+        } else if (s.allocationAlgorithm == "segregated_slab") {
+            Segment::Register(shmId, s.id, AllocationAlgorithm::segregated_slab);
         } else {
             LOG(error) << "Unknown allocation algorithm provided: " << s.allocationAlgorithm;
             throw MonitorError("Unknown allocation algorithm provided: " + s.allocationAlgorithm);
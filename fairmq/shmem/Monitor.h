@@ -12,6 +12,7 @@
 
 #include <fairlogger/Logger.h>
 
+#include <array>
 #include <thread>
 #include <chrono>
 #include <atomic>
@@ -51,6 +52,34 @@ struct BufferDebugInfo
     uint64_t fCreationTime;
 };
 
+struct AllocCacheInfo
+{
+    uint64_t fHits = 0;
+    uint64_t fMisses = 0;
+    uint64_t fRefills = 0;
+    uint64_t fFlushes = 0;
+    int64_t fCachedBytes = 0;
+};
+
+struct FragmentationInfo
+{
+    static constexpr std::size_t kNumBuckets = 48;
+
+    uint64_t fSize = 0;              ///< size of the segment
+    uint64_t fFreeBytes = 0;         ///< in free blocks of the allocator (without free chunks of the segregated_slab arena)
+    uint64_t fNumFreeBlocks = 0;
+    uint64_t fLargestFreeBlock = 0;  ///< size of the largest free block
+    uint64_t fLargestMessage = 0;    ///< largest message that can currently be allocated from it
+    double fFragmentation = 0.;      ///< 1 - largest free block / free bytes: 0 if the free memory is contiguous, towards 1 if it is scattered
+    uint64_t fUsedBytes = 0;         ///< in allocated blocks (including the allocator and FairMQ headers)
+    uint64_t fNumUsedBlocks = 0;
+    uint64_t fSlabFreeBytes = 0;     ///< free in the arena of segregated_slab (only for its size classes)
+    std::array<uint64_t, kNumBuckets> fFreeBlocks{};   ///< number of free blocks of size [2^i, 2^(i+1))
+    std::array<uint64_t, kNumBuckets> fFreeBlockBytes{}; ///< their total size
+    std::array<uint64_t, kNumBuckets> fUsedBlocks{};   ///< number of allocated blocks of size [2^i, 2^(i+1))
+    bool fConsistent = true;         ///< false if the segment kept changing during the analysis, the numbers are then approximate
+};
+
 struct SegmentConfig
 {
     uint16_t id;
@@ -128,6 +157,28 @@ class Monitor
     /// @param segmentId segment id
     /// @throws MonitorError
     static unsigned long GetFreeMemory(const SessionId& sessionId, uint16_t segmentId);
+    /// @brief Returns the counters of the per-thread allocation caches (--shm-alloc-cache) for the specified segment
+    /// @param shmId shmem id
+    /// @param segmentId segment id
+    /// @throws MonitorError if the segment has not been used with the allocation cache
+    static AllocCacheInfo GetAllocCacheInfo(const ShmId& shmId, uint16_t segmentId);
+    /// @brief Returns the counters of the per-thread allocation caches (--shm-alloc-cache) for the specified segment
+    /// @param sessionId session id
+    /// @param segmentId segment id
+    /// @throws MonitorError if the segment has not been used with the allocation cache
+    static AllocCacheInfo GetAllocCacheInfo(const SessionId& sessionId, uint16_t segmentId);
+    /// @brief Analyzes the free and allocated blocks of the specified segment (rbtree_best_fit or segregated_slab allocation).
+    /// Reads the segment through a read-only mapping without taking its mutex, not needing FAIRMQ_DEBUG_MODE.
+    /// @param shmId shmem id
+    /// @param segmentId segment id
+    /// @throws MonitorError if the segment is not found or its allocation algorithm is not supported
+    static FragmentationInfo GetFragmentationInfo(const ShmId& shmId, uint16_t segmentId);
+    /// @brief Analyzes the free and allocated blocks of the specified segment (rbtree_best_fit or segregated_slab allocation).
+    /// Reads the segment through a read-only mapping without taking its mutex, not needing FAIRMQ_DEBUG_MODE.
+    /// @param sessionId session id
+    /// @param segmentId segment id
+    /// @throws MonitorError if the segment is not found or its allocation algorithm is not supported
+    static FragmentationInfo GetFragmentationInfo(const SessionId& sessionId, uint16_t segmentId);
     /// @brief Checks if a given segment can be opened
     /// @param shmId shmem id
     /// @param segmentId segment id
@@ -147,6 +198,7 @@ class Monitor
 
 
     static bool PrintShm(const ShmId& shmId);
+    static bool PrintFragmentation(const ShmId& shmId);
     static void ListAll(const std::string& path);
 
     static bool RemoveObject(const std::string& name);
@@ -12,8 +12,14 @@
 #include <fairlogger/Logger.h>
 #include <fairmq/Channel.h>
 #include <fairmq/Poller.h>
+#include <fairmq/Probes.h>
+#include <fairmq/shmem/MetaRing.h>
 #include <fairmq/shmem/Socket.h>
 #include <fairmq/tools/Strings.h>
+#include <fairmq/zeromq/Common.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 #include <zmq.h>
@@ -30,6 +36,7 @@ class Poller final : public fair::mq::Poller
     {
         fNumItems = channels.size();
         fItems = new zmq_pollitem_t[fNumItems];
+        fSockets.resize(fNumItems);
 
         for (int i = 0; i < fNumItems; ++i) {
             fItems[i].socket = static_cast<const Socket*>(&(channels.at(i).GetSocket()))->GetSocket();
@@ -41,6 +48,7 @@ class Poller final : public fair::mq::Poller
             zmq_getsockopt(static_cast<const Socket*>(&(channels.at(i).GetSocket()))->GetSocket(), ZMQ_TYPE, &type, &size);
 
             SetItemEvents(fItems[i], type);
+            AddSocket(i, *static_cast<const Socket*>(&(channels.at(i).GetSocket())));
         }
     }
 
@@ -50,6 +58,7 @@ class Poller final : public fair::mq::Poller
     {
         fNumItems = channels.size();
         fItems = new zmq_pollitem_t[fNumItems];
+        fSockets.resize(fNumItems);
 
         for (int i = 0; i < fNumItems; ++i) {
             fItems[i].socket = static_cast<const Socket*>(&(channels.at(i)->GetSocket()))->GetSocket();
@@ -61,6 +70,7 @@ class Poller final : public fair::mq::Poller
             zmq_getsockopt(static_cast<const Socket*>(&(channels.at(i)->GetSocket()))->GetSocket(), ZMQ_TYPE, &type, &size);
 
             SetItemEvents(fItems[i], type);
+            AddSocket(i, *static_cast<const Socket*>(&(channels.at(i)->GetSocket())));
         }
     }
 
@@ -78,6 +88,7 @@ class Poller final : public fair::mq::Poller
             }
 
             fItems = new zmq_pollitem_t[fNumItems];
+            fSockets.resize(fNumItems);
 
             int index = 0;
             for (std::string channel : channelList) {
@@ -93,6 +104,7 @@ class Poller final : public fair::mq::Poller
                     zmq_getsockopt(static_cast<const Socket*>(&(channelsMap.at(channel).at(i).GetSocket()))->GetSocket(), ZMQ_TYPE, &type, &size);
 
                     SetItemEvents(fItems[index], type);
+                    AddSocket(index, *static_cast<const Socket*>(&(channelsMap.at(channel).at(i).GetSocket())));
                 }
             }
         } catch (const std::out_of_range& oor) {
@@ -120,22 +132,29 @@ class Poller final : public fair::mq::Poller
         }
     }
 
+    /// sockets that exchange metadata via a shared memory ring are not polled via ZeroMQ, but via their ring.
+    /// All sockets are checked for messages kept from a received batch.
+    void AddSocket(int index, const Socket& socket)
+    {
+        fSockets[index] = &socket;
+        if (socket.GetRxRing() || socket.GetTxRing()) {
+            fRingItems.push_back(RingItem{ index, fItems[index].events, socket.GetRxRing(), socket.GetTxRing() });
+            fItems[index].events = 0;
+        }
+    }
+
     void Poll(int timeout) override
     {
-        while (true) {
-            if (zmq_poll(fItems, fNumItems, timeout) < 0) {
-                if (errno == ETERM) {
-                    LOG(debug) << "polling exited, reason: " << zmq_strerror(errno);
-                    return;
-                } else if (errno == EINTR) {
-                    LOG(debug) << "polling interrupted by system call";
-                    continue;
-                } else {
-                    LOG(error) << "polling failed, reason: " << zmq_strerror(errno);
-                    throw fair::mq::PollerError(fair::mq::tools::ToString("Polling failed, reason: ", zmq_strerror(errno)));
+        FAIRMQ_PROBE_SCOPE(poll, timeout);
+        // messages kept in a socket from a received batch are ready without waiting
+        const bool pending = std::any_of(fSockets.begin(), fSockets.end(), [](const Socket* s) { return s->HasPendingRx(); });
+        PollSockets(pending ? 0 : timeout);
+        if (pending) {
+            for (int i = 0; i < fNumItems; ++i) {
+                if ((fItems[i].events & ZMQ_POLLIN) && fSockets[i]->HasPendingRx()) {
+                    fItems[i].revents |= ZMQ_POLLIN;
                 }
             }
-            break;
         }
     }
 
@@ -193,6 +212,133 @@ class Poller final : public fair::mq::Poller
     zmq_pollitem_t* fItems;
     int fNumItems;
 
+    struct RingItem
+    {
+        int fIndex;
+        short fEvents;
+        MetaRing* fRx;
+        MetaRing* fTx;
+    };
+    std::vector<RingItem> fRingItems;
+    std::vector<const Socket*> fSockets; // by item index
+
+    void PollSockets(int timeout)
+    {
+        if (!fRingItems.empty()) {
+            PollWithRings(timeout);
+            return;
+        }
+
+        if (fSpinTime.count() > 0 && timeout != 0) {
+            int numReady = zmq::SpinPoll(fItems, fNumItems, fSpinTime, timeout, fStats);
+            if (numReady != 0) {
+                CountPoll(numReady > 0, true);
+                return;
+            }
+        }
+
+        int numReady = ZmqPoll(timeout);
+        if (numReady >= 0) {
+            CountPoll(numReady > 0, false);
+        }
+    }
+
+    /// returns the number of ready items, -1 if the context was terminated
+    int ZmqPoll(int timeout)
+    {
+        while (true) {
+            int numReady = zmq_poll(fItems, fNumItems, timeout);
+            if (numReady < 0) {
+                if (errno == ETERM) {
+                    LOG(debug) << "polling exited, reason: " << zmq_strerror(errno);
+                    return -1;
+                } else if (errno == EINTR) {
+                    LOG(debug) << "polling interrupted by system call";
+                    continue;
+                } else {
+                    LOG(error) << "polling failed, reason: " << zmq_strerror(errno);
+                    throw fair::mq::PollerError(fair::mq::tools::ToString("Polling failed, reason: ", zmq_strerror(errno)));
+                }
+            }
+            return numReady;
+        }
+    }
+
+    /// sets revents of the ring items, returns true if any of them is ready
+    bool UpdateRingEvents()
+    {
+        bool ready = false;
+        for (const auto& item : fRingItems) {
+            short revents = 0;
+            if ((item.fEvents & ZMQ_POLLIN) && item.fRx && item.fRx->HasData()) {
+                revents |= ZMQ_POLLIN;
+            }
+            if ((item.fEvents & ZMQ_POLLOUT) && item.fTx && item.fTx->HasSpace()) {
+                revents |= ZMQ_POLLOUT;
+            }
+            fItems[item.fIndex].revents = revents;
+            ready = ready || revents != 0;
+        }
+        return ready;
+    }
+
+    /// Checks the rings and the ZeroMQ sockets in turns: spinning first (for the spin time of the busy-poll mode, or a
+    /// number of iterations), then sleeping on the ring if it is the only item, otherwise in short ZeroMQ poll slices.
+    void PollWithRings(int timeout)
+    {
+        const bool timedSpin = fSpinTime.count() > 0;
+        const int spinIterations = std::thread::hardware_concurrency() > 1 ? 2000 : 0;
+        constexpr int sliceMs = 1;
+        const bool onlyRings = std::all_of(fItems, fItems + fNumItems, [](const zmq_pollitem_t& i) { return i.events == 0; });
+        const bool singleRing = onlyRings && fRingItems.size() == 1;
+        const auto start = std::chrono::steady_clock::now();
+        bool spinning = timedSpin || spinIterations > 0;
+
+        for (int iteration = 0; true; ++iteration) {
+            const auto now = std::chrono::steady_clock::now();
+            if (spinning && (timedSpin ? now - start >= fSpinTime : iteration >= spinIterations)) {
+                spinning = false;
+                fStats.spinTimeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count();
+            }
+            int remaining = -1;
+            if (timeout >= 0) {
+                remaining = std::max(0L, timeout - static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count()));
+            }
+
+            // check ZeroMQ items without blocking (this also resets revents of all items), then check the rings
+            bool ready = false;
+            if (!onlyRings) {
+                int numReady = (spinning && timedSpin) ? zmq::PollEvents(fItems, fNumItems) : ZmqPoll(0);
+                if (numReady < 0) {
+                    return;
+                }
+                ready = numReady > 0;
+            }
+            ready = UpdateRingEvents() || ready;
+            if (ready || remaining == 0) {
+                if (spinning) {
+                    fStats.spinTimeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count();
+                }
+                CountPoll(ready, spinning);
+                return;
+            } else if (spinning) {
+                continue;
+            }
+
+            const int waitMs = remaining < 0 ? 100 : std::min(remaining, 100);
+            if (singleRing) {
+                const RingItem& item = fRingItems.front();
+                if ((item.fEvents & ZMQ_POLLIN) && item.fRx) {
+                    item.fRx->WaitForData(0, waitMs);
+                } else if (item.fTx) {
+                    item.fTx->WaitForSpace(1, 0, waitMs);
+                }
+            } else if (ZmqPoll(std::min(waitMs, sliceMs)) < 0) {
+                return;
+            }
+        }
+    }
+
     std::unordered_map<std::string, int> fOffsetMap;
 };
 
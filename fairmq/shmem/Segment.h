@@ -21,8 +21,10 @@ namespace fair::mq::shmem
 
 struct SimpleSeqFit {};
 struct RBTreeBestFit {};
+struct SegregatedSlab {};
 static const SimpleSeqFit simpleSeqFit = SimpleSeqFit();
 static const RBTreeBestFit rbTreeBestFit = RBTreeBestFit();
+static const SegregatedSlab segregatedSlab = SegregatedSlab();
 
 struct Segment
 {
@@ -40,6 +42,12 @@ struct Segment
         Register(shmId, id, AllocationAlgorithm::rbtree_best_fit);
     }
 
+    Segment(const std::string& shmId, uint16_t id, size_t size, SegregatedSlab)
+        : fSegment(SegregatedSlabSegment(boost::interprocess::open_or_create, MakeShmName(shmId, "m", id).c_str(), size))
+    {
+        Register(shmId, id, AllocationAlgorithm::segregated_slab);
+    }
+
     size_t GetSize() const { return std::visit([](auto& s){ return s.get_size(); }, fSegment); }
     void* GetData() { return std::visit([](auto& s){ return s.get_address(); }, fSegment); }
 
@@ -59,7 +67,7 @@ struct Segment
     }
 
   private:
-    std::variant<RBTreeBestFitSegment, SimpleSeqFitSegment> fSegment;
+    std::variant<RBTreeBestFitSegment, SimpleSeqFitSegment, SegregatedSlabSegment> fSegment;
 
     static void Register(const std::string& shmId, uint16_t id, AllocationAlgorithm allocAlgo)
     {
@@ -0,0 +1,326 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+#ifndef FAIR_MQ_SHMEM_SEGREGATEDSLABALGORITHM_H_
+#define FAIR_MQ_SHMEM_SEGREGATEDSLABALGORITHM_H_
+
+#include <boost/interprocess/detail/utilities.hpp> // to_raw_pointer
+#include <boost/interprocess/mem_algo/rbtree_best_fit.hpp>
+
+#include <algorithm> // min
+#include <atomic>
+#include <cstddef> // size_t
+#include <cstdint>
+#include <cstring> // memset
+#include <new> // placement new
+
+namespace fair::mq::shmem
+{
+
+/// Memory algorithm for boost::interprocess managed segments, used by the 'segregated_slab' allocation algorithm.
+///
+/// On creation, half of the segment is reserved as an arena of fixed size slabs. Slabs are handed out on demand to
+/// power-of-two size classes (64 B .. 256 KiB) and split into chunks of the class size. Free chunks of each class are
+/// kept in a lock-free list in the segment itself, so allocations and deallocations of small buffers do not take the
+/// segment mutex (only slab carving is a single atomic increment). Slabs are never returned to the rest of the segment.
+/// Larger allocations, and small ones once the arena is exhausted, are served by rbtree_best_fit from the remaining memory.
+///
+/// All state is stored as offsets from the algorithm object (the segment start), so it is valid in every process.
+template<class MutexFamily, class VoidPointer>
+class SegregatedSlabAlgorithm : public boost::interprocess::rbtree_best_fit<MutexFamily, VoidPointer>
+{
+    using Base = boost::interprocess::rbtree_best_fit<MutexFamily, VoidPointer>;
+
+  public:
+    using size_type = typename Base::size_type;
+    using multiallocation_chain = typename Base::multiallocation_chain;
+
+    static constexpr size_type kMinClassSize = 64;
+    static constexpr size_type kNumClasses = 13;
+    static constexpr size_type kMaxClassSize = kMinClassSize << (kNumClasses - 1); // 256 KiB
+    static constexpr size_type kSlabSize = 1 << 20;
+
+    SegregatedSlabAlgorithm(size_type segmentSize, size_type extraHdrBytes)
+        : Base(segmentSize, extraHdrBytes + OwnBytes())
+        , fArenaOffset(0)
+        , fTableOffset(0)
+        , fNumSlabs(0)
+        , fNextSlab(0)
+    {
+        static_assert(std::atomic<uint64_t>::is_always_lock_free, "segregated_slab requires lock-free 64 bit atomics");
+
+        size_type arenaSize = (Base::get_free_memory() / 2) / kSlabSize * kSlabSize;
+        if (arenaSize == 0) {
+            return; // too small for a single slab, everything goes to rbtree_best_fit
+        }
+        const size_type numSlabs = arenaSize / kSlabSize;
+        void* table = Base::allocate(numSlabs * sizeof(std::atomic<uint8_t>));
+        void* arena = table ? Base::allocate_aligned(arenaSize, 4096) : nullptr;
+        if (!arena || Offset(arena) + arenaSize > kOffsetMask) {
+            if (arena) {
+                Base::deallocate(arena);
+            }
+            if (table) {
+                Base::deallocate(table);
+            }
+            return;
+        }
+        for (size_type i = 0; i < numSlabs; ++i) {
+            new (static_cast<std::atomic<uint8_t>*>(table) + i) std::atomic<uint8_t>(kUncarved);
+        }
+        fTableOffset = Offset(table);
+        fArenaOffset = Offset(arena);
+        fNumSlabs = numSlabs;
+    }
+
+    SegregatedSlabAlgorithm(const SegregatedSlabAlgorithm&) = delete;
+    SegregatedSlabAlgorithm(SegregatedSlabAlgorithm&&) = delete;
+    SegregatedSlabAlgorithm& operator=(const SegregatedSlabAlgorithm&) = delete;
+    SegregatedSlabAlgorithm& operator=(SegregatedSlabAlgorithm&&) = delete;
+
+    static size_type get_min_size(size_type extraHdrBytes) { return Base::get_min_size(extraHdrBytes + OwnBytes()); }
+
+    void* allocate(size_type nbytes)
+    {
+        if (nbytes <= kMaxClassSize && fNumSlabs > 0) {
+            if (void* ptr = SlabAllocate(SizeClass(nbytes))) {
+                return ptr;
+            }
+        }
+        return Base::allocate(nbytes);
+    }
+
+    void deallocate(void* addr)
+    {
+        if (InArena(addr)) {
+            char* chunk = static_cast<char*>(addr);
+            Push(fClasses[ClassOf(chunk)], chunk, chunk, 1);
+        } else {
+            Base::deallocate(addr);
+        }
+    }
+
+    void allocate_many(size_type elemBytes, size_type numElements, multiallocation_chain& chain)
+    {
+        if (elemBytes == 0 || elemBytes > kMaxClassSize || fNumSlabs == 0) {
+            Base::allocate_many(elemBytes, numElements, chain);
+            return;
+        }
+        multiallocation_chain chunks;
+        size_type num = 0;
+        for (; num < numElements; ++num) {
+            void* ptr = SlabAllocate(SizeClass(elemBytes));
+            if (!ptr) {
+                break;
+            }
+            chunks.push_back(ptr);
+        }
+        if (num < numElements) {
+            const size_type prevSize = chunks.size();
+            Base::allocate_many(elemBytes, numElements - num, chunks);
+            if (chunks.size() == prevSize) {
+                // all or nothing, like rbtree_best_fit
+                deallocate_many(chunks);
+                return;
+            }
+        }
+        while (!chunks.empty()) {
+            chain.push_back(chunks.pop_front());
+        }
+    }
+
+    void allocate_many(const size_type* elemSizes, size_type numElements, size_type sizeofElement, multiallocation_chain& chain)
+    {
+        Base::allocate_many(elemSizes, numElements, sizeofElement, chain);
+    }
+
+    void deallocate_many(multiallocation_chain& chain)
+    {
+        multiallocation_chain rest;
+        while (!chain.empty()) {
+            void* ptr = boost::interprocess::ipcdetail::to_raw_pointer(chain.pop_front());
+            if (InArena(ptr)) {
+                deallocate(ptr);
+            } else {
+                rest.push_back(ptr);
+            }
+        }
+        if (!rest.empty()) {
+            Base::deallocate_many(rest);
+        }
+    }
+
+    size_type size(const void* ptr) const
+    {
+        if (InArena(ptr)) {
+            return ClassSize(ClassOf(ptr));
+        }
+        return Base::size(ptr);
+    }
+
+    template<class T>
+    T* allocation_command(boost::interprocess::allocation_type command, size_type limitSize, size_type& preferInRecvdOutSize, T*& reuse)
+    {
+        void* rawReuse = reuse;
+        void* ret = raw_allocation_command(command, limitSize, preferInRecvdOutSize, rawReuse, sizeof(T));
+        reuse = static_cast<T*>(rawReuse);
+        return static_cast<T*>(ret);
+    }
+
+    void* raw_allocation_command(boost::interprocess::allocation_type command, size_type limitObjects, size_type& preferInRecvdOutSize, void*& reuse, size_type sizeofObject = 1)
+    {
+        if (!reuse || !InArena(reuse)) {
+            return Base::raw_allocation_command(command, limitObjects, preferInRecvdOutSize, reuse, sizeofObject);
+        }
+        // slab chunks can neither grow nor shrink, only a new buffer can be provided
+        if (command & boost::interprocess::allocate_new) {
+            void* ret = allocate(preferInRecvdOutSize * sizeofObject);
+            if (ret) {
+                reuse = nullptr;
+            }
+            return ret;
+        }
+        return nullptr;
+    }
+
+    size_type get_free_memory() const
+    {
+        size_type free = Base::get_free_memory();
+        for (size_type c = 0; c < kNumClasses; ++c) {
+            free += static_cast<size_type>(std::max<int64_t>(0, fClasses[c].fNumFree.load(std::memory_order_relaxed))) * ClassSize(c);
+        }
+        return free + NumUncarvedSlabs() * kSlabSize;
+    }
+
+    void zero_free_memory()
+    {
+        Base::zero_free_memory();
+        // free chunks in the class lists hold the list links, only the slabs that have not been carved yet are zeroed
+        const size_type firstUncarved = fNumSlabs - NumUncarvedSlabs();
+        std::memset(Arena() + firstUncarved * kSlabSize, 0, NumUncarvedSlabs() * kSlabSize);
+    }
+
+  private:
+    // list heads: [tag (24 bit)][offset of the first free chunk from the segment start (40 bit)]
+    static constexpr uint64_t kOffsetMask = (uint64_t(1) << 40) - 1;
+    static constexpr uint64_t kTagUnit = uint64_t(1) << 40;
+    static constexpr uint8_t kUncarved = 0xFF;
+
+    // padded to a cache line, the object may be placed at an address with less than 64 byte alignment
+    struct FreeList
+    {
+        std::atomic<uint64_t> fHead{0};
+        std::atomic<int64_t> fNumFree{0};
+        char fPadding[64 - 2 * sizeof(uint64_t)];
+    };
+
+    static constexpr size_type OwnBytes() { return sizeof(SegregatedSlabAlgorithm) - sizeof(Base); }
+
+    static size_type ClassSize(size_type sizeClass) { return kMinClassSize << sizeClass; }
+    static size_type SizeClass(size_type nbytes)
+    {
+        return nbytes <= kMinClassSize ? 0 : (64 - __builtin_clzll(nbytes - 1)) - 6; // 6 == log2(kMinClassSize)
+    }
+
+    char* Segment() const { return reinterpret_cast<char*>(const_cast<SegregatedSlabAlgorithm*>(this)); }
+    uint64_t Offset(const void* ptr) const { return static_cast<uint64_t>(static_cast<const char*>(ptr) - Segment()); }
+    char* Arena() const { return Segment() + fArenaOffset; }
+    std::atomic<uint8_t>* Table() const { return reinterpret_cast<std::atomic<uint8_t>*>(Segment() + fTableOffset); }
+    static std::atomic<uint64_t>& Next(char* chunk) { return *reinterpret_cast<std::atomic<uint64_t>*>(chunk); }
+
+    bool InArena(const void* ptr) const
+    {
+        const char* p = static_cast<const char*>(ptr);
+        return fNumSlabs > 0 && p >= Arena() && p < Arena() + fNumSlabs * kSlabSize;
+    }
+    size_type ClassOf(const void* ptr) const
+    {
+        return Table()[(static_cast<const char*>(ptr) - Arena()) / kSlabSize].load(std::memory_order_acquire);
+    }
+    size_type NumUncarvedSlabs() const
+    {
+        return fNumSlabs - std::min<size_type>(fNextSlab.load(std::memory_order_relaxed), fNumSlabs);
+    }
+
+    void* SlabAllocate(size_type sizeClass)
+    {
+        FreeList& list = fClasses[sizeClass];
+        while (true) {
+            if (char* chunk = Pop(list)) {
+                return chunk;
+            }
+            if (!Carve(sizeClass)) {
+                return Pop(list); // arena exhausted, but another thread/process might have freed a chunk meanwhile
+            }
+        }
+    }
+
+    // assign the next uncarved slab to the size class and push all its chunks at once
+    bool Carve(size_type sizeClass)
+    {
+        if (fNextSlab.load(std::memory_order_relaxed) >= fNumSlabs) {
+            return false; // checked first to keep fNextSlab from wrapping around
+        }
+        const uint32_t slab = fNextSlab.fetch_add(1, std::memory_order_relaxed);
+        if (slab >= fNumSlabs) {
+            return false;
+        }
+        Table()[slab].store(static_cast<uint8_t>(sizeClass), std::memory_order_release);
+
+        const size_type chunkSize = ClassSize(sizeClass);
+        const size_type numChunks = kSlabSize / chunkSize;
+        char* first = Arena() + slab * kSlabSize;
+        for (size_type i = 0; i + 1 < numChunks; ++i) {
+            new (first + i * chunkSize) std::atomic<uint64_t>(Offset(first + (i + 1) * chunkSize));
+        }
+        char* last = first + (numChunks - 1) * chunkSize;
+        new (last) std::atomic<uint64_t>(0);
+        Push(fClasses[sizeClass], first, last, numChunks);
+        return true;
+    }
+
+    char* Pop(FreeList& list)
+    {
+        uint64_t head = list.fHead.load(std::memory_order_acquire);
+        while ((head & kOffsetMask) != 0) {
+            char* chunk = Segment() + (head & kOffsetMask);
+            // the chunk may be popped and reused concurrently, the tag makes the exchange fail in that case
+            const uint64_t next = Next(chunk).load(std::memory_order_relaxed);
+            const uint64_t newHead = (next & kOffsetMask) | ((head + kTagUnit) & ~kOffsetMask);
+            if (list.fHead.compare_exchange_weak(head, newHead, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                list.fNumFree.fetch_sub(1, std::memory_order_relaxed);
+                return chunk;
+            }
+        }
+        return nullptr;
+    }
+
+    // push an already linked chain of chunks [first..last]
+    void Push(FreeList& list, char* first, char* last, size_type num)
+    {
+        if (first == last) {
+            new (first) std::atomic<uint64_t>(0);
+        }
+        uint64_t head = list.fHead.load(std::memory_order_relaxed);
+        uint64_t newHead = 0;
+        do {
+            Next(last).store(head & kOffsetMask, std::memory_order_relaxed);
+            newHead = Offset(first) | ((head + kTagUnit) & ~kOffsetMask);
+        } while (!list.fHead.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed));
+        list.fNumFree.fetch_add(static_cast<int64_t>(num), std::memory_order_relaxed);
+    }
+
+    uint64_t fArenaOffset;
+    uint64_t fTableOffset;
+    uint64_t fNumSlabs;
+    std::atomic<uint32_t> fNextSlab;
+    FreeList fClasses[kNumClasses];
+};
+
+} // namespace fair::mq::shmem
+
+#endif /* FAIR_MQ_SHMEM_SEGREGATEDSLABALGORITHM_H_ */
@@ -11,9 +11,12 @@
 #include "Common.h"
 #include "Manager.h"
 #include "Message.h"
+#include "MetaRing.h"
 #include <fairmq/Error.h>              // for assertm
 #include <fairmq/Message.h>
+#include <fairmq/Probes.h>
 #include <fairmq/Socket.h>
+#include <fairmq/Tracing.h>
 #include <fairmq/tools/Strings.h>
 #include <fairmq/zeromq/Common.h>      // for zmq::HandleErrors, zmq::ShouldRetry
 #include <fairmq/zeromq/ZMsg.h>        // for zmq::ZMsg
@@ -22,12 +25,21 @@
 
 #include <zmq.h>
 
-#include <algorithm>         // for std::max
+#include <algorithm>         // for std::max, std::find
 #include <atomic>
+#include <chrono>
 #include <cstddef>           // for std::size_t
-#include <cstring>           // for std::memcpy
+#include <cstring>           // for std::memcpy, std::memset
+#include <deque>
 #include <exception>         // for std::terminate
+#include <limits>
 #include <memory>            // for std::make_unique
+#include <optional>
+#include <string>
+#include <thread>            // for std::thread::hardware_concurrency
+#include <vector>
+
+#include <unistd.h>          // for getpid
 
 namespace fair::mq {
     class TransportFactory;
@@ -43,24 +55,35 @@ class Socket final : public fair::mq::Socket
         : fair::mq::Socket(fac)
         , fManager(manager)
         , fId(id + "." + name + "." + type)
+        , fType(type)
         , fSocket(nullptr)
         , fMonitorSocket(nullptr)
         , fBytesTx(0)
         , fBytesRx(0)
         , fMessagesTx(0)
         , fMessagesRx(0)
+        , fRetriesTx(0)
+        , fRetriesRx(0)
         , fTimeout(100)
         , fConnectedPeersCount(0)
         , fMetadataMsgSize(manager.GetMetadataMsgSize())
+        , fContext(context)
+        , fNumEndpoints(0)
+        , fTxRing(nullptr)
+        , fRxRing(nullptr)
+        , fRingSpinMax(std::thread::hardware_concurrency() > 1 ? manager.GetMetaRingSpin() : 0) // spinning only delays the peer on a single core
+        , fRingSpin(fRingSpinMax)
+        , fPublisher(type == "pub" || type == "xpub")
+        , fSubscriber(type == "sub" || type == "xsub")
+        , fBlockingPub(manager.BlockingPub())
+        , fNumPubDrops(0)
     {
         assert(context);
 
-        if (type == "sub" || type == "pub") {
-            LOG(error) << "PUB/SUB socket type is not supported for shared memory transport";
-            throw SocketError("PUB/SUB socket type is not supported for shared memory transport");
-        }
-
-        fSocket = zmq_socket(context, zmq::getConstant(type));
+        // the publisher addresses each subscriber individually, so that every subscriber owns a reference to the published buffers:
+        // pub sockets are ROUTER sockets that track their subscribers, sub sockets are DEALER sockets that announce themselves to it
+        int zmqType = fPublisher ? ZMQ_ROUTER : (fSubscriber ? ZMQ_DEALER : zmq::getConstant(type));
+        fSocket = zmq_socket(context, zmqType);
         fMonitorSocket = zmq::makeMonitorSocket(context, fSocket, fId);
 
         if (fSocket == nullptr) {
@@ -68,7 +91,8 @@ class Socket final : public fair::mq::Socket
             throw SocketError(tools::ToString("Failed creating socket ", fId, ", reason: ", zmq_strerror(errno)));
         }
 
-        if (zmq_setsockopt(fSocket, ZMQ_IDENTITY, fId.c_str(), fId.length()) != 0) {
+        // subscribers get a unique identity from the publisher, a reconnecting subscriber must not clash with its previous connection
+        if (!fSubscriber && zmq_setsockopt(fSocket, ZMQ_IDENTITY, fId.c_str(), fId.length()) != 0) {
             LOG(error) << "Failed setting ZMQ_IDENTITY socket option, reason: " << zmq_strerror(errno);
         }
 
@@ -87,13 +111,20 @@ class Socket final : public fair::mq::Socket
             LOG(error) << "Failed setting ZMQ_RCVTIMEO socket option, reason: " << zmq_strerror(errno);
         }
 
-        // if (type == "sub")
-        // {
-        //     if (zmq_setsockopt(fSocket, ZMQ_SUBSCRIBE, nullptr, 0) != 0)
-        //     {
-        //         LOG(error) << "Failed setting ZMQ_SUBSCRIBE socket option, reason: " << zmq_strerror(errno);
-        //     }
-        // }
+        if (fPublisher) {
+            // fail instead of silently dropping when a subscriber is gone or at its high-water mark
+            int mandatory = 1;
+            if (zmq_setsockopt(fSocket, ZMQ_ROUTER_MANDATORY, &mandatory, sizeof(mandatory)) != 0) {
+                LOG(error) << "Failed setting ZMQ_ROUTER_MANDATORY socket option, reason: " << zmq_strerror(errno);
+            }
+        } else if (fSubscriber) {
+            // subscribe by sending an empty message to the publisher on every (re)connection
+            int probe = 1;
+            if (zmq_setsockopt(fSocket, ZMQ_PROBE_ROUTER, &probe, sizeof(probe)) != 0) {
+                LOG(error) << "Failed setting ZMQ_PROBE_ROUTER socket option, reason: " << zmq_strerror(errno);
+            }
+        }
+
         LOG(debug) << "Created socket " << GetId();
     }
 
@@ -106,16 +137,34 @@ class Socket final : public fair::mq::Socket
 
     bool Bind(const std::string& address) override
     {
-        return zmq::Bind(fSocket, address, fId);
+        if (!CheckMetaRingEndpoint(address)) {
+            return false;
+        }
+        return zmq::Bind(fSocket, address, fId) && AttachMetaRings(address, true);
     }
 
     bool Connect(const std::string& address) override
     {
-        return zmq::Connect(fSocket, address, fId);
+        if (!CheckMetaRingEndpoint(address)) {
+            return false;
+        }
+        return zmq::Connect(fSocket, address, fId) && AttachMetaRings(address, false);
     }
 
     int64_t Send(mq::MessagePtr& msg, int timeout = -1) override
     {
+        FAIRMQ_PROBE_SCOPE(send, 1);
+        if (fSubscriber) {
+            return Unsupported("Send");
+        } else if (fPublisher) {
+            int64_t result = Publish(&msg, 1, std::nullopt, timeout);
+            if (result >= 0) {
+                ++fMessagesTx;
+                fBytesTx += result;
+            }
+            return result;
+        }
+
         auto msgPtr = msg.get();
         if (!msgPtr) {
             return static_cast<int>(TransferCode::error);
@@ -131,13 +180,29 @@ class Socket final : public fair::mq::Socket
 
         MetaHeader meta{ shmMsg->fSize, shmMsg->fHint, shmMsg->fHandle, shmMsg->fShared, shmMsg->fRegionId, shmMsg->fSegmentId, shmMsg->fManaged };
 
-        // meta msg format: | MetaHeader | padded to fMetadataMsgSize |
-        zmq::ZMsg zmqMsg(std::max(fMetadataMsgSize, sizeof(MetaHeader)));
+        if (fTxRing) {
+            int64_t result = SendToRing(&meta, 1, timeout);
+            if (result < 0) {
+                return result;
+            }
+            shmMsg->fQueued = true;
+            ++fMessagesTx;
+            size_t size = msg->GetSize();
+            fBytesTx += size;
+            return size;
+        }
+
+        // meta msg format: | MetaHeader | [trace context] | padded to fMetadataMsgSize |
+        tracing::WireContext trace;
+        bool const traced = tracing::IsEnabled() && tracing::Outgoing(trace.fContext);
+        zmq::ZMsg zmqMsg(std::max(fMetadataMsgSize, sizeof(MetaHeader) + (traced ? sizeof(trace) : 0)));
         std::memcpy(zmqMsg.Data(), &meta, sizeof(MetaHeader));
+        WriteTrace(zmqMsg, sizeof(MetaHeader), traced ? &trace : nullptr);
 
         while (true) {
             int nbytes = zmq_msg_send(zmqMsg.Msg(), fSocket, flags);
             if (nbytes > 0) {
+                FAIRMQ_PROBE(meta_send, 1);
                 shmMsg->fQueued = true;
                 ++fMessagesTx;
                 size_t size = msg->GetSize();
@@ -146,7 +211,7 @@ class Socket final : public fair::mq::Socket
             } else if (zmq_errno() == EAGAIN || zmq_errno() == EINTR) {
                 if (fManager.Interrupted()) {
                     return static_cast<int>(TransferCode::interrupted);
-                } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed)) {
+                } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed, fRetriesTx)) {
                     continue;
                 } else {
                     return static_cast<int>(TransferCode::timeout);
@@ -161,6 +226,30 @@ class Socket final : public fair::mq::Socket
 
     int64_t Receive(MessagePtr& msg, int timeout = -1) override
     {
+        FAIRMQ_PROBE_SCOPE(receive, 1);
+        if (fPublisher) {
+            return Unsupported("Receive");
+        } else if (fRxRing) {
+            Message* shmMsg = static_cast<Message*>(msg.get());
+            int64_t result = ReceiveFromRing([&](const MetaHeader& meta) { shmMsg->SetMeta(meta); }, 1, timeout);
+            if (result < 0) {
+                return result;
+            }
+            size_t size = shmMsg->GetSize();
+            fBytesRx += size;
+            ++fMessagesRx;
+            return size;
+        }
+
+        Message* shmMsg = static_cast<Message*>(msg.get());
+        if (!fRxPending.empty()) {
+            shmMsg->SetMeta(PopPendingRx());
+            size_t size = shmMsg->GetSize();
+            fBytesRx += size;
+            ++fMessagesRx;
+            return size;
+        }
+
         int flags = 0;
         if (timeout == 0) {
             flags = ZMQ_DONTWAIT;
@@ -168,9 +257,7 @@ class Socket final : public fair::mq::Socket
         int elapsed = 0;
 
         while (true) {
-            Message* shmMsg = static_cast<Message*>(msg.get());
-            MetaHeader meta;
-            int nbytes = zmq_recv(fSocket, &meta, sizeof(MetaHeader), flags);
+            int nbytes = zmq_msg_recv(fRxFrame.Msg(), fSocket, flags);
             if (nbytes > 0) {
                 // check for number of received messages. must be 1
                 if (static_cast<std::size_t>(nbytes) < sizeof(MetaHeader)) {
@@ -179,8 +266,19 @@ class Socket final : public fair::mq::Socket
                             "Possibly due to a misconfigured transport on the sender side. ",
                             "Expected minimum size of ", sizeof(MetaHeader), " bytes, received ", nbytes));
                 }
-
-                shmMsg->SetMeta(meta);
+                if (*static_cast<std::size_t*>(fRxFrame.Data()) & kBatchFlag) {
+                    // the first message of the batch is returned, the others stay in the socket for the next receive calls
+                    QueueBatch(fRxFrame);
+                    shmMsg->SetMeta(PopPendingRx());
+                } else {
+                    FAIRMQ_PROBE(meta_recv, 1);
+                    if (tracing::IsEnabled()) {
+                        ReadTrace(fRxFrame.Data(), fRxFrame.Size(), sizeof(MetaHeader));
+                    }
+                    MetaHeader meta;
+                    std::memcpy(&meta, fRxFrame.Data(), sizeof(MetaHeader));
+                    shmMsg->SetMeta(meta);
+                }
 
                 size_t size = shmMsg->GetSize();
                 fBytesRx += size;
@@ -189,7 +287,7 @@ class Socket final : public fair::mq::Socket
             } else if (zmq_errno() == EAGAIN || zmq_errno() == EINTR) {
                 if (fManager.Interrupted()) {
                     return static_cast<int>(TransferCode::interrupted);
-                } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed)) {
+                } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed, fRetriesRx)) {
                     continue;
                 } else {
                     return static_cast<int>(TransferCode::timeout);
@@ -202,15 +300,32 @@ class Socket final : public fair::mq::Socket
 
     int64_t Send(Parts::container& msgVec, int timeout = -1) override
     {
+        FAIRMQ_PROBE_SCOPE(send, msgVec.size());
+        if (fSubscriber) {
+            return Unsupported("Send");
+        } else if (fPublisher) {
+            int64_t result = Publish(msgVec.data(), msgVec.size(), msgVec.size(), timeout);
+            if (result >= 0) {
+                fMessagesTx++;
+                fBytesTx += result;
+            }
+            return result;
+        } else if (fTxRing) {
+            return SendPartsToRing(msgVec, timeout);
+        }
+
         int flags = 0;
         if (timeout == 0) {
             flags = ZMQ_DONTWAIT;
         }
         int elapsed = 0;
 
-        // meta msg format: | n | MetaHeader 1 | ... | MetaHeader n | padded to fMetadataMsgSize |
+        // meta msg format: | n | MetaHeader 1 | ... | MetaHeader n | [trace context] | padded to fMetadataMsgSize |
         auto const n = msgVec.size();
-        zmq::ZMsg zmqMsg(std::max(fMetadataMsgSize, sizeof(std::size_t) + n * sizeof(MetaHeader)));
+        tracing::WireContext trace;
+        bool const traced = tracing::IsEnabled() && tracing::Outgoing(trace.fContext);
+        zmq::ZMsg zmqMsg(std::max(fMetadataMsgSize, sizeof(std::size_t) + n * sizeof(MetaHeader) + (traced ? sizeof(trace) : 0)));
+        WriteTrace(zmqMsg, sizeof(std::size_t) + n * sizeof(MetaHeader), traced ? &trace : nullptr);
 
         auto meta_n = static_cast<std::size_t*>(zmqMsg.Data());
         *meta_n = n;
@@ -232,6 +347,7 @@ class Socket final : public fair::mq::Socket
             int nbytes = zmq_msg_send(zmqMsg.Msg(), fSocket, flags);
             if (nbytes > 0) {
                 assert(static_cast<unsigned int>(nbytes) >= sizeof(std::size_t) + (n * sizeof(MetaHeader)));
+                FAIRMQ_PROBE(meta_send, n);
 
                 for (auto& msg : msgVec) {
                     Message* shmMsg = static_cast<Message*>(msg.get());
@@ -247,7 +363,7 @@ class Socket final : public fair::mq::Socket
             } else if (zmq_errno() == EAGAIN || zmq_errno() == EINTR) {
                 if (fManager.Interrupted()) {
                     return static_cast<int>(TransferCode::interrupted);
-                } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed)) {
+                } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed, fRetriesTx)) {
                     continue;
                 } else {
                     return static_cast<int>(TransferCode::timeout);
@@ -262,6 +378,28 @@ class Socket final : public fair::mq::Socket
 
     int64_t Receive(Parts::container& msgVec, int timeout = -1) override
     {
+        FAIRMQ_PROBE_SCOPE(receive, msgVec.size());
+        if (fPublisher) {
+            return Unsupported("Receive");
+        } else if (fRxRing) {
+            std::size_t totalSize = 0;
+            auto const transport = GetTransport();
+            int64_t result = ReceiveFromRing([&](const MetaHeader& meta) {
+                MetaHeader hdr = meta;
+                msgVec.push_back(std::make_unique<Message>(fManager, hdr, transport));
+                totalSize += hdr.fSize;
+            }, UINT32_MAX, timeout);
+            if (result < 0) {
+                return result;
+            }
+            // store statistics on how many messages have been received (handle all parts as a single message)
+            fMessagesRx++;
+            fBytesRx += totalSize;
+            return totalSize;
+        } else if (!fRxPending.empty()) {
+            return ReceivePendingPart(msgVec);
+        }
+
         int flags = 0;
         if (timeout == 0) {
             flags = ZMQ_DONTWAIT;
@@ -278,7 +416,16 @@ class Socket final : public fair::mq::Socket
                 assert(size > sizeof(std::size_t));
                 auto meta_n = static_cast<std::size_t*>(zmqMsg.Data());
                 auto const n = *meta_n;
+                if (n & kBatchFlag) {
+                    // the messages of a batch are received one at a time, as single parts
+                    QueueBatch(zmqMsg);
+                    return ReceivePendingPart(msgVec);
+                }
                 assert(size >= sizeof(std::size_t) + n * sizeof(MetaHeader));
+                FAIRMQ_PROBE(meta_recv, n);
+                if (tracing::IsEnabled()) {
+                    ReadTrace(zmqMsg.Data(), size, sizeof(std::size_t) + n * sizeof(MetaHeader));
+                }
                 ++meta_n;
                 auto metas = static_cast<MetaHeader*>(static_cast<void*>(meta_n));
                 msgVec.reserve(msgVec.size() + n);
@@ -300,7 +447,7 @@ class Socket final : public fair::mq::Socket
             } else if (zmq_errno() == EAGAIN || zmq_errno() == EINTR) {
                 if (fManager.Interrupted()) {
                     return static_cast<int>(TransferCode::interrupted);
-                } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed)) {
+                } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed, fRetriesRx)) {
                     continue;
                 } else {
                     return static_cast<int>(TransferCode::timeout);
@@ -313,12 +460,389 @@ class Socket final : public fair::mq::Socket
         return static_cast<int>(TransferCode::error);
     }
 
+    /// receives the metadata of all parts at once and hands out (data pointer, size) handles,
+    /// messages are created only for the parts that are taken out of the view
+    int64_t Receive(PartsView& view, int timeout = -1) override
+    {
+        if (fPublisher) {
+            return Unsupported("Receive");
+        }
+
+        auto& backend = view.PrepareBackend<ViewBackend>();
+        backend.fManager = &fManager;
+        backend.fTransport = GetTransport();
+
+        std::size_t n = 0;
+        if (fRxRing) {
+            int64_t result = ReceiveFromRing([&](const MetaHeader& meta) { backend.fRingMetas.push_back(meta); }, UINT32_MAX, timeout);
+            if (result < 0) {
+                return result;
+            }
+            n = backend.fRingMetas.size();
+            backend.fMetas = backend.fRingMetas.data();
+        } else if (!fRxPending.empty()) {
+            backend.fRingMetas.push_back(PopPendingRx());
+            n = 1;
+            backend.fMetas = backend.fRingMetas.data();
+        } else {
+            int flags = 0;
+            if (timeout == 0) {
+                flags = ZMQ_DONTWAIT;
+            }
+            int elapsed = 0;
+
+            while (true) {
+                // the metadata stays in the received frame, which is kept by the view until the next receive
+                int nbytes = zmq_msg_recv(backend.fFrame.Msg(), fSocket, flags);
+                if (nbytes > 0) {
+                    [[maybe_unused]] auto const size = backend.fFrame.Size();
+                    assert(size > sizeof(std::size_t));
+                    auto meta_n = static_cast<std::size_t*>(backend.fFrame.Data());
+                    n = *meta_n;
+                    if (n & kBatchFlag) {
+                        // the messages of a batch are received one at a time, as single parts
+                        QueueBatch(backend.fFrame);
+                        backend.fRingMetas.push_back(PopPendingRx());
+                        n = 1;
+                        backend.fMetas = backend.fRingMetas.data();
+                        break;
+                    }
+                    assert(size >= sizeof(std::size_t) + n * sizeof(MetaHeader));
+                    if (tracing::IsEnabled()) {
+                        ReadTrace(backend.fFrame.Data(), size, sizeof(std::size_t) + n * sizeof(MetaHeader));
+                    }
+                    ++meta_n;
+                    backend.fMetas = static_cast<MetaHeader*>(static_cast<void*>(meta_n));
+                    break;
+                } else if (zmq_errno() == EAGAIN || zmq_errno() == EINTR) {
+                    if (fManager.Interrupted()) {
+                        return static_cast<int>(TransferCode::interrupted);
+                    } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed, fRetriesRx)) {
+                        continue;
+                    } else {
+                        return static_cast<int>(TransferCode::timeout);
+                    }
+                } else {
+                    return zmq::HandleErrors(fId);
+                }
+            }
+        }
+
+        // consecutive parts usually come from the same segment/region, look it up only on change
+        view.Reserve(n);
+        std::size_t totalSize = 0;
+        int segmentId = -1;
+        int regionId = -1;
+        UnmanagedRegion* region = nullptr;
+        for (std::size_t i = 0; i < n; ++i) {
+            const MetaHeader& meta = backend.fMetas[i];
+            char* data = nullptr;
+            if (meta.fManaged) {
+                if (meta.fSize > 0) {
+                    if (meta.fSegmentId != segmentId) {
+                        fManager.GetSegment(meta.fSegmentId);
+                        segmentId = meta.fSegmentId;
+                    }
+                    data = ShmHeader::UserPtr(fManager.GetAddressFromHandle(meta.fHandle, meta.fSegmentId));
+                }
+            } else {
+                if (meta.fRegionId != regionId) {
+                    region = fManager.GetRegionFromCache(meta.fRegionId);
+                    regionId = meta.fRegionId;
+                }
+                if (region) {
+                    data = static_cast<char*>(region->GetData()) + meta.fHandle;
+                }
+            }
+            view.AddPart(data, meta.fSize);
+            totalSize += meta.fSize;
+        }
+
+        // store statistics on how many messages have been received (handle all parts as a single message)
+        fMessagesRx++;
+        fBytesRx += totalSize;
+        return totalSize;
+    }
+
+    int64_t SendBatch(std::vector<MessagePtr>& msgs, int timeout = -1) override
+    {
+        if (fSubscriber) {
+            return Unsupported("SendBatch");
+        } else if (msgs.empty()) {
+            return 0;
+        } else if (fPublisher) {
+            // the whole batch goes to each subscriber in one metadata msg
+            auto const n = msgs.size();
+            int64_t result = Publish(msgs.data(), n, n | kBatchFlag, timeout);
+            if (result < 0) {
+                return result;
+            }
+            fMessagesTx += n;
+            fBytesTx += result;
+            return n;
+        } else if (fTxRing) {
+            return SendBatchToRing(msgs, timeout);
+        } else if (msgs.size() == 1) {
+            int64_t result = Send(msgs.front(), timeout);
+            return result < 0 ? result : 1;
+        }
+
+        int flags = 0;
+        if (timeout == 0) {
+            flags = ZMQ_DONTWAIT;
+        }
+        int elapsed = 0;
+
+        // batch msg format: | n + kBatchFlag | MetaHeader 1 | ... | MetaHeader n | padded to fMetadataMsgSize |
+        auto const n = msgs.size();
+        zmq::ZMsg zmqMsg(std::max(fMetadataMsgSize, sizeof(std::size_t) + n * sizeof(MetaHeader)));
+
+        auto meta_n = static_cast<std::size_t*>(zmqMsg.Data());
+        *meta_n = n | kBatchFlag;
+        ++meta_n;
+        auto metas = static_cast<MetaHeader*>(static_cast<void*>(meta_n));
+        for (auto& msg : msgs) {
+            auto msgPtr = msg.get();
+            if (!msgPtr) {
+                return static_cast<int>(TransferCode::error);
+            }
+            assertm(dynamic_cast<shmem::Message*>(msgPtr), "given mq::Message is a shmem::Message");   // NOLINT
+            auto shmMsg = static_cast<shmem::Message*>(msgPtr);   // NOLINT(cppcoreguidelines-pro-type-static-cast-downcast)
+            MetaHeader meta{ shmMsg->fSize, shmMsg->fHint, shmMsg->fHandle, shmMsg->fShared, shmMsg->fRegionId, shmMsg->fSegmentId, shmMsg->fManaged };
+            std::memcpy(metas++, &meta, sizeof(MetaHeader));
+        }
+
+        while (true) {
+            int nbytes = zmq_msg_send(zmqMsg.Msg(), fSocket, flags);
+            if (nbytes > 0) {
+                int64_t totalSize = 0;
+                for (auto& msg : msgs) {
+                    Message* shmMsg = static_cast<Message*>(msg.get());
+                    shmMsg->fQueued = true;
+                    totalSize += shmMsg->fSize;
+                }
+                // the messages of a batch are counted individually
+                fMessagesTx += n;
+                fBytesTx += totalSize;
+                return n;
+            } else if (zmq_errno() == EAGAIN || zmq_errno() == EINTR) {
+                if (fManager.Interrupted()) {
+                    return static_cast<int>(TransferCode::interrupted);
+                } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed, fRetriesTx)) {
+                    continue;
+                } else {
+                    return static_cast<int>(TransferCode::timeout);
+                }
+            } else {
+                return zmq::HandleErrors(fId);
+            }
+        }
+    }
+
+    int64_t ReceiveBatch(std::vector<MessagePtr>& msgs, std::size_t maxMessages, int timeout = -1) override
+    {
+        if (fPublisher) {
+            return Unsupported("ReceiveBatch");
+        } else if (maxMessages == 0) {
+            return 0;
+        } else if (fRxRing) {
+            return ReceiveBatchFromRing(msgs, maxMessages, timeout);
+        }
+
+        int flags = 0;
+        if (timeout == 0) {
+            flags = ZMQ_DONTWAIT;
+        }
+        int elapsed = 0;
+
+        zmq::ZMsg zmqMsg;
+        auto const transport = GetTransport();
+        std::size_t numReceived = 0;
+        std::size_t totalSize = 0;
+
+        // messages left over from a batch received before come first
+        for (; numReceived < maxMessages && !fRxPending.empty(); ++numReceived) {
+            msgs.push_back(std::make_unique<Message>(fManager, fRxPending.front(), transport));
+            totalSize += fRxPending.front().fSize;
+            fRxPending.pop_front();
+        }
+
+        // accepts batches as well as single messages, waits only for the first one.
+        // Messages of a batch beyond maxMessages stay in the socket for the next receive calls.
+        while (numReceived < maxMessages) {
+            int nbytes = zmq_msg_recv(zmqMsg.Msg(), fSocket, numReceived == 0 ? flags : ZMQ_DONTWAIT);
+            if (nbytes > 0) {
+                auto const size = zmqMsg.Size();
+                if (size < sizeof(std::size_t)) {
+                    throw SocketError(tools::ToString("Received message is not a valid FairMQ shared memory message, size: ", size));
+                }
+                // either a batch: | n + kBatchFlag | MetaHeader 1 | ... | MetaHeader n |, or a single message: | MetaHeader |
+                auto meta_n = static_cast<std::size_t*>(zmqMsg.Data());
+                std::size_t n = 1;
+                std::size_t headerSize = 0;
+                if (*meta_n & kBatchFlag) {
+                    n = *meta_n & ~kBatchFlag;
+                    headerSize = sizeof(std::size_t);
+                    ++meta_n;
+                }
+                if (size < headerSize + n * sizeof(MetaHeader)) {
+                    throw SocketError(tools::ToString("Received message is not a valid FairMQ shared memory message. ",
+                                                      "Expected ", n, " metadata headers, received ", size, " bytes"));
+                }
+                auto metas = static_cast<MetaHeader*>(static_cast<void*>(meta_n));
+                msgs.reserve(msgs.size() + std::min(n, maxMessages - numReceived));
+                for (std::size_t i = 0; i < n; ++i, ++metas) {
+                    if (numReceived == maxMessages) {
+                        fRxPending.insert(fRxPending.end(), metas, metas + (n - i));
+                        break;
+                    }
+                    msgs.push_back(std::make_unique<Message>(fManager, *metas, transport));
+                    totalSize += metas->fSize;
+                    ++numReceived;
+                }
+            } else if (numReceived > 0) {
+                break;
+            } else if (zmq_errno() == EAGAIN || zmq_errno() == EINTR) {
+                if (fManager.Interrupted()) {
+                    return static_cast<int>(TransferCode::interrupted);
+                } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed, fRetriesRx)) {
+                    continue;
+                } else {
+                    return static_cast<int>(TransferCode::timeout);
+                }
+            } else {
+                return zmq::HandleErrors(fId);
+            }
+        }
+
+        fMessagesRx += numReceived;
+        fBytesRx += totalSize;
+        return numReceived;
+    }
+
+    int64_t SendToAll(const std::vector<fair::mq::Socket*>& sockets, MessagePtr& msg, int timeout = -1) override
+    {
+        if (!CanShareMetadata(sockets)) {
+            return fair::mq::Socket::SendToAll(sockets, msg, timeout);
+        }
+        return FanOut(sockets, &msg, 1, std::nullopt, timeout);
+    }
+
+    int64_t SendToAll(const std::vector<fair::mq::Socket*>& sockets, Parts::container& msgVec, int timeout = -1) override
+    {
+        if (!CanShareMetadata(sockets)) {
+            return fair::mq::Socket::SendToAll(sockets, msgVec, timeout);
+        }
+        return FanOut(sockets, msgVec.data(), msgVec.size(), msgVec.size(), timeout);
+    }
+
+    /// passes the metadata msg on to the destination as it is, if the destination is a socket of the same session:
+    /// the buffers change hands without creating (or touching) message objects. Falls back to receive & send otherwise.
+    int64_t Forward(fair::mq::Socket& destination, bool multipart, int timeout = -1, int sndTimeout = -1) override
+    {
+        auto dest = dynamic_cast<Socket*>(&destination);
+        if (!dest || &dest->fManager != &fManager || fRxRing || dest->fTxRing || !fRxPending.empty()
+            || fPublisher || fSubscriber || dest->fPublisher || dest->fSubscriber) {
+            return fair::mq::Socket::Forward(destination, multipart, timeout, sndTimeout);
+        }
+
+        int flags = 0;
+        if (timeout == 0) {
+            flags = ZMQ_DONTWAIT;
+        }
+        int elapsed = 0;
+
+        while (true) {
+            int nbytes = zmq_msg_recv(fForwardFrame.Msg(), fSocket, flags);
+            if (nbytes > 0) {
+                break;
+            } else if (zmq_errno() == EAGAIN || zmq_errno() == EINTR) {
+                if (fManager.Interrupted()) {
+                    return static_cast<int>(TransferCode::interrupted);
+                } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed, fRetriesRx)) {
+                    continue;
+                } else {
+                    return static_cast<int>(TransferCode::timeout);
+                }
+            } else {
+                return zmq::HandleErrors(fId);
+            }
+        }
+
+        // | n + kBatchFlag | MetaHeader*n | (batch), | n | MetaHeader*n | (multipart) or | MetaHeader | (single)
+        auto const size = fForwardFrame.Size();
+        if (size < sizeof(std::size_t)) {
+            throw SocketError(tools::ToString("Received message is not a valid FairMQ shared memory message, size: ", size));
+        }
+        auto meta_n = static_cast<std::size_t*>(fForwardFrame.Data());
+        std::size_t n = 1;
+        std::size_t numMessages = 1; // as counted by the receiving/sending calls: a batch counts every message, multipart ones once
+        std::size_t headerSize = 0;
+        if (*meta_n & kBatchFlag) {
+            n = *meta_n & ~kBatchFlag;
+            numMessages = n;
+            headerSize = sizeof(std::size_t);
+        } else if (multipart) {
+            n = *meta_n;
+            headerSize = sizeof(std::size_t);
+        }
+        if (size < headerSize + n * sizeof(MetaHeader)) {
+            throw SocketError(tools::ToString("Received message is not a valid FairMQ shared memory message. ",
+                                              "Expected ", n, " metadata headers, received ", size, " bytes"));
+        }
+        auto metas = static_cast<MetaHeader*>(static_cast<void*>(static_cast<char*>(fForwardFrame.Data()) + headerSize));
+        int64_t totalSize = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            totalSize += metas[i].fSize;
+        }
+        fMessagesRx += numMessages;
+        fBytesRx += totalSize;
+
+        int64_t result = dest->SendMetaMsg(fForwardFrame, sndTimeout);
+        if (result < 0) {
+            // nobody took over the buffers, release them
+            for (std::size_t i = 0; i < n; ++i) {
+                MetaHeader meta;
+                std::memcpy(&meta, metas + i, sizeof(MetaHeader));
+                Message msg(fManager, meta, GetTransport());
+            }
+            return result;
+        }
+        dest->fMessagesTx += numMessages;
+        dest->fBytesTx += totalSize;
+        return totalSize;
+    }
+
     void* GetSocket() const { return fSocket; }
+    MetaRing* GetTxRing() const { return fTxRing; }
+    MetaRing* GetRxRing() const { return fRxRing; }
+    bool HasPendingRx() const { return !fRxPending.empty(); }
+    /// pub sockets: number of subscribers that have announced themselves
+    std::size_t GetNumberOfSubscribers()
+    {
+        UpdateSubscribers();
+        return fSubscribers.size();
+    }
+    /// pub sockets: number of times a subscriber missed a message because it was at its high-water mark
+    unsigned long GetNumberOfDroppedMessages() const { return fNumPubDrops; }
 
     void Close() override
     {
         // LOG(debug) << "Closing socket " << fId;
 
+        DetachMetaRings();
+
+        // release the buffers of the messages that were not taken out of a received batch
+        for (auto& meta : fRxPending) {
+            Message msg(fManager, meta);
+        }
+        fRxPending.clear();
+
+        if (fNumPubDrops > 0) {
+            LOG(debug) << "Socket " << fId << ": subscribers missed " << fNumPubDrops << " messages at their high-water mark";
+            fNumPubDrops = 0;
+        }
+
         if (fSocket && zmq_close(fSocket) != 0) {
             LOG(error) << "Failed closing data socket " << fId
                        << ", reason: " << zmq_strerror(errno);
@@ -355,6 +879,16 @@ class Socket final : public fair::mq::Socket
 
     int Events(uint32_t* events) override
     {
+        if (fTxRing || fRxRing) {
+            *events = 0;
+            if (fRxRing && fRxRing->HasData()) {
+                *events |= ZMQ_POLLIN;
+            }
+            if (fTxRing && fTxRing->HasSpace()) {
+                *events |= ZMQ_POLLOUT;
+            }
+            return 0;
+        }
         size_t eventsSize = sizeof(uint32_t);
         return zmq_getsockopt(fSocket, ZMQ_EVENTS, events, &eventsSize);
     }
@@ -447,6 +981,8 @@ class Socket final : public fair::mq::Socket
     unsigned long GetBytesRx() const override { return fBytesRx; }
     unsigned long GetMessagesTx() const override { return fMessagesTx; }
     unsigned long GetMessagesRx() const override { return fMessagesRx; }
+    unsigned long GetRetriesTx() const override { return fRetriesTx; }
+    unsigned long GetRetriesRx() const override { return fRetriesRx; }
 
     [[deprecated("Use fair::mq::zmq::getConstant() from <fairmq/zeromq/Common.h> instead.")]]
     static int GetConstant(const std::string& constant) { return zmq::getConstant(constant); }
@@ -456,16 +992,592 @@ class Socket final : public fair::mq::Socket
   private:
     Manager& fManager;
     std::string fId;
+    std::string fType;
     void* fSocket;
     void* fMonitorSocket;
     std::atomic<unsigned long> fBytesTx;
     std::atomic<unsigned long> fBytesRx;
     std::atomic<unsigned long> fMessagesTx;
     std::atomic<unsigned long> fMessagesRx;
+    std::atomic<unsigned long> fRetriesTx;
+    std::atomic<unsigned long> fRetriesRx;
 
     int fTimeout;
     mutable unsigned long fConnectedPeersCount;
     std::size_t fMetadataMsgSize;
+
+    static constexpr std::size_t kBatchFlag = std::size_t(1) << (sizeof(std::size_t) * 8 - 1); // marks the count of a batch in the metadata msg
+
+    /// write the trace context after the MetaHeader(s) of the metadata msg (see fair::mq::tracing),
+    /// without one clear the magic in the padding, where a stale one could be left from a previous msg
+    static void WriteTrace(zmq::ZMsg& zmqMsg, std::size_t offset, const tracing::WireContext* trace)
+    {
+        auto at = static_cast<char*>(zmqMsg.Data()) + offset;
+        if (trace) {
+            std::memcpy(at, trace, sizeof(tracing::WireContext));
+        } else if (zmqMsg.Size() >= offset + sizeof(tracing::WireContext)) {
+            std::memset(at, 0, sizeof(tracing::kMagic));
+        }
+    }
+
+    static void ReadTrace(const void* data, std::size_t size, std::size_t offset)
+    {
+        if (size < offset + sizeof(tracing::WireContext)) {
+            return;
+        }
+        tracing::WireContext trace;
+        std::memcpy(&trace, static_cast<const char*>(data) + offset, sizeof(trace));
+        if (trace.fMagic == tracing::kMagic) {
+            tracing::Incoming(trace.fContext);
+        }
+    }
+
+    void* fContext; // ZeroMQ context of the socket, the scope of its inproc endpoints
+    int fNumEndpoints;
+    MetaRing* fTxRing;
+    MetaRing* fRxRing;
+    std::vector<std::pair<std::string, MetaRing*>> fRings; // attached rings, by name
+    unsigned int fRingSpinMax;
+    unsigned int fRingSpin;
+    std::vector<MetaHeader> fTxMetas; // reused for multipart/batch sends to the ring and to subscribers
+    zmq::ZMsg fForwardFrame; // reused by Forward()
+    zmq::ZMsg fRxFrame; // reused by the single message Receive()
+    std::deque<MetaHeader> fRxPending; // messages of a received batch that were not taken yet by the receive calls
+
+    bool fPublisher;
+    bool fSubscriber;
+    bool fBlockingPub; // wait for subscribers at their high-water mark instead of dropping the message for them
+    std::atomic<unsigned long> fNumPubDrops;
+    std::vector<std::string> fSubscribers; // identities of the subscribers of a pub socket
+
+    // owns the parts of a PartsView through their metadata: within the received frame, or copied from the ring or from a batch
+    struct ViewBackend : PartsView::Backend
+    {
+        MessagePtr Take(std::size_t index) override { return std::make_unique<Message>(*fManager, fMetas[index], fTransport); }
+        void Release(std::size_t index) override { Message msg(*fManager, fMetas[index]); } // the buffer is released with msg
+        void Clear() override
+        {
+            fMetas = nullptr;
+            fRingMetas.clear();
+        }
+
+        Manager* fManager = nullptr;
+        fair::mq::TransportFactory* fTransport = nullptr;
+        MetaHeader* fMetas = nullptr;
+        std::vector<MetaHeader> fRingMetas;
+        zmq::ZMsg fFrame;
+    };
+
+    int64_t Unsupported(const char* operation) const
+    {
+        LOG(error) << operation << "() is not supported on socket " << fId << " of type " << fType;
+        return static_cast<int>(TransferCode::error);
+    }
+
+    /// keeps the messages of a received batch (| n + kBatchFlag | MetaHeader 1 | ... | MetaHeader n |) in the socket,
+    /// for the receive calls that take one message at a time
+    void QueueBatch(zmq::ZMsg& frame)
+    {
+        auto meta_n = static_cast<std::size_t*>(frame.Data());
+        auto const n = *meta_n & ~kBatchFlag;
+        if (n == 0 || frame.Size() < sizeof(std::size_t) + n * sizeof(MetaHeader)) {
+            throw SocketError(tools::ToString("Received message is not a valid FairMQ shared memory message. ",
+                                              "Expected ", n, " metadata headers, received ", frame.Size(), " bytes"));
+        }
+        FAIRMQ_PROBE(meta_recv, n);
+        auto metas = static_cast<MetaHeader*>(static_cast<void*>(meta_n + 1));
+        fRxPending.insert(fRxPending.end(), metas, metas + n);
+    }
+
+    MetaHeader PopPendingRx()
+    {
+        MetaHeader meta = fRxPending.front();
+        fRxPending.pop_front();
+        return meta;
+    }
+
+    /// receives the next message kept from a batch as a single part
+    int64_t ReceivePendingPart(Parts::container& msgVec)
+    {
+        MetaHeader meta = PopPendingRx();
+        msgVec.push_back(std::make_unique<Message>(fManager, meta, GetTransport()));
+        fMessagesRx++;
+        fBytesRx += meta.fSize;
+        return meta.fSize;
+    }
+
+    /// subscribers announce themselves with an empty message on every (re)connection (ZMQ_PROBE_ROUTER),
+    /// disconnected subscribers are removed when sending to them fails
+    void UpdateSubscribers()
+    {
+        while (true) {
+            zmq::ZMsg identity;
+            if (zmq_msg_recv(identity.Msg(), fSocket, ZMQ_DONTWAIT) < 0) {
+                return;
+            }
+            bool more = zmq_msg_more(identity.Msg());
+            while (more) {
+                zmq::ZMsg frame;
+                if (zmq_msg_recv(frame.Msg(), fSocket, ZMQ_DONTWAIT) < 0) {
+                    break;
+                }
+                more = zmq_msg_more(frame.Msg());
+            }
+            std::string subscriber(static_cast<const char*>(identity.Data()), identity.Size());
+            if (std::find(fSubscribers.begin(), fSubscribers.end(), subscriber) == fSubscribers.end()) {
+                fSubscribers.push_back(std::move(subscriber));
+                LOG(debug) << "Socket " << fId << ": new subscriber, " << fSubscribers.size() << " in total";
+            }
+        }
+    }
+
+    /// sends the metadata of msgs to every subscriber, each of them receives its own reference to the buffers (the payload is not copied).
+    /// A subscriber at its high-water mark misses the message, unless shm-pub-policy is 'block', then it is waited for within the timeout.
+    /// @param header leading word of the metadata msg (number of parts, or of batched messages), none for single messages
+    /// @return total size of the messages, or TransferCode
+    int64_t Publish(MessagePtr* msgs, std::size_t n, std::optional<std::size_t> header, int timeout)
+    {
+        int64_t totalSize = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            auto msgPtr = msgs[i].get();
+            if (!msgPtr) {
+                return static_cast<int>(TransferCode::error);
+            }
+            assertm(dynamic_cast<shmem::Message*>(msgPtr), "given mq::Message is a shmem::Message");   // NOLINT
+            totalSize += msgPtr->GetSize();
+        }
+
+        UpdateSubscribers();
+
+        int flags = 0;
+        if (timeout == 0 || !fBlockingPub) {
+            flags = ZMQ_DONTWAIT;
+        }
+        int elapsed = 0;
+
+        // meta msg format as for Send/SendBatch: | [header] | MetaHeader 1 | ... | MetaHeader n | padded to fMetadataMsgSize |
+        std::size_t const headerSize = header ? sizeof(std::size_t) : 0;
+        std::size_t const metaMsgSize = std::max(fMetadataMsgSize, headerSize + n * sizeof(MetaHeader));
+        auto& metas = fTxMetas;
+        metas.resize(n);
+
+        auto subscriber = fSubscribers.begin();
+        while (subscriber != fSubscribers.end()) {
+            for (std::size_t i = 0; i < n; ++i) {
+                metas[i] = static_cast<Message*>(msgs[i].get())->Share();   // NOLINT(cppcoreguidelines-pro-type-static-cast-downcast)
+            }
+            zmq::ZMsg zmqMsg(metaMsgSize);
+            auto data = static_cast<char*>(zmqMsg.Data());
+            if (header) {
+                std::memcpy(data, &*header, headerSize);
+            }
+            std::memcpy(data + headerSize, metas.data(), n * sizeof(MetaHeader));
+            WriteTrace(zmqMsg, headerSize + n * sizeof(MetaHeader), nullptr);
+
+            bool gone = false;
+            int64_t result = SendToSubscriber(*subscriber, zmqMsg, flags, timeout, elapsed, gone);
+            if (result >= 0) {
+                ++subscriber;
+                continue;
+            }
+            // not delivered, release the references of this subscriber
+            for (auto& meta : metas) {
+                Message ref(fManager, meta);
+            }
+            if (gone) {
+                subscriber = fSubscribers.erase(subscriber);
+                LOG(debug) << "Socket " << fId << ": subscriber disconnected, " << fSubscribers.size() << " remaining";
+            } else if (result == static_cast<int>(TransferCode::timeout)) {
+                ++fNumPubDrops;
+                ++subscriber;
+            } else {
+                return result;
+            }
+        }
+
+        // the subscribers hold their own references now, release the one of the publisher
+        for (std::size_t i = 0; i < n; ++i) {
+            auto shmMsg = static_cast<Message*>(msgs[i].get());   // NOLINT(cppcoreguidelines-pro-type-static-cast-downcast)
+            shmMsg->Deallocate();
+            shmMsg->fQueued = true;
+        }
+        return totalSize;
+    }
+
+    /// the metadata can be shared among shmem sockets that send it as is (not pub sockets, which address each subscriber)
+    static bool CanShareMetadata(const std::vector<fair::mq::Socket*>& sockets)
+    {
+        for (auto socket : sockets) {
+            auto shmSocket = dynamic_cast<Socket*>(socket);
+            if (!shmSocket || shmSocket->fPublisher || shmSocket->fSubscriber) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// sends the same metadata to all sockets: the reference counts are raised once for all destinations (one atomic increment per part),
+    /// and the metadata msg is encoded once and shared by all destinations. The last destination takes over the reference of msgs.
+    /// @param header leading word of the metadata msg (number of parts), none for single messages
+    int64_t FanOut(const std::vector<fair::mq::Socket*>& sockets, MessagePtr* msgs, std::size_t n, std::optional<std::size_t> header, int timeout)
+    {
+        if (sockets.empty()) {
+            return 0;
+        }
+        // all destinations hold a reference to the buffers, the 16 bit reference count limits their number
+        if (sockets.size() > std::numeric_limits<uint16_t>::max()) {
+            throw SocketError(tools::ToString("SendToAll(): cannot share a shared memory message among ", sockets.size(),
+                                              " sockets, at most ", std::numeric_limits<uint16_t>::max(), " are supported"));
+        }
+        auto const numRefs = static_cast<uint16_t>(sockets.size() - 1);
+
+        int64_t totalSize = 0;
+        auto& metas = fTxMetas;
+        metas.clear();
+        metas.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            auto msgPtr = msgs[i].get();
+            if (!msgPtr) {
+                return static_cast<int>(TransferCode::error);
+            }
+            assertm(dynamic_cast<shmem::Message*>(msgPtr), "given mq::Message is a shmem::Message");   // NOLINT
+            auto shmMsg = static_cast<shmem::Message*>(msgPtr);   // NOLINT(cppcoreguidelines-pro-type-static-cast-downcast)
+            metas.push_back(shmMsg->Share(numRefs));
+            totalSize += shmMsg->fSize;
+        }
+
+        // meta msg format as for Send: | [header] | MetaHeader 1 | ... | MetaHeader n | [trace context] | padded to fMetadataMsgSize |
+        std::size_t const headerSize = header ? sizeof(std::size_t) : 0;
+        tracing::WireContext trace;
+        bool const traced = tracing::IsEnabled() && tracing::Outgoing(trace.fContext);
+        zmq::ZMsg zmqMsg(std::max(fMetadataMsgSize, headerSize + n * sizeof(MetaHeader) + (traced ? sizeof(trace) : 0)));
+        if (header) {
+            std::memcpy(zmqMsg.Data(), &*header, headerSize);
+        }
+        std::memcpy(static_cast<char*>(zmqMsg.Data()) + headerSize, metas.data(), n * sizeof(MetaHeader));
+        WriteTrace(zmqMsg, headerSize + n * sizeof(MetaHeader), traced ? &trace : nullptr);
+
+        int64_t failure = 0;
+        for (std::size_t d = 0; d < sockets.size(); ++d) {
+            auto dest = static_cast<Socket*>(sockets[d]);   // NOLINT(cppcoreguidelines-pro-type-static-cast-downcast)
+            bool const last = d + 1 == sockets.size();
+            int64_t result = 0;
+            if (dest->fTxRing) {
+                result = dest->SendToRing(metas.data(), static_cast<uint32_t>(n), timeout);
+            } else if (last) {
+                result = dest->SendMetaMsg(zmqMsg, timeout);
+            } else {
+                // long zmq messages are reference counted, the copy shares the buffer
+                zmq::ZMsg copy;
+                zmq_msg_copy(copy.Msg(), zmqMsg.Msg());
+                result = dest->SendMetaMsg(copy, timeout);
+            }
+
+            if (result >= 0) {
+                ++dest->fMessagesTx;
+                dest->fBytesTx += totalSize;
+                if (last) {
+                    for (std::size_t i = 0; i < n; ++i) {
+                        static_cast<Message*>(msgs[i].get())->fQueued = true;   // NOLINT(cppcoreguidelines-pro-type-static-cast-downcast)
+                    }
+                }
+            } else {
+                if (failure == 0) {
+                    failure = result;
+                }
+                // release the references of this destination, the last one leaves them with the caller
+                if (!last) {
+                    for (auto meta : metas) {
+                        Message ref(fManager, meta);
+                    }
+                }
+            }
+        }
+        return failure < 0 ? failure : totalSize;
+    }
+
+    /// @return number of bytes of the metadata msg, or TransferCode
+    int64_t SendMetaMsg(zmq::ZMsg& zmqMsg, int timeout)
+    {
+        int flags = 0;
+        if (timeout == 0) {
+            flags = ZMQ_DONTWAIT;
+        }
+        int elapsed = 0;
+
+        while (true) {
+            int nbytes = zmq_msg_send(zmqMsg.Msg(), fSocket, flags);
+            if (nbytes > 0) {
+                return nbytes;
+            } else if (zmq_errno() == EAGAIN || zmq_errno() == EINTR) {
+                if (fManager.Interrupted()) {
+                    return static_cast<int>(TransferCode::interrupted);
+                } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed, fRetriesTx)) {
+                    continue;
+                } else {
+                    return static_cast<int>(TransferCode::timeout);
+                }
+            } else {
+                return zmq::HandleErrors(fId);
+            }
+        }
+    }
+
+    /// @return number of sent bytes, TransferCode::timeout if the subscriber is at its high-water mark (for longer than the timeout),
+    /// or another TransferCode. gone is set if the subscriber has disconnected.
+    int64_t SendToSubscriber(const std::string& subscriber, zmq::ZMsg& zmqMsg, int flags, int timeout, int& elapsed, bool& gone)
+    {
+        while (true) {
+            // with ZMQ_ROUTER_MANDATORY the identity frame fails if the subscriber is unknown or cannot take the message
+            if (zmq_send(fSocket, subscriber.data(), subscriber.size(), flags | ZMQ_SNDMORE) >= 0) {
+                int nbytes = zmq_msg_send(zmqMsg.Msg(), fSocket, flags);
+                if (nbytes >= 0) {
+                    return nbytes;
+                }
+                return zmq::HandleErrors(fId);
+            } else if (zmq_errno() == EHOSTUNREACH) {
+                gone = true;
+                return static_cast<int>(TransferCode::error);
+            } else if (zmq_errno() == EAGAIN || zmq_errno() == EINTR) {
+                if (fManager.Interrupted()) {
+                    return static_cast<int>(TransferCode::interrupted);
+                } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed, fRetriesTx)) {
+                    continue;
+                } else {
+                    return static_cast<int>(TransferCode::timeout);
+                }
+            } else {
+                return zmq::HandleErrors(fId);
+            }
+        }
+    }
+
+    bool UsesMetaRing(const std::string& address) const
+    {
+        return fManager.MetaRingEnabled()
+            && (fType == "push" || fType == "pull" || fType == "pair")
+            && (address.compare(0, 6, "ipc://") == 0 || address.compare(0, 9, "inproc://") == 0);
+    }
+
+    /// metadata ring mode supports exactly one (ipc/inproc) endpoint per socket
+    bool CheckMetaRingEndpoint(const std::string& address)
+    {
+        if (fNumEndpoints > 0 && (!fRings.empty() || UsesMetaRing(address))) {
+            LOG(error) << "Socket " << fId << ": with shm-ring enabled, push/pull/pair sockets support only a single ipc/inproc endpoint, cannot add " << address;
+            return false;
+        }
+        ++fNumEndpoints;
+        return true;
+    }
+
+    bool AttachMetaRings(const std::string& address, bool bound)
+    {
+        if (!UsesMetaRing(address)) {
+            return true;
+        }
+        // the ring name is derived from the endpoint, pair sockets use one ring per direction.
+        // An inproc endpoint exists only within its ZeroMQ context, other processes or transports of the session
+        // can bind the same address: their rings are told apart by the process and context.
+        std::string endpoint(address);
+        if (address.compare(0, 9, "inproc://") == 0) {
+            endpoint += tools::ToString("@", getpid(), ".", fContext);
+        }
+        try {
+            if (fType == "push") {
+                fTxRing = AttachMetaRing(endpoint + ".0");
+            } else if (fType == "pull") {
+                fRxRing = AttachMetaRing(endpoint + ".0");
+            } else {
+                fTxRing = AttachMetaRing(endpoint + (bound ? ".0" : ".1"));
+                fRxRing = AttachMetaRing(endpoint + (bound ? ".1" : ".0"));
+            }
+        } catch (boost::interprocess::interprocess_exception& e) {
+            LOG(error) << "Socket " << fId << ": could not create metadata ring for " << address << ": " << e.what();
+            DetachMetaRings();
+            return false;
+        }
+        LOG(debug) << "Socket " << fId << " exchanges metadata via shared memory ring for " << address;
+        return true;
+    }
+
+    MetaRing* AttachMetaRing(const std::string& endpoint)
+    {
+        std::string name("ring_" + endpoint);
+        MetaRing* ring = fManager.AttachMetaRing(name);
+        fRings.emplace_back(name, ring);
+        return ring;
+    }
+
+    void DetachMetaRings()
+    {
+        fTxRing = nullptr;
+        fRxRing = nullptr;
+        for (auto& [name, ring] : fRings) {
+            try {
+                // messages that nobody received are released (as ZeroMQ would drop them after linger)
+                for (auto& meta : fManager.DetachMetaRing(name, ring)) {
+                    Message msg(fManager, meta, GetTransport());
+                }
+            } catch (boost::interprocess::interprocess_exception& e) {
+                LOG(error) << "Socket " << fId << ": could not detach from metadata ring " << name << ": " << e.what();
+            }
+        }
+        fRings.clear();
+    }
+
+    /// adapt the number of spin iterations: grow while spinning pays off, shrink when the wait ends up sleeping anyway
+    void AdaptRingSpin(bool spinSucceeded)
+    {
+        if (spinSucceeded) {
+            fRingSpin = std::min(fRingSpinMax, std::max(16U, fRingSpin * 2));
+        } else {
+            fRingSpin /= 2;
+        }
+    }
+
+    template<typename Try, typename Wait>
+    int64_t RingTransfer(Try tryTransfer, Wait wait, int timeout)
+    {
+        auto start = std::chrono::steady_clock::now();
+        while (true) {
+            int64_t result = tryTransfer();
+            if (result != 0) {
+                return result;
+            } else if (timeout == 0) {
+                return static_cast<int>(TransferCode::timeout);
+            } else if (fManager.Interrupted()) {
+                return static_cast<int>(TransferCode::interrupted);
+            }
+            int waitMs = fTimeout;
+            if (timeout > 0) {
+                int elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+                if (elapsed >= timeout) {
+                    return static_cast<int>(TransferCode::timeout);
+                }
+                waitMs = std::min(waitMs, timeout - elapsed);
+            }
+            AdaptRingSpin(wait(waitMs));
+        }
+    }
+
+    int64_t SendToRing(const MetaHeader* metas, uint32_t n, int timeout)
+    {
+        if (n > fTxRing->Capacity()) {
+            LOG(error) << "Socket " << fId << ": cannot send " << n << " parts, metadata ring capacity (shm-ring-capacity) is " << fTxRing->Capacity();
+            return static_cast<int>(TransferCode::error);
+        }
+        return RingTransfer([&]() -> int64_t { return fTxRing->TryPush(metas, n) ? 1 : 0; },
+                            [&](int waitMs) { return fTxRing->WaitForSpace(n, fRingSpin, waitMs); },
+                            timeout);
+    }
+
+    int64_t SendPartsToRing(Parts::container& msgVec, int timeout)
+    {
+        auto& metas = fTxMetas;
+        metas.clear();
+        metas.reserve(msgVec.size());
+        for (auto& msg : msgVec) {
+            auto msgPtr = msg.get();
+            if (!msgPtr) {
+                return static_cast<int>(TransferCode::error);
+            }
+            assertm(dynamic_cast<shmem::Message*>(msgPtr), "given mq::Message is a shmem::Message");   // NOLINT
+            auto shmMsg = static_cast<shmem::Message*>(msgPtr);   // NOLINT(cppcoreguidelines-pro-type-static-cast-downcast)
+            metas.push_back(MetaHeader{ shmMsg->fSize, shmMsg->fHint, shmMsg->fHandle, shmMsg->fShared, shmMsg->fRegionId, shmMsg->fSegmentId, shmMsg->fManaged });
+        }
+
+        int64_t result = SendToRing(metas.data(), static_cast<uint32_t>(metas.size()), timeout);
+        if (result < 0) {
+            return result;
+        }
+
+        int64_t totalSize = 0;
+        for (auto& msg : msgVec) {
+            Message* shmMsg = static_cast<Message*>(msg.get());
+            shmMsg->fQueued = true;
+            totalSize += shmMsg->fSize;
+        }
+        // store statistics on how many messages have been sent
+        fMessagesTx++;
+        fBytesTx += totalSize;
+        return totalSize;
+    }
+
+    /// batches are pushed to the ring as individual messages
+    int64_t SendBatchToRing(std::vector<MessagePtr>& msgs, int timeout)
+    {
+        auto& metas = fTxMetas;
+        metas.clear();
+        metas.reserve(msgs.size());
+        for (auto& msg : msgs) {
+            auto msgPtr = msg.get();
+            if (!msgPtr) {
+                return static_cast<int>(TransferCode::error);
+            }
+            assertm(dynamic_cast<shmem::Message*>(msgPtr), "given mq::Message is a shmem::Message");   // NOLINT
+            auto shmMsg = static_cast<shmem::Message*>(msgPtr);   // NOLINT(cppcoreguidelines-pro-type-static-cast-downcast)
+            metas.push_back(MetaHeader{ shmMsg->fSize, shmMsg->fHint, shmMsg->fHandle, shmMsg->fShared, shmMsg->fRegionId, shmMsg->fSegmentId, shmMsg->fManaged });
+        }
+
+        int64_t result = SendToRing(metas.data(), 1, timeout);
+        if (result < 0) {
+            return result;
+        }
+        std::size_t numSent = 1;
+        while (numSent < metas.size() && fTxRing->TryPush(&metas[numSent], 1)) {
+            ++numSent;
+        }
+
+        int64_t totalSize = 0;
+        for (std::size_t i = 0; i < numSent; ++i) {
+            Message* shmMsg = static_cast<Message*>(msgs[i].get());
+            shmMsg->fQueued = true;
+            totalSize += shmMsg->fSize;
+        }
+        fMessagesTx += numSent;
+        fBytesTx += totalSize;
+        return numSent;
+    }
+
+    int64_t ReceiveBatchFromRing(std::vector<MessagePtr>& msgs, std::size_t maxMessages, int timeout)
+    {
+        auto const transport = GetTransport();
+        std::size_t totalSize = 0;
+        auto consume = [&](const MetaHeader& meta) {
+            MetaHeader hdr = meta;
+            msgs.push_back(std::make_unique<Message>(fManager, hdr, transport));
+            totalSize += hdr.fSize;
+        };
+
+        int64_t result = ReceiveFromRing(consume, 1, timeout);
+        if (result < 0) {
+            return result;
+        }
+        // stops at the first multipart message, if any
+        std::size_t numReceived = 1;
+        while (numReceived < maxMessages && fRxRing->TryPop(consume, 1) > 0) {
+            ++numReceived;
+        }
+
+        fMessagesRx += numReceived;
+        fBytesRx += totalSize;
+        return numReceived;
+    }
+
+    template<typename F>
+    int64_t ReceiveFromRing(F&& consume, uint32_t maxParts, int timeout)
+    {
+        return RingTransfer([&]() -> int64_t {
+                                int64_t n = fRxRing->TryPop(consume, maxParts);
+                                if (n < 0) {
+                                    throw SocketError(tools::ToString("Received a multipart message on socket ", fId, ", but expected a single part message. ",
+                                                                      "Possibly due to a mismatch of Send/Receive calls on the sender and receiver side."));
+                                }
+                                return n;
+                            },
+                            [&](int waitMs) { return fRxRing->WaitForData(fRingSpin, waitMs); },
+                            timeout);
+    }
 };
 
 } // namespace fair::mq::shmem
@@ -15,6 +15,7 @@
 #include "Poller.h"
 #include "Socket.h"
 #include "UnmanagedRegionImpl.h"
+#include <fairmq/Metrics.h>
 #include <fairmq/ProgOptions.h>
 #include <fairmq/tools/Strings.h>
 #include <fairmq/TransportFactory.h>
@@ -25,6 +26,7 @@
 
 #include <zmq.h>
 
+#include <chrono>
 #include <memory> // unique_ptr, make_unique
 #include <string>
 #include <vector>
@@ -59,13 +61,14 @@ class TransportFactory final : public fair::mq::TransportFactory
             sessionName = config->GetProperty<std::string>("session", sessionName);
             segmentSize = config->GetProperty<size_t>("shm-segment-size", segmentSize);
             allocationAlgorithm = config->GetProperty<std::string>("shm-allocation", allocationAlgorithm);
+            fPollSpin = std::chrono::microseconds(config->GetProperty<unsigned int>("poll-spin", 0));
         } else {
             LOG(debug) << "ProgOptions not available! Using defaults.";
         }
 
-        if (allocationAlgorithm != "rbtree_best_fit" && allocationAlgorithm != "simple_seq_fit") {
-            LOG(error) << "Provided shared memory allocation algorithm '" << allocationAlgorithm << "' is not supported. Supported are 'rbtree_best_fit'/'simple_seq_fit'";
-            throw SharedMemoryError(tools::ToString("Provided shared memory allocation algorithm '", allocationAlgorithm, "' is not supported. Supported are 'rbtree_best_fit'/'simple_seq_fit'"));
+        if (allocationAlgorithm != "rbtree_best_fit" && allocationAlgorithm != "simple_seq_fit" && allocationAlgorithm != "segregated_slab") {
+            LOG(error) << "Provided shared memory allocation algorithm '" << allocationAlgorithm << "' is not supported. Supported are 'rbtree_best_fit'/'simple_seq_fit'/'segregated_slab'";
+            throw SharedMemoryError(tools::ToString("Provided shared memory allocation algorithm '", allocationAlgorithm, "' is not supported. Supported are 'rbtree_best_fit'/'simple_seq_fit'/'segregated_slab'"));
         }
 
         try {
@@ -130,17 +133,23 @@ class TransportFactory final : public fair::mq::TransportFactory
 
     PollerPtr CreatePoller(const std::vector<Channel>& channels) const override
     {
-        return std::make_unique<Poller>(channels);
+        auto poller = std::make_unique<Poller>(channels);
+        poller->SetSpinTime(fPollSpin);
+        return poller;
     }
 
     PollerPtr CreatePoller(const std::vector<Channel*>& channels) const override
     {
-        return std::make_unique<Poller>(channels);
+        auto poller = std::make_unique<Poller>(channels);
+        poller->SetSpinTime(fPollSpin);
+        return poller;
     }
 
     PollerPtr CreatePoller(const std::unordered_map<std::string, std::vector<Channel>>& channelsMap, const std::vector<std::string>& channelList) const override
     {
-        return std::make_unique<Poller>(channelsMap, channelList);
+        auto poller = std::make_unique<Poller>(channelsMap, channelList);
+        poller->SetSpinTime(fPollSpin);
+        return poller;
     }
 
     UnmanagedRegionPtr CreateUnmanagedRegion(size_t size, RegionCallback callback = nullptr, const std::string& path = "", int flags = 0, fair::mq::RegionConfig cfg = fair::mq::RegionConfig()) override
@@ -184,7 +193,9 @@ class TransportFactory final : public fair::mq::TransportFactory
 
     UnmanagedRegionPtr CreateUnmanagedRegion(size_t size, RegionCallback callback, RegionBulkCallback bulkCallback, fair::mq::RegionConfig cfg)
     {
-        return std::make_unique<UnmanagedRegionImpl>(*fManager, size, callback, bulkCallback, std::move(cfg), this);
+        return UnmanagedRegionImpl::CreateWithAllocator(cfg, std::move(callback), std::move(bulkCallback), [&](RegionCallback cb, RegionBulkCallback bcb) {
+            return std::make_unique<UnmanagedRegionImpl>(*fManager, size, std::move(cb), std::move(bcb), cfg, this);
+        });
     }
 
     void SubscribeToRegionEvents(RegionEventCallback callback) override { fManager->SubscribeToRegionEvents(callback); }
@@ -198,6 +209,18 @@ class TransportFactory final : public fair::mq::TransportFactory
     void Resume() override { fManager->Resume(); }
     void Reset() override { fManager->Reset(); }
 
+    void RegisterMetrics(metrics::Registry& registry) override
+    {
+        Manager* manager = fManager.get();
+        metrics::Labels labels{{"segment", std::to_string(manager->GetSegmentId())}};
+        registry.AddCallback(this, "fairmq_shm_segment_size_bytes", "Size of the shared memory segment for new messages", metrics::Type::Gauge, labels,
+            [manager]() { return static_cast<double>(manager->GetSegmentSize()); });
+        registry.AddCallback(this, "fairmq_shm_segment_free_bytes", "Free memory in the shared memory segment for new messages", metrics::Type::Gauge, labels,
+            [manager]() { return static_cast<double>(manager->GetSegmentFreeMemory()); });
+        registry.AddCallback(this, "fairmq_shm_bad_alloc_retries_total", "Message allocations that failed for lack of memory and were retried", metrics::Type::Counter, {},
+            [manager]() { return static_cast<double>(manager->GetNumBadAllocRetries()); });
+    }
+
     ~TransportFactory() override
     {
         LOG(debug) << "Destroying Shared Memory transport...";
@@ -222,6 +245,7 @@ class TransportFactory final : public fair::mq::TransportFactory
   private:
     void* fZmqCtx;
     std::unique_ptr<Manager> fManager;
+    std::chrono::microseconds fPollSpin{0}; // spin time of the busy-poll mode of created pollers
 };
 
 } // namespace fair::mq::shmem
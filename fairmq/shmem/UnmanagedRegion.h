@@ -9,18 +9,18 @@
 #ifndef FAIR_MQ_SHMEM_UNMANAGEDREGION_H_
 #define FAIR_MQ_SHMEM_UNMANAGEDREGION_H_
 
+#include <fairmq/shmem/AckRing.h>
 #include <fairmq/shmem/Common.h>
 #include <fairmq/shmem/Monitor.h>
+#include <fairmq/Probes.h>
 #include <fairmq/tools/Strings.h>
 #include <fairmq/UnmanagedRegion.h>
 #include <fairmq/Transports.h>
 
 #include <fairlogger/Logger.h>
 
-#include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/interprocess/managed_shared_memory.hpp>
 #include <boost/interprocess/file_mapping.hpp>
-#include <boost/interprocess/ipc/message_queue.hpp>
 
 #include <algorithm> // min
 #include <atomic>
@@ -32,7 +32,8 @@
 #include <cerrno>
 #include <chrono>
 #include <ios>
-#include <utility> // move
+#include <utility> // move, pair
+#include <vector>
 
 namespace fair::mq::shmem
 {
@@ -59,6 +60,8 @@ struct UnmanagedRegion
         : fControlling(controlling)
         , fRemoveOnDestruction(cfg.removeOnDestruction)
         , fLinger(cfg.linger)
+        , fAckMaxDelay(cfg.ackMaxDelay)
+        , fAckBatchSize(std::max(cfg.ackBatchSize, 1U))
         , fStopAcks(false)
         , fName(MakeShmName(shmId, "rg", cfg.id.value()))
         , fQueueName(MakeShmName(shmId, "rgq", cfg.id.value()))
@@ -67,7 +70,8 @@ struct UnmanagedRegion
         , fFile(nullptr)
         , fFileMapping()
         , fRcSegmentSize(cfg.rcSegmentSize)
-        , fQueue(nullptr)
+        , fAckSegment(nullptr)
+        , fAckRing(nullptr)
         , fCallback(nullptr)
         , fBulkCallback(nullptr)
     {
@@ -168,6 +172,8 @@ struct UnmanagedRegion
     {
         fControlling = true;
         fLinger = cfg.linger;
+        fAckMaxDelay = cfg.ackMaxDelay;
+        fAckBatchSize = std::max(cfg.ackBatchSize, 1U);
         fRemoveOnDestruction = cfg.removeOnDestruction;
     }
 
@@ -191,6 +197,19 @@ struct UnmanagedRegion
 
     bool RemoveOnDestruction() { return fRemoveOnDestruction; }
 
+    fair::mq::RegionAckStats GetAckStats() const
+    {
+        fair::mq::RegionAckStats stats;
+        if (fAckRing) {
+            stats.count = fAckRing->NumAcks();
+            stats.p50 = fAckRing->LatencyPercentile(0.5);
+            stats.p90 = fAckRing->LatencyPercentile(0.9);
+            stats.p99 = fAckRing->LatencyPercentile(0.99);
+            stats.max = fAckRing->MaxLatency();
+        }
+        return stats;
+    }
+
     RefCount& MakeRefCount(uint16_t initialCount = 1)
     {
         RefCount* refCount = fRefCountPool->allocate_one().get();
@@ -210,13 +229,18 @@ struct UnmanagedRegion
         fStopAcks = true;
 
         if (fAcksSender.joinable()) {
+            { std::lock_guard<std::mutex> lock(fBlockMtx); } // sender is either waiting or sees fStopAcks
             fBlockSendCV.notify_one();
             fAcksSender.join();
         }
 
         if (fControlling) {
             if (fAcksReceiver.joinable()) {
+                fAckRing->WakeReceiver();
                 fAcksReceiver.join();
+                auto stats = GetAckStats();
+                LOG(debug) << "Region '" << fName << "' acks: " << stats.count << ", latency (ns) p50: " << stats.p50
+                           << ", p90: " << stats.p90 << ", p99: " << stats.p99 << ", max: " << stats.max;
             }
 
             if (fRemoveOnDestruction) {
@@ -235,7 +259,8 @@ struct UnmanagedRegion
                 LOG(debug) << "Skipping removal of " << fName << " unmanaged region, because RegionConfig::removeOnDestruction is false";
             }
 
-            if (boost::interprocess::message_queue::remove(fQueueName.c_str())) {
+            fAckSegment.reset();
+            if (boost::interprocess::shared_memory_object::remove(fQueueName.c_str())) {
                 LOG(trace) << "Region queue '" << fQueueName << "' destroyed.";
             } else {
                 LOG(debug) << "Region queue '" << fQueueName << "' not destroyed.";
@@ -255,6 +280,8 @@ struct UnmanagedRegion
     bool fControlling;
     bool fRemoveOnDestruction;
     uint32_t fLinger;
+    uint32_t fAckMaxDelay; // us
+    uint32_t fAckBatchSize;
     std::atomic<bool> fStopAcks;
     std::string fName;
     std::string fQueueName;
@@ -266,10 +293,12 @@ struct UnmanagedRegion
 
     std::mutex fBlockMtx;
     std::condition_variable fBlockSendCV;
-    std::vector<RegionBlock> fBlocksToFree;
-    const std::size_t fAckBunchSize = 256;
+    std::vector<std::pair<RegionBlock, uint64_t>> fBlocksToFree; // acks that did not fit into the ring, with their release time
+    const uint32_t fAckBunchSize = 256;
+    static constexpr uint32_t kAckRingCapacity = 65536;
     uint64_t fRcSegmentSize;
-    std::unique_ptr<boost::interprocess::message_queue> fQueue;
+    std::unique_ptr<boost::interprocess::managed_shared_memory> fAckSegment;
+    AckRing* fAckRing;
     std::unique_ptr<boost::interprocess::managed_shared_memory> fRefCountSegment;
     std::unique_ptr<RefCountPool> fRefCountPool;
 
@@ -315,9 +344,18 @@ struct UnmanagedRegion
     void InitializeQueues()
     {
         using namespace boost::interprocess;
-        if (!fQueue) {
-            fQueue = std::make_unique<message_queue>(open_or_create, fQueueName.c_str(), 1024, fAckBunchSize * sizeof(RegionBlock));
-            LOG(trace) << "shmem: initialized region queue: " << fQueueName;
+        if (!fAckSegment) {
+            fAckSegment = std::make_unique<managed_shared_memory>(open_or_create, fQueueName.c_str(), kAckRingCapacity * sizeof(AckRing::Slot) + sizeof(AckRing) + 65536);
+            // the ring and its slots are created together, by whoever comes first
+            auto findOrCreate = [this]() {
+                fAckRing = fAckSegment->find<AckRing>(unique_instance).first;
+                if (!fAckRing) {
+                    auto slots = static_cast<AckRing::Slot*>(fAckSegment->allocate(kAckRingCapacity * sizeof(AckRing::Slot)));
+                    fAckRing = fAckSegment->construct<AckRing>(unique_instance)(slots, kAckRingCapacity);
+                }
+            };
+            fAckSegment->atomic_func(findOrCreate);
+            LOG(trace) << "shmem: initialized region ack ring: " << fQueueName;
         }
     }
 
@@ -350,101 +388,133 @@ struct UnmanagedRegion
             fAcksSender = std::thread(&UnmanagedRegion::SendAcks, this);
         }
     }
+    // ships the acks that did not fit into the ring on release
     void SendAcks()
     {
-        std::unique_ptr<RegionBlock[]> blocks = std::make_unique<RegionBlock[]>(fAckBunchSize);
-        size_t blocksToSend = 0;
+        std::vector<std::pair<RegionBlock, uint64_t>> blocks;
 
         while (true) {
             {
                 std::unique_lock<std::mutex> lock(fBlockMtx);
-
-                // try to get <fAckBunchSize> blocks
-                if (fBlocksToFree.size() < fAckBunchSize) {
-                    fBlockSendCV.wait_for(lock, std::chrono::milliseconds(500));
-                }
-
-                // send whatever blocks we have
-                blocksToSend = std::min(fBlocksToFree.size(), fAckBunchSize);
-
-                copy_n(fBlocksToFree.end() - blocksToSend, blocksToSend, blocks.get());
-                fBlocksToFree.resize(fBlocksToFree.size() - blocksToSend);
+                fBlockSendCV.wait(lock, [&]() { return !fBlocksToFree.empty() || fStopAcks; });
+                blocks.insert(blocks.end(), fBlocksToFree.begin(), fBlocksToFree.end());
+                fBlocksToFree.clear();
             }
 
-            if (blocksToSend > 0) {
-                while (!fQueue->try_send(blocks.get(), blocksToSend * sizeof(RegionBlock), 0) && !fStopAcks) {
-                    // receiver slow? yield and try again...
-                    std::this_thread::yield();
-                }
-                // LOG(debug) << "Sent " << blocksToSend << " blocks.";
-            } else { // blocksToSend == 0
-                if (fStopAcks) {
+            size_t sent = 0;
+            while (sent < blocks.size()) {
+                if (fAckRing->TryPush(blocks[sent].first, blocks[sent].second)) {
+                    ++sent;
+                } else if (fStopAcks) {
                     break;
+                } else {
+                    // receiver slow? wait for it to make space
+                    fAckRing->WaitForSpace(10000000);
                 }
             }
+            blocks.erase(blocks.begin(), blocks.begin() + sent);
+
+            if (fStopAcks) {
+                break;
+            }
         }
 
-        LOG(trace) << "AcksSender for " << fName << " leaving " << "(blocks left to free: " << fBlocksToFree.size() << ", "
-                                                                << " blocks left to send: " << blocksToSend << ").";
+        LOG(trace) << "AcksSender for " << fName << " leaving (blocks left to send: " << blocks.size() << ").";
     }
 
     void StartAckReceiver()
     {
         if (!fAcksReceiver.joinable()) {
+            // active before the thread runs, blocks released in the meantime are queued, not dropped
+            fAckRing->SetReceiverActive(true);
             fAcksReceiver = std::thread(&UnmanagedRegion::ReceiveAcks, this);
         }
     }
+    // Delivers acks as soon as fAckBatchSize of them are pending, or when the oldest one has waited for fAckMaxDelay.
+    // Sleeps on the ring otherwise, producers wake it up.
     void ReceiveAcks()
     {
-        unsigned int priority = 0;
-        boost::interprocess::message_queue::size_type recvdSize = 0;
-        std::unique_ptr<RegionBlock[]> blocks = std::make_unique<RegionBlock[]>(fAckBunchSize);
         std::vector<fair::mq::RegionBlock> result;
-        result.reserve(fAckBunchSize);
+        result.reserve(std::max(fAckBatchSize, fAckBunchSize));
+        const uint64_t maxDelay = static_cast<uint64_t>(fAckMaxDelay) * 1000;
+        auto stopped = [this]() { return fStopAcks.load(); };
+        bool leave = false;
+        uint64_t lingerEnd = 0;
 
         while (true) {
-            uint32_t timeout = 100;
-            bool leave = false;
-            if (fStopAcks) {
-                timeout = fLinger;
+            if (!leave && fStopAcks) {
+                // collect outstanding acks for the linger period
                 leave = true;
+                lingerEnd = AckClock() + static_cast<uint64_t>(fLinger) * 1000000;
             }
-            auto rcvTill = boost::posix_time::microsec_clock::universal_time() + boost::posix_time::milliseconds(timeout);
-
-            while (fQueue->timed_receive(blocks.get(), fAckBunchSize * sizeof(RegionBlock), recvdSize, priority, rcvTill)) {
-                const auto numBlocks = recvdSize / sizeof(RegionBlock);
-                // LOG(debug) << "Received " << numBlocks << " blocks (recvdSize: " << recvdSize << "). (remaining queue size: " << fQueue->get_num_msg() << ").";
-                if (fBulkCallback) {
-                    result.clear();
-                    for (size_t i = 0; i < numBlocks; i++) {
-                        result.emplace_back(reinterpret_cast<char*>(fRegion.get_address()) + blocks[i].fHandle, blocks[i].fSize, reinterpret_cast<void*>(blocks[i].fHint));
-                    }
-                    fBulkCallback(result);
-                } else if (fCallback) {
-                    for (size_t i = 0; i < numBlocks; i++) {
-                        fCallback(reinterpret_cast<char*>(fRegion.get_address()) + blocks[i].fHandle, blocks[i].fSize, reinterpret_cast<void*>(blocks[i].fHint));
+
+            uint64_t now = AckClock();
+            uint64_t pending = fAckRing->Size();
+            if (pending == 0) {
+                if (leave) {
+                    if (now >= lingerEnd) {
+                        break;
                     }
+                    fAckRing->WaitForAcks(1, static_cast<int64_t>(lingerEnd - now), []() { return false; });
+                } else {
+                    fAckRing->WaitForAcks(1, -1, stopped);
+                }
+                continue;
+            }
+            if (!leave && pending < fAckBatchSize) {
+                uint64_t oldest = fAckRing->OldestReleaseTime();
+                if (oldest != 0 && now < oldest + maxDelay) {
+                    fAckRing->WaitForAcks(fAckBatchSize, static_cast<int64_t>(oldest + maxDelay - now), stopped);
+                    continue;
                 }
             }
 
-            if (leave) {
-                break;
+            result.clear();
+            fAckRing->Pop([&](const RegionBlock& block, uint64_t releaseTime) {
+                result.emplace_back(reinterpret_cast<char*>(fRegion.get_address()) + block.fHandle, block.fSize, reinterpret_cast<void*>(block.fHint));
+                fAckRing->RecordLatency(now > releaseTime ? now - releaseTime : 0);
+            }, static_cast<uint32_t>(result.capacity()));
+            FAIRMQ_PROBE(region_ack_batch, result.size());
+
+            if (fBulkCallback) {
+                fBulkCallback(result);
+            } else if (fCallback) {
+                for (const auto& block : result) {
+                    fCallback(block.ptr, block.size, block.hint);
+                }
             }
         }
 
-        LOG(trace) << "AcksReceiver for " << fName << " leaving (remaining queue size: " << fQueue->get_num_msg() << ").";
+        fAckRing->SetReceiverActive(false);
+        LOG(trace) << "AcksReceiver for " << fName << " leaving (remaining queue size: " << fAckRing->Size() << ").";
     }
 
     void ReleaseBlock(const RegionBlock& block)
     {
-        std::unique_lock<std::mutex> lock(fBlockMtx);
+        if (!fAckRing) {
+            return;
+        }
+        if (!fAckRing->ReceiverActive() && (!(fCallback || fBulkCallback) || fStopAcks)) {
+            return; // nobody to acknowledge to
+        }
 
-        fBlocksToFree.emplace_back(block);
+        uint64_t now = AckClock();
+        if (fAckRing->TryPush(block, now)) {
+            return;
+        }
 
-        if (fBlocksToFree.size() >= fAckBunchSize) {
-            lock.unlock();
-            fBlockSendCV.notify_one();
+        // ring is full, leave it to the sender thread
+        {
+            std::lock_guard<std::mutex> lock(fBlockMtx);
+            fBlocksToFree.emplace_back(block, now);
         }
+        fBlockSendCV.notify_one();
+    }
+
+    static uint64_t AckClock()
+    {
+        // steady_clock is system-wide (CLOCK_MONOTONIC), the release time is compared across processes
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
     }
 
     void StopAcks()
@@ -452,11 +522,13 @@ struct UnmanagedRegion
         fStopAcks = true;
 
         if (fAcksSender.joinable()) {
+            { std::lock_guard<std::mutex> lock(fBlockMtx); } // sender is either waiting or sees fStopAcks
             fBlockSendCV.notify_one();
             fAcksSender.join();
         }
 
         if (fAcksReceiver.joinable()) {
+            fAckRing->WakeReceiver();
             fAcksReceiver.join();
         }
     }
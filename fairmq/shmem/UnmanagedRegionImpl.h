@@ -55,6 +55,7 @@ class UnmanagedRegionImpl final : public fair::mq::UnmanagedRegion
     uint16_t GetId() const override { return fRegionId; }
     void SetLinger(uint32_t linger) override { fRegion->SetLinger(linger); }
     uint32_t GetLinger() const override { return fRegion->GetLinger(); }
+    RegionAckStats GetAckStats() const override { return fRegion->GetAckStats(); }
 
     Transport GetType() const override { return fair::mq::Transport::SHM; }
 
@@ -0,0 +1,226 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+#include "Common.h"
+
+#include <boost/program_options.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Compares the managed segment allocation algorithms under concurrent allocate/deallocate churn from multiple processes.
+// Every process keeps a window of live buffers and replaces a random one in each iteration,
+// with sizes drawn from the given list (e.g. a mix of small and large messages).
+
+using namespace std;
+using namespace boost::program_options;
+using namespace fair::mq::shmem;
+namespace bipc = ::boost::interprocess;
+
+namespace
+{
+
+struct Result
+{
+    uint64_t fOps = 0;
+    uint64_t fFailed = 0;
+    uint64_t fNs = 0;
+};
+
+struct Config
+{
+    size_t fSegmentSize;
+    int fNumProcesses;
+    uint64_t fIterations;
+    size_t fWindow;
+    vector<size_t> fSizes;
+    vector<double> fWeights;
+};
+
+template<typename S>
+Result Churn(const string& name, const Config& cfg, unsigned int seed)
+{
+    S segment(bipc::open_only, name.c_str());
+    mt19937_64 rng(seed);
+    discrete_distribution<size_t> sizeDist(cfg.fWeights.begin(), cfg.fWeights.end());
+    uniform_int_distribution<size_t> slotDist(0, cfg.fWindow - 1);
+    vector<char*> live(cfg.fWindow, nullptr);
+
+    Result result;
+    auto start = chrono::steady_clock::now();
+    for (uint64_t i = 0; i < cfg.fIterations; ++i) {
+        char*& slot = live[slotDist(rng)];
+        if (slot) {
+            segment.deallocate(slot);
+            slot = nullptr;
+        }
+        slot = static_cast<char*>(segment.allocate(cfg.fSizes[sizeDist(rng)], nothrow));
+        if (slot) {
+            *slot = 1; // touch
+            ++result.fOps;
+        } else {
+            ++result.fFailed;
+        }
+    }
+    for (char* ptr : live) {
+        if (ptr) {
+            segment.deallocate(ptr);
+        }
+    }
+    result.fNs = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+template<typename S>
+void Run(const string& algorithm, const Config& cfg)
+{
+    string name(MakeShmName(to_string(getpid()), "allocbench"));
+    bipc::shared_memory_object::remove(name.c_str());
+
+    size_t initialFree = 0;
+    {
+        S segment(bipc::create_only, name.c_str(), cfg.fSegmentSize);
+        initialFree = segment.get_free_memory();
+    }
+
+    // children wait for the start pipe to be closed, and report their results through the result pipe
+    int startPipe[2];
+    int resultPipe[2];
+    if (pipe(startPipe) != 0 || pipe(resultPipe) != 0) {
+        throw runtime_error("could not create pipes");
+    }
+
+    vector<pid_t> children;
+    for (int p = 0; p < cfg.fNumProcesses; ++p) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            throw runtime_error("fork failed");
+        }
+        if (pid == 0) {
+            close(startPipe[1]);
+            close(resultPipe[0]);
+            char c;
+            while (read(startPipe[0], &c, 1) > 0) {}
+            Result r = Churn<S>(name, cfg, 1234 + p);
+            bool ok = write(resultPipe[1], &r, sizeof(r)) == sizeof(r);
+            _exit(ok ? 0 : 1);
+        }
+        children.push_back(pid);
+    }
+    close(startPipe[0]);
+    close(resultPipe[1]);
+    close(startPipe[1]); // go
+
+    Result total;
+    uint64_t maxNs = 0;
+    for (int p = 0; p < cfg.fNumProcesses; ++p) {
+        Result r;
+        if (read(resultPipe[0], &r, sizeof(r)) != sizeof(r)) {
+            throw runtime_error("could not read result of a benchmark process");
+        }
+        total.fOps += r.fOps;
+        total.fFailed += r.fFailed;
+        total.fNs += r.fNs;
+        maxNs = max(maxNs, r.fNs);
+    }
+    close(resultPipe[0]);
+    for (pid_t pid : children) {
+        waitpid(pid, nullptr, 0);
+    }
+
+    size_t finalFree = 0;
+    {
+        S segment(bipc::open_only, name.c_str());
+        finalFree = segment.get_free_memory();
+    }
+    bipc::shared_memory_object::remove(name.c_str());
+
+    // every op is one allocation + (mostly) one deallocation
+    cout << left << setw(16) << algorithm << right
+         << setw(14) << fixed << setprecision(0) << (maxNs ? total.fOps * 1e9 / maxNs : 0.)
+         << setw(14) << setprecision(1) << (total.fOps ? static_cast<double>(total.fNs) / total.fOps : 0.)
+         << setw(12) << total.fFailed
+         << setw(16) << (initialFree > finalFree ? initialFree - finalFree : 0)
+         << endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try {
+        string algorithm("all");
+        Config cfg{};
+
+        options_description desc("Options");
+        desc.add_options()
+            ("algorithm,a", value<string>(&algorithm)->default_value("all"), "Allocation algorithm: rbtree_best_fit/simple_seq_fit/segregated_slab/all")
+            ("segment-size", value<size_t>(&cfg.fSegmentSize)->default_value(2ULL << 30), "Size of the managed segment (in bytes)")
+            ("processes,p", value<int>(&cfg.fNumProcesses)->default_value(4), "Number of concurrent processes")
+            ("iterations,n", value<uint64_t>(&cfg.fIterations)->default_value(1000000), "Allocate/deallocate iterations per process")
+            ("window,w", value<size_t>(&cfg.fWindow)->default_value(64), "Number of live buffers per process")
+            ("sizes,s", value<vector<size_t>>(&cfg.fSizes)->multitoken()->default_value({1024, 8388608}, "1024 8388608"), "Allocation sizes (in bytes)")
+            ("weights", value<vector<double>>(&cfg.fWeights)->multitoken(), "Relative frequencies of the sizes (default: 99:1 for two sizes, uniform otherwise)")
+            ("help,h", "Print help");
+
+        variables_map vm;
+        store(parse_command_line(argc, argv, desc), vm);
+        notify(vm);
+
+        if (vm.count("help")) {
+            cout << "Benchmark of the shared memory allocation algorithms under multi-process churn" << endl << desc << endl;
+            return 0;
+        }
+
+        if (cfg.fWeights.empty()) {
+            if (cfg.fSizes.size() == 2) {
+                cfg.fWeights = {99., 1.};
+            } else {
+                cfg.fWeights.assign(cfg.fSizes.size(), 1.);
+            }
+        }
+        if (cfg.fSizes.empty() || cfg.fWeights.size() != cfg.fSizes.size() || cfg.fWindow == 0 || cfg.fNumProcesses < 1) {
+            cout << "invalid sizes/weights/window/processes" << endl;
+            return 1;
+        }
+
+        cout << "processes: " << cfg.fNumProcesses << ", iterations/process: " << cfg.fIterations << ", window: " << cfg.fWindow
+             << ", segment size: " << cfg.fSegmentSize << ", sizes (weight):";
+        for (size_t i = 0; i < cfg.fSizes.size(); ++i) {
+            cout << " " << cfg.fSizes.at(i) << " (" << cfg.fWeights.at(i) << ")";
+        }
+        cout << endl;
+        cout << left << setw(16) << "algorithm" << right << setw(14) << "allocs/s" << setw(14) << "ns/alloc" << setw(12) << "failed" << setw(16) << "leaked bytes" << endl;
+
+        if (algorithm == "all" || algorithm == "rbtree_best_fit") {
+            Run<RBTreeBestFitSegment>("rbtree_best_fit", cfg);
+        }
+        if (algorithm == "all" || algorithm == "simple_seq_fit") {
+            Run<SimpleSeqFitSegment>("simple_seq_fit", cfg);
+        }
+        if (algorithm == "all" || algorithm == "segregated_slab") {
+            Run<SegregatedSlabSegment>("segregated_slab", cfg);
+        }
+    } catch (exception& e) {
+        cout << "Unhandled Exception reached the top of main: " << e.what() << ", application will now exit" << endl;
+        return 2;
+    }
+
+    return 0;
+}
@@ -88,6 +88,7 @@ int main(int argc, char** argv)
         bool cleanOnExit = false;
         bool getShmId = false;
         bool listAll = false;
+        bool fragmentation = false;
         string listAllPath;
         bool verbose = false;
         string severity;
@@ -111,6 +112,7 @@ int main(int argc, char** argv)
             ("get-shmid"      , value<bool>(&getShmId)->implicit_value(true),           "Translate given session id and user id to a shmem id (uses current user id if none provided)")
             ("list-all"       , value<bool>(&listAll)->implicit_value(true),            "List all sessions & segments")
             ("list-all-path"  , value<string>(&listAllPath)->default_value("/dev/shm/"),"Path for the --list-all command to search segments in")
+            ("fragmentation"  , value<bool>(&fragmentation)->implicit_value(true),      "Print the fragmentation of the managed segments (read-only, without locking them)")
             ("verbose"        , value<bool>(&verbose)->implicit_value(true),            "Verbose mode (daemon will output to a file 'fairmq-shmmonitor_<timestamp>')")
             ("severity"       , value<string>(&severity)->default_value("info"),        "Log severity")
             ("user-id"        , value<int>(&userId)->default_value(-1),                 "User id (used with --get-shmid)")
@@ -163,6 +165,13 @@ int main(int argc, char** argv)
             return 0;
         }
 
+        if (fragmentation) {
+            if (!Monitor::PrintFragmentation(ShmId{shmId})) {
+                LOG(info) << "No segments found.";
+            }
+            return 0;
+        }
+
         if (!viewOnly && !interactive && !monitor) {
             // if neither of the run modes are selected, use view only mode.
             viewOnly = true;
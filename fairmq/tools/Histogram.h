@@ -0,0 +1,161 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef FAIR_MQ_TOOLS_HISTOGRAM_H
+#define FAIR_MQ_TOOLS_HISTOGRAM_H
+
+#include <algorithm> // std::min, std::max
+#include <cmath>     // std::sqrt
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace fair::mq::tools
+{
+
+/// Bucketing of LatencyHistogram, for other log-linear histograms to use the same buckets:
+/// values below 2^bits have a bucket each, every power of two range above is divided into 2^bits linear sub-buckets,
+/// so that the width of a bucket is at most 2^-bits of its values.
+constexpr std::size_t LogLinearNumBuckets(unsigned int bits) { return (65 - bits) * (std::size_t(1) << bits); }
+
+inline std::size_t LogLinearBucket(uint64_t value, unsigned int bits)
+{
+    uint64_t const subBuckets = uint64_t(1) << bits;
+    if (value < subBuckets) {
+        return static_cast<std::size_t>(value);
+    }
+    unsigned int msb = 63 - static_cast<unsigned int>(__builtin_clzll(value));
+    unsigned int shift = msb - bits; // value >> shift is within [subBuckets, 2 * subBuckets)
+    return static_cast<std::size_t>((shift + 1) * subBuckets + ((value >> shift) - subBuckets));
+}
+
+/// highest value of the given bucket
+inline uint64_t LogLinearBucketMax(std::size_t index, unsigned int bits)
+{
+    uint64_t const subBuckets = uint64_t(1) << bits;
+    uint64_t range = index / subBuckets;
+    uint64_t sub = index % subBuckets;
+    if (range == 0) {
+        return sub;
+    }
+    auto shift = static_cast<unsigned int>(range - 1);
+    uint64_t lowest = (subBuckets + sub) << shift;
+    return lowest + ((uint64_t(1) << shift) - 1);
+}
+
+/**
+ * Histogram of non-negative integer values (e.g. latencies in ns) with a bounded relative error, in the style of
+ * HdrHistogram: every power of two range is divided into 2^precisionBits linear sub-buckets, values below
+ * 2^precisionBits are counted exactly. Recording is O(1) and does not allocate, the memory is fixed
+ * ((65 - precisionBits) * 2^precisionBits counters). Not thread-safe, merge per-thread histograms instead.
+ *
+ * Example:
+ * \code
+ * LatencyHistogram hist(7); // < 1% relative error
+ * hist.Record(latencyNs);
+ * LOG(info) << "p99: " << hist.Percentile(99.) << " ns";
+ * \endcode
+ */
+class LatencyHistogram
+{
+  public:
+    explicit LatencyHistogram(unsigned int precisionBits = 7)
+        : fPrecisionBits(precisionBits)
+    {
+        if (precisionBits < 1 || precisionBits > 16) {
+            throw std::invalid_argument("LatencyHistogram: precision must be within 1 and 16 bits");
+        }
+        fCounts.assign(LogLinearNumBuckets(precisionBits), 0);
+    }
+
+    void Record(uint64_t value, uint64_t count = 1)
+    {
+        fCounts[Index(value)] += count;
+        fCount += count;
+        fMin = std::min(fMin, value);
+        fMax = std::max(fMax, value);
+        fSum += static_cast<double>(value) * count;
+        fSumOfSquares += static_cast<double>(value) * value * count;
+    }
+
+    /// add the values of another histogram with the same precision
+    void Merge(const LatencyHistogram& other)
+    {
+        if (other.fPrecisionBits != fPrecisionBits) {
+            throw std::invalid_argument("LatencyHistogram: cannot merge histograms of different precision");
+        }
+        for (std::size_t i = 0; i < fCounts.size(); ++i) {
+            fCounts[i] += other.fCounts[i];
+        }
+        fCount += other.fCount;
+        fMin = std::min(fMin, other.fMin);
+        fMax = std::max(fMax, other.fMax);
+        fSum += other.fSum;
+        fSumOfSquares += other.fSumOfSquares;
+    }
+
+    void Reset()
+    {
+        std::fill(fCounts.begin(), fCounts.end(), 0);
+        fCount = 0;
+        fMin = std::numeric_limits<uint64_t>::max();
+        fMax = 0;
+        fSum = 0.;
+        fSumOfSquares = 0.;
+    }
+
+    /// value below which the given percentage (0 - 100) of the recorded values lie (within the precision)
+    uint64_t Percentile(double percentile) const
+    {
+        if (fCount == 0) {
+            return 0;
+        }
+        auto rank = static_cast<uint64_t>(percentile / 100. * static_cast<double>(fCount) + 0.5);
+        rank = std::max<uint64_t>(1, std::min(rank, fCount));
+        uint64_t seen = 0;
+        for (std::size_t i = 0; i < fCounts.size(); ++i) {
+            seen += fCounts[i];
+            if (seen >= rank) {
+                return std::max(fMin, std::min(fMax, HighestInBucket(i)));
+            }
+        }
+        return fMax;
+    }
+
+    uint64_t GetCount() const { return fCount; }
+    uint64_t GetMin() const { return fCount > 0 ? fMin : 0; }
+    uint64_t GetMax() const { return fMax; }
+    double GetMean() const { return fCount > 0 ? fSum / static_cast<double>(fCount) : 0.; }
+    double GetStdDev() const
+    {
+        if (fCount == 0) {
+            return 0.;
+        }
+        double mean = GetMean();
+        return std::sqrt(std::max(0., fSumOfSquares / static_cast<double>(fCount) - mean * mean));
+    }
+    unsigned int GetPrecisionBits() const { return fPrecisionBits; }
+
+  private:
+    std::size_t Index(uint64_t value) const { return LogLinearBucket(value, fPrecisionBits); }
+    uint64_t HighestInBucket(std::size_t index) const { return LogLinearBucketMax(index, fPrecisionBits); }
+
+    unsigned int fPrecisionBits;
+    std::vector<uint64_t> fCounts;
+    uint64_t fCount = 0;
+    uint64_t fMin = std::numeric_limits<uint64_t>::max();
+    uint64_t fMax = 0;
+    double fSum = 0.;
+    double fSumOfSquares = 0.;
+};
+
+} // namespace fair::mq::tools
+
+#endif /* FAIR_MQ_TOOLS_HISTOGRAM_H */
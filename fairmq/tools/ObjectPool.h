@@ -0,0 +1,140 @@
+/********************************************************************************
+ * Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH       *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#ifndef FAIR_MQ_TOOLS_OBJECTPOOL_H
+#define FAIR_MQ_TOOLS_OBJECTPOOL_H
+
+#include <algorithm> // min
+#include <cstddef> // size_t
+#include <mutex>
+#include <new> // operator new/delete
+#include <vector>
+
+namespace fair::mq::tools
+{
+
+/// @brief Per-thread free lists for the storage of objects of type T
+///
+/// Meant for the class-specific operator new/delete of small, frequently created objects (e.g. messages), so that
+/// std::unique_ptr and plain new/delete keep working. Every thread caches up to CacheSize free objects. Objects freed
+/// by another thread than the one that allocated them (e.g. producer/consumer threads) travel back in batches via a
+/// shared depot, which is the only place that takes a lock. The free objects of exiting threads go to the depot as well.
+template<typename T, std::size_t CacheSize = 256>
+class ObjectPool
+{
+  public:
+    static void* Allocate(std::size_t size)
+    {
+#ifndef __SANITIZE_ADDRESS__
+        if (size == sizeof(T) && !tCacheDestroyed) {
+            Cache& cache = GetCache();
+            if (cache.fCount == 0) {
+                Depot().Take(cache);
+            }
+            if (cache.fCount > 0) {
+                return cache.fObjects[--cache.fCount];
+            }
+        }
+#endif
+        return ::operator new(size);
+    }
+
+    static void Deallocate(void* ptr, std::size_t size)
+    {
+#ifndef __SANITIZE_ADDRESS__
+        if (size == sizeof(T) && !tCacheDestroyed) {
+            Cache& cache = GetCache();
+            if (cache.fCount == CacheSize) {
+                Depot().Give(cache);
+            }
+            cache.fObjects[cache.fCount++] = ptr;
+            return;
+        }
+#endif
+        ::operator delete(ptr);
+    }
+
+  private:
+    static constexpr std::size_t kBatchSize = CacheSize / 2;
+    static constexpr std::size_t kMaxDepotSize = 64 * CacheSize;
+
+    struct Cache
+    {
+        Cache() = default;
+        Cache(const Cache&) = delete;
+        Cache(Cache&&) = delete;
+        Cache& operator=(const Cache&) = delete;
+        Cache& operator=(Cache&&) = delete;
+        ~Cache()
+        {
+            tCacheDestroyed = true; // objects destroyed later during thread exit go to the heap
+            while (fCount > 0) {
+                Depot().Give(*this);
+            }
+        }
+
+        void* fObjects[CacheSize];
+        std::size_t fCount = 0;
+    };
+
+    struct SharedDepot
+    {
+        /// moves a batch from the depot into the (empty) cache
+        void Take(Cache& cache)
+        {
+            std::lock_guard<std::mutex> lock(fMtx);
+            std::size_t n = std::min(kBatchSize, fObjects.size());
+            for (std::size_t i = 0; i < n; ++i) {
+                cache.fObjects[cache.fCount++] = fObjects.back();
+                fObjects.pop_back();
+            }
+        }
+
+        /// moves a batch from the cache into the depot, or to the heap if the depot is full
+        void Give(Cache& cache)
+        {
+            const std::size_t n = std::min(kBatchSize, cache.fCount);
+            {
+                std::lock_guard<std::mutex> lock(fMtx);
+                if (fObjects.size() + n <= kMaxDepotSize) {
+                    if (fObjects.capacity() == 0) {
+                        fObjects.reserve(kMaxDepotSize);
+                    }
+                    for (std::size_t i = 0; i < n; ++i) {
+                        fObjects.push_back(cache.fObjects[--cache.fCount]);
+                    }
+                    return;
+                }
+            }
+            for (std::size_t i = 0; i < n; ++i) {
+                ::operator delete(cache.fObjects[--cache.fCount]);
+            }
+        }
+
+        std::mutex fMtx;
+        std::vector<void*> fObjects;
+    };
+
+    static inline thread_local bool tCacheDestroyed = false;
+
+    static Cache& GetCache()
+    {
+        thread_local Cache cache;
+        return cache;
+    }
+
+    static SharedDepot& Depot()
+    {
+        static auto* depot = new SharedDepot(); // never destroyed, objects may be freed during static destruction
+        return *depot;
+    }
+};
+
+} // namespace fair::mq::tools
+
+#endif /* FAIR_MQ_TOOLS_OBJECTPOOL_H */
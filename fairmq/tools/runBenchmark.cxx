@@ -0,0 +1,430 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include <fairmq/Channel.h>
+#include <fairmq/Parts.h>
+#include <fairmq/ProgOptions.h>
+#include <fairmq/TransportFactory.h>
+#include <fairmq/tools/Histogram.h>
+#include <fairmq/tools/RateLimit.h>
+#include <fairmq/tools/Strings.h>
+#include <fairmq/tools/Unique.h>
+
+#include <boost/program_options.hpp>
+
+#include <algorithm> // std::max
+#include <chrono>
+#include <cstdint>
+#include <cstring> // std::memcpy
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Latency and throughput benchmark of the transports. For every combination of the given transports, patterns,
+// message sizes, part counts and thread counts, <threads> pairs of a client and a server thread exchange messages:
+//  - oneway: the client sends messages with its send time embedded in the first part, the server records the
+//    latency at reception (both threads share one clock). The throughput is the one of the stream.
+//  - rtt: the client sends a message, the server sends it back and the client records the round-trip time.
+// The req-rep pattern waits for the reply of the server in both modes.
+// With --hops the messages from the client to the server pass through a chain of forwarding threads (as in the Proxy
+// device, with Channel::Forward()), comparing the results with 0 hops gives the overhead per hop.
+
+using namespace std;
+using namespace boost::program_options;
+using namespace fair::mq;
+
+namespace
+{
+
+using clock_type = chrono::steady_clock;
+
+struct Config
+{
+    string fMode;
+    uint64_t fIterations;
+    uint64_t fWarmup;
+    float fRate;
+    unsigned int fPrecision;
+};
+
+struct Case
+{
+    string fTransport;
+    string fPattern;
+    size_t fMsgSize;
+    int fNumParts;
+    int fNumThreads;
+    int fNumHops;
+};
+
+struct Result
+{
+    Case fCase;
+    tools::LatencyHistogram fLatency;
+    double fSeconds = 0.;
+    uint64_t fMessages = 0;
+};
+
+uint64_t Now()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(clock_type::now().time_since_epoch()).count();
+}
+
+/// a forwarding thread between the client and the server
+struct Hop
+{
+    unique_ptr<Channel> fIn, fOut;
+};
+
+/// a connected pair of a client and a server, forward: client [-> hops] -> server, backward: server -> client
+struct Link
+{
+    unique_ptr<Channel> fClientOut, fServerIn, fServerOut, fClientIn;
+    vector<Hop> fHops;
+
+    Link(shared_ptr<TransportFactory> factory, const string& pattern, int numHops, bool needsReply, const string& address)
+    {
+        if (numHops > 0 && pattern != "push-pull") {
+            throw runtime_error(tools::ToString("forwarding hops are supported with the push-pull pattern only, not with '", pattern, "'"));
+        }
+        if (pattern == "push-pull") {
+            fHops.resize(numHops);
+            unique_ptr<Channel>* out = &fClientOut;
+            for (int h = 0; h < numHops; ++h) {
+                Connect(factory, "push", "pull", *out, fHops[h].fIn, tools::ToString(address, "_hop_", h));
+                out = &fHops[h].fOut;
+            }
+            Connect(factory, "push", "pull", *out, fServerIn, address + "_fwd");
+            if (needsReply) {
+                Connect(factory, "push", "pull", fServerOut, fClientIn, address + "_bwd");
+            }
+        } else if (pattern == "pair" || pattern == "req-rep") {
+            bool reqRep = pattern == "req-rep";
+            Connect(factory, reqRep ? "req" : "pair", reqRep ? "rep" : "pair", fClientOut, fServerIn, address);
+        } else {
+            throw runtime_error(tools::ToString("unknown pattern '", pattern, "', expected push-pull/pair/req-rep"));
+        }
+    }
+
+    // bidirectional patterns use one channel per side
+    Channel& ClientIn() { return fClientIn ? *fClientIn : *fClientOut; }
+    Channel& ServerOut() { return fServerOut ? *fServerOut : *fServerIn; }
+
+    static void Connect(shared_ptr<TransportFactory> factory, const string& clientType, const string& serverType,
+                        unique_ptr<Channel>& client, unique_ptr<Channel>& server, const string& address)
+    {
+        server = make_unique<Channel>(tools::ToString("server_", serverType), serverType, factory);
+        client = make_unique<Channel>(tools::ToString("client_", clientType), clientType, factory);
+        if (!server->Bind(address) || !client->Connect(address)) {
+            throw runtime_error(tools::ToString("could not connect ", address));
+        }
+    }
+};
+
+Parts MakeMessage(Channel& channel, const Case& c, uint64_t timestamp)
+{
+    Parts parts;
+    for (int p = 0; p < c.fNumParts; ++p) {
+        // the first part carries the send time, it needs at least 8 bytes
+        parts.AddPart(channel.NewMessage(p == 0 ? max(c.fMsgSize, sizeof(timestamp)) : c.fMsgSize));
+    }
+    memcpy(parts.At(0)->GetData(), &timestamp, sizeof(timestamp));
+    return parts;
+}
+
+uint64_t Timestamp(const Parts& parts)
+{
+    uint64_t timestamp = 0;
+    memcpy(&timestamp, parts.At(0)->GetData(), sizeof(timestamp));
+    return timestamp;
+}
+
+void Transfer(int64_t result, const char* what)
+{
+    if (result < 0) {
+        throw runtime_error(tools::ToString("failed to ", what, " (", result, ")"));
+    }
+}
+
+/// client side, returns the duration of the measured iterations
+double RunClient(Link& link, const Case& c, const Config& cfg, bool reply, tools::LatencyHistogram& latency)
+{
+    tools::RateLimiter rateLimiter(cfg.fRate);
+    clock_type::time_point start;
+    for (uint64_t i = 0; i < cfg.fWarmup + cfg.fIterations; ++i) {
+        if (i == cfg.fWarmup) {
+            start = clock_type::now();
+        }
+        Parts parts = MakeMessage(*link.fClientOut, c, Now());
+        Transfer(link.fClientOut->Send(parts), "send");
+        if (reply) {
+            Parts answer;
+            Transfer(link.ClientIn().Receive(answer), "receive a reply");
+            if (cfg.fMode == "rtt" && i >= cfg.fWarmup) {
+                latency.Record(Now() - Timestamp(answer));
+            }
+        }
+        if (cfg.fRate > 0) {
+            rateLimiter.maybe_sleep();
+        }
+    }
+    return chrono::duration<double>(clock_type::now() - start).count();
+}
+
+/// forwards all messages of the client
+void RunHop(Hop& hop, const Config& cfg)
+{
+    for (uint64_t i = 0; i < cfg.fWarmup + cfg.fIterations; ++i) {
+        Transfer(hop.fIn->Forward(*hop.fOut, true), "forward");
+    }
+}
+
+/// server side, returns the duration of the measured iterations
+double RunServer(Link& link, const Config& cfg, bool reply, tools::LatencyHistogram& latency)
+{
+    clock_type::time_point start = clock_type::now();
+    for (uint64_t i = 0; i < cfg.fWarmup + cfg.fIterations; ++i) {
+        Parts parts;
+        Transfer(link.fServerIn->Receive(parts), "receive");
+        uint64_t now = Now();
+        if (i + 1 == cfg.fWarmup) {
+            start = clock_type::now();
+        }
+        if (cfg.fMode == "oneway" && i >= cfg.fWarmup) {
+            latency.Record(now - Timestamp(parts));
+        }
+        if (reply) {
+            if (cfg.fMode == "rtt") {
+                Transfer(link.ServerOut().Send(parts), "send a reply");
+            } else {
+                MessagePtr ack(link.ServerOut().NewMessage());
+                Transfer(link.ServerOut().Send(ack), "send a reply");
+            }
+        }
+    }
+    return chrono::duration<double>(clock_type::now() - start).count();
+}
+
+Result Run(shared_ptr<TransportFactory> factory, const Case& c, const Config& cfg)
+{
+    bool reply = cfg.fMode == "rtt" || c.fPattern == "req-rep";
+    vector<unique_ptr<Link>> links;
+    string prefix(tools::ToString("ipc://fairmq_bench_", tools::UuidHash()));
+    for (int t = 0; t < c.fNumThreads; ++t) {
+        links.push_back(make_unique<Link>(factory, c.fPattern, c.fNumHops, reply, tools::ToString(prefix, "_", t)));
+    }
+
+    vector<tools::LatencyHistogram> latencies(c.fNumThreads, tools::LatencyHistogram(cfg.fPrecision));
+    vector<double> seconds(c.fNumThreads, 0.);
+    vector<exception_ptr> errors((2 + c.fNumHops) * c.fNumThreads);
+    vector<thread> threads;
+    for (int t = 0; t < c.fNumThreads; ++t) {
+        for (int h = 0; h < c.fNumHops; ++h) {
+            threads.emplace_back([&, t, h]() {
+                try {
+                    RunHop(links[t]->fHops[h], cfg);
+                } catch (...) {
+                    errors[2 * c.fNumThreads + t * c.fNumHops + h] = current_exception();
+                }
+            });
+        }
+        threads.emplace_back([&, t]() {
+            try {
+                double s = RunServer(*links[t], cfg, reply, latencies[t]);
+                if (cfg.fMode == "oneway") {
+                    seconds[t] = s;
+                }
+            } catch (...) {
+                errors[2 * t] = current_exception();
+            }
+        });
+        threads.emplace_back([&, t]() {
+            try {
+                double s = RunClient(*links[t], c, cfg, reply, latencies[t]);
+                if (cfg.fMode == "rtt") {
+                    seconds[t] = s;
+                }
+            } catch (...) {
+                errors[2 * t + 1] = current_exception();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (auto& error : errors) {
+        if (error) {
+            rethrow_exception(error);
+        }
+    }
+
+    Result result{c, tools::LatencyHistogram(cfg.fPrecision)};
+    for (int t = 0; t < c.fNumThreads; ++t) {
+        result.fLatency.Merge(latencies[t]);
+        result.fSeconds = max(result.fSeconds, seconds[t]);
+    }
+    result.fMessages = cfg.fIterations * c.fNumThreads;
+    return result;
+}
+
+const vector<pair<string, double>> kPercentiles = {{"p50", 50.}, {"p90", 90.}, {"p99", 99.}, {"p99.9", 99.9}};
+
+void PrintTableHeader(ostream& os)
+{
+    os << setw(9) << "transport" << setw(10) << "pattern" << setw(11) << "size" << setw(6) << "parts" << setw(8) << "threads"
+       << setw(5) << "hops" << setw(13) << "msg/s" << setw(11) << "MB/s";
+    os << setw(10) << "min [us]";
+    for (const auto& p : kPercentiles) {
+        os << setw(10) << p.first;
+    }
+    os << setw(10) << "max" << setw(10) << "stddev" << endl;
+}
+
+void Print(ostream& os, const string& format, const Config& cfg, const Result& r, bool first)
+{
+    const Case& c = r.fCase;
+    const tools::LatencyHistogram& h = r.fLatency;
+    double msgRate = r.fSeconds > 0. ? r.fMessages / r.fSeconds : 0.;
+    double mbRate = msgRate * c.fMsgSize * c.fNumParts / 1e6;
+
+    if (format == "table") {
+        if (first) {
+            PrintTableHeader(os);
+        }
+        os << setw(9) << c.fTransport << setw(10) << c.fPattern << setw(11) << c.fMsgSize << setw(6) << c.fNumParts << setw(8) << c.fNumThreads
+           << setw(5) << c.fNumHops << fixed << setprecision(0) << setw(13) << msgRate << setprecision(1) << setw(11) << mbRate << setprecision(2)
+           << setw(10) << h.GetMin() / 1000.;
+        for (const auto& p : kPercentiles) {
+            os << setw(10) << h.Percentile(p.second) / 1000.;
+        }
+        os << setw(10) << h.GetMax() / 1000. << setw(10) << h.GetStdDev() / 1000. << endl;
+    } else if (format == "csv") {
+        if (first) {
+            os << "mode,transport,pattern,msg_size,parts,threads,hops,iterations,msgs_per_s,mb_per_s,min_ns,p50_ns,p90_ns,p99_ns,p999_ns,max_ns,mean_ns,stddev_ns" << endl;
+        }
+        os << cfg.fMode << "," << c.fTransport << "," << c.fPattern << "," << c.fMsgSize << "," << c.fNumParts << "," << c.fNumThreads << "," << c.fNumHops << ","
+           << cfg.fIterations << "," << fixed << setprecision(1) << msgRate << "," << setprecision(3) << mbRate << "," << h.GetMin();
+        for (const auto& p : kPercentiles) {
+            os << "," << h.Percentile(p.second);
+        }
+        os << "," << h.GetMax() << "," << setprecision(1) << h.GetMean() << "," << h.GetStdDev() << endl;
+    } else {
+        os << (first ? "[\n" : ",\n")
+           << "  {\"mode\": \"" << cfg.fMode << "\", \"transport\": \"" << c.fTransport << "\", \"pattern\": \"" << c.fPattern
+           << "\", \"msg_size\": " << c.fMsgSize << ", \"parts\": " << c.fNumParts << ", \"threads\": " << c.fNumThreads
+           << ", \"hops\": " << c.fNumHops << ", \"iterations\": " << cfg.fIterations << fixed << setprecision(1) << ", \"msgs_per_s\": " << msgRate
+           << setprecision(3) << ", \"mb_per_s\": " << mbRate << ", \"latency_ns\": {\"min\": " << h.GetMin();
+        for (const auto& p : kPercentiles) {
+            os << ", \"" << p.first << "\": " << h.Percentile(p.second);
+        }
+        os << ", \"max\": " << h.GetMax() << setprecision(1) << ", \"mean\": " << h.GetMean() << ", \"stddev\": " << h.GetStdDev() << "}}";
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try {
+        Config cfg{};
+        vector<string> transports;
+        vector<string> patterns;
+        vector<size_t> sizes;
+        vector<int> parts;
+        vector<int> threads;
+        vector<int> hops;
+        string format;
+        string output;
+        size_t segmentSize = 0;
+
+        options_description desc("Options");
+        desc.add_options()
+            ("mode,m", value<string>(&cfg.fMode)->default_value("oneway"), "Latency mode: oneway (send to receive) / rtt (round trip)")
+            ("transport,t", value<vector<string>>(&transports)->multitoken()->default_value({"zeromq", "shmem"}, "zeromq shmem"), "Transports")
+            ("pattern,p", value<vector<string>>(&patterns)->multitoken()->default_value({"push-pull"}, "push-pull"), "Patterns: push-pull / pair / req-rep")
+            ("msg-size,s", value<vector<size_t>>(&sizes)->multitoken()->default_value({64, 4096, 1048576}, "64 4096 1048576"), "Message (part) sizes in bytes")
+            ("parts", value<vector<int>>(&parts)->multitoken()->default_value({1}, "1"), "Numbers of parts per message")
+            ("threads", value<vector<int>>(&threads)->multitoken()->default_value({1}, "1"), "Numbers of concurrent client/server pairs")
+            ("hops", value<vector<int>>(&hops)->multitoken()->default_value({0}, "0"), "Numbers of forwarding hops between client and server (push-pull)")
+            ("iterations,n", value<uint64_t>(&cfg.fIterations)->default_value(10000), "Measured messages per client")
+            ("warmup", value<uint64_t>(&cfg.fWarmup)->default_value(1000), "Messages per client before the measurement")
+            ("rate", value<float>(&cfg.fRate)->default_value(0), "Messages per second per client (0 - as fast as possible)")
+            ("precision", value<unsigned int>(&cfg.fPrecision)->default_value(7), "Histogram precision in bits (relative error 2^-precision)")
+            ("format,f", value<string>(&format)->default_value("table"), "Output format: table / csv / json")
+            ("output,o", value<string>(&output)->default_value(""), "Output file (default: stdout)")
+            ("shm-segment-size", value<size_t>(&segmentSize)->default_value(2000000000), "Size of the shmem segment (in bytes)")
+            ("help,h", "Print help");
+
+        variables_map vm;
+        store(parse_command_line(argc, argv, desc), vm);
+        notify(vm);
+
+        if (vm.count("help")) {
+            cout << "FairMQ latency and throughput benchmark" << endl << desc << endl;
+            return 0;
+        }
+
+        if ((cfg.fMode != "oneway" && cfg.fMode != "rtt") || (format != "table" && format != "csv" && format != "json") || cfg.fIterations == 0) {
+            cerr << "invalid mode/format/iterations, see --help" << endl;
+            return 1;
+        }
+
+        ofstream file;
+        if (!output.empty()) {
+            file.open(output);
+            if (!file) {
+                cerr << "could not open '" << output << "'" << endl;
+                return 1;
+            }
+        }
+        ostream& os = output.empty() ? cout : file;
+
+        if (format == "table") {
+            os << "mode: " << cfg.fMode << ", " << cfg.fIterations << " iterations (+" << cfg.fWarmup << " warmup)"
+               << (cfg.fRate > 0 ? tools::ToString(" at ", cfg.fRate, " msg/s") : "") << ", latencies in us" << endl;
+        }
+
+        bool first = true;
+        for (const auto& transport : transports) {
+            ProgOptions config;
+            config.SetProperty<string>("session", tools::Uuid());
+            config.SetProperty<size_t>("shm-segment-size", segmentSize);
+            auto factory = TransportFactory::CreateTransportFactory(transport, tools::Uuid(), &config);
+
+            for (const auto& pattern : patterns) {
+                for (size_t size : sizes) {
+                    for (int numParts : parts) {
+                        for (int numThreads : threads) {
+                            for (int numHops : hops) {
+                                if (numParts < 1 || numThreads < 1 || numHops < 0) {
+                                    continue;
+                                }
+                                Result result = Run(factory, Case{transport, pattern, size, numParts, numThreads, numHops}, cfg);
+                                Print(os, format, cfg, result, first);
+                                first = false;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        if (format == "json") {
+            os << (first ? "[]\n" : "\n]\n");
+        }
+
+        return 0;
+    } catch (exception& e) {
+        cerr << "Unhandled Exception reached the top of main: " << e.what() << ", application will now exit" << endl;
+        return 2;
+    }
+}
@@ -0,0 +1,198 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include <fairmq/Channel.h>
+#include <fairmq/Parts.h>
+#include <fairmq/ProgOptions.h>
+#include <fairmq/TransportFactory.h>
+#include <fairmq/tools/Strings.h>
+#include <fairmq/tools/Unique.h>
+
+#include <boost/program_options.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Measures the cost of sending one multipart message to a number of outputs (as the Multiplier device does),
+// once by copying the message for every output, and once with Channel::SendToAll().
+// Only the send side is timed, the outputs are drained outside of the measurement.
+
+using namespace std;
+using namespace boost::program_options;
+using namespace fair::mq;
+
+namespace
+{
+
+struct Config
+{
+    string fTransport;
+    int fNumParts;
+    size_t fPartSize;
+    uint64_t fIterations;
+    vector<int> fOutputs;
+};
+
+struct Outputs
+{
+    vector<unique_ptr<Channel>> fPushes;
+    vector<unique_ptr<Channel>> fPulls;
+    vector<Channel*> fChannels;
+};
+
+Outputs Connect(shared_ptr<TransportFactory> factory, int numOutputs, const string& prefix)
+{
+    Outputs outputs;
+    for (int i = 0; i < numOutputs; ++i) {
+        string address(tools::ToString("inproc://", prefix, "_", i));
+        outputs.fPulls.push_back(make_unique<Channel>(tools::ToString("pull", i), "pull", factory));
+        outputs.fPushes.push_back(make_unique<Channel>(tools::ToString("push", i), "push", factory));
+        if (!outputs.fPulls.back()->Bind(address) || !outputs.fPushes.back()->Connect(address)) {
+            throw runtime_error(tools::ToString("could not connect ", address));
+        }
+        outputs.fChannels.push_back(outputs.fPushes.back().get());
+    }
+    return outputs;
+}
+
+Parts MakeParts(Channel& channel, const Config& cfg)
+{
+    Parts parts;
+    for (int p = 0; p < cfg.fNumParts; ++p) {
+        parts.AddPart(channel.NewMessage(cfg.fPartSize));
+    }
+    return parts;
+}
+
+void Drain(Outputs& outputs)
+{
+    for (auto& pull : outputs.fPulls) {
+        Parts parts;
+        if (pull->Receive(parts) < 0) {
+            throw runtime_error("could not receive");
+        }
+    }
+}
+
+uint64_t CopyToAll(Outputs& outputs, Parts& parts)
+{
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < outputs.fChannels.size(); ++i) {
+        Channel& channel = *outputs.fChannels[i];
+        if (i + 1 < outputs.fChannels.size()) {
+            Parts copy;
+            for (const auto& part : parts) {
+                copy.AddPart(channel.NewMessage());
+                copy.fParts.back()->Copy(*part);
+            }
+            channel.Send(copy);
+        } else {
+            channel.Send(parts);
+        }
+    }
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+}
+
+uint64_t SendToAll(Outputs& outputs, Parts& parts)
+{
+    auto start = chrono::steady_clock::now();
+    Channel::SendToAll(outputs.fChannels, parts);
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+}
+
+void Run(shared_ptr<TransportFactory> factory, const Config& cfg, int numOutputs)
+{
+    Outputs outputs = Connect(factory, numOutputs, tools::ToString("fanout_bench_", tools::UuidHash()));
+
+    uint64_t copyNs = 0;
+    uint64_t sharedNs = 0;
+    for (uint64_t i = 0; i < cfg.fIterations; ++i) {
+        Parts parts = MakeParts(*outputs.fChannels.front(), cfg);
+        copyNs += CopyToAll(outputs, parts);
+        Drain(outputs);
+
+        parts = MakeParts(*outputs.fChannels.front(), cfg);
+        sharedNs += SendToAll(outputs, parts);
+        Drain(outputs);
+    }
+
+    double copyUs = copyNs / 1000. / cfg.fIterations;
+    double sharedUs = sharedNs / 1000. / cfg.fIterations;
+    cout << setw(8) << numOutputs
+         << setw(14) << fixed << setprecision(2) << copyUs
+         << setw(14) << copyUs / numOutputs
+         << setw(14) << sharedUs
+         << setw(14) << sharedUs / numOutputs
+         << setw(10) << setprecision(1) << (sharedUs > 0. ? copyUs / sharedUs : 0.)
+         << endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try {
+        Config cfg{};
+        size_t segmentSize = 0;
+
+        options_description desc("Options");
+        desc.add_options()
+            ("transport,t", value<string>(&cfg.fTransport)->default_value("shmem"), "Transport: shmem/zeromq")
+            ("outputs,o", value<vector<int>>(&cfg.fOutputs)->multitoken()->default_value({1, 2, 4, 8, 16}, "1 2 4 8 16"), "Numbers of outputs to measure")
+            ("parts,p", value<int>(&cfg.fNumParts)->default_value(64), "Number of parts of the message")
+            ("part-size,s", value<size_t>(&cfg.fPartSize)->default_value(1024), "Size of each part (in bytes)")
+            ("iterations,n", value<uint64_t>(&cfg.fIterations)->default_value(10000), "Messages sent per number of outputs and method")
+            ("shm-segment-size", value<size_t>(&segmentSize)->default_value(512000000), "Size of the shmem segment (in bytes)")
+            ("help,h", "Print help");
+
+        variables_map vm;
+        store(parse_command_line(argc, argv, desc), vm);
+        notify(vm);
+
+        if (vm.count("help")) {
+            cout << "Benchmark of sending one message to multiple outputs" << endl << desc << endl;
+            return 0;
+        }
+
+        if (cfg.fNumParts < 1 || cfg.fIterations == 0 || cfg.fOutputs.empty()) {
+            cout << "invalid parts/iterations/outputs" << endl;
+            return 1;
+        }
+
+        ProgOptions config;
+        config.SetProperty<string>("session", tools::Uuid());
+        config.SetProperty<size_t>("shm-segment-size", segmentSize);
+        auto factory = TransportFactory::CreateTransportFactory(cfg.fTransport, tools::Uuid(), &config);
+
+        cout << "transport: " << cfg.fTransport << ", " << cfg.fNumParts << " parts of " << cfg.fPartSize << " bytes, "
+             << cfg.fIterations << " iterations" << endl;
+        cout << setw(8) << "outputs"
+             << setw(14) << "copy [us]"
+             << setw(14) << "per output"
+             << setw(14) << "shared [us]"
+             << setw(14) << "per output"
+             << setw(10) << "speedup"
+             << endl;
+        for (int numOutputs : cfg.fOutputs) {
+            if (numOutputs < 1) {
+                continue;
+            }
+            Run(factory, cfg, numOutputs);
+        }
+
+        return 0;
+    } catch (exception& e) {
+        cerr << "Unhandled Exception reached the top of main: " << e.what() << ", application will now exit" << endl;
+        return 2;
+    }
+}
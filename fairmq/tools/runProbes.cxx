@@ -0,0 +1,180 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include <fairmq/Probes.h>
+#include <fairmq/tools/Histogram.h>
+
+#include <boost/program_options.hpp>
+
+#include <algorithm> // std::min, std::max
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility> // std::pair
+#include <vector>
+
+// Summarizes the files written by the probes recorder (see <fairmq/Probes.h>, FAIRMQ_PROBES_FILE):
+//  - for every pair of <name>_begin/<name>_end probes the distribution of the durations in between (matched per thread,
+//    nested pairs of the same name are matched inside out),
+//  - for the other probes the number of events, the rate and the mean of their argument.
+// Events of several files (processes) are combined.
+
+using namespace std;
+using namespace boost::program_options;
+using namespace fair::mq;
+
+namespace
+{
+
+struct Point
+{
+    uint64_t fCount = 0;
+    double fArgSum = 0.;
+};
+
+struct Summary
+{
+    explicit Summary(unsigned int precision) : fPrecision(precision) {}
+
+    void Add(const probes::Recording& rec)
+    {
+        // begin times of the open scopes, per thread and scope name
+        map<pair<uint32_t, string>, vector<uint64_t>> open;
+        for (const auto& event : rec.fEvents) {
+            if (event.fProbe == probes::kDropped) {
+                fDropped += event.fArg;
+                continue;
+            }
+            fFirst = min(fFirst, event.fTimeNs);
+            fLast = max(fLast, event.fTimeNs);
+            const string& name = rec.fProbeNames.at(event.fProbe);
+            if (EndsWith(name, "_begin")) {
+                open[{event.fThread, name.substr(0, name.size() - 6)}].push_back(event.fTimeNs);
+            } else if (EndsWith(name, "_end")) {
+                string const scope = name.substr(0, name.size() - 4);
+                auto& begins = open[{event.fThread, scope}];
+                if (begins.empty()) {
+                    continue; // begin not recorded (recorder started in between or event dropped)
+                }
+                uint64_t const begin = begins.back();
+                begins.pop_back();
+                auto it = fScopes.try_emplace(scope, fPrecision).first;
+                it->second.Record(event.fTimeNs > begin ? event.fTimeNs - begin : 0);
+            } else {
+                Point& point = fPoints[name];
+                ++point.fCount;
+                point.fArgSum += static_cast<double>(event.fArg);
+            }
+        }
+    }
+
+    void Print(ostream& os, bool csv) const
+    {
+        double const seconds = fLast > fFirst ? static_cast<double>(fLast - fFirst) / 1e9 : 0.;
+        if (csv) {
+            os << "probe,count,mean_ns,p50_ns,p90_ns,p99_ns,max_ns,rate_per_s,mean_arg\n";
+            for (const auto& [name, hist] : fScopes) {
+                os << name << ',' << hist.GetCount() << ',' << hist.GetMean() << ',' << hist.Percentile(50.) << ',' << hist.Percentile(90.) << ','
+                   << hist.Percentile(99.) << ',' << hist.GetMax() << ',' << Rate(hist.GetCount(), seconds) << ",\n";
+            }
+            for (const auto& [name, point] : fPoints) {
+                os << name << ',' << point.fCount << ",,,,,," << Rate(point.fCount, seconds) << ',' << point.fArgSum / static_cast<double>(point.fCount) << '\n';
+            }
+            return;
+        }
+
+        os << "recorded " << fixed << setprecision(3) << seconds << " s" << (fDropped > 0 ? ", " + to_string(fDropped) + " events dropped" : "") << "\n\n";
+        os << left << setw(20) << "scope" << right << setw(12) << "count" << setw(12) << "mean [ns]" << setw(12) << "p50 [ns]"
+           << setw(12) << "p90 [ns]" << setw(12) << "p99 [ns]" << setw(12) << "max [ns]" << setw(14) << "rate [1/s]" << '\n';
+        for (const auto& [name, hist] : fScopes) {
+            os << left << setw(20) << name << right << setw(12) << hist.GetCount() << setw(12) << setprecision(0) << hist.GetMean()
+               << setw(12) << hist.Percentile(50.) << setw(12) << hist.Percentile(90.) << setw(12) << hist.Percentile(99.) << setw(12)
+               << hist.GetMax() << setw(14) << Rate(hist.GetCount(), seconds) << '\n';
+        }
+        os << '\n' << left << setw(20) << "probe" << right << setw(12) << "count" << setw(14) << "rate [1/s]" << setw(12) << "mean arg" << '\n';
+        for (const auto& [name, point] : fPoints) {
+            os << left << setw(20) << name << right << setw(12) << point.fCount << setw(14) << setprecision(0) << Rate(point.fCount, seconds)
+               << setw(12) << setprecision(2) << point.fArgSum / static_cast<double>(point.fCount) << '\n';
+        }
+    }
+
+  private:
+    static bool EndsWith(const string& s, const string& suffix)
+    {
+        return s.size() > suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    static double Rate(uint64_t count, double seconds) { return seconds > 0. ? static_cast<double>(count) / seconds : 0.; }
+
+    unsigned int fPrecision;
+    map<string, tools::LatencyHistogram> fScopes;
+    map<string, Point> fPoints;
+    uint64_t fFirst = UINT64_MAX;
+    uint64_t fLast = 0;
+    uint64_t fDropped = 0;
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    try {
+        vector<string> files;
+        string format;
+        unsigned int precision = 7;
+
+        options_description desc("Options");
+        desc.add_options()
+            ("file", value<vector<string>>(&files)->multitoken()->required(), "Files written by the probes recorder (FAIRMQ_PROBES_FILE)")
+            ("format,f", value<string>(&format)->default_value("table"), "Output format: table / csv")
+            ("precision", value<unsigned int>(&precision)->default_value(7), "Histogram precision in bits (relative error 2^-precision)")
+            ("help,h", "Print help");
+        positional_options_description positional;
+        positional.add("file", -1);
+
+        variables_map vm;
+        store(command_line_parser(argc, argv).options(desc).positional(positional).run(), vm);
+
+        if (vm.count("help")) {
+            cout << "Summary of FairMQ transport probes recordings" << endl
+                 << "Usage: fairmq-probes [options] <file>..." << endl << desc << endl;
+            return 0;
+        }
+        notify(vm);
+
+        if (format != "table" && format != "csv") {
+            cerr << "invalid format, see --help" << endl;
+            return 1;
+        }
+
+        Summary summary(precision);
+        for (const auto& file : files) {
+            ifstream in(file, ios::binary);
+            if (!in) {
+                cerr << "could not open '" << file << "'" << endl;
+                return 1;
+            }
+            try {
+                summary.Add(probes::ReadRecording(in));
+            } catch (probes::ProbesError& e) {
+                cerr << file << ": " << e.what() << endl;
+                return 1;
+            }
+        }
+        summary.Print(cout, format == "csv");
+
+        return 0;
+    } catch (exception& e) {
+        cerr << "Unhandled Exception reached the top of main: " << e.what() << ", application will now exit" << endl;
+        return 2;
+    }
+}
@@ -10,7 +10,11 @@
 
 #include <fairlogger/Logger.h>
 #include <fairmq/Error.h>
+#include <fairmq/Poller.h>
 #include <fairmq/tools/Strings.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <stdexcept>
 #include <string_view>
 #include <zmq.h>
@@ -61,7 +65,8 @@ inline bool Connect(void* socket, const std::string& address, const std::string&
     return true;
 }
 
-inline bool ShouldRetry(int flags, int socketTimeout, int userTimeout, int& elapsed)
+/// called when a transfer returned EAGAIN/EINTR, counts the retries (each one follows a socket timeout or an interruption)
+inline bool ShouldRetry(int flags, int socketTimeout, int userTimeout, int& elapsed, std::atomic<unsigned long>& retries)
 {
     if ((flags & ZMQ_DONTWAIT) == 0) {
         if (userTimeout > 0) {
@@ -70,6 +75,7 @@ inline bool ShouldRetry(int flags, int socketTimeout, int userTimeout, int& elap
                 return false;
             }
         }
+        ++retries;
         return true;
     } else {
         return false;
@@ -87,6 +93,53 @@ inline int HandleErrors(const std::string& id)
     }
 }
 
+/// Non-blocking readiness check of the poll items via ZMQ_EVENTS (no system call, unlike zmq_poll), sets their revents.
+/// @return number of ready items, -1 if the context was terminated
+inline int PollEvents(zmq_pollitem_t* items, int numItems)
+{
+    int numReady = 0;
+    for (int i = 0; i < numItems; ++i) {
+        items[i].revents = 0;
+        if (items[i].events == 0 || !items[i].socket) {
+            continue;
+        }
+        int events = 0;
+        size_t size = sizeof(events);
+        if (zmq_getsockopt(items[i].socket, ZMQ_EVENTS, &events, &size) != 0) {
+            if (errno == ETERM) {
+                return -1;
+            }
+            continue;
+        }
+        items[i].revents = static_cast<short>(events & items[i].events);
+        if (items[i].revents != 0) {
+            ++numReady;
+        }
+    }
+    return numReady;
+}
+
+/// Busy-polls the items with PollEvents() for up to spinTime, but no longer than timeout (ms, negative: infinite).
+/// Reduces timeout by the time spent and adds it to the statistics.
+/// @return number of ready items, -1 if the context was terminated
+inline int SpinPoll(zmq_pollitem_t* items, int numItems, std::chrono::microseconds spinTime, int& timeout, PollerStats& stats)
+{
+    auto const start = std::chrono::steady_clock::now();
+    auto const end = start + (timeout >= 0 ? std::min<std::chrono::microseconds>(spinTime, std::chrono::milliseconds(timeout)) : spinTime);
+    auto now = start;
+    int numReady = 0;
+    do {
+        numReady = PollEvents(items, numItems);
+        now = std::chrono::steady_clock::now();
+    } while (numReady == 0 && now < end);
+
+    stats.spinTimeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count();
+    if (timeout > 0) {
+        timeout = std::max(0, timeout - static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count()));
+    }
+    return numReady;
+}
+
 /// Lookup table for various zmq constants
 inline auto getConstant(std::string_view constant) -> int
 {
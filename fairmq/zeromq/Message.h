@@ -12,6 +12,7 @@
 #include <fairmq/zeromq/UnmanagedRegion.h>
 #include <fairmq/Message.h>
 #include <fairmq/UnmanagedRegion.h>
+#include <fairmq/tools/ObjectPool.h>
 
 #include <fairlogger/Logger.h>
 
@@ -20,7 +21,6 @@
 #include <cstddef>
 #include <cstdlib> // malloc
 #include <cstring>
-#include <memory> // make_unique
 #include <new> // bad_alloc
 #include <string>
 
@@ -41,9 +41,8 @@ class Message final : public fair::mq::Message
 
     Message(fair::mq::TransportFactory* factory = nullptr)
         : fair::mq::Message(factory)
-        , fMsg(std::make_unique<zmq_msg_t>())
     {
-        if (zmq_msg_init(fMsg.get()) != 0) {
+        if (zmq_msg_init(&fMsg) != 0) {
             LOG(error) << "failed initializing message, reason: " << zmq_strerror(errno);
         }
     }
@@ -51,18 +50,16 @@ class Message final : public fair::mq::Message
     Message(Alignment alignment, fair::mq::TransportFactory* factory = nullptr)
         : fair::mq::Message(factory)
         , fAlignment(alignment.alignment)
-        , fMsg(std::make_unique<zmq_msg_t>())
     {
-        if (zmq_msg_init(fMsg.get()) != 0) {
+        if (zmq_msg_init(&fMsg) != 0) {
             LOG(error) << "failed initializing message, reason: " << zmq_strerror(errno);
         }
     }
 
     Message(const size_t size, fair::mq::TransportFactory* factory = nullptr)
         : fair::mq::Message(factory)
-        , fMsg(std::make_unique<zmq_msg_t>())
     {
-        if (zmq_msg_init_size(fMsg.get(), size) != 0) {
+        if (zmq_msg_init_size(&fMsg, size) != 0) {
             LOG(error) << "failed initializing message with size, reason: " << zmq_strerror(errno);
         }
     }
@@ -84,15 +81,14 @@ class Message final : public fair::mq::Message
     Message(const size_t size, Alignment alignment, fair::mq::TransportFactory* factory = nullptr)
         : fair::mq::Message(factory)
         , fAlignment(alignment.alignment)
-        , fMsg(std::make_unique<zmq_msg_t>())
     {
         if (fAlignment != 0) {
             auto ptrs = AllocateAligned(size, fAlignment);
-            if (zmq_msg_init_data(fMsg.get(), ptrs.second, size, [](void* /* data */, void* hint) { free(hint); }, ptrs.first) != 0) {
+            if (zmq_msg_init_data(&fMsg, ptrs.second, size, [](void* /* data */, void* hint) { free(hint); }, ptrs.first) != 0) {
                 LOG(error) << "failed initializing message with size, reason: " << zmq_strerror(errno);
             }
         } else {
-            if (zmq_msg_init_size(fMsg.get(), size) != 0) {
+            if (zmq_msg_init_size(&fMsg, size) != 0) {
                 LOG(error) << "failed initializing message with size, reason: " << zmq_strerror(errno);
             }
         }
@@ -100,50 +96,35 @@ class Message final : public fair::mq::Message
 
     Message(void* data, const size_t size, fair::mq::FreeFn* ffn, void* hint = nullptr, fair::mq::TransportFactory* factory = nullptr)
         : fair::mq::Message(factory)
-        , fMsg(std::make_unique<zmq_msg_t>())
     {
-        if (zmq_msg_init_data(fMsg.get(), data, size, ffn, hint) != 0) {
+        if (zmq_msg_init_data(&fMsg, data, size, ffn, hint) != 0) {
             LOG(error) << "failed initializing message with data, reason: " << zmq_strerror(errno);
         }
     }
 
     Message(UnmanagedRegionPtr& region, void* data, const size_t size, void* hint = 0, fair::mq::TransportFactory* factory = nullptr)
         : fair::mq::Message(factory)
-        , fMsg(std::make_unique<zmq_msg_t>())
     {
         if (region->GetType() != GetType()) {
             LOG(error) << "region type (" << region->GetType() << ") does not match message type (" << GetType() << ")";
             throw TransportError(tools::ToString("region type (", region->GetType(), ") does not match message type (", GetType(), ")"));
         }
 
-        // FIXME: make this zero-copy:
-        // simply taking over the provided buffer can casue premature delete, since region could be
-        // destroyed before the message is sent out. Needs lifetime extension for the ZMQ region.
-        if (zmq_msg_init_size(fMsg.get(), size) != 0) {
-            LOG(error) << "failed initializing message with size, reason: " << zmq_strerror(errno);
-        }
-
-        std::memcpy(zmq_msg_data(fMsg.get()), data, size);
-        // call region callback
-        auto ptr = static_cast<UnmanagedRegion*>(region.get());
-        if (ptr->fBulkCallback) {
-            ptr->fBulkCallback({{data, size, hint}});
-        } else if (ptr->fCallback) {
-            ptr->fCallback(data, size, hint);
+        // zero-copy: the message points into the region buffer. The block is handed back to the region
+        // (and the region callback is called) only once ZeroMQ releases the message.
+        auto zRegion = static_cast<UnmanagedRegion*>(region.get());
+        void* block = zRegion->AcquireBlock(size, hint);
+        if (zmq_msg_init_data(&fMsg, data, size, &UnmanagedRegion::ReleaseBlock, block) != 0) {
+            LOG(error) << "failed initializing message with region data, reason: " << zmq_strerror(errno);
+            UnmanagedRegion::ReleaseBlock(data, block);
+            zmq_msg_init(&fMsg);
         }
-
-        // if (zmq_msg_init_data(fMsg.get(), data, size, [](void*, void*){}, nullptr) != 0)
-        // {
-        //     LOG(error) << "failed initializing message with data, reason: " <<
-        //     zmq_strerror(errno);
-        // }
     }
 
     void Rebuild() override
     {
         CloseMessage();
-        fMsg = std::make_unique<zmq_msg_t>();
-        if (zmq_msg_init(fMsg.get()) != 0) {
+        if (zmq_msg_init(&fMsg) != 0) {
             LOG(error) << "failed initializing message, reason: " << zmq_strerror(errno);
         }
     }
@@ -152,8 +133,7 @@ class Message final : public fair::mq::Message
     {
         CloseMessage();
         fAlignment = alignment.alignment;
-        fMsg = std::make_unique<zmq_msg_t>();
-        if (zmq_msg_init(fMsg.get()) != 0) {
+        if (zmq_msg_init(&fMsg) != 0) {
             LOG(error) << "failed initializing message, reason: " << zmq_strerror(errno);
         }
     }
@@ -161,8 +141,7 @@ class Message final : public fair::mq::Message
     void Rebuild(size_t size) override
     {
         CloseMessage();
-        fMsg = std::make_unique<zmq_msg_t>();
-        if (zmq_msg_init_size(fMsg.get(), size) != 0) {
+        if (zmq_msg_init_size(&fMsg, size) != 0) {
             LOG(error) << "failed initializing message with size, reason: " << zmq_strerror(errno);
         }
     }
@@ -171,15 +150,13 @@ class Message final : public fair::mq::Message
     {
         CloseMessage();
         fAlignment = alignment.alignment;
-        fMsg = std::make_unique<zmq_msg_t>();
-
         if (fAlignment != 0) {
             auto ptrs = AllocateAligned(size, fAlignment);
-            if (zmq_msg_init_data(fMsg.get(), ptrs.second, size, [](void* /* data */, void* hint) { free(hint); }, ptrs.first) != 0) {
+            if (zmq_msg_init_data(&fMsg, ptrs.second, size, [](void* /* data */, void* hint) { free(hint); }, ptrs.first) != 0) {
                 LOG(error) << "failed initializing message with size, reason: " << zmq_strerror(errno);
             }
         } else {
-            if (zmq_msg_init_size(fMsg.get(), size) != 0) {
+            if (zmq_msg_init_size(&fMsg, size) != 0) {
                 LOG(error) << "failed initializing message with size, reason: " << zmq_strerror(errno);
             }
         }
@@ -188,22 +165,21 @@ class Message final : public fair::mq::Message
     void Rebuild(void* data, size_t size, fair::mq::FreeFn* ffn, void* hint = nullptr) override
     {
         CloseMessage();
-        fMsg = std::make_unique<zmq_msg_t>();
-        if (zmq_msg_init_data(fMsg.get(), data, size, ffn, hint) != 0) {
+        if (zmq_msg_init_data(&fMsg, data, size, ffn, hint) != 0) {
             LOG(error) << "failed initializing message with data, reason: " << zmq_strerror(errno);
         }
     }
 
     void* GetData() const override
     {
-        if (zmq_msg_size(fMsg.get()) > 0) {
-            return zmq_msg_data(fMsg.get());
+        if (zmq_msg_size(&fMsg) > 0) {
+            return zmq_msg_data(&fMsg);
         } else {
             return nullptr;
         }
     }
 
-    size_t GetSize() const override { return zmq_msg_size(fMsg.get()); }
+    size_t GetSize() const override { return zmq_msg_size(&fMsg); }
 
     // To emulate shrinking, a new message is created with the new size (ViewMsg), that points to
     // the original buffer with the new size. Once the "view message" is transfered, the original is
@@ -219,17 +195,20 @@ class Message final : public fair::mq::Message
             LOG(error) << "cannot set used size higher than original.";
             return false;
         } else {
-            auto newMsg = std::make_unique<zmq_msg_t>();
-            void* data = GetData();
-            if (zmq_msg_init_data(newMsg.get(), data, size, [](void* /* data */, void* obj) {
+            // the original message is moved out and kept alive by the view message
+            auto orig = static_cast<zmq_msg_t*>(tools::ObjectPool<zmq_msg_t>::Allocate(sizeof(zmq_msg_t)));
+            zmq_msg_init(orig);
+            zmq_msg_move(orig, &fMsg);
+            if (zmq_msg_init_data(&fMsg, zmq_msg_data(orig), size, [](void* /* data */, void* obj) {
                     zmq_msg_close(static_cast<zmq_msg_t*>(obj));
-                    delete static_cast<zmq_msg_t*>(obj);
-                }, fMsg.get()) != 0) {
+                    tools::ObjectPool<zmq_msg_t>::Deallocate(obj, sizeof(zmq_msg_t));
+                }, orig) != 0) {
                 LOG(error) << "failed initializing message with data, reason: " << zmq_strerror(errno);
+                zmq_msg_move(&fMsg, orig);
+                zmq_msg_close(orig);
+                tools::ObjectPool<zmq_msg_t>::Deallocate(orig, sizeof(zmq_msg_t));
                 return false;
             }
-            fMsg.release();
-            fMsg.swap(newMsg);
             return true;
         }
     }
@@ -244,7 +223,7 @@ class Message final : public fair::mq::Message
             if (data != nullptr && reinterpret_cast<uintptr_t>(GetData()) % fAlignment) {
                 // create new aligned buffer
                 auto ptrs = AllocateAligned(size, fAlignment);
-                std::memcpy(ptrs.second, zmq_msg_data(fMsg.get()), size);
+                std::memcpy(ptrs.second, zmq_msg_data(&fMsg), size);
                 // rebuild the message with the new buffer
                 Rebuild(ptrs.second, size, [](void* /* buf */, void* hint) { free(hint); }, ptrs.first);
             }
@@ -257,7 +236,7 @@ class Message final : public fair::mq::Message
     {
         const Message& zMsg = static_cast<const Message&>(msg);
         // Shares the message buffer between msg and this fMsg.
-        if (zmq_msg_copy(fMsg.get(), zMsg.GetMessage()) != 0) {
+        if (zmq_msg_copy(&fMsg, zMsg.GetMessage()) != 0) {
             LOG(error) << "failed copying message, reason: " << zmq_strerror(errno);
             return;
         }
@@ -265,19 +244,21 @@ class Message final : public fair::mq::Message
 
     ~Message() override { CloseMessage(); }
 
+    // message objects are recycled via per-thread free lists instead of the heap
+    static void* operator new(size_t size) { return tools::ObjectPool<Message>::Allocate(size); }
+    static void operator delete(void* ptr, size_t size) { tools::ObjectPool<Message>::Deallocate(ptr, size); }
+
   private:
     size_t fAlignment = 0;
-    std::unique_ptr<zmq_msg_t> fMsg;
+    mutable zmq_msg_t fMsg{}; // mutable for zmq_msg_data() in const getters
 
-    zmq_msg_t* GetMessage() const { return fMsg.get(); }
+    zmq_msg_t* GetMessage() const { return &fMsg; }
 
     void CloseMessage()
     {
-        if (zmq_msg_close(fMsg.get()) != 0) {
+        if (zmq_msg_close(&fMsg) != 0) {
             LOG(error) << "failed closing message, reason: " << zmq_strerror(errno);
         }
-        // reset the message object to allow reuse in Rebuild
-        fMsg.reset(nullptr);
         fAlignment = 0;
     }
 };
@@ -12,7 +12,9 @@
 #include <fairlogger/Logger.h>
 #include <fairmq/Channel.h>
 #include <fairmq/Poller.h>
+#include <fairmq/Probes.h>
 #include <fairmq/tools/Strings.h>
+#include <fairmq/zeromq/Common.h>
 #include <fairmq/zeromq/Socket.h>
 #include <unordered_map>
 #include <vector>
@@ -124,8 +126,18 @@ class Poller final : public fair::mq::Poller
 
     void Poll(int timeout) override
     {
+        FAIRMQ_PROBE_SCOPE(poll, timeout);
+        if (fSpinTime.count() > 0 && timeout != 0) {
+            int numReady = zmq::SpinPoll(fItems, fNumItems, fSpinTime, timeout, fStats);
+            if (numReady != 0) {
+                CountPoll(numReady > 0, true);
+                return;
+            }
+        }
+
         while (true) {
-            if (zmq_poll(fItems, fNumItems, timeout) < 0) {
+            int numReady = zmq_poll(fItems, fNumItems, timeout);
+            if (numReady < 0) {
                 if (errno == ETERM) {
                     LOG(debug) << "polling exited, reason: " << zmq_strerror(errno);
                     return;
@@ -137,6 +149,7 @@ class Poller final : public fair::mq::Poller
                     throw fair::mq::PollerError(fair::mq::tools::ToString("Polling failed, reason: ", zmq_strerror(errno)));
                 }
             }
+            CountPoll(numReady > 0, false);
             break;
         }
     }
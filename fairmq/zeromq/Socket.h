@@ -11,6 +11,7 @@
 
 #include <fairmq/Message.h>
 #include <fairmq/Socket.h>
+#include <fairmq/Tracing.h>
 #include <fairmq/tools/Strings.h>
 #include <fairmq/zeromq/Common.h>
 #include <fairmq/zeromq/Context.h>
@@ -21,9 +22,13 @@
 #include <zmq.h>
 
 #include <atomic>
+#include <cerrno>
+#include <cstddef> // size_t
+#include <cstring> // memcpy
 #include <functional>
 #include <memory> // unique_ptr, make_unique
 #include <string_view>
+#include <vector>
 
 namespace fair::mq::zmq
 {
@@ -41,6 +46,8 @@ class Socket final : public fair::mq::Socket
         , fBytesRx(0)
         , fMessagesTx(0)
         , fMessagesRx(0)
+        , fRetriesTx(0)
+        , fRetriesRx(0)
         , fTimeout(100)
         , fConnectedPeersCount(0)
     {
@@ -103,9 +110,15 @@ class Socket final : public fair::mq::Socket
         int elapsed = 0;
 
         int64_t actualBytes = zmq_msg_size(static_cast<Message*>(msg.get())->GetMessage());
+        tracing::WireContext trace;
+        bool tracePending = tracing::IsEnabled() && tracing::Outgoing(trace.fContext);
 
         while (true) {
-            int nbytes = zmq_msg_send(static_cast<Message*>(msg.get())->GetMessage(), fSocket, flags);
+            int nbytes = tracePending ? SendTraceFrame(trace, flags) : 0;
+            if (nbytes >= 0) {
+                tracePending = false;
+                nbytes = zmq_msg_send(static_cast<Message*>(msg.get())->GetMessage(), fSocket, flags);
+            }
             if (nbytes >= 0) {
                 fBytesTx += actualBytes;
                 ++fMessagesTx;
@@ -113,7 +126,7 @@ class Socket final : public fair::mq::Socket
             } else if (zmq_errno() == EAGAIN || zmq_errno() == EINTR) {
                 if (fCtx.Interrupted()) {
                     return static_cast<int>(TransferCode::interrupted);
-                } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed)) {
+                } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed, fRetriesTx)) {
                     continue;
                 } else {
                     return static_cast<int>(TransferCode::timeout);
@@ -135,6 +148,9 @@ class Socket final : public fair::mq::Socket
         while (true) {
             int nbytes = zmq_msg_recv(static_cast<Message*>(msg.get())->GetMessage(), fSocket, flags);
             if (nbytes >= 0) {
+                if (ReceivedTraceFrame(static_cast<Message*>(msg.get())->GetMessage())) {
+                    continue; // the message follows
+                }
                 static_cast<Message*>(msg.get())->Realign();
                 int64_t actualBytes = zmq_msg_size(static_cast<Message*>(msg.get())->GetMessage());
                 fBytesRx += actualBytes;
@@ -143,7 +159,7 @@ class Socket final : public fair::mq::Socket
             } else if (zmq_errno() == EAGAIN || zmq_errno() == EINTR) {
                 if (fCtx.Interrupted()) {
                     return static_cast<int>(TransferCode::interrupted);
-                } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed)) {
+                } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed, fRetriesRx)) {
                     continue;
                 } else {
                     return static_cast<int>(TransferCode::timeout);
@@ -166,19 +182,25 @@ class Socket final : public fair::mq::Socket
         // Sending vector typicaly handles more then one part
         if (vecSize > 1) {
             int elapsed = 0;
+            tracing::WireContext trace;
+            bool tracePending = tracing::IsEnabled() && tracing::Outgoing(trace.fContext);
 
             while (true) {
                 int64_t totalSize = 0;
                 bool repeat = false;
 
                 for (unsigned int i = 0; i < vecSize; ++i) {
-                    int nbytes = zmq_msg_send(static_cast<Message*>(msgVec[i].get())->GetMessage(), fSocket, (i < vecSize - 1) ? ZMQ_SNDMORE | flags : flags);
+                    int nbytes = tracePending ? SendTraceFrame(trace, flags) : 0;
+                    if (nbytes >= 0) {
+                        tracePending = false;
+                        nbytes = zmq_msg_send(static_cast<Message*>(msgVec[i].get())->GetMessage(), fSocket, (i < vecSize - 1) ? ZMQ_SNDMORE | flags : flags);
+                    }
                     if (nbytes >= 0) {
                         totalSize += nbytes;
                     } else if (zmq_errno() == EAGAIN || zmq_errno() == EINTR) {
                         if (fCtx.Interrupted()) {
                             return static_cast<int>(TransferCode::interrupted);
-                        } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed)) {
+                        } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed, fRetriesTx)) {
                             repeat = true;
                             break;
                         } else {
@@ -218,19 +240,23 @@ class Socket final : public fair::mq::Socket
             int64_t totalSize = 0;
             int more = 0;
             bool repeat = false;
+            bool first = true;
 
             do {
                 fair::mq::MessagePtr part = std::make_unique<Message>(GetTransport());
 
                 int nbytes = zmq_msg_recv(static_cast<Message*>(part.get())->GetMessage(), fSocket, flags);
                 if (nbytes >= 0) {
-                    static_cast<Message*>(part.get())->Realign();
-                    msgVec.push_back(std::move(part));
-                    totalSize += nbytes;
+                    if (!(first && ReceivedTraceFrame(static_cast<Message*>(part.get())->GetMessage()))) {
+                        static_cast<Message*>(part.get())->Realign();
+                        msgVec.push_back(std::move(part));
+                        totalSize += nbytes;
+                    }
+                    first = false;
                 } else if (zmq_errno() == EAGAIN || zmq_errno() == EINTR) {
                     if (fCtx.Interrupted()) {
                         return static_cast<int>(TransferCode::interrupted);
-                    } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed)) {
+                    } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed, fRetriesRx)) {
                         repeat = true;
                         break;
                     } else {
@@ -255,6 +281,87 @@ class Socket final : public fair::mq::Socket
         }
     }
 
+    int64_t SendBatch(std::vector<MessagePtr>& msgs, int timeout = -1) override
+    {
+        int flags = 0;
+        if (timeout == 0) {
+            flags = ZMQ_DONTWAIT;
+        }
+        int elapsed = 0;
+
+        int64_t numSent = 0;
+        int64_t totalSize = 0;
+        for (auto& msg : msgs) {
+            zmq_msg_t* zmqMsg = static_cast<Message*>(msg.get())->GetMessage();
+            int64_t actualBytes = zmq_msg_size(zmqMsg);
+            // only the first message waits, stop at the first one that cannot be queued right away
+            int nbytes = -1;
+            while ((nbytes = zmq_msg_send(zmqMsg, fSocket, numSent == 0 ? flags : ZMQ_DONTWAIT)) < 0 && numSent == 0) {
+                if (zmq_errno() == EAGAIN || zmq_errno() == EINTR) {
+                    if (fCtx.Interrupted()) {
+                        return static_cast<int>(TransferCode::interrupted);
+                    } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed, fRetriesTx)) {
+                        continue;
+                    } else {
+                        return static_cast<int>(TransferCode::timeout);
+                    }
+                } else {
+                    return zmq::HandleErrors(fId);
+                }
+            }
+            if (nbytes < 0) {
+                break;
+            }
+            ++numSent;
+            totalSize += actualBytes;
+        }
+
+        fMessagesTx += numSent;
+        fBytesTx += totalSize;
+        return numSent;
+    }
+
+    int64_t ReceiveBatch(std::vector<MessagePtr>& msgs, std::size_t maxMessages, int timeout = -1) override
+    {
+        int flags = 0;
+        if (timeout == 0) {
+            flags = ZMQ_DONTWAIT;
+        }
+        int elapsed = 0;
+
+        int64_t numReceived = 0;
+        int64_t totalSize = 0;
+        while (static_cast<std::size_t>(numReceived) < maxMessages) {
+            auto msg = std::make_unique<Message>(GetTransport());
+            int nbytes = zmq_msg_recv(msg->GetMessage(), fSocket, numReceived == 0 ? flags : ZMQ_DONTWAIT);
+            if (nbytes >= 0) {
+                if (ReceivedTraceFrame(msg->GetMessage())) {
+                    continue; // the message follows
+                }
+                msg->Realign();
+                msgs.push_back(std::move(msg));
+                totalSize += nbytes;
+                ++numReceived;
+            } else if (numReceived > 0) {
+                break;
+            } else if (zmq_errno() == EAGAIN || zmq_errno() == EINTR) {
+                if (fCtx.Interrupted()) {
+                    return static_cast<int>(TransferCode::interrupted);
+                } else if (zmq::ShouldRetry(flags, fTimeout, timeout, elapsed, fRetriesRx)) {
+                    continue;
+                } else {
+                    return static_cast<int>(TransferCode::timeout);
+                }
+            } else {
+                return zmq::HandleErrors(fId);
+            }
+        }
+
+        fMessagesRx += numReceived;
+        fBytesRx += totalSize;
+        return numReceived;
+    }
+
     void* GetSocket() const { return fSocket; }
 
     void Close() override
@@ -389,6 +496,8 @@ class Socket final : public fair::mq::Socket
     unsigned long GetBytesRx() const override { return fBytesRx; }
     unsigned long GetMessagesTx() const override { return fMessagesTx; }
     unsigned long GetMessagesRx() const override { return fMessagesRx; }
+    unsigned long GetRetriesTx() const override { return fRetriesTx; }
+    unsigned long GetRetriesRx() const override { return fRetriesRx; }
 
     [[deprecated("Use fair::mq::zmq::getConstant() from <fairmq/zeromq/Common.h> instead.")]]
     static int GetConstant(const std::string& constant) { return getConstant(constant); }
@@ -404,9 +513,43 @@ class Socket final : public fair::mq::Socket
     std::atomic<unsigned long> fBytesRx;
     std::atomic<unsigned long> fMessagesTx;
     std::atomic<unsigned long> fMessagesRx;
+    std::atomic<unsigned long> fRetriesTx;
+    std::atomic<unsigned long> fRetriesRx;
 
     int fTimeout;
     mutable unsigned long fConnectedPeersCount;
+
+    /// send the trace context as a frame in front of the message (see fair::mq::tracing)
+    int SendTraceFrame(const tracing::WireContext& trace, int flags)
+    {
+        zmq_msg_t frame;
+        zmq_msg_init_size(&frame, sizeof(trace));
+        std::memcpy(zmq_msg_data(&frame), &trace, sizeof(trace));
+        int nbytes = zmq_msg_send(&frame, fSocket, flags | ZMQ_SNDMORE);
+        if (nbytes < 0) {
+            int const err = zmq_errno();
+            zmq_msg_close(&frame);
+            errno = err;
+        }
+        return nbytes;
+    }
+
+    /// whether msg is a trace frame sent in front of a message, passes its context on if tracing is enabled
+    static bool ReceivedTraceFrame(zmq_msg_t* msg)
+    {
+        if (zmq_msg_size(msg) != sizeof(tracing::WireContext) || !zmq_msg_more(msg)) {
+            return false;
+        }
+        tracing::WireContext trace;
+        std::memcpy(&trace, zmq_msg_data(msg), sizeof(trace));
+        if (trace.fMagic != tracing::kMagic) {
+            return false;
+        }
+        if (tracing::IsEnabled()) {
+            tracing::Incoming(trace.fContext);
+        }
+        return true;
+    }
 };
 
 } // namespace fair::mq::zmq
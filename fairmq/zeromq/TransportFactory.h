@@ -17,6 +17,7 @@
 #include <fairmq/TransportFactory.h>
 #include <fairmq/ProgOptions.h>
 
+#include <chrono>
 #include <memory> // unique_ptr, make_unique
 #include <string>
 #include <vector>
@@ -37,6 +38,7 @@ class TransportFactory final : public fair::mq::TransportFactory
 
         if (config) {
             fCtx = std::make_unique<Context>(config->GetProperty<int>("io-threads", 1));
+            fPollSpin = std::chrono::microseconds(config->GetProperty<unsigned int>("poll-spin", 0));
         } else {
             LOG(debug) << "fair::mq::ProgOptions not available! Using defaults.";
             fCtx = std::make_unique<Context>(1);
@@ -85,17 +87,23 @@ class TransportFactory final : public fair::mq::TransportFactory
 
     PollerPtr CreatePoller(const std::vector<Channel>& channels) const override
     {
-        return std::make_unique<Poller>(channels);
+        auto poller = std::make_unique<Poller>(channels);
+        poller->SetSpinTime(fPollSpin);
+        return poller;
     }
 
     PollerPtr CreatePoller(const std::vector<Channel*>& channels) const override
     {
-        return std::make_unique<Poller>(channels);
+        auto poller = std::make_unique<Poller>(channels);
+        poller->SetSpinTime(fPollSpin);
+        return poller;
     }
 
     PollerPtr CreatePoller(const std::unordered_map<std::string, std::vector<Channel>>& channelsMap, const std::vector<std::string>& channelList) const override
     {
-        return std::make_unique<Poller>(channelsMap, channelList);
+        auto poller = std::make_unique<Poller>(channelsMap, channelList);
+        poller->SetSpinTime(fPollSpin);
+        return poller;
     }
 
     UnmanagedRegionPtr CreateUnmanagedRegion(size_t size, RegionCallback callback, const std::string& path = "", int flags = 0, fair::mq::RegionConfig cfg = fair::mq::RegionConfig()) override
@@ -129,7 +137,9 @@ class TransportFactory final : public fair::mq::TransportFactory
 
     UnmanagedRegionPtr CreateUnmanagedRegion(size_t size, int64_t userFlags, RegionCallback callback, RegionBulkCallback bulkCallback, const std::string&, int /* flags */, fair::mq::RegionConfig cfg)
     {
-        UnmanagedRegionPtr ptr = std::make_unique<UnmanagedRegion>(*fCtx, size, userFlags, callback, bulkCallback, this, cfg);
+        UnmanagedRegionPtr ptr = UnmanagedRegion::CreateWithAllocator(cfg, std::move(callback), std::move(bulkCallback), [&](RegionCallback cb, RegionBulkCallback bcb) {
+            return std::make_unique<UnmanagedRegion>(*fCtx, size, userFlags, std::move(cb), std::move(bcb), this, cfg);
+        });
         auto zPtr = static_cast<UnmanagedRegion*>(ptr.get());
         fCtx->AddRegion(false, zPtr->GetId(), zPtr->GetData(), zPtr->GetSize(), zPtr->GetUserFlags(), RegionEvent::created);
         return ptr;
@@ -150,6 +160,7 @@ class TransportFactory final : public fair::mq::TransportFactory
 
   private:
     std::unique_ptr<Context> fCtx;
+    std::chrono::microseconds fPollSpin{0}; // spin time of the busy-poll mode of created pollers
 };
 
 } // namespace fair::mq::zmq
@@ -14,9 +14,17 @@
 
 #include <fairlogger/Logger.h>
 
+#include <chrono>
+#include <condition_variable>
 #include <cstddef> // size_t
+#include <cstdlib> // malloc, free
+#include <memory> // shared_ptr, unique_ptr
+#include <mutex>
+#include <new> // bad_alloc
 #include <string>
+#include <thread>
 #include <utility> // move
+#include <vector>
 
 #include <sys/mman.h> // mlock
 
@@ -39,9 +47,11 @@ class UnmanagedRegion final : public fair::mq::UnmanagedRegion
         : fair::mq::UnmanagedRegion(factory)
         , fCtx(ctx)
         , fId(fCtx.RegionCount())
-        , fBuffer(malloc(size))
+        , fState(std::make_shared<State>(size))
+        , fBuffer(fState->fBuffer)
         , fSize(size)
         , fUserFlags(userFlags)
+        , fLinger(cfg.linger)
         , fCallback(std::move(callback))
         , fBulkCallback(std::move(bulkCallback))
     {
@@ -57,6 +67,10 @@ class UnmanagedRegion final : public fair::mq::UnmanagedRegion
             memset(fBuffer, 0x00, fSize);
             LOG(debug) << "Successfully zeroed free memory of region " << fId << ".";
         }
+        if (fCallback || fBulkCallback) {
+            fState->fQueueAcks = true;
+            fAcksDelivery = std::thread(&UnmanagedRegion::DeliverAcks, this);
+        }
     }
 
     UnmanagedRegion(const UnmanagedRegion&) = delete;
@@ -68,8 +82,8 @@ class UnmanagedRegion final : public fair::mq::UnmanagedRegion
     size_t GetSize() const override { return fSize; }
     uint16_t GetId() const override { return fId; }
     int64_t GetUserFlags() const { return fUserFlags; }
-    void SetLinger(uint32_t /* linger */) override { LOG(debug) << "ZeroMQ UnmanagedRegion linger option not implemented. Acknowledgements are local."; }
-    uint32_t GetLinger() const override { LOG(debug) << "ZeroMQ UnmanagedRegion linger option not implemented. Acknowledgements are local."; return 0; }
+    void SetLinger(uint32_t linger) override { fLinger = linger; }
+    uint32_t GetLinger() const override { return fLinger; }
 
     Transport GetType() const override { return Transport::ZMQ; }
 
@@ -77,17 +91,137 @@ class UnmanagedRegion final : public fair::mq::UnmanagedRegion
     {
         LOG(debug) << "destroying region " << fId;
         fCtx.RemoveRegion(fId);
-        free(fBuffer);
+
+        {
+            std::lock_guard<std::mutex> lock(fState->fMtx);
+            fState->fStopAcks = true;
+            fState->fStopDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(fLinger);
+        }
+        fState->fBlocksCV.notify_all();
+        if (fAcksDelivery.joinable()) {
+            fAcksDelivery.join();
+        }
+
+        std::lock_guard<std::mutex> lock(fState->fMtx);
+        fState->fQueueAcks = false;
+        fState->fBlocksToFree.clear();
+        if (fState->fNumInFlight > 0) {
+            LOG(debug) << "region " << fId << " destroyed with " << fState->fNumInFlight
+                       << " messages in flight. Its buffer is kept until they are released, without calling the region callback.";
+        }
     }
 
   private:
+    // Buffer and ack queue, shared with the in-flight messages of the region. Keeps the buffer alive until ZeroMQ
+    // has released the last message that points into it, even if the region object is destroyed before that.
+    struct State
+    {
+        explicit State(size_t size)
+            : fBuffer(malloc(size))
+        {
+            if (!fBuffer) {
+                throw std::bad_alloc();
+            }
+        }
+
+        State(const State&) = delete;
+        State(State&&) = delete;
+        State& operator=(const State&) = delete;
+        State& operator=(State&&) = delete;
+
+        ~State() { free(fBuffer); }
+
+        void* fBuffer;
+        std::mutex fMtx;
+        std::condition_variable fBlocksCV;
+        std::vector<RegionBlock> fBlocksToFree;
+        uint64_t fNumInFlight = 0;
+        bool fQueueAcks = false; // only while there is a callback to deliver them to
+        bool fStopAcks = false;
+        std::chrono::steady_clock::time_point fStopDeadline;
+    };
+
+    // hint of a region message, owns a reference to the region state
+    struct InFlightBlock
+    {
+        std::shared_ptr<State> fState;
+        size_t fSize;
+        void* fHint;
+    };
+
     Context& fCtx;
     uint16_t fId;
+    std::shared_ptr<State> fState;
     void* fBuffer;
     size_t fSize;
     int64_t fUserFlags;
+    uint32_t fLinger;
     RegionCallback fCallback;
     RegionBulkCallback fBulkCallback;
+    std::thread fAcksDelivery;
+
+    /// creates the hint for a new message pointing into the region, to be passed to ReleaseBlock
+    void* AcquireBlock(size_t size, void* hint)
+    {
+        {
+            std::lock_guard<std::mutex> lock(fState->fMtx);
+            ++fState->fNumInFlight;
+        }
+        return new InFlightBlock{fState, size, hint};
+    }
+
+    /// free function of region messages, called by ZeroMQ (possibly from its I/O thread) once it is done with the buffer
+    static void ReleaseBlock(void* data, void* obj)
+    {
+        std::unique_ptr<InFlightBlock> block(static_cast<InFlightBlock*>(obj));
+        State& state = *block->fState;
+        {
+            std::lock_guard<std::mutex> lock(state.fMtx);
+            if (state.fQueueAcks) {
+                state.fBlocksToFree.emplace_back(data, block->fSize, block->fHint);
+            }
+            --state.fNumInFlight;
+        }
+        state.fBlocksCV.notify_all();
+        // the last released block of a destroyed region frees the buffer here
+    }
+
+    /// calls the region callbacks outside of the ZeroMQ threads, bulk callbacks get all blocks released in the meantime
+    void DeliverAcks()
+    {
+        std::vector<RegionBlock> blocks;
+        std::unique_lock<std::mutex> lock(fState->fMtx);
+
+        while (true) {
+            if (fState->fStopAcks) {
+                // deliver what is released within the linger period
+                fState->fBlocksCV.wait_until(lock, fState->fStopDeadline, [&]() { return !fState->fBlocksToFree.empty() || fState->fNumInFlight == 0; });
+            } else {
+                fState->fBlocksCV.wait(lock, [&]() { return !fState->fBlocksToFree.empty() || fState->fStopAcks; });
+            }
+
+            if (fState->fBlocksToFree.empty()) {
+                if (fState->fStopAcks && (fState->fNumInFlight == 0 || std::chrono::steady_clock::now() >= fState->fStopDeadline)) {
+                    break;
+                }
+                continue;
+            }
+
+            blocks.swap(fState->fBlocksToFree);
+            lock.unlock();
+            if (fBulkCallback) {
+                fBulkCallback(blocks);
+            } else if (fCallback) {
+                for (const auto& block : blocks) {
+                    fCallback(block.ptr, block.size, block.hint);
+                }
+            }
+            blocks.clear();
+            lock.lock();
+        }
+
+        LOG(trace) << "AcksDelivery for region " << fId << " leaving (blocks in flight: " << fState->fNumInFlight << ").";
+    }
 };
 
 } // namespace fair::mq::zmq
@@ -11,11 +11,14 @@
 #include <fairmq/Device.h>
 #include <fairmq/DeviceRunner.h>
 #include <fairmq/ProgOptions.h>
+#include <fairmq/tools/Unique.h>
 
 #include <gtest/gtest.h>
 
 #include <sstream> // std::stringstream
 #include <thread>
+#include <utility> // std::pair
+#include <vector>
 
 namespace _config
 {
@@ -50,6 +53,21 @@ class TestDevice : public Device
     thread fDeviceThread;
 };
 
+// records the type of the default transport factory and of the channel's transport
+class TransportRecorder : public Device
+{
+  public:
+    fair::mq::Transport fDefaultTransport = fair::mq::Transport::DEFAULT;
+    fair::mq::Transport fChannelTransport = fair::mq::Transport::DEFAULT;
+
+  protected:
+    void InitTask() override
+    {
+        fDefaultTransport = Transport()->GetType();
+        fChannelTransport = GetChannel("data").Transport()->GetType();
+    }
+};
+
 class Config : public ::testing::Test
 {
   public:
@@ -132,6 +150,35 @@ class Config : public ::testing::Test
         return device.GetTransportName();
     }
 
+    pair<fair::mq::Transport, fair::mq::Transport> TestDeviceTransportFromCmdLine(const string& transport)
+    {
+        ProgOptions config;
+
+        vector<string> args = {"dummy", "--id", "test", "--color", "false", "--transport", transport,
+                               "--session", tools::Uuid(), "--shm-segment-size", "10000000"};
+
+        config.ParseAll(args, true);
+
+        TransportRecorder device;
+        device.SetConfig(config);
+
+        Channel channel;
+        channel.UpdateType("pub");
+        channel.UpdateMethod("connect");
+        channel.UpdateAddress("tcp://localhost:5558");
+        device.AddChannel("data", std::move(channel));
+
+        thread t([&]() { test::Control(device); });
+
+        device.RunStateMachine();
+
+        if (t.joinable()) {
+            t.join();
+        }
+
+        return {device.fDefaultTransport, device.fChannelTransport};
+    }
+
     string TestDeviceSetTransport(const string& transport)
     {
         Device device;
@@ -179,6 +226,14 @@ TEST_F(Config, SetTransport)
     EXPECT_EQ(transport, returnedTransport);
 }
 
+TEST_F(Config, TransportFromCmdLine)
+{
+    auto transports = TestDeviceTransportFromCmdLine("shmem");
+
+    EXPECT_EQ(transports.first, fair::mq::Transport::SHM);
+    EXPECT_EQ(transports.second, fair::mq::Transport::SHM);
+}
+
 TEST_F(Config, ControlInConstructor)
 {
     string transport = "zeromq";
@@ -0,0 +1,143 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include <fairmq/Parts.h>
+#include <fairmq/TransportFactory.h>
+#include <fairmq/devices/FileWriter.h>
+#include <fairmq/tools/Strings.h>
+#include <fairmq/tools/Unique.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdio> // std::remove
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+
+namespace
+{
+
+using namespace std;
+using namespace fair::mq;
+
+class FileWriterTest : public ::testing::Test
+{
+  public:
+    FileWriterTest()
+        : fFactory(TransportFactory::CreateTransportFactory("zeromq", tools::Uuid()))
+        , fPath(tools::ToString("/tmp/fairmq_test_file_writer_", tools::UuidHash()))
+    {}
+
+    ~FileWriterTest() override
+    {
+        remove(fPath.c_str());
+        for (int i = 0; i < 16; ++i) {
+            remove(tools::ToString(fPath, ".", i).c_str());
+        }
+    }
+
+    MessagePtr Message(const string& content)
+    {
+        MessagePtr msg(fFactory->CreateMessage(content.size()));
+        memcpy(msg->GetData(), content.data(), content.size());
+        return msg;
+    }
+
+    static string ReadFile(const string& path)
+    {
+        ifstream file(path, ios::binary);
+        return string(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    }
+
+    shared_ptr<TransportFactory> fFactory;
+    string fPath;
+};
+
+TEST_F(FileWriterTest, GathersParts)
+{
+    FileWriter::Config config;
+    config.path = fPath;
+    config.batch = 3;
+    config.syncBytes = 1;
+    FileWriter writer(config);
+
+    string expected;
+    for (int i = 0; i < 10; ++i) {
+        Parts parts;
+        for (int p = 0; p < 4; ++p) {
+            string content(tools::ToString("<", i, ":", p, ">"));
+            parts.AddPart(Message(content));
+            expected += content;
+        }
+        writer.Push(parts);
+        EXPECT_TRUE(parts.Empty());
+    }
+    writer.Push(Message("end"));
+    expected += "end";
+    writer.Close();
+
+    EXPECT_EQ(ReadFile(fPath), expected);
+    FileWriterStats stats = writer.GetStats();
+    EXPECT_EQ(stats.bytesWritten, expected.size());
+    EXPECT_EQ(stats.numParts, 41U);
+    EXPECT_EQ(stats.numFiles, 1U);
+    EXPECT_GE(stats.numWrites, 14U); // at most 3 parts per write
+    EXPECT_GT(stats.numSyncs, 0U);
+    EXPECT_GT(stats.maxQueuedBytes, 0U);
+
+    EXPECT_THROW(writer.Push(Message("late")), FileWriterError);
+}
+
+TEST_F(FileWriterTest, BoundedQueue)
+{
+    FileWriter::Config config;
+    config.path = fPath;
+    config.queueSize = 1000;
+    FileWriter writer(config);
+
+    for (int i = 0; i < 1000; ++i) {
+        writer.Push(Message(string(100, 'x')));
+    }
+    writer.Push(Message(string(5000, 'y'))); // larger than the queue, accepted alone
+    writer.Close();
+
+    FileWriterStats stats = writer.GetStats();
+    EXPECT_EQ(stats.bytesWritten, 105000U);
+    EXPECT_LE(stats.maxQueuedBytes, 5000U);
+    EXPECT_EQ(ReadFile(fPath).size(), 105000U);
+}
+
+TEST_F(FileWriterTest, RotatesBySize)
+{
+    FileWriter::Config config;
+    config.path = fPath;
+    config.rotateSize = 250;
+    FileWriter writer(config);
+
+    for (int i = 0; i < 10; ++i) {
+        writer.Push(Message(string(100, static_cast<char>('a' + i))));
+    }
+    writer.Close();
+
+    // files are rotated at message boundaries, after reaching the rotation size
+    EXPECT_EQ(writer.GetStats().numFiles, 4U);
+    EXPECT_EQ(ReadFile(tools::ToString(fPath, ".0")), string(100, 'a') + string(100, 'b') + string(100, 'c'));
+    EXPECT_EQ(ReadFile(tools::ToString(fPath, ".3")), string(100, 'j'));
+    EXPECT_EQ(writer.GetFileName(), tools::ToString(fPath, ".3"));
+}
+
+TEST_F(FileWriterTest, OpenError)
+{
+    FileWriter::Config config;
+    config.path = "/nonexistent_directory/file";
+    EXPECT_THROW(FileWriter writer(config), FileWriterError);
+}
+
+} // namespace
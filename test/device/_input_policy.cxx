@@ -0,0 +1,192 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include <fairmq/Device.h>
+#include <fairmq/TransportFactory.h>
+#include <fairmq/tools/Strings.h>
+#include <fairmq/tools/Unique.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+namespace
+{
+
+using namespace std;
+using namespace fair::mq;
+
+class InputReceiver : public Device
+{
+  public:
+    InputReceiver(const InputPolicy& policy, size_t numExpected)
+        : fPolicy(policy)
+        , fNumExpected(numExpected)
+    {}
+
+    string fOrder; // channel names of the handled messages, in order
+    map<char, set<int>> fWorkers; // input workers that handled the messages of a channel
+
+  protected:
+    void InitTask() override
+    {
+        SetInputPolicy(fPolicy);
+        OnData("a", [this](MessagePtr&, int) { return Record('a'); });
+        OnData("b", [this](MessagePtr&, int) { return Record('b'); });
+    }
+
+    bool Record(char channel)
+    {
+        lock_guard<mutex> lock(fMtx);
+        fOrder.push_back(channel);
+        fWorkers[channel].insert(GetInputWorker());
+        return fOrder.size() < fNumExpected;
+    }
+
+    InputPolicy fPolicy;
+    size_t fNumExpected;
+    mutex fMtx;
+};
+
+// both inputs have all their messages queued before the device starts running
+string RunWithPolicy(const InputPolicy& policy, int numMessages, InputStats& statsA, InputStats& statsB, map<char, set<int>>* workers = nullptr)
+{
+    InputReceiver device(policy, 2 * numMessages);
+    device.SetTransport("zeromq");
+
+    string addressA(tools::ToString("ipc://test_input_policy_a_", tools::UuidHash()));
+    string addressB(tools::ToString("ipc://test_input_policy_b_", tools::UuidHash()));
+    Channel channelA("pull", "bind", addressA);
+    Channel channelB("pull", "bind", addressB);
+    channelA.UpdateRateLogging(0);
+    channelB.UpdateRateLogging(0);
+    device.AddChannel("a", std::move(channelA));
+    device.AddChannel("b", std::move(channelB));
+
+    auto factory = TransportFactory::CreateTransportFactory("zeromq");
+    Channel pushA("pushA", "push", factory);
+    Channel pushB("pushB", "push", factory);
+
+    thread control([&]() {
+        device.ChangeStateOrThrow(Transition::InitDevice);
+        device.WaitForState(State::InitializingDevice);
+        device.ChangeStateOrThrow(Transition::CompleteInit);
+        device.WaitForState(State::Initialized);
+        device.ChangeStateOrThrow(Transition::Bind);
+        device.WaitForState(State::Bound);
+        device.ChangeStateOrThrow(Transition::Connect);
+        device.WaitForState(State::DeviceReady);
+        device.ChangeStateOrThrow(Transition::InitTask);
+        device.WaitForState(State::Ready);
+
+        pushA.Connect(addressA);
+        pushB.Connect(addressB);
+        for (int i = 0; i < numMessages; ++i) {
+            MessagePtr msgA(pushA.NewMessage());
+            MessagePtr msgB(pushB.NewMessage());
+            pushA.Send(msgA);
+            pushB.Send(msgB);
+        }
+        this_thread::sleep_for(chrono::milliseconds(300));
+
+        device.ChangeStateOrThrow(Transition::Run);
+        device.WaitForState(State::Running);
+        device.WaitForState(State::Ready);
+        device.ChangeStateOrThrow(Transition::ResetTask);
+        device.WaitForState(State::DeviceReady);
+        device.ChangeStateOrThrow(Transition::ResetDevice);
+        device.WaitForState(State::Idle);
+        device.ChangeStateOrThrow(Transition::End);
+    });
+
+    device.RunStateMachine();
+    control.join();
+
+    statsA = device.GetInputStats("a");
+    statsB = device.GetInputStats("b");
+    if (workers) {
+        *workers = device.fWorkers;
+    }
+    return device.fOrder;
+}
+
+TEST(InputPolicy, Default)
+{
+    InputStats statsA, statsB;
+    EXPECT_EQ(RunWithPolicy(InputPolicy(), 4, statsA, statsB), "abababab");
+    EXPECT_EQ(statsA.numMessages, 4U);
+    EXPECT_EQ(statsB.numMessages, 4U);
+    EXPECT_EQ(statsA.numWakeups, 4U);
+    EXPECT_GT(statsB.delayNs, 0U);
+    EXPECT_GE(statsB.maxDelayNs * 4, statsB.delayNs);
+}
+
+TEST(InputPolicy, Rotate)
+{
+    InputPolicy policy;
+    policy.rotate = true;
+    InputStats statsA, statsB;
+    EXPECT_EQ(RunWithPolicy(policy, 4, statsA, statsB), "abbaabba");
+}
+
+TEST(InputPolicy, Drain)
+{
+    InputPolicy policy;
+    policy.drain = 3;
+    InputStats statsA, statsB;
+    EXPECT_EQ(RunWithPolicy(policy, 6, statsA, statsB), "aaabbbaaabbb");
+    EXPECT_EQ(statsA.numMessages, 6U);
+    EXPECT_EQ(statsA.numWakeups, 2U);
+}
+
+TEST(InputPolicy, Weights)
+{
+    InputPolicy policy;
+    policy.drain = 2;
+    policy.weights["a"] = 2;
+    InputStats statsA, statsB;
+    EXPECT_EQ(RunWithPolicy(policy, 8, statsA, statsB), "aaaabbaaaabbbbbb");
+    EXPECT_EQ(statsA.numWakeups, 2U);
+    EXPECT_EQ(statsB.numWakeups, 4U);
+}
+
+TEST(InputPolicy, Workers)
+{
+    InputPolicy policy;
+    policy.threads = 2;
+    InputStats statsA, statsB;
+    map<char, set<int>> workers;
+    string order(RunWithPolicy(policy, 8, statsA, statsB, &workers));
+    EXPECT_EQ(order.size(), 16U);
+    EXPECT_EQ(statsA.numMessages, 8U);
+    EXPECT_EQ(statsB.numMessages, 8U);
+    // the sub-channels are distributed over the workers, each is handled by one worker only
+    EXPECT_EQ(workers['a'], set<int>{0});
+    EXPECT_EQ(workers['b'], set<int>{1});
+}
+
+TEST(InputPolicy, WorkerGroups)
+{
+    InputPolicy policy;
+    policy.threads = 2;
+    policy.groups["a"] = 1;
+    policy.groups["b"] = 1;
+    InputStats statsA, statsB;
+    map<char, set<int>> workers;
+    // both channels in the same worker: handled in order as without workers
+    EXPECT_EQ(RunWithPolicy(policy, 4, statsA, statsB, &workers), "abababab");
+    EXPECT_EQ(workers['a'], set<int>{1});
+    EXPECT_EQ(workers['b'], set<int>{1});
+}
+
+} // namespace
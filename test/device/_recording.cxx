@@ -0,0 +1,138 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include <fairmq/Parts.h>
+#include <fairmq/TransportFactory.h>
+#include <fairmq/devices/Recording.h>
+#include <fairmq/tools/Strings.h>
+#include <fairmq/tools/Unique.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdio> // std::remove
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+using namespace std;
+using namespace fair::mq;
+
+class RecordingTest : public ::testing::Test
+{
+  public:
+    RecordingTest()
+        : fFactory(TransportFactory::CreateTransportFactory("zeromq", tools::Uuid()))
+        , fPath(tools::ToString("/tmp/fairmq_test_recording_", tools::UuidHash()))
+    {}
+
+    ~RecordingTest() override { remove(fPath.c_str()); }
+
+    MessagePtr Message(const string& content)
+    {
+        MessagePtr msg(fFactory->CreateMessage(content.size()));
+        memcpy(msg->GetData(), content.data(), content.size());
+        return msg;
+    }
+
+    void Write(const char* data, size_t size) { fContent.append(data, size); }
+
+    template<typename Encode>
+    void WriteMetadata(size_t size, Encode&& encode)
+    {
+        vector<char> buffer(size);
+        encode(buffer.data());
+        Write(buffer.data(), size);
+    }
+
+    // records frames of 1, 2 and 3 parts with the given prefix, as the Sink does
+    void Record(bool withIndex)
+    {
+        WriteMetadata(RecordingEncoder::FileHeaderSize(), [&](char* out) { fEncoder.FileHeader(out); });
+        for (uint64_t i = 0; i < 3; ++i) {
+            Parts parts;
+            for (uint64_t p = 0; p <= i; ++p) {
+                parts.AddPart(Message(tools::ToString("frame", i, "-part", p)));
+            }
+            WriteMetadata(fEncoder.FrameHeaderSize(parts.Size()), [&](char* out) { fEncoder.FrameHeader(out, 1000 * i, parts); });
+            for (const auto& part : parts) {
+                Write(static_cast<const char*>(part->GetData()), part->GetSize());
+            }
+        }
+        if (withIndex) {
+            WriteMetadata(fEncoder.IndexSize(), [&](char* out) { fEncoder.Index(out); });
+        }
+        ofstream(fPath, ios::binary) << fContent;
+    }
+
+    void Check(const RecordingReader& reader)
+    {
+        ASSERT_EQ(reader.GetNumFrames(), 3U);
+        for (uint64_t i = 0; i < 3; ++i) {
+            RecordingReader::Frame frame = reader.GetFrame(i);
+            EXPECT_EQ(frame.timestampNs, 1000 * i);
+            ASSERT_EQ(frame.numParts, i + 1);
+            EXPECT_EQ(frame.data, reader.GetData() + frame.offset);
+            const char* data = frame.data;
+            for (uint64_t p = 0; p <= i; ++p) {
+                EXPECT_EQ(string(data, frame.sizes[p]), tools::ToString("frame", i, "-part", p));
+                data += frame.sizes[p];
+            }
+        }
+    }
+
+    shared_ptr<TransportFactory> fFactory;
+    string fPath;
+    string fContent;
+    RecordingEncoder fEncoder;
+};
+
+TEST_F(RecordingTest, Indexed)
+{
+    Record(true);
+    RecordingReader reader(fPath);
+    EXPECT_TRUE(reader.IsIndexed());
+    EXPECT_EQ(reader.GetSize(), fContent.size());
+    Check(reader);
+}
+
+TEST_F(RecordingTest, WithoutIndex)
+{
+    Record(false);
+    RecordingReader reader(fPath);
+    EXPECT_FALSE(reader.IsIndexed());
+    Check(reader);
+}
+
+TEST_F(RecordingTest, Truncated)
+{
+    Record(true);
+    // cut into the index: the frames are found by scanning
+    ofstream(fPath, ios::binary | ios::trunc) << fContent.substr(0, fContent.size() - 10);
+    RecordingReader reader(fPath);
+    EXPECT_FALSE(reader.IsIndexed());
+    Check(reader);
+
+    // cut into the last frame: only the complete frames are found
+    ofstream(fPath, ios::binary | ios::trunc) << fContent.substr(0, reader.GetFrame(2).offset + 3);
+    RecordingReader truncated(fPath);
+    EXPECT_EQ(truncated.GetNumFrames(), 2U);
+}
+
+TEST_F(RecordingTest, Invalid)
+{
+    EXPECT_THROW(RecordingReader("/nonexistent_directory/recording"), RecordingError);
+    ofstream(fPath, ios::binary) << "this is not a recording at all";
+    EXPECT_THROW(RecordingReader reader(fPath), RecordingError);
+}
+
+} // namespace
@@ -0,0 +1,192 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include <fairmq/Channel.h>
+#include <fairmq/ProgOptions.h>
+#include <fairmq/TransportFactory.h>
+#include <fairmq/devices/Splitter.h>
+#include <fairmq/tools/Strings.h>
+#include <fairmq/tools/Unique.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+using namespace std;
+using namespace fair::mq;
+
+class TestSplitter : public Splitter
+{
+  public:
+    using Splitter::fStats;
+};
+
+struct Peers
+{
+    Channel fIn;                          // pushes into the splitter input
+    vector<unique_ptr<Channel>> fOutputs; // pull from the splitter outputs
+    vector<unique_ptr<Channel>> fCredits; // push credits to the splitter
+};
+
+// runs a splitter with two outputs (zeromq, single part messages) and calls whileRunning in the Running state
+void RunSplitter(TestSplitter& device, const string& dispatch, bool connectFirstOutput, const function<void(Peers&)>& whileRunning)
+{
+    constexpr int numOutputs = 2;
+    device.SetTransport("zeromq");
+    device.GetConfig()->SetProperty<bool>("multipart", false);
+    device.GetConfig()->SetProperty<string>("in-channel", "data-in");
+    device.GetConfig()->SetProperty<string>("out-channel", "data-out");
+    device.GetConfig()->SetProperty<string>("dispatch", dispatch);
+    device.GetConfig()->SetProperty<string>("credit-channel", "credits");
+    device.GetConfig()->SetProperty<int>("credits", 2);
+
+    auto const id = tools::UuidHash();
+    string inAddress(tools::ToString("ipc://test_splitter_in_", id));
+    vector<string> outAddresses;
+    vector<string> creditAddresses;
+    Channel in("pull", "bind", inAddress);
+    in.UpdateRateLogging(0);
+    device.AddChannel("data-in", std::move(in));
+    for (int i = 0; i < numOutputs; ++i) {
+        outAddresses.push_back(tools::ToString("ipc://test_splitter_out_", i, "_", id));
+        Channel out("push", "bind", outAddresses.back());
+        out.UpdateRateLogging(0);
+        device.AddChannel("data-out", std::move(out));
+        if (dispatch == "credit") {
+            creditAddresses.push_back(tools::ToString("ipc://test_splitter_credits_", i, "_", id));
+            Channel credits("pull", "bind", creditAddresses.back());
+            credits.UpdateRateLogging(0);
+            device.AddChannel("credits", std::move(credits));
+        }
+    }
+
+    auto factory = TransportFactory::CreateTransportFactory("zeromq");
+    Peers peers{Channel("in", "push", factory), {}, {}};
+
+    thread control([&]() {
+        device.ChangeStateOrThrow(Transition::InitDevice);
+        device.WaitForState(State::InitializingDevice);
+        device.ChangeStateOrThrow(Transition::CompleteInit);
+        device.WaitForState(State::Initialized);
+        device.ChangeStateOrThrow(Transition::Bind);
+        device.WaitForState(State::Bound);
+        device.ChangeStateOrThrow(Transition::Connect);
+        device.WaitForState(State::DeviceReady);
+        device.ChangeStateOrThrow(Transition::InitTask);
+        device.WaitForState(State::Ready);
+
+        peers.fIn.Connect(inAddress);
+        for (int i = 0; i < numOutputs; ++i) {
+            peers.fOutputs.push_back(make_unique<Channel>(tools::ToString("out", i), "pull", factory));
+            if (i > 0 || connectFirstOutput) {
+                peers.fOutputs.back()->Connect(outAddresses.at(i));
+            }
+        }
+        for (const auto& address : creditAddresses) {
+            peers.fCredits.push_back(make_unique<Channel>("credits", "push", factory));
+            peers.fCredits.back()->Connect(address);
+        }
+        this_thread::sleep_for(chrono::milliseconds(100)); // let the connections establish
+
+        device.ChangeStateOrThrow(Transition::Run);
+        device.WaitForState(State::Running);
+        whileRunning(peers);
+        device.ChangeStateOrThrow(Transition::Stop);
+        device.WaitForState(State::Ready);
+        device.ChangeStateOrThrow(Transition::ResetTask);
+        device.WaitForState(State::DeviceReady);
+        device.ChangeStateOrThrow(Transition::ResetDevice);
+        device.WaitForState(State::Idle);
+        device.ChangeStateOrThrow(Transition::End);
+    });
+
+    device.RunStateMachine();
+    control.join();
+}
+
+void SendInputs(Peers& peers, int numMessages)
+{
+    for (int i = 0; i < numMessages; ++i) {
+        MessagePtr msg(peers.fIn.NewMessage(100));
+        ASSERT_EQ(peers.fIn.Send(msg), 100);
+    }
+}
+
+// receives up to maxMessages, stops at the first receive that takes longer than timeoutMs
+int ReceiveOutputs(Channel& output, int maxMessages, int timeoutMs)
+{
+    int received = 0;
+    while (received < maxMessages) {
+        MessagePtr msg(output.NewMessage());
+        if (output.Receive(msg, timeoutMs) < 0) {
+            break;
+        }
+        ++received;
+    }
+    return received;
+}
+
+TEST(Splitter, ReadySkipsBusyOutput)
+{
+    constexpr int numMessages = 10;
+    TestSplitter device;
+    // the first output has no peer, a send to it cannot complete without waiting
+    RunSplitter(device, "ready", false, [&](Peers& peers) {
+        SendInputs(peers, numMessages);
+        EXPECT_EQ(ReceiveOutputs(*peers.fOutputs.at(1), numMessages, 2000), numMessages);
+    });
+
+    ASSERT_EQ(device.fStats.size(), 2UL);
+    EXPECT_EQ(device.fStats.at(0).fDispatched, 0U);
+    EXPECT_GE(device.fStats.at(0).fBusy, static_cast<uint64_t>(numMessages));
+    EXPECT_EQ(device.fStats.at(1).fDispatched, static_cast<uint64_t>(numMessages));
+}
+
+TEST(Splitter, CreditWindow)
+{
+    TestSplitter device;
+    RunSplitter(device, "credit", true, [&](Peers& peers) {
+        SendInputs(peers, 10);
+
+        // two credits per output: two messages each, then the splitter waits for credits
+        EXPECT_EQ(ReceiveOutputs(*peers.fOutputs.at(0), 10, 500), 2);
+        EXPECT_EQ(ReceiveOutputs(*peers.fOutputs.at(1), 10, 500), 2);
+
+        // one credit (empty message) for the first output, two (as uint32_t) for the second
+        MessagePtr one(peers.fCredits.at(0)->NewMessage());
+        ASSERT_EQ(peers.fCredits.at(0)->Send(one), 0);
+        MessagePtr two(peers.fCredits.at(1)->NewMessage(sizeof(uint32_t)));
+        uint32_t const numCredits = 2;
+        memcpy(two->GetData(), &numCredits, sizeof(numCredits));
+        ASSERT_EQ(peers.fCredits.at(1)->Send(two), static_cast<int64_t>(sizeof(uint32_t)));
+
+        EXPECT_EQ(ReceiveOutputs(*peers.fOutputs.at(0), 10, 500), 1);
+        EXPECT_EQ(ReceiveOutputs(*peers.fOutputs.at(1), 10, 500), 2);
+    });
+
+    ASSERT_EQ(device.fStats.size(), 2UL);
+    EXPECT_EQ(device.fStats.at(0).fDispatched, 3U);
+    EXPECT_EQ(device.fStats.at(1).fDispatched, 4U);
+    for (const auto& stats : device.fStats) {
+        EXPECT_EQ(stats.fInFlight, 2);
+        EXPECT_EQ(stats.fMaxInFlight, 2);
+        EXPECT_GT(stats.fBusy, 0U);
+    }
+}
+
+} // namespace
@@ -0,0 +1,144 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include <fairmq/Parts.h>
+#include <fairmq/TransportFactory.h>
+#include <fairmq/devices/TimeframeBuffer.h>
+#include <fairmq/tools/Unique.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+
+using namespace std;
+using namespace fair::mq;
+using Result = TimeframeBuffer::Result;
+
+class TimeframeBufferTest : public ::testing::Test
+{
+  public:
+    TimeframeBufferTest()
+        : fFactory(TransportFactory::CreateTransportFactory("zeromq", tools::Uuid()))
+    {}
+
+    // sub time frame of a sender with the given number of parts, each part holds the sender index
+    Parts SubTimeframe(uint32_t sender, int numParts = 2)
+    {
+        Parts parts;
+        for (int i = 0; i < numParts; ++i) {
+            parts.AddPart(fFactory->CreateMessage(sizeof(sender)));
+            *static_cast<uint32_t*>(parts.At(i)->GetData()) = sender;
+        }
+        return parts;
+    }
+
+    shared_ptr<TransportFactory> fFactory;
+};
+
+TEST_F(TimeframeBufferTest, Complete)
+{
+    TimeframeBuffer buffer(16, 3, chrono::milliseconds(1000));
+    Parts frame;
+
+    Parts parts = SubTimeframe(2);
+    EXPECT_EQ(buffer.Add(7, 2, parts, frame), Result::Added);
+    EXPECT_TRUE(parts.Empty());
+    parts = SubTimeframe(0);
+    EXPECT_EQ(buffer.Add(7, 0, parts, frame), Result::Added);
+    EXPECT_EQ(buffer.Size(), 1U);
+
+    parts = SubTimeframe(0);
+    EXPECT_EQ(buffer.Add(7, 0, parts, frame), Result::Duplicate);
+    EXPECT_EQ(parts.Size(), 2U);
+
+    parts = SubTimeframe(1);
+    ASSERT_EQ(buffer.Add(7, 1, parts, frame), Result::Complete);
+    ASSERT_EQ(frame.Size(), 6U);
+    for (size_t i = 0; i < frame.Size(); ++i) {
+        EXPECT_EQ(*static_cast<uint32_t*>(frame.At(i)->GetData()), i / 2); // in sender order
+    }
+    EXPECT_EQ(buffer.Size(), 0U);
+
+    parts = SubTimeframe(1);
+    EXPECT_EQ(buffer.Add(7, 1, parts, frame), Result::Late);
+    EXPECT_EQ(parts.Size(), 2U);
+
+    const TimeframeStats& stats = buffer.GetStats();
+    EXPECT_EQ(stats.numComplete, 1U);
+    EXPECT_EQ(stats.numIncomplete, 0U);
+    EXPECT_EQ(stats.numLate, 1U);
+    EXPECT_EQ(stats.numDuplicate, 1U);
+    EXPECT_EQ(stats.CompletenessRatio(), 1.);
+    EXPECT_GE(stats.maxBuildTimeNs * 1., stats.MeanBuildTimeNs());
+}
+
+TEST_F(TimeframeBufferTest, Timeout)
+{
+    TimeframeBuffer buffer(16, 2, chrono::milliseconds(50));
+    Parts frame;
+    vector<uint64_t> expired;
+    auto onIncomplete = [&](uint64_t id, Parts& parts) {
+        expired.push_back(id);
+        EXPECT_EQ(parts.Size(), 2U);
+    };
+
+    Parts parts = SubTimeframe(0);
+    EXPECT_EQ(buffer.Add(5, 0, parts, frame), Result::Added);
+    parts = SubTimeframe(1);
+    EXPECT_EQ(buffer.Add(6, 1, parts, frame), Result::Added);
+
+    auto now = TimeframeBuffer::clock::now();
+    EXPECT_EQ(buffer.Expire(onIncomplete, now), 0U);
+    EXPECT_EQ(buffer.Expire(onIncomplete, now + chrono::milliseconds(20)), 0U);
+    EXPECT_EQ(buffer.Expire(onIncomplete, now + chrono::milliseconds(200)), 2U);
+    sort(expired.begin(), expired.end());
+    EXPECT_EQ(expired, (vector<uint64_t>{5, 6}));
+    EXPECT_EQ(buffer.Size(), 0U);
+
+    parts = SubTimeframe(1);
+    EXPECT_EQ(buffer.Add(5, 1, parts, frame), Result::Late);
+    EXPECT_EQ(buffer.GetStats().numIncomplete, 2U);
+    EXPECT_EQ(buffer.GetStats().CompletenessRatio(), 0.);
+}
+
+TEST_F(TimeframeBufferTest, BoundedByCapacity)
+{
+    constexpr size_t capacity = 4;
+    TimeframeBuffer buffer(capacity, 2, chrono::milliseconds(10000));
+    Parts frame;
+    vector<uint64_t> evicted;
+    auto onIncomplete = [&](uint64_t id, Parts&) { evicted.push_back(id); };
+
+    // only one sender contributes, every time frame stays incomplete
+    for (uint64_t id = 0; id < 100; ++id) {
+        Parts parts = SubTimeframe(0);
+        EXPECT_EQ(buffer.Add(id, 0, parts, frame, onIncomplete), Result::Added);
+        EXPECT_LE(buffer.Size(), capacity);
+    }
+    EXPECT_EQ(evicted.size(), 100 - capacity);
+    EXPECT_EQ(evicted.front(), 0U);
+
+    // the other sender for an evicted and for an in-flight time frame
+    Parts parts = SubTimeframe(1);
+    EXPECT_EQ(buffer.Add(3, 1, parts, frame, onIncomplete), Result::Late);
+    parts = SubTimeframe(1);
+    EXPECT_EQ(buffer.Add(99, 1, parts, frame, onIncomplete), Result::Complete);
+    EXPECT_EQ(frame.Size(), 4U);
+    EXPECT_EQ(buffer.Size(), capacity - 1);
+
+    EXPECT_THROW(buffer.Add(100, 2, parts, frame), TimeframeBufferError);
+    EXPECT_THROW(TimeframeBuffer(0, 2, chrono::milliseconds(10)), TimeframeBufferError);
+}
+
+} // namespace
@@ -0,0 +1,125 @@
+/********************************************************************************
+ * Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH       *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include <fairmq/Channel.h>
+#include <fairmq/Parts.h>
+#include <fairmq/ProgOptions.h>
+#include <fairmq/tools/Strings.h>
+#include <fairmq/tools/Unique.h>
+#include <fairmq/TransportFactory.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdlib> // malloc, free
+#include <cstring>
+#include <new>
+#include <string>
+
+// Counts the C++ heap allocations (global operator new) of the test thread while tCountAllocations is set, i.e. those
+// of the message objects, part vectors and transport bookkeeping. malloc calls are not counted: the zeromq transport
+// allocates the data buffer of every message in libzmq (zmq_msg_init_size), that is not what is checked here.
+// Replaces the global operator new, hence this test has its own executable.
+
+namespace
+{
+
+thread_local bool tCountAllocations = false;
+thread_local size_t tNumAllocations = 0;
+
+} // namespace
+
+void* operator new(size_t size)
+{
+    if (tCountAllocations) {
+        ++tNumAllocations;
+    }
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t /* size */) noexcept { std::free(ptr); }
+
+namespace
+{
+
+using namespace std;
+using namespace fair::mq;
+
+struct AllocationCounter
+{
+    AllocationCounter() { tNumAllocations = 0; tCountAllocations = true; }
+    ~AllocationCounter() { tCountAllocations = false; }
+    size_t Count() const { return tNumAllocations; }
+};
+
+auto RunSteadyStateCxxAllocations(string const& transport, string const& _address) -> void
+{
+#ifdef __SANITIZE_ADDRESS__
+    GTEST_SKIP() << "message pooling is disabled under AddressSanitizer";
+#endif
+    ProgOptions config;
+    config.SetProperty<string>("session", tools::Uuid());
+    config.SetProperty<size_t>("shm-segment-size", 100000000);
+    auto factory(TransportFactory::CreateTransportFactory(transport, tools::Uuid(), &config));
+
+    Channel push{"Push", "push", factory};
+    Channel pull{"Pull", "pull", factory};
+    auto const address(tools::ToString(_address, "_", transport, "_", config.GetProperty<string>("session")));
+    push.Bind(address);
+    pull.Connect(address);
+
+    constexpr size_t numParts = 4;
+    Parts outParts;
+    Parts inParts;
+
+    auto transfer = [&]() {
+        auto outMsg(push.NewMessage(1000));
+        std::memset(outMsg->GetData(), 1, outMsg->GetSize());
+        ASSERT_EQ(push.Send(outMsg), 1000);
+        auto inMsg(pull.NewMessage());
+        ASSERT_EQ(pull.Receive(inMsg), 1000);
+
+        for (size_t i = 0; i < numParts; ++i) {
+            outParts.AddPart(push.NewMessage(100));
+        }
+        ASSERT_EQ(push.Send(outParts), numParts * 100);
+        ASSERT_EQ(pull.Receive(inParts), numParts * 100);
+        outParts.Clear();
+        inParts.Clear();
+    };
+
+    // warm-up: fills the message free lists, the part vectors and the transport internals
+    for (int i = 0; i < 1000; ++i) {
+        transfer();
+    }
+
+    size_t numAllocations = 0;
+    {
+        AllocationCounter counter;
+        for (int i = 0; i < 10000; ++i) {
+            transfer();
+        }
+        numAllocations = counter.Count();
+    }
+    EXPECT_EQ(numAllocations, 0);
+}
+
+TEST(SteadyStateCxxAllocations, zeromq) // NOLINT
+{
+    RunSteadyStateCxxAllocations("zeromq", "ipc://test_alloc_count");
+}
+
+TEST(SteadyStateCxxAllocations, shmem) // NOLINT
+{
+    RunSteadyStateCxxAllocations("shmem", "ipc://test_alloc_count");
+}
+
+} // namespace
@@ -8,13 +8,19 @@
 
 #include "runner.h"
 
+#include <fairmq/Channel.h>
+#include <fairmq/Poller.h>
+#include <fairmq/ProgOptions.h>
+#include <fairmq/TransportFactory.h>
 #include <fairmq/tools/Unique.h>
 #include <fairmq/tools/Process.h>
 #include <fairmq/tools/Strings.h>
 #include <gtest/gtest.h>
+#include <chrono>
 #include <cstdio> // std::remove
 #include <sstream> // std::stringstream
 #include <thread>
+#include <vector>
 
 namespace
 {
@@ -70,6 +76,99 @@ auto RunPoller(string transport, int pollType) -> void
     exit(pollout.exit_code + pollin.exit_code);
 }
 
+auto RunBusyPoll(string const& transport) -> void
+{
+    fair::mq::ProgOptions config;
+    config.SetProperty<string>("session", Uuid());
+    config.SetProperty<size_t>("shm-segment-size", 100000000);
+    config.SetProperty<unsigned int>("poll-spin", 200000);
+    auto factory = fair::mq::TransportFactory::CreateTransportFactory(transport, Uuid(), &config);
+
+    fair::mq::Channel push("Push", "push", factory);
+    fair::mq::Channel pull("Pull", "pull", factory);
+    auto const address(ToString("inproc://test_busy_poll_", transport));
+    ASSERT_TRUE(pull.Bind(address));
+    ASSERT_TRUE(push.Connect(address));
+
+    vector<fair::mq::Channel*> channels{&pull};
+    auto poller = factory->CreatePoller(channels);
+    ASSERT_EQ(poller->GetSpinTime(), chrono::microseconds(200000));
+
+    // the spin phase is limited by the poll timeout
+    auto start = chrono::steady_clock::now();
+    poller->Poll(50);
+    EXPECT_LT(chrono::steady_clock::now() - start, chrono::milliseconds(150));
+    EXPECT_FALSE(poller->CheckInput(0));
+    EXPECT_EQ(poller->GetStats().numPolls, 1);
+    EXPECT_EQ(poller->GetStats().numTimeouts, 1);
+    EXPECT_GT(poller->GetStats().spinTimeNs, 0);
+
+    auto sendOne = [&]() {
+        this_thread::sleep_for(chrono::milliseconds(10));
+        auto msg(push.NewMessage(8));
+        ASSERT_EQ(push.Send(msg), 8);
+    };
+    auto receiveOne = [&]() {
+        auto msg(pull.NewMessage());
+        ASSERT_EQ(pull.Receive(msg), 8);
+    };
+
+    // a message arriving within the spin time is found while spinning
+    thread sender(sendOne);
+    poller->Poll(1000);
+    sender.join();
+    EXPECT_TRUE(poller->CheckInput(0));
+    EXPECT_EQ(poller->GetStats().numSpinWakeups, 1);
+    receiveOne();
+
+    // a message arriving after the spin phase is found by the blocking poll
+    poller->SetSpinTime(chrono::milliseconds(1));
+    poller->ResetStats();
+    sender = thread(sendOne);
+    poller->Poll(1000);
+    sender.join();
+    EXPECT_TRUE(poller->CheckInput(0));
+    EXPECT_EQ(poller->GetStats().numSpinWakeups, 0);
+    EXPECT_EQ(poller->GetStats().numBlockWakeups, 1);
+    EXPECT_EQ(poller->GetStats().SpinRatio(), 0.);
+    receiveOne();
+
+    // the blocking poll after the spin phase only waits for the remaining timeout
+    poller->SetSpinTime(chrono::milliseconds(200));
+    poller->ResetStats();
+    start = chrono::steady_clock::now();
+    poller->Poll(300);
+    auto const elapsed = chrono::steady_clock::now() - start;
+    EXPECT_GE(elapsed, chrono::milliseconds(290));
+    EXPECT_LT(elapsed, chrono::milliseconds(450)); // 500 if the spin time was added to the timeout
+    EXPECT_FALSE(poller->CheckInput(0));
+    EXPECT_EQ(poller->GetStats().numTimeouts, 1);
+    EXPECT_GE(poller->GetStats().spinTimeNs, 200000000);
+
+    // without spin time it is found by blocking, nothing is spent spinning
+    poller->SetSpinTime(chrono::microseconds(0));
+    poller->ResetStats();
+    sender = thread(sendOne);
+    poller->Poll(1000);
+    sender.join();
+    EXPECT_TRUE(poller->CheckInput(0));
+    EXPECT_EQ(poller->GetStats().numBlockWakeups, 1);
+    EXPECT_EQ(poller->GetStats().numSpinWakeups, 0);
+    EXPECT_EQ(poller->GetStats().SpinRatio(), 0.);
+    EXPECT_EQ(poller->GetStats().spinTimeNs, 0);
+    receiveOne();
+}
+
+TEST(BusyPoll, zeromq)
+{
+    RunBusyPoll("zeromq");
+}
+
+TEST(BusyPoll, shmem)
+{
+    RunBusyPoll("shmem");
+}
+
 TEST(Subchannel, zeromq)
 {
     EXPECT_EXIT(RunPoller("zeromq", 0), ::testing::ExitedWithCode(0), "POLL test successfull");
@@ -39,6 +39,8 @@ auto RunPubSub(string transport) -> void
         cmd << runTestDevice
             << " --id pub_" << transport
             << " --control static"
+            << " --transport " << transport
+            << " --shm-segment-size 100000000"
             << " --session " << session
             << " --color false"
             << " --channel-config name=data,type=pub,method=bind,address=" << dataAddress
@@ -52,6 +54,8 @@ auto RunPubSub(string transport) -> void
         cmd << runTestDevice
             << " --id sub_1" << transport
             << " --control static"
+            << " --transport " << transport
+            << " --shm-segment-size 100000000"
             << " --session " << session
             << " --color false"
             << " --channel-config name=data,type=sub,method=connect,address=" << dataAddress
@@ -65,6 +69,8 @@ auto RunPubSub(string transport) -> void
         cmd << runTestDevice
             << " --id sub_2" << transport
             << " --control static"
+            << " --transport " << transport
+            << " --shm-segment-size 100000000"
             << " --session " << session
             << " --color false"
             << " --channel-config name=data,type=sub,method=connect,address=" << dataAddress
@@ -88,4 +94,9 @@ TEST(PubSub, zeromq)
     EXPECT_EXIT(RunPubSub("zeromq"), ::testing::ExitedWithCode(0), "PUB-SUB test successfull");
 }
 
+TEST(PubSub, shmem)
+{
+    EXPECT_EXIT(RunPubSub("shmem"), ::testing::ExitedWithCode(0), "PUB-SUB test successfull");
+}
+
 } // namespace
@@ -21,10 +21,14 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm> // fill_n
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <map>
 #include <memory> // make_unique
 #include <string>
+#include <thread>
 #include <utility> // pair
 #include <vector> // pair
 
@@ -335,6 +339,179 @@ void RegionCallbacks(const string& transport, const string& _address)
     LOG(info) << "2 done.";
 }
 
+void RegionZeroCopy(const string& transport, const string& _address)
+{
+    size_t session(tools::UuidHash());
+    std::string address(tools::ToString(_address, "_", transport));
+
+    ProgOptions config;
+    config.SetProperty<string>("session", to_string(session));
+
+    auto factory = TransportFactory::CreateTransportFactory(transport, tools::Uuid(), &config);
+
+    Channel push("Push", "push", factory);
+    push.Bind(address);
+
+    Channel pull("Pull", "pull", factory);
+    pull.Connect(address);
+
+    constexpr size_t size = 1000;
+    tools::Semaphore blocker;
+    atomic<int> numAcks(0);
+
+    auto region = factory->CreateUnmanagedRegion(10000, [&](const std::vector<RegionBlock>& blocks) {
+        numAcks += blocks.size();
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            blocker.Signal();
+        }
+    });
+    char* data = static_cast<char*>(region->GetData());
+    std::fill_n(data, size, 'a');
+    std::fill_n(data + size, size, 'b');
+
+    {
+        MessagePtr msgOut(push.NewMessage(region, data, size));
+        ASSERT_EQ(push.Send(msgOut), size);
+        MessagePtr msgIn(pull.NewMessage());
+        ASSERT_EQ(pull.Receive(msgIn), size);
+        // the received message points into the region
+        ASSERT_EQ(msgIn->GetData(), data);
+        this_thread::sleep_for(chrono::milliseconds(50));
+        ASSERT_EQ(numAcks, 0); // still in use by the receiver
+    }
+    blocker.Wait();
+    ASSERT_EQ(numAcks, 1);
+
+    // in-flight messages keep the region buffer alive
+    MessagePtr msgOut(push.NewMessage(region, data + size, size));
+    ASSERT_EQ(push.Send(msgOut), size);
+    MessagePtr msgIn(pull.NewMessage());
+    ASSERT_EQ(pull.Receive(msgIn), size);
+    region->SetLinger(10);
+    region.reset();
+    ASSERT_EQ(string(static_cast<char*>(msgIn->GetData()), size), string(size, 'b'));
+    ASSERT_EQ(numAcks, 1);
+}
+
+void RegionAckLatency(const string& transport, const string& _address)
+{
+    size_t session(tools::UuidHash());
+    std::string address(tools::ToString(_address, "_", transport));
+
+    ProgOptions config;
+    config.SetProperty<string>("session", to_string(session));
+    config.SetProperty<size_t>("shm-segment-size", 100000000);
+
+    auto factory = TransportFactory::CreateTransportFactory(transport, tools::Uuid(), &config);
+
+    Channel push("Push", "push", factory);
+    push.Bind(address);
+
+    Channel pull("Pull", "pull", factory);
+    pull.Connect(address);
+
+    constexpr int numMsgs = 10;
+    constexpr size_t size = 100;
+    tools::Semaphore blocker;
+
+    RegionConfig cfg;
+    cfg.ackMaxDelay = 50;
+    cfg.ackBatchSize = 256;
+    auto region = factory->CreateUnmanagedRegion(10000, [&](const std::vector<RegionBlock>& blocks) {
+        for (size_t i = 0; i < blocks.size(); ++i) {
+            blocker.Signal();
+        }
+    }, cfg);
+
+    // at a low message rate, every ack has to arrive well before the size threshold is reached
+    for (int i = 0; i < numMsgs; ++i) {
+        MessagePtr msgOut(push.NewMessage(region, static_cast<char*>(region->GetData()) + i * size, size));
+        ASSERT_EQ(push.Send(msgOut), size);
+        {
+            MessagePtr msgIn(pull.NewMessage());
+            ASSERT_EQ(pull.Receive(msgIn), size);
+        }
+        auto start = chrono::steady_clock::now();
+        blocker.Wait();
+        ASSERT_LT(chrono::steady_clock::now() - start, chrono::milliseconds(100));
+    }
+
+    auto stats = region->GetAckStats();
+    LOG(info) << "ack latency (ns) p50: " << stats.p50 << ", p90: " << stats.p90 << ", p99: " << stats.p99 << ", max: " << stats.max;
+    ASSERT_EQ(stats.count, static_cast<uint64_t>(numMsgs));
+    ASSERT_LE(stats.p50, stats.p99);
+    ASSERT_LE(stats.p99, stats.max);
+    ASSERT_LT(stats.max, 100000000);
+}
+
+void RegionAllocation(const string& transport, const string& _address)
+{
+    size_t session(tools::UuidHash());
+    std::string address(tools::ToString(_address, "_", transport));
+
+    ProgOptions config;
+    config.SetProperty<string>("session", to_string(session));
+    config.SetProperty<size_t>("shm-segment-size", 100000000);
+
+    auto factory = TransportFactory::CreateTransportFactory(transport, tools::Uuid(), &config);
+
+    Channel push("Push", "push", factory);
+    push.Bind(address);
+
+    Channel pull("Pull", "pull", factory);
+    pull.Connect(address);
+
+    constexpr size_t regionSize = 65536;
+    constexpr size_t size = 1000;
+    atomic<int> numAcks(0);
+
+    RegionConfig cfg;
+    cfg.allocator = true;
+    cfg.allocatorGranularity = 256;
+    cfg.ackMaxDelay = 0;
+    auto region = factory->CreateUnmanagedRegion(regionSize, [&](const std::vector<RegionBlock>& blocks) {
+        numAcks += blocks.size();
+    }, cfg);
+    ASSERT_TRUE(region->HasAllocator());
+
+    // many times the region capacity, replenished by the acks
+    constexpr int numMsgs = 1000;
+    for (int i = 0; i < numMsgs; ++i) {
+        void* ptr = region->Allocate(size, 64, RegionAllocationPolicy::block, 5000);
+        ASSERT_NE(ptr, nullptr);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(ptr) % 64, 0);
+        std::fill_n(static_cast<char*>(ptr), size, static_cast<char>(i));
+        MessagePtr msgOut(push.NewMessage(region, ptr, size));
+        ASSERT_EQ(push.Send(msgOut), size);
+        MessagePtr msgIn(pull.NewMessage());
+        ASSERT_EQ(pull.Receive(msgIn), size);
+        ASSERT_EQ(static_cast<char*>(msgIn->GetData())[size - 1], static_cast<char>(i));
+    }
+
+    // wait for the acks of all messages (their buffers are released before the callback), then fill the region without sending
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+    while (numAcks < numMsgs && chrono::steady_clock::now() < deadline) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    ASSERT_EQ(numAcks, numMsgs);
+    ASSERT_EQ(region->GetAllocator()->GetFreeSize(), region->GetAllocator()->GetCapacity());
+
+    vector<void*> buffers;
+    while (void* ptr = region->Allocate(size, 0, RegionAllocationPolicy::fail)) {
+        buffers.push_back(ptr);
+    }
+    ASSERT_EQ(buffers.size(), regionSize / 1024);
+    ASSERT_EQ(region->Allocate(size, 0, RegionAllocationPolicy::block, 10), nullptr);
+    for (void* ptr : buffers) {
+        region->Deallocate(ptr);
+    }
+    ASSERT_NE(region->Allocate(size, 0, RegionAllocationPolicy::fail), nullptr);
+
+    auto plainRegion = factory->CreateUnmanagedRegion(regionSize, [](const std::vector<RegionBlock>&) {});
+    ASSERT_FALSE(plainRegion->HasAllocator());
+    ASSERT_THROW(plainRegion->Allocate(size), RegionAllocatorError);
+}
+
 TEST(RegionsSizeMismatch, shmem)
 {
     RegionsSizeMismatch();
@@ -370,6 +547,26 @@ TEST(Callbacks, shmem)
     RegionCallbacks("shmem", "ipc://test_region_callbacks");
 }
 
+TEST(ZeroCopy, zeromq)
+{
+    RegionZeroCopy("zeromq", "inproc://test_region_zerocopy");
+}
+
+TEST(AckLatency, shmem)
+{
+    RegionAckLatency("shmem", "ipc://test_region_ack_latency");
+}
+
+TEST(Allocator, zeromq)
+{
+    RegionAllocation("zeromq", "ipc://test_region_allocator");
+}
+
+TEST(Allocator, shmem)
+{
+    RegionAllocation("shmem", "ipc://test_region_allocator");
+}
+
 TEST(EventSubscriptionsExternalRegion, shmem)
 {
     RegionEventSubscriptions("shmem", true);
@@ -0,0 +1,74 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include <fairmq/tools/Histogram.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+
+using namespace std;
+using namespace fair::mq::tools;
+
+TEST(Histogram, SmallValuesAreExact)
+{
+    LatencyHistogram hist(7);
+    for (uint64_t v = 0; v < 100; ++v) {
+        hist.Record(v);
+    }
+    EXPECT_EQ(hist.GetCount(), 100U);
+    EXPECT_EQ(hist.GetMin(), 0U);
+    EXPECT_EQ(hist.GetMax(), 99U);
+    EXPECT_EQ(hist.Percentile(50.), 49U);
+    EXPECT_EQ(hist.Percentile(100.), 99U);
+    EXPECT_DOUBLE_EQ(hist.GetMean(), 49.5);
+}
+
+TEST(Histogram, RelativeError)
+{
+    LatencyHistogram hist(7);
+    for (uint64_t v = 1; v <= 1000000; ++v) {
+        hist.Record(v);
+    }
+    for (double p : {50., 90., 99., 99.9}) {
+        double expected = p / 100. * 1000000;
+        EXPECT_NEAR(static_cast<double>(hist.Percentile(p)), expected, expected / 128.) << "p" << p;
+    }
+    EXPECT_EQ(hist.Percentile(0.), 1U);
+    EXPECT_EQ(hist.Percentile(100.), 1000000U);
+    EXPECT_NEAR(hist.GetStdDev(), 288675., 10.);
+
+    hist.Record(numeric_limits<uint64_t>::max());
+    EXPECT_EQ(hist.GetMax(), numeric_limits<uint64_t>::max());
+}
+
+TEST(Histogram, Merge)
+{
+    LatencyHistogram a(5);
+    LatencyHistogram b(5);
+    a.Record(1000, 3);
+    b.Record(10);
+    b.Record(100000);
+    a.Merge(b);
+    EXPECT_EQ(a.GetCount(), 5U);
+    EXPECT_EQ(a.GetMin(), 10U);
+    EXPECT_EQ(a.GetMax(), 100000U);
+    EXPECT_NEAR(static_cast<double>(a.Percentile(50.)), 1000., 1000. / 32.);
+
+    a.Reset();
+    EXPECT_EQ(a.GetCount(), 0U);
+    EXPECT_EQ(a.Percentile(99.), 0U);
+    EXPECT_THROW(a.Merge(LatencyHistogram(7)), invalid_argument);
+}
+
+} // namespace
@@ -0,0 +1,148 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include <fairmq/Metrics.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+using namespace std;
+using namespace fair::mq::metrics;
+
+TEST(Metrics, CounterAcrossThreads)
+{
+    Counter counter;
+    vector<thread> threads;
+    for (int t = 0; t < 2 * static_cast<int>(kNumShards); ++t) {
+        threads.emplace_back([&counter]() {
+            for (int i = 0; i < 10000; ++i) {
+                counter.Add();
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(counter.Get(), 2 * kNumShards * 10000);
+}
+
+TEST(Metrics, HistogramBuckets)
+{
+    vector<uint64_t> bounds{1, 2, 3, 4, 6, 8, 12, 16, 24, 32};
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        EXPECT_EQ(Histogram::BucketBound(i), bounds[i]);
+        EXPECT_EQ(Histogram::BucketIndex(bounds[i]), i);
+        EXPECT_EQ(Histogram::BucketIndex(bounds[i] + 1), i + 1);
+    }
+    EXPECT_EQ(Histogram::BucketIndex(0), 0UL);
+    for (size_t i = 1; i < Histogram::kNumBuckets; ++i) {
+        EXPECT_LT(Histogram::BucketBound(i - 1), Histogram::BucketBound(i));
+        EXPECT_EQ(Histogram::BucketIndex(Histogram::BucketBound(i)), i);
+        EXPECT_EQ(Histogram::BucketIndex(Histogram::BucketBound(i - 1) + 1), i);
+    }
+    EXPECT_EQ(Histogram::BucketIndex(Histogram::BucketBound(Histogram::kNumBuckets - 1) + 1), Histogram::kNumBuckets);
+    EXPECT_EQ(Histogram::BucketIndex(UINT64_MAX), Histogram::kNumBuckets);
+
+    Histogram histogram;
+    histogram.Observe(3);
+    histogram.Observe(4);
+    histogram.Observe(1000);
+    auto s = histogram.Get();
+    EXPECT_EQ(s.fCount, 3UL);
+    EXPECT_EQ(s.fSum, 1007UL);
+    EXPECT_EQ(s.fBuckets[2], 1UL);
+    EXPECT_EQ(s.fBuckets[3], 1UL);
+    EXPECT_EQ(s.fBuckets[Histogram::BucketIndex(1000)], 1UL);
+    EXPECT_EQ(Histogram::BucketBound(Histogram::BucketIndex(1000)), 1024UL);
+}
+
+TEST(Metrics, TransferMetrics)
+{
+    Registry registry;
+    TransferMetrics m;
+    EXPECT_FALSE(m);
+    m.fTiming = &registry.GetTimingFlag();
+    m.fBlockedNs = &registry.GetCounter("test_blocked_total", "");
+    m.fTimeouts = &registry.GetCounter("test_timeouts_total", "");
+    m.fDuration = &registry.GetHistogram("test_duration", "");
+#ifndef FAIRMQ_NO_CHANNEL_METRICS
+    EXPECT_TRUE(m);
+#endif
+
+    EXPECT_EQ(m.Measure([]() { return 10; }), 10);
+    EXPECT_EQ(m.fDuration->Get().fCount, 0UL);
+
+    registry.SetTimingEnabled(true);
+    EXPECT_EQ(m.Measure([]() { return 10; }), 10);
+    EXPECT_EQ(m.Measure([]() { return -2; }), -2);
+    EXPECT_EQ(m.fDuration->Get().fCount, 1UL);
+    EXPECT_EQ(m.fTimeouts->Get(), 1UL);
+    EXPECT_GT(m.fBlockedNs->Get(), 0UL);
+}
+
+TEST(Metrics, Registry)
+{
+    Registry registry;
+    Counter& c = registry.GetCounter("test_total", "a counter", {{"channel", "data"}});
+    EXPECT_EQ(&registry.GetCounter("test_total", "a counter", {{"channel", "data"}}), &c);
+    EXPECT_NE(&registry.GetCounter("test_total", "a counter", {{"channel", "other"}}), &c);
+    EXPECT_THROW(registry.GetGauge("test_total", "a gauge"), MetricsError);
+    EXPECT_THROW(registry.GetCounter("0invalid-name", "a counter"), MetricsError);
+
+    int owner = 0;
+    registry.AddCallback(&owner, "test_value", "a callback", Type::Gauge, {}, []() { return 42.; });
+    EXPECT_THROW(registry.AddCallback(&owner, "test_total", "", Type::Counter, {{"channel", "data"}}, []() { return 0.; }), MetricsError);
+    EXPECT_EQ(registry.GetNumMetrics(), 3UL);
+    registry.RemoveCallbacks(&owner);
+    EXPECT_EQ(registry.GetNumMetrics(), 2UL);
+}
+
+TEST(Metrics, Prometheus)
+{
+    Registry registry;
+    registry.GetCounter("test_seconds_total", "time", {{"channel", "da\"ta"}}, 1e-3).Add(1500);
+    registry.GetHistogram("test_size", "sizes").Observe(3);
+    int owner = 0;
+    registry.AddCallback(&owner, "test_value", "a callback", Type::Gauge, {}, []() { return 42.; });
+
+    ostringstream ss;
+    registry.WritePrometheus(ss);
+    string out = ss.str();
+    EXPECT_NE(out.find("# TYPE test_seconds_total counter\n"), string::npos);
+    EXPECT_NE(out.find("test_seconds_total{channel=\"da\\\"ta\"} 1.5\n"), string::npos);
+    EXPECT_NE(out.find("# TYPE test_size histogram\n"), string::npos);
+    EXPECT_NE(out.find("test_size_bucket{le=\"1\"} 0\n"), string::npos);
+    EXPECT_NE(out.find("test_size_bucket{le=\"2\"} 0\n"), string::npos);
+    EXPECT_NE(out.find("test_size_bucket{le=\"3\"} 1\n"), string::npos);
+    EXPECT_NE(out.find("test_size_bucket{le=\"+Inf\"} 1\n"), string::npos);
+    EXPECT_NE(out.find("test_size_sum 3\n"), string::npos);
+    EXPECT_NE(out.find("test_size_count 1\n"), string::npos);
+    EXPECT_NE(out.find("test_value 42\n"), string::npos);
+}
+
+TEST(Metrics, Json)
+{
+    Registry registry;
+    registry.GetGauge("test_depth", "depth", {{"queue", "a"}}).Set(-3);
+
+    ostringstream ss;
+    registry.WriteJson(ss);
+    string out = ss.str();
+    EXPECT_EQ(out.find("{\"timestamp_ms\": "), 0UL);
+    EXPECT_NE(out.find("{\"name\": \"test_depth\", \"type\": \"gauge\", \"labels\": {\"queue\": \"a\"}, \"value\": -3}"), string::npos);
+}
+
+} // namespace
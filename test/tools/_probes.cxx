@@ -0,0 +1,78 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include <fairmq/Probes.h>
+#include <fairmq/tools/Unique.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdio> // std::remove
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+using namespace std;
+using namespace fair::mq::probes;
+
+TEST(Probes, RecordAndRead)
+{
+    string const file = "/tmp/fairmq_probes_test_" + fair::mq::tools::Uuid();
+    StartRecording(file);
+    ASSERT_TRUE(IsRecording());
+    EXPECT_THROW(StartRecording(file), ProbesError);
+
+    detail::Record(Probe::alloc_begin, 100);
+    detail::Record(Probe::alloc_end, 100);
+    thread t([]() {
+        for (uint64_t i = 0; i < 10; ++i) {
+            detail::Record(Probe::region_ack_batch, i);
+        }
+    });
+    t.join();
+    StopRecording();
+    EXPECT_FALSE(IsRecording());
+
+    ifstream in(file, ios::binary);
+    ASSERT_TRUE(in.good());
+    Recording rec = ReadRecording(in);
+    remove(file.c_str());
+
+    ASSERT_EQ(rec.fProbeNames.size(), static_cast<size_t>(Probe::NumProbes));
+    EXPECT_EQ(rec.fProbeNames.at(static_cast<size_t>(Probe::region_ack_batch)), GetName(Probe::region_ack_batch));
+    ASSERT_EQ(rec.fEvents.size(), 12UL);
+
+    uint32_t mainThread = 0;
+    uint64_t ackArgs = 0;
+    for (const auto& event : rec.fEvents) {
+        if (event.fProbe == static_cast<uint16_t>(Probe::alloc_begin)) {
+            mainThread = event.fThread;
+            EXPECT_EQ(event.fArg, 100UL);
+        } else if (event.fProbe == static_cast<uint16_t>(Probe::region_ack_batch)) {
+            ackArgs += event.fArg;
+        }
+    }
+    EXPECT_EQ(ackArgs, 45UL);
+    for (const auto& event : rec.fEvents) {
+        if (event.fProbe == static_cast<uint16_t>(Probe::region_ack_batch)) {
+            EXPECT_NE(event.fThread, mainThread);
+        }
+    }
+}
+
+TEST(Probes, InvalidRecording)
+{
+    istringstream notARecording("this is not a recording");
+    EXPECT_THROW(ReadRecording(notARecording), ProbesError);
+}
+
+} // namespace
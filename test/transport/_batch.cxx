@@ -0,0 +1,130 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include <fairmq/Channel.h>
+#include <fairmq/Parts.h>
+#include <fairmq/Poller.h>
+#include <fairmq/ProgOptions.h>
+#include <fairmq/TransportFactory.h>
+#include <fairmq/tools/Strings.h>
+#include <fairmq/tools/Unique.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+using namespace std;
+using namespace fair::mq;
+
+void Batch(const string& transport, const string& address)
+{
+    ProgOptions config;
+    config.SetProperty<string>("session", tools::Uuid());
+    config.SetProperty<size_t>("shm-segment-size", 100000000);
+
+    auto factory = TransportFactory::CreateTransportFactory(transport, tools::Uuid(), &config);
+
+    Channel push("Push", "push", factory);
+    Channel pull("Pull", "pull", factory);
+    ASSERT_TRUE(pull.Bind(address));
+    ASSERT_TRUE(push.Connect(address));
+
+    vector<MessagePtr> empty;
+    EXPECT_EQ(pull.ReceiveBatch(empty, 10, 0), static_cast<int>(TransferCode::timeout));
+
+    constexpr int numMsgs = 100;
+    vector<MessagePtr> out;
+    for (int i = 0; i < numMsgs; ++i) {
+        out.push_back(push.NewMessage(sizeof(int)));
+        memcpy(out.back()->GetData(), &i, sizeof(int));
+    }
+    ASSERT_EQ(push.SendBatch(out), numMsgs);
+    EXPECT_EQ(push.GetMessagesTx(), static_cast<unsigned long>(numMsgs));
+    EXPECT_EQ(push.GetBytesTx(), numMsgs * sizeof(int));
+
+    // single messages can be received as part of a batch
+    MessagePtr single(push.NewMessage(sizeof(int)));
+    memcpy(single->GetData(), &numMsgs, sizeof(int));
+    ASSERT_EQ(push.Send(single), static_cast<int64_t>(sizeof(int)));
+
+    vector<MessagePtr> in;
+    while (in.size() < numMsgs + 1) {
+        ASSERT_GT(pull.ReceiveBatch(in, numMsgs + 1, 1000), 0);
+    }
+    ASSERT_EQ(in.size(), static_cast<size_t>(numMsgs + 1));
+    for (int i = 0; i <= numMsgs; ++i) {
+        ASSERT_EQ(in.at(i)->GetSize(), sizeof(int));
+        EXPECT_EQ(*static_cast<int*>(in.at(i)->GetData()), i);
+    }
+    EXPECT_EQ(pull.GetMessagesRx(), static_cast<unsigned long>(numMsgs + 1));
+    EXPECT_EQ(pull.GetBytesRx(), (numMsgs + 1) * sizeof(int));
+
+    // a batch is handed out within maxMessages, and to the single message receive calls one message at a time
+    constexpr int batchSize = 6;
+    out.clear();
+    for (int i = 0; i < batchSize; ++i) {
+        out.push_back(push.NewMessage(sizeof(int)));
+        memcpy(out.back()->GetData(), &i, sizeof(int));
+    }
+    ASSERT_EQ(push.SendBatch(out), batchSize);
+
+    vector<MessagePtr> first;
+    while (first.empty()) {
+        ASSERT_GE(pull.ReceiveBatch(first, 2, 1000), 0);
+    }
+    ASSERT_LE(first.size(), 2UL);
+    int next = static_cast<int>(first.size());
+    for (int i = 0; i < next; ++i) {
+        EXPECT_EQ(*static_cast<int*>(first.at(i)->GetData()), i);
+    }
+    if (next < 3) {
+        MessagePtr msg(pull.NewMessage());
+        ASSERT_EQ(pull.Receive(msg, 1000), static_cast<int64_t>(sizeof(int)));
+        EXPECT_EQ(*static_cast<int*>(msg->GetData()), next++);
+    }
+    Parts parts;
+    ASSERT_EQ(pull.Receive(parts, 1000), static_cast<int64_t>(sizeof(int)));
+    ASSERT_EQ(parts.Size(), 1UL);
+    EXPECT_EQ(*static_cast<int*>(parts.At(0)->GetData()), next++);
+
+    // the rest is ready for the poller without anything left in the transport
+    auto poller = factory->CreatePoller(vector<Channel*>{&pull});
+    poller->Poll(1000);
+    EXPECT_TRUE(poller->CheckInput(0));
+
+    vector<MessagePtr> rest;
+    while (next + static_cast<int>(rest.size()) < batchSize) {
+        ASSERT_GT(pull.ReceiveBatch(rest, batchSize, 1000), 0);
+    }
+    ASSERT_EQ(next + rest.size(), static_cast<size_t>(batchSize));
+    for (auto& msg : rest) {
+        EXPECT_EQ(*static_cast<int*>(msg->GetData()), next++);
+    }
+}
+
+TEST(Batch, zeromq)
+{
+    Batch("zeromq", "inproc://test_batch_zeromq");
+}
+
+TEST(Batch, shmem)
+{
+    Batch("shmem", "inproc://test_batch_shmem");
+}
+
+TEST(Batch, shmem_ipc)
+{
+    Batch("shmem", tools::ToString("ipc://test_batch_shmem_", tools::UuidHash()));
+}
+
+} // namespace
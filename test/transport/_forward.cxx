@@ -0,0 +1,122 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include <fairmq/Channel.h>
+#include <fairmq/Parts.h>
+#include <fairmq/ProgOptions.h>
+#include <fairmq/TransportFactory.h>
+#include <fairmq/shmem/Monitor.h>
+#include <fairmq/tools/Strings.h>
+#include <fairmq/tools/Unique.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+using namespace std;
+using namespace fair::mq;
+
+void Forward(const string& transport, const string& address, bool ring)
+{
+    ProgOptions config;
+    string session(tools::Uuid());
+    config.SetProperty<string>("session", session);
+    config.SetProperty<size_t>("shm-segment-size", 100000000);
+    config.SetProperty<bool>("shm-ring", ring);
+
+    auto factory = TransportFactory::CreateTransportFactory(transport, tools::Uuid(), &config);
+    auto freeMemory = [&]() { return shmem::Monitor::GetFreeMemory(shmem::SessionId{session}, 0); };
+
+    // source -> in => out -> sink
+    Channel source("Push", "push", factory);
+    Channel in("Pull", "pull", factory);
+    Channel out("Push", "push", factory);
+    Channel sink("Pull", "pull", factory);
+    ASSERT_TRUE(in.Bind(address + "_in"));
+    ASSERT_TRUE(source.Connect(address + "_in"));
+    ASSERT_TRUE(sink.Bind(address + "_out"));
+    ASSERT_TRUE(out.Connect(address + "_out"));
+
+    unsigned long initialFree = 0;
+    if (transport == "shmem") {
+        initialFree = freeMemory();
+    }
+
+    EXPECT_EQ(in.Forward(out, false, 0), static_cast<int>(TransferCode::timeout));
+
+    for (int i = 0; i < 3; ++i) {
+        MessagePtr msg(factory->CreateMessage(1000));
+        memset(msg->GetData(), 'a' + i, 1000);
+        void* data = msg->GetData();
+        ASSERT_EQ(source.Send(msg), 1000);
+        ASSERT_EQ(in.Forward(out, false), 1000);
+
+        MessagePtr received(sink.NewMessage());
+        ASSERT_EQ(sink.Receive(received), 1000);
+        EXPECT_EQ(static_cast<char*>(received->GetData())[999], 'a' + i);
+        if (transport == "shmem") {
+            EXPECT_EQ(received->GetData(), data);
+        }
+    }
+    EXPECT_EQ(in.GetMessagesRx(), 3UL);
+    EXPECT_EQ(out.GetMessagesTx(), 3UL);
+    EXPECT_EQ(out.GetBytesTx(), 3000UL);
+
+    {
+        constexpr int numParts = 100;
+        Parts parts;
+        for (int i = 0; i < numParts; ++i) {
+            parts.AddPart(factory->CreateMessage(sizeof(int)));
+            memcpy(parts.At(i)->GetData(), &i, sizeof(int));
+        }
+        ASSERT_EQ(source.Send(parts), static_cast<int64_t>(numParts * sizeof(int)));
+        ASSERT_EQ(in.Forward(out, true), static_cast<int64_t>(numParts * sizeof(int)));
+
+        Parts received;
+        ASSERT_EQ(sink.Receive(received), static_cast<int64_t>(numParts * sizeof(int)));
+        ASSERT_EQ(received.Size(), static_cast<size_t>(numParts));
+        EXPECT_EQ(*static_cast<int*>(received.At(numParts - 1)->GetData()), numParts - 1);
+    }
+
+    if (!ring) {
+        // the send is limited by the send timeout of the output, the message is dropped
+        Channel stalled("Push", "push", factory);
+        stalled.UpdateSndTimeout(100);
+        ASSERT_TRUE(stalled.Connect(address + "_nowhere"));
+        MessagePtr msg(factory->CreateMessage(1000));
+        ASSERT_EQ(source.Send(msg), 1000);
+        EXPECT_EQ(in.Forward(stalled, false), static_cast<int>(TransferCode::timeout));
+    }
+
+    if (transport == "shmem") {
+        EXPECT_EQ(freeMemory(), initialFree);
+    }
+}
+
+TEST(Forward, zeromq)
+{
+    Forward("zeromq", "inproc://test_forward_zeromq", false);
+}
+
+TEST(Forward, shmem)
+{
+    Forward("shmem", tools::ToString("ipc://test_forward_shmem_", tools::UuidHash()), false);
+}
+
+TEST(Forward, shmem_ring)
+{
+    Forward("shmem", "inproc://test_forward_shmem_ring", true);
+}
+
+} // namespace
@@ -0,0 +1,120 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include <fairmq/Channel.h>
+#include <fairmq/Parts.h>
+#include <fairmq/PartsView.h>
+#include <fairmq/ProgOptions.h>
+#include <fairmq/TransportFactory.h>
+#include <fairmq/shmem/Monitor.h>
+#include <fairmq/tools/Strings.h>
+#include <fairmq/tools/Unique.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+namespace
+{
+
+using namespace std;
+using namespace fair::mq;
+
+void SendParts(Channel& push, int numParts, int offset)
+{
+    Parts parts;
+    for (int i = 0; i < numParts; ++i) {
+        parts.AddPart(push.NewMessage(sizeof(int)));
+        int value = offset + i;
+        memcpy(parts.At(i)->GetData(), &value, sizeof(int));
+    }
+    ASSERT_EQ(push.Send(parts), static_cast<int64_t>(numParts * sizeof(int)));
+}
+
+void View(const string& transport, const string& address)
+{
+    ProgOptions config;
+    string session(tools::Uuid());
+    config.SetProperty<string>("session", session);
+    config.SetProperty<size_t>("shm-segment-size", 100000000);
+
+    auto factory = TransportFactory::CreateTransportFactory(transport, tools::Uuid(), &config);
+    auto freeMemory = [&]() { return shmem::Monitor::GetFreeMemory(shmem::SessionId{session}, 0); };
+
+    Channel push("Push", "push", factory);
+    Channel pull("Pull", "pull", factory);
+    ASSERT_TRUE(pull.Bind(address));
+    ASSERT_TRUE(push.Connect(address));
+
+    PartsView view;
+    EXPECT_EQ(pull.Receive(view, 0), static_cast<int>(TransferCode::timeout));
+    EXPECT_TRUE(view.Empty());
+
+    unsigned long initialFree = 0;
+    if (transport == "shmem") {
+        initialFree = freeMemory();
+    }
+
+    constexpr int numParts = 1000;
+    SendParts(push, numParts, 0);
+    ASSERT_EQ(pull.Receive(view), static_cast<int64_t>(numParts * sizeof(int)));
+    ASSERT_EQ(view.Size(), static_cast<size_t>(numParts));
+    int i = 0;
+    for (const auto& part : view) {
+        ASSERT_EQ(part.size, sizeof(int));
+        EXPECT_EQ(*static_cast<int*>(part.data), i++);
+    }
+    EXPECT_EQ(pull.GetMessagesRx(), 1UL);
+    EXPECT_EQ(pull.GetBytesRx(), numParts * sizeof(int));
+
+    // a taken part outlives the view content
+    MessagePtr taken = view.Take(7);
+    EXPECT_TRUE(view.IsTaken(7));
+    EXPECT_THROW(view.Take(7), PartsViewError);
+    EXPECT_THROW(view.Take(numParts), PartsViewError);
+
+    // receiving again releases the remaining parts of the previous message
+    SendParts(push, 3, 100);
+    ASSERT_EQ(pull.Receive(view), static_cast<int64_t>(3 * sizeof(int)));
+    ASSERT_EQ(view.Size(), 3UL);
+    EXPECT_EQ(*static_cast<int*>(view[2].data), 102);
+    ASSERT_EQ(taken->GetSize(), sizeof(int));
+    EXPECT_EQ(*static_cast<int*>(taken->GetData()), 7);
+
+    Parts rest;
+    view.TakeAll(rest);
+    ASSERT_EQ(rest.Size(), 3UL);
+    EXPECT_EQ(*static_cast<int*>(rest.At(0)->GetData()), 100);
+    view.Clear();
+    EXPECT_TRUE(view.Empty());
+    EXPECT_EQ(*static_cast<int*>(rest.At(1)->GetData()), 101);
+
+    rest.Clear();
+    taken.reset();
+    if (transport == "shmem") {
+        EXPECT_EQ(freeMemory(), initialFree);
+    }
+}
+
+TEST(PartsView, zeromq)
+{
+    View("zeromq", "inproc://test_parts_view_zeromq");
+}
+
+TEST(PartsView, shmem)
+{
+    View("shmem", "inproc://test_parts_view_shmem");
+}
+
+TEST(PartsView, shmem_ipc)
+{
+    View("shmem", tools::ToString("ipc://test_parts_view_shmem_", tools::UuidHash()));
+}
+
+} // namespace
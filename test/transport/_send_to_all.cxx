@@ -0,0 +1,131 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include <fairmq/Channel.h>
+#include <fairmq/Parts.h>
+#include <fairmq/ProgOptions.h>
+#include <fairmq/TransportFactory.h>
+#include <fairmq/shmem/Message.h>
+#include <fairmq/shmem/Monitor.h>
+#include <fairmq/tools/Strings.h>
+#include <fairmq/tools/Unique.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+using namespace std;
+using namespace fair::mq;
+
+void SendToAll(const string& transport, const string& address, bool ring)
+{
+    ProgOptions config;
+    string session(tools::Uuid());
+    config.SetProperty<string>("session", session);
+    config.SetProperty<size_t>("shm-segment-size", 100000000);
+    config.SetProperty<bool>("shm-ring", ring);
+
+    auto factory = TransportFactory::CreateTransportFactory(transport, tools::Uuid(), &config);
+    auto freeMemory = [&]() { return shmem::Monitor::GetFreeMemory(shmem::SessionId{session}, 0); };
+
+    constexpr int numOutputs = 3;
+    vector<unique_ptr<Channel>> pushs;
+    vector<unique_ptr<Channel>> pulls;
+    vector<Channel*> outputs;
+    for (int i = 0; i < numOutputs; ++i) {
+        pushs.push_back(make_unique<Channel>("Push", "push", factory));
+        pulls.push_back(make_unique<Channel>("Pull", "pull", factory));
+        string endpoint(tools::ToString(address, "_", i));
+        ASSERT_TRUE(pulls.back()->Bind(endpoint));
+        ASSERT_TRUE(pushs.back()->Connect(endpoint));
+        outputs.push_back(pushs.back().get());
+    }
+
+    unsigned long initialFree = 0;
+    if (transport == "shmem") {
+        initialFree = freeMemory();
+    }
+
+    {
+        MessagePtr msg(factory->CreateMessage(1000));
+        memset(msg->GetData(), 'a', 1000);
+        ASSERT_EQ(Channel::SendToAll(outputs, msg), 1000);
+
+        vector<MessagePtr> received;
+        for (auto& pull : pulls) {
+            received.push_back(pull->NewMessage());
+            ASSERT_EQ(pull->Receive(received.back()), 1000);
+            EXPECT_EQ(static_cast<char*>(received.back()->GetData())[999], 'a');
+            EXPECT_EQ(pull->GetMessagesRx(), 1UL);
+        }
+        for (auto& push : pushs) {
+            EXPECT_EQ(push->GetBytesTx(), 1000UL);
+        }
+        if (transport == "shmem") {
+            // all outputs share one buffer
+            EXPECT_EQ(received.at(0)->GetData(), received.at(2)->GetData());
+            EXPECT_EQ(static_cast<const shmem::Message&>(*received.at(1)).GetRefCount(), numOutputs);
+        }
+    }
+
+    {
+        constexpr int numParts = 500;
+        Parts parts;
+        for (int i = 0; i < numParts; ++i) {
+            parts.AddPart(factory->CreateMessage(sizeof(int)));
+            memcpy(parts.At(i)->GetData(), &i, sizeof(int));
+        }
+        ASSERT_EQ(Channel::SendToAll(outputs, parts), static_cast<int64_t>(numParts * sizeof(int)));
+        for (auto& pull : pulls) {
+            Parts received;
+            ASSERT_EQ(pull->Receive(received), static_cast<int64_t>(numParts * sizeof(int)));
+            ASSERT_EQ(received.Size(), static_cast<size_t>(numParts));
+            EXPECT_EQ(*static_cast<int*>(received.At(numParts - 1)->GetData()), numParts - 1);
+        }
+    }
+
+    if (!ring) {
+        // an output without peer does not get the message, the others do
+        Channel unconnected("Push", "push", factory);
+        ASSERT_TRUE(unconnected.Bind(tools::ToString(address, "_unconnected")));
+        vector<Channel*> withUnconnected{ outputs.at(0), &unconnected, outputs.at(1) };
+        MessagePtr msg(factory->CreateMessage(100));
+        EXPECT_EQ(Channel::SendToAll(withUnconnected, msg, 0), static_cast<int>(TransferCode::timeout));
+        for (int i = 0; i < 2; ++i) {
+            MessagePtr received(pulls.at(i)->NewMessage());
+            ASSERT_EQ(pulls.at(i)->Receive(received), 100);
+        }
+    }
+
+    if (transport == "shmem") {
+        EXPECT_EQ(freeMemory(), initialFree);
+    }
+}
+
+TEST(SendToAll, zeromq)
+{
+    SendToAll("zeromq", "inproc://test_send_to_all_zeromq", false);
+}
+
+TEST(SendToAll, shmem)
+{
+    SendToAll("shmem", tools::ToString("ipc://test_send_to_all_shmem_", tools::UuidHash()), false);
+}
+
+TEST(SendToAll, shmem_ring)
+{
+    SendToAll("shmem", "inproc://test_send_to_all_shmem_ring", true);
+}
+
+} // namespace
@@ -6,14 +6,23 @@
  *                  copied verbatim in the file "LICENSE"                       *
  ********************************************************************************/
 
+#include <fairmq/Channel.h>
+#include <fairmq/Parts.h>
 #include <fairmq/ProgOptions.h>
+#include <fairmq/shmem/Message.h>
 #include <fairmq/shmem/Monitor.h>
+#include <fairmq/shmem/Socket.h>
 #include <fairmq/tools/Unique.h>
 #include <fairmq/TransportFactory.h>
 
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <cstring>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace
 {
@@ -41,4 +50,361 @@ TEST(Monitor, GetFreeMemory)
     GetFreeMemory();
 }
 
+void AllocCache(size_t maxSize)
+{
+    ProgOptions config;
+    string sessionId(to_string(tools::UuidHash()));
+    config.SetProperty<string>("session", sessionId);
+    config.SetProperty<size_t>("shm-segment-size", 100000000);
+    config.SetProperty<bool>("shm-alloc-cache", true);
+    config.SetProperty<size_t>("shm-alloc-cache-max-size", maxSize);
+
+    auto factory = TransportFactory::CreateTransportFactory("shmem", tools::Uuid(), &config);
+    const auto freeBefore = shmem::Monitor::GetFreeMemory(shmem::SessionId{sessionId}, 0);
+
+    constexpr uint64_t numMsgs = 1000;
+    for (uint64_t i = 0; i < numMsgs; ++i) {
+        auto msg = factory->CreateMessage(1000);
+        // above the largest size class, below the max size if that is not a power of two: not cached
+        auto large = factory->CreateMessage(maxSize - 1000);
+    }
+
+    // returns the cached chunks to the segment and publishes the remaining counters
+    factory->Reset();
+
+    auto info = shmem::Monitor::GetAllocCacheInfo(shmem::SessionId{sessionId}, 0);
+    EXPECT_EQ(info.fHits + info.fMisses, maxSize == 65536 ? 2 * numMsgs : numMsgs);
+    EXPECT_GE(info.fMisses, 1U);
+    EXPECT_GE(info.fRefills, 1U);
+    EXPECT_EQ(info.fCachedBytes, 0);
+    EXPECT_EQ(shmem::Monitor::GetFreeMemory(shmem::SessionId{sessionId}, 0), freeBefore);
+}
+
+TEST(Monitor, AllocCache)
+{
+    AllocCache(65536);
+}
+
+TEST(Monitor, AllocCacheNonPowerOfTwoMaxSize)
+{
+    AllocCache(100000);
+}
+
+void SegregatedSlab()
+{
+    ProgOptions config;
+    string sessionId(to_string(tools::UuidHash()));
+    config.SetProperty<string>("session", sessionId);
+    config.SetProperty<size_t>("shm-segment-size", 100000000);
+    config.SetProperty<string>("shm-allocation", "segregated_slab");
+
+    auto factory = TransportFactory::CreateTransportFactory("shmem", tools::Uuid(), &config);
+    const auto freeBefore = shmem::Monitor::GetFreeMemory(shmem::SessionId{sessionId}, 0);
+
+    {
+        vector<MessagePtr> msgs;
+        for (size_t size : { 10, 1000, 100000, 1000000, 2000000 }) {
+            for (int i = 0; i < 10; ++i) {
+                msgs.push_back(factory->CreateMessage(size));
+                memset(msgs.back()->GetData(), 'x', size);
+            }
+        }
+        EXPECT_LT(shmem::Monitor::GetFreeMemory(shmem::SessionId{sessionId}, 0), freeBefore);
+        // shrinking chunks from the slab arena keeps the full chunk
+        EXPECT_TRUE(msgs.at(10)->SetUsedSize(500));
+        EXPECT_EQ(msgs.at(10)->GetSize(), 500U);
+        EXPECT_TRUE(msgs.at(40)->SetUsedSize(500000));
+        EXPECT_EQ(msgs.at(40)->GetSize(), 500000U);
+    }
+
+    EXPECT_EQ(shmem::Monitor::GetFreeMemory(shmem::SessionId{sessionId}, 0), freeBefore);
+}
+
+TEST(Monitor, SegregatedSlab)
+{
+    SegregatedSlab();
+}
+
+void Fragmentation(const string& allocationAlgorithm)
+{
+    ProgOptions config;
+    string sessionId(to_string(tools::UuidHash()));
+    config.SetProperty<string>("session", sessionId);
+    config.SetProperty<size_t>("shm-segment-size", 100000000);
+    config.SetProperty<string>("shm-allocation", allocationAlgorithm);
+
+    ASSERT_THROW(shmem::Monitor::GetFragmentationInfo(shmem::SessionId{sessionId}, 0), shmem::Monitor::MonitorError);
+
+    auto factory = TransportFactory::CreateTransportFactory("shmem", tools::Uuid(), &config);
+    const auto before = shmem::Monitor::GetFragmentationInfo(shmem::SessionId{sessionId}, 0);
+    EXPECT_TRUE(before.fConsistent);
+    EXPECT_LE(before.fSize, 100000000U);
+    EXPECT_GT(before.fSize, before.fFreeBytes);
+    EXPECT_GT(before.fLargestMessage, 0U);
+    EXPECT_LT(before.fLargestMessage, before.fLargestFreeBlock);
+    ASSERT_THROW(shmem::Monitor::GetFragmentationInfo(shmem::SessionId{sessionId}, 1), shmem::Monitor::MonitorError);
+
+    {
+        // every other message freed: holes that are too small for a large message
+        vector<MessagePtr> msgs;
+        for (int i = 0; i < 200; ++i) {
+            msgs.push_back(factory->CreateMessage(300000));
+        }
+        for (size_t i = 0; i < msgs.size(); i += 2) {
+            msgs[i].reset();
+        }
+
+        const auto info = shmem::Monitor::GetFragmentationInfo(shmem::SessionId{sessionId}, 0);
+        EXPECT_TRUE(info.fConsistent);
+        EXPECT_GE(info.fNumFreeBlocks, before.fNumFreeBlocks + 99);
+        EXPECT_GE(info.fNumUsedBlocks, before.fNumUsedBlocks + 100);
+        EXPECT_LT(info.fLargestFreeBlock, before.fLargestFreeBlock);
+        EXPECT_GT(info.fFragmentation, before.fFragmentation);
+
+        uint64_t numFree = 0;
+        uint64_t freeBytes = 0;
+        for (size_t i = 0; i < shmem::FragmentationInfo::kNumBuckets; ++i) {
+            numFree += info.fFreeBlocks.at(i);
+            freeBytes += info.fFreeBlockBytes.at(i);
+        }
+        EXPECT_EQ(numFree, info.fNumFreeBlocks);
+        EXPECT_EQ(freeBytes, info.fFreeBytes);
+
+        // the largest message fits
+        EXPECT_NO_THROW(factory->CreateMessage(info.fLargestMessage));
+    }
+
+    const auto after = shmem::Monitor::GetFragmentationInfo(shmem::SessionId{sessionId}, 0);
+    EXPECT_EQ(after.fLargestFreeBlock, before.fLargestFreeBlock);
+    EXPECT_EQ(after.fFreeBytes, before.fFreeBytes);
+}
+
+TEST(Monitor, Fragmentation)
+{
+    Fragmentation("rbtree_best_fit");
+}
+
+TEST(Monitor, FragmentationSegregatedSlab)
+{
+    Fragmentation("segregated_slab");
+}
+
+void MetaRing(const string& address)
+{
+    ProgOptions config;
+    string sessionId(to_string(tools::UuidHash()));
+    config.SetProperty<string>("session", sessionId);
+    config.SetProperty<size_t>("shm-segment-size", 100000000);
+    config.SetProperty<bool>("shm-ring", true);
+    config.SetProperty<size_t>("shm-ring-capacity", 16);
+
+    auto factory = TransportFactory::CreateTransportFactory("shmem", tools::Uuid(), &config);
+    const auto freeBefore = shmem::Monitor::GetFreeMemory(shmem::SessionId{sessionId}, 0);
+
+    {
+        Channel push("Push", "push", factory);
+        Channel pull("Pull", "pull", factory);
+        ASSERT_TRUE(pull.Bind(address));
+        ASSERT_TRUE(push.Connect(address));
+
+        uint32_t events = 0;
+        ASSERT_EQ(pull.GetSocket().Events(&events), 0);
+        EXPECT_EQ(events, 0U);
+        MessagePtr empty(pull.NewMessage());
+        EXPECT_EQ(pull.Receive(empty, 0), static_cast<int>(TransferCode::timeout));
+
+        for (int i = 0; i < 10; ++i) {
+            MessagePtr msg(push.NewMessage(sizeof(int)));
+            memcpy(msg->GetData(), &i, sizeof(int));
+            ASSERT_EQ(push.Send(msg), static_cast<int64_t>(sizeof(int)));
+        }
+        Parts parts;
+        for (int i = 0; i < 5; ++i) {
+            parts.AddPart(push.NewMessage(100 * (i + 1)));
+        }
+        ASSERT_EQ(push.Send(parts), 1500);
+
+        ASSERT_EQ(pull.GetSocket().Events(&events), 0);
+        EXPECT_TRUE(events & 1); // ZMQ_POLLIN
+
+        auto poller = factory->CreatePoller(vector<Channel*>{ &pull });
+        poller->Poll(100);
+        EXPECT_TRUE(poller->CheckInput(0));
+
+        for (int i = 0; i < 10; ++i) {
+            MessagePtr msg(pull.NewMessage());
+            ASSERT_EQ(pull.Receive(msg), static_cast<int64_t>(sizeof(int)));
+            EXPECT_EQ(*static_cast<int*>(msg->GetData()), i);
+        }
+        Parts received;
+        ASSERT_EQ(pull.Receive(received), 1500);
+        ASSERT_EQ(received.Size(), 5U);
+        EXPECT_EQ(received.At(4)->GetSize(), 500U);
+
+        // the ring is full after 16 parts, a non-blocking send has to time out
+        for (int i = 0; i < 16; ++i) {
+            MessagePtr msg(push.NewMessage(1000));
+            ASSERT_EQ(push.Send(msg, 0), 1000);
+        }
+        MessagePtr msg(push.NewMessage(1000));
+        EXPECT_EQ(push.Send(msg, 0), static_cast<int>(TransferCode::timeout));
+        // messages left in the ring are released when the last socket detaches
+    }
+
+    EXPECT_EQ(shmem::Monitor::GetFreeMemory(shmem::SessionId{sessionId}, 0), freeBefore);
+}
+
+TEST(MetaRing, inproc)
+{
+    MetaRing("inproc://test_shm_meta_ring");
+}
+
+TEST(MetaRing, ipc)
+{
+    MetaRing(tools::ToString("ipc://test_shm_meta_ring_", tools::UuidHash()));
+}
+
+TEST(MetaRing, InprocPerTransport)
+{
+    ProgOptions config;
+    config.SetProperty<string>("session", to_string(tools::UuidHash()));
+    config.SetProperty<size_t>("shm-segment-size", 100000000);
+    config.SetProperty<bool>("shm-ring", true);
+
+    // inproc endpoints of the same address in two transports of one session are independent, and so are their rings
+    auto factory1 = TransportFactory::CreateTransportFactory("shmem", tools::Uuid(), &config);
+    auto factory2 = TransportFactory::CreateTransportFactory("shmem", tools::Uuid(), &config);
+    const string address("inproc://test_shm_meta_ring_per_transport");
+    Channel push1("Push1", "push", factory1);
+    Channel pull1("Pull1", "pull", factory1);
+    Channel push2("Push2", "push", factory2);
+    Channel pull2("Pull2", "pull", factory2);
+    ASSERT_TRUE(pull1.Bind(address));
+    ASSERT_TRUE(push1.Connect(address));
+    ASSERT_TRUE(pull2.Bind(address));
+    ASSERT_TRUE(push2.Connect(address));
+
+    MessagePtr msg(push1.NewMessage(1000));
+    ASSERT_EQ(push1.Send(msg), 1000);
+    MessagePtr other(pull2.NewMessage());
+    EXPECT_EQ(pull2.Receive(other, 100), static_cast<int>(TransferCode::timeout));
+    MessagePtr received(pull1.NewMessage());
+    EXPECT_EQ(pull1.Receive(received, 1000), 1000);
+}
+
+void PubSub(const string& address)
+{
+    ProgOptions config;
+    string sessionId(to_string(tools::UuidHash()));
+    config.SetProperty<string>("session", sessionId);
+    config.SetProperty<size_t>("shm-segment-size", 100000000);
+
+    auto factory = TransportFactory::CreateTransportFactory("shmem", tools::Uuid(), &config);
+    const auto freeBefore = shmem::Monitor::GetFreeMemory(shmem::SessionId{sessionId}, 0);
+
+    Channel pub("Pub", "pub", factory);
+    auto& pubSocket = static_cast<shmem::Socket&>(pub.GetSocket());
+    pubSocket.SetSndBufSize(10);
+    ASSERT_TRUE(pub.Bind(address));
+
+    vector<unique_ptr<Channel>> subs;
+    for (int i = 0; i < 2; ++i) {
+        subs.push_back(make_unique<Channel>("Sub", "sub", factory));
+        subs.back()->GetSocket().SetRcvBufSize(10);
+        ASSERT_TRUE(subs.back()->Connect(address));
+    }
+    auto waitForSubscribers = [&](size_t n) {
+        for (int i = 0; i < 500 && pubSocket.GetNumberOfSubscribers() != n; ++i) {
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        return pubSocket.GetNumberOfSubscribers() == n;
+    };
+    ASSERT_TRUE(waitForSubscribers(2));
+
+    MessagePtr wrong(pub.NewMessage());
+    EXPECT_EQ(pub.Receive(wrong, 0), static_cast<int>(TransferCode::error));
+    EXPECT_EQ(subs[0]->Send(wrong, 0), static_cast<int>(TransferCode::error));
+
+    {
+        // every subscriber gets a reference to the same buffer
+        MessagePtr msg(pub.NewMessage(1000));
+        void* data = msg->GetData();
+        memset(data, 'x', 1000);
+        ASSERT_EQ(pub.Send(msg), 1000);
+        EXPECT_LT(shmem::Monitor::GetFreeMemory(shmem::SessionId{sessionId}, 0), freeBefore);
+
+        MessagePtr received1(subs[0]->NewMessage());
+        MessagePtr received2(subs[1]->NewMessage());
+        ASSERT_EQ(subs[0]->Receive(received1), 1000);
+        ASSERT_EQ(subs[1]->Receive(received2), 1000);
+        EXPECT_EQ(received1->GetData(), data);
+        EXPECT_EQ(received2->GetData(), data);
+        EXPECT_EQ(static_cast<char*>(received2->GetData())[999], 'x');
+        EXPECT_EQ(static_cast<const shmem::Message&>(*received1).GetRefCount(), 2);
+
+        received1.reset();
+        EXPECT_EQ(static_cast<const shmem::Message&>(*received2).GetRefCount(), 1);
+        EXPECT_LT(shmem::Monitor::GetFreeMemory(shmem::SessionId{sessionId}, 0), freeBefore);
+    }
+    EXPECT_EQ(shmem::Monitor::GetFreeMemory(shmem::SessionId{sessionId}, 0), freeBefore);
+
+    {
+        Parts parts;
+        parts.AddPart(pub.NewMessage(100));
+        parts.AddPart(pub.NewMessage(200));
+        ASSERT_EQ(pub.Send(parts), 300);
+        for (auto& sub : subs) {
+            Parts received;
+            ASSERT_EQ(sub->Receive(received), 300);
+            ASSERT_EQ(received.Size(), 2U);
+            EXPECT_EQ(received.At(1)->GetSize(), 200U);
+        }
+    }
+    EXPECT_EQ(shmem::Monitor::GetFreeMemory(shmem::SessionId{sessionId}, 0), freeBefore);
+
+    {
+        // subscribers that do not receive miss messages beyond their high-water mark, instead of pinning buffers
+        // (enough messages to also exceed the kernel socket buffers of ipc)
+        constexpr int numMsgs = 10000;
+        for (int i = 0; i < numMsgs; ++i) {
+            MessagePtr msg(pub.NewMessage(100));
+            ASSERT_EQ(pub.Send(msg, 0), 100);
+        }
+        EXPECT_GT(pubSocket.GetNumberOfDroppedMessages(), 0UL);
+        EXPECT_EQ(pubSocket.GetNumberOfSubscribers(), 2U);
+        for (auto& sub : subs) {
+            int numReceived = 0;
+            while (true) {
+                MessagePtr msg(sub->NewMessage());
+                if (sub->Receive(msg, 100) < 0) {
+                    break;
+                }
+                ++numReceived;
+            }
+            EXPECT_GT(numReceived, 0);
+            EXPECT_LT(numReceived, numMsgs);
+        }
+    }
+    EXPECT_EQ(shmem::Monitor::GetFreeMemory(shmem::SessionId{sessionId}, 0), freeBefore);
+
+    // disconnected subscribers are forgotten
+    subs.pop_back();
+    for (int i = 0; i < 500 && pubSocket.GetNumberOfSubscribers() != 1; ++i) {
+        MessagePtr empty(pub.NewMessage());
+        ASSERT_EQ(pub.Send(empty), 0);
+        this_thread::sleep_for(chrono::milliseconds(10));
+    }
+    EXPECT_EQ(pubSocket.GetNumberOfSubscribers(), 1U);
+}
+
+TEST(PubSub, inproc)
+{
+    PubSub("inproc://test_shm_pub_sub");
+}
+
+TEST(PubSub, ipc)
+{
+    PubSub(tools::ToString("ipc://test_shm_pub_sub_", tools::UuidHash()));
+}
+
 } // namespace
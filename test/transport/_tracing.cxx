@@ -0,0 +1,132 @@
+/********************************************************************************
+ *    Copyright (C) 2024 GSI Helmholtzzentrum fuer Schwerionenforschung GmbH    *
+ *                                                                              *
+ *              This software is distributed under the terms of the             *
+ *              GNU Lesser General Public Licence (LGPL) version 3,             *
+ *                  copied verbatim in the file "LICENSE"                       *
+ ********************************************************************************/
+
+#include <fairmq/Channel.h>
+#include <fairmq/Parts.h>
+#include <fairmq/ProgOptions.h>
+#include <fairmq/TransportFactory.h>
+#include <fairmq/Tracing.h>
+#include <fairmq/tools/Strings.h>
+#include <fairmq/tools/Unique.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+using namespace std;
+using namespace fair::mq;
+
+void Tracing(const string& transport, const string& address, size_t metadataMsgSize)
+{
+    ProgOptions config;
+    config.SetProperty<string>("session", tools::Uuid());
+    config.SetProperty<size_t>("shm-segment-size", 100000000);
+    config.SetProperty<size_t>("shm-metadata-msg-size", metadataMsgSize);
+
+    auto factory = TransportFactory::CreateTransportFactory(transport, tools::Uuid(), &config);
+
+    Channel push("data", "push", factory);
+    Channel pull("data", "pull", factory);
+    ASSERT_TRUE(pull.Bind(address));
+    ASSERT_TRUE(push.Connect(address));
+
+    tracing::Collect([](const tracing::Span&) {});
+    tracing::ClearCurrentContext();
+
+    // rate 0: nothing starts a trace
+    tracing::Enable(0.);
+    {
+        MessagePtr msg(push.NewMessage(100));
+        ASSERT_EQ(push.Send(msg), 100);
+        MessagePtr received(pull.NewMessage());
+        ASSERT_EQ(pull.Receive(received), 100);
+        EXPECT_EQ(tracing::GetCurrentContext().fTraceId, 0UL);
+    }
+
+    // the first send starts a trace, the receive makes it the current one of this thread, the following sends continue it
+    tracing::SetSampleRate(1.);
+    uint64_t traceId = 0;
+    for (uint32_t hop = 0; hop < 2; ++hop) {
+        MessagePtr msg(push.NewMessage(100));
+        ASSERT_EQ(push.Send(msg), 100);
+        MessagePtr received(pull.NewMessage());
+        ASSERT_EQ(pull.Receive(received), 100);
+        auto ctx = tracing::GetCurrentContext();
+        EXPECT_NE(ctx.fTraceId, 0UL);
+        EXPECT_EQ(ctx.fHop, hop);
+        if (hop == 0) {
+            traceId = ctx.fTraceId;
+        }
+        EXPECT_EQ(ctx.fTraceId, traceId);
+    }
+    {
+        Parts parts;
+        for (int i = 0; i < 3; ++i) {
+            parts.AddPart(push.NewMessage(10));
+        }
+        ASSERT_EQ(push.Send(parts), 30);
+        Parts received;
+        ASSERT_EQ(pull.Receive(received), 30);
+        EXPECT_EQ(received.Size(), 3UL);
+        EXPECT_EQ(tracing::GetCurrentContext().fTraceId, traceId);
+        EXPECT_EQ(tracing::GetCurrentContext().fHop, 2U);
+    }
+
+    vector<tracing::Span> spans;
+    EXPECT_EQ(tracing::Collect([&](const tracing::Span& span) { spans.push_back(span); }), 6UL);
+    ASSERT_EQ(spans.size(), 6UL);
+    for (size_t i = 0; i < spans.size(); ++i) {
+        EXPECT_EQ(spans[i].fContext.fTraceId, traceId);
+        EXPECT_EQ(spans[i].fContext.fHop, i / 2);
+        EXPECT_EQ(spans[i].fDirection, i % 2 == 0 ? tracing::Direction::tx : tracing::Direction::rx);
+        EXPECT_EQ(string(spans[i].fChannel), "data");
+        EXPECT_LE(spans[i].fStartNs, spans[i].fEndNs);
+    }
+
+    // with tracing disabled the receiver still takes the trace context off the messages
+    {
+        MessagePtr msg(push.NewMessage(100));
+        ASSERT_EQ(push.Send(msg), 100);
+        Parts parts;
+        parts.AddPart(push.NewMessage(10));
+        parts.AddPart(push.NewMessage(10));
+        ASSERT_EQ(push.Send(parts), 20);
+
+        tracing::Disable();
+        tracing::ClearCurrentContext();
+        MessagePtr received(pull.NewMessage());
+        ASSERT_EQ(pull.Receive(received), 100);
+        Parts receivedParts;
+        ASSERT_EQ(pull.Receive(receivedParts), 20);
+        EXPECT_EQ(receivedParts.Size(), 2UL);
+        EXPECT_EQ(tracing::GetCurrentContext().fTraceId, 0UL);
+    }
+    tracing::Collect([](const tracing::Span&) {});
+}
+
+TEST(Tracing, zeromq)
+{
+    Tracing("zeromq", "inproc://test_tracing_zeromq", 0);
+}
+
+TEST(Tracing, shmem)
+{
+    Tracing("shmem", tools::ToString("ipc://test_tracing_shmem_", tools::UuidHash()), 0);
+}
+
+TEST(Tracing, shmem_padded_metadata)
+{
+    Tracing("shmem", tools::ToString("ipc://test_tracing_shmem_padded_", tools::UuidHash()), 1024);
+}
+
+} // namespace